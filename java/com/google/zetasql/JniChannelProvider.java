@@ -17,26 +17,44 @@
 
 package com.google.zetasql;
 
+import static java.nio.charset.StandardCharsets.UTF_8;
+
 import com.google.auto.service.AutoService;
+import com.google.protobuf.CodedOutputStream;
+import com.google.protobuf.MessageLite;
+import io.grpc.CallOptions;
 import io.grpc.Channel;
+import io.grpc.ClientCall;
 import io.grpc.LoadBalancerProvider;
 import io.grpc.LoadBalancerRegistry;
+import io.grpc.Metadata;
+import io.grpc.MethodDescriptor;
+import io.grpc.Status;
 import io.grpc.netty.NettyChannelBuilder;
 import io.netty.channel.ChannelException;
 import io.netty.channel.nio.NioEventLoopGroup;
 import io.netty.channel.socket.nio.NioSocketChannel;
 import io.netty.util.concurrent.DefaultThreadFactory;
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
 import java.io.IOException;
+import java.io.InputStream;
 import java.net.InetSocketAddress;
 import java.net.SocketAddress;
+import java.nio.ByteBuffer;
 import java.nio.channels.SocketChannel;
 
 /** Controller class of the ZetaSQL JniChannelProvider. */
 @AutoService(ClientChannelProvider.class)
 public class JniChannelProvider implements ClientChannelProvider {
   private static final InetSocketAddress ADDRESS = new InetSocketAddress(0);
+  private static final int MIN_DIRECT_BUFFER_SIZE = 64 * 1024;
   private static NioEventLoopGroup eventLoop = null;
 
+  /** Per-thread native buffer that direct call requests are serialized into. */
+  private static final ThreadLocal<ByteBuffer> directBuffer =
+      ThreadLocal.withInitial(() -> ByteBuffer.allocateDirect(MIN_DIRECT_BUFFER_SIZE));
+
   private static String getLibraryPath() {
     String path = System.getProperty("zetasql.local_service.path");
     if (path != null) {
@@ -83,6 +101,29 @@ public class JniChannelProvider implements ClientChannelProvider {
   /** Returns a SocketChannel connected to the server. */
   private static native SocketChannel getSocketChannel() throws IOException;
 
+  /**
+   * Runs the unary method with bare name {@code method} in-process, reading the serialized request
+   * from the first {@code length} bytes of the direct buffer {@code request}, and returns the
+   * serialized response.
+   */
+  private static native byte[] callDirect(String method, ByteBuffer request, int length)
+      throws DirectCallException;
+
+  /** Thrown by {@link #callDirect} when the server returns an error. */
+  protected static class DirectCallException extends Exception {
+    private final int code;
+
+    /** {@code utf8Message} is the UTF-8 encoded error message. */
+    public DirectCallException(int code, byte[] utf8Message) {
+      super(new String(utf8Message, UTF_8));
+      this.code = code;
+    }
+
+    Status toStatus() {
+      return Status.fromCodeValue(code).withDescription(getMessage());
+    }
+  }
+
   /** Wraps one end of a socketpair for NioSocketChannel. */
   protected static class SocketPairChannel extends NioSocketChannel {
 
@@ -141,14 +182,165 @@ public class JniChannelProvider implements ClientChannelProvider {
     return eventLoop;
   }
 
-  /** Create a new channel that can be used to call RPC of the ZetaSQL server. */
+  /** Returns a direct buffer of at least {@code size} bytes for the current thread. */
+  private static ByteBuffer getDirectBuffer(int size) {
+    ByteBuffer buffer = directBuffer.get();
+    if (buffer.capacity() < size) {
+      // Round up to a power of two, unless that would overflow an int.
+      int capacity = size > (1 << 30) ? size : Integer.highestOneBit(size - 1) << 1;
+      buffer = ByteBuffer.allocateDirect(Math.max(capacity, size));
+      directBuffer.set(buffer);
+    }
+    buffer.clear();
+    return buffer;
+  }
+
+  /**
+   * Runs a unary call synchronously through {@link #callDirect} when it is half-closed. Requests
+   * are serialized directly into native memory, and the response is delivered to the listener on
+   * the calling thread. Deadlines are not enforced and cancellation only has an effect before the
+   * call has run.
+   */
+  private static final class DirectClientCall<ReqT, RespT> extends ClientCall<ReqT, RespT> {
+    private final MethodDescriptor<ReqT, RespT> method;
+    private Listener<RespT> listener;
+    private ReqT request;
+    private boolean closed = false;
+
+    DirectClientCall(MethodDescriptor<ReqT, RespT> method) {
+      this.method = method;
+    }
+
+    @Override
+    public void start(Listener<RespT> listener, Metadata headers) {
+      this.listener = listener;
+    }
+
+    @Override
+    public void request(int numMessages) {}
+
+    @Override
+    public void cancel(String message, Throwable cause) {
+      close(Status.CANCELLED.withDescription(message).withCause(cause));
+    }
+
+    @Override
+    public void halfClose() {
+      if (closed) {
+        return;
+      }
+      if (request == null) {
+        close(Status.INTERNAL.withDescription("No request sent"));
+        return;
+      }
+      RespT response;
+      try {
+        response = method.parseResponse(new ByteArrayInputStream(call()));
+      } catch (DirectCallException e) {
+        close(e.toStatus());
+        return;
+      } catch (IOException | RuntimeException e) {
+        close(Status.INTERNAL.withDescription(e.getMessage()).withCause(e));
+        return;
+      }
+      listener.onHeaders(new Metadata());
+      listener.onMessage(response);
+      close(Status.OK);
+    }
+
+    @Override
+    public void sendMessage(ReqT message) {
+      request = message;
+    }
+
+    private byte[] call() throws DirectCallException, IOException {
+      ByteBuffer buffer;
+      int length;
+      if (request instanceof MessageLite) {
+        MessageLite message = (MessageLite) request;
+        length = message.getSerializedSize();
+        buffer = getDirectBuffer(length);
+        CodedOutputStream output = CodedOutputStream.newInstance(buffer);
+        message.writeTo(output);
+        output.flush();
+      } else {
+        byte[] bytes = toByteArray(method.streamRequest(request));
+        length = bytes.length;
+        buffer = getDirectBuffer(length);
+        buffer.put(bytes);
+      }
+      return callDirect(
+          MethodDescriptor.extractBareMethodName(method.getFullMethodName()), buffer, length);
+    }
+
+    private void close(Status status) {
+      if (closed) {
+        return;
+      }
+      closed = true;
+      if (listener != null) {
+        listener.onClose(status, new Metadata());
+      }
+    }
+
+    private static byte[] toByteArray(InputStream stream) throws IOException {
+      ByteArrayOutputStream output = new ByteArrayOutputStream();
+      byte[] chunk = new byte[4096];
+      int read;
+      while ((read = stream.read(chunk)) != -1) {
+        output.write(chunk, 0, read);
+      }
+      return output.toByteArray();
+    }
+  }
+
+  /**
+   * Sends unary calls through {@link #callDirect}, and all other calls over the socketpair
+   * channel.
+   */
+  private static final class DirectCallChannel extends Channel {
+    private final Channel socketChannel;
+
+    DirectCallChannel(Channel socketChannel) {
+      this.socketChannel = socketChannel;
+    }
+
+    @Override
+    public <ReqT, RespT> ClientCall<ReqT, RespT> newCall(
+        MethodDescriptor<ReqT, RespT> method, CallOptions callOptions) {
+      if (method.getType() == MethodDescriptor.MethodType.UNARY) {
+        return new DirectClientCall<>(method);
+      }
+      return socketChannel.newCall(method, callOptions);
+    }
+
+    @Override
+    public String authority() {
+      return socketChannel.authority();
+    }
+  }
+
+  /**
+   * Create a new channel that can be used to call RPC of the ZetaSQL server. Unary calls bypass
+   * the socketpair when the {@code zetasql.local_service.direct_calls} system property is "true".
+   */
   @Override
   public Channel newChannel() {
-    return NettyChannelBuilder.forAddress(ADDRESS)
-        .channelType(SocketPairChannel.class)
-        .eventLoopGroup(getEventLoop())
-        // Disables encryption, not needed because the socketpair is in memory.
-        .usePlaintext()
-        .build();
+    return newChannel(Boolean.getBoolean("zetasql.local_service.direct_calls"));
+  }
+
+  /**
+   * Create a new channel that can be used to call RPC of the ZetaSQL server. If {@code
+   * directCalls}, unary calls run in-process through JNI rather than over the socketpair.
+   */
+  Channel newChannel(boolean directCalls) {
+    Channel channel =
+        NettyChannelBuilder.forAddress(ADDRESS)
+            .channelType(SocketPairChannel.class)
+            .eventLoopGroup(getEventLoop())
+            // Disables encryption, not needed because the socketpair is in memory.
+            .usePlaintext()
+            .build();
+    return directCalls ? new DirectCallChannel(channel) : channel;
   }
 }
@@ -21,10 +21,13 @@ import static com.google.common.base.Verify.verify;
 
 import com.google.common.base.Ascii;
 import com.google.common.base.Preconditions;
+import com.google.common.collect.ImmutableList;
 import com.google.common.collect.ImmutableMap;
 import com.google.common.collect.Queues;
 import com.google.common.util.concurrent.ListenableFuture;
 import com.google.common.util.concurrent.SettableFuture;
+import com.google.zetasql.LocalService.EvaluateBatchRequest;
+import com.google.zetasql.LocalService.EvaluateBatchResponse;
 import com.google.zetasql.LocalService.EvaluateRequest;
 import com.google.zetasql.LocalService.EvaluateRequestBatch;
 import com.google.zetasql.LocalService.EvaluateResponse;
@@ -33,6 +36,7 @@ import com.google.zetasql.LocalService.PrepareRequest;
 import com.google.zetasql.LocalService.PrepareResponse;
 import com.google.zetasql.LocalService.PreparedState;
 import com.google.zetasql.LocalService.UnprepareRequest;
+import com.google.zetasql.ZetaSQLValue.ValueProto;
 import io.grpc.Channel;
 import io.grpc.ManagedChannel;
 import io.grpc.StatusRuntimeException;
@@ -231,6 +235,75 @@ public class PreparedExpression implements AutoCloseable {
     return Value.deserialize(outputType, resp.getValue());
   }
 
+  /**
+   * Evaluate the sql expression for a batch of rows with a single Service RPC. This is much cheaper
+   * than calling execute() once per row. Functions like CURRENT_TIMESTAMP() return the same value
+   * for every row of a batch.
+   *
+   * @param rowCount Number of rows in the batch.
+   * @param columns Map of column name to the column's values, one value per row. Only the columns
+   *     returned by getReferencedColumns() are required.
+   * @param parameters Map of parameter name:value pairs, shared by all rows.
+   * @return The evaluation result of each row.
+   */
+  public ImmutableList<Value> executeBatch(
+      int rowCount, Map<String, ? extends List<Value>> columns, Map<String, Value> parameters) {
+    Preconditions.checkState(prepared);
+    Preconditions.checkState(!closed);
+    Preconditions.checkNotNull(columns);
+    Preconditions.checkNotNull(parameters);
+    Preconditions.checkArgument(rowCount >= 0);
+
+    EvaluateBatchRequest.Builder request =
+        EvaluateBatchRequest.newBuilder().setPreparedExpressionId(preparedId).setRowCount(rowCount);
+    Map<String, List<Value>> normalizedColumns = new HashMap<>();
+    for (Map.Entry<String, ? extends List<Value>> entry : columns.entrySet()) {
+      String name = Ascii.toLowerCase(entry.getKey());
+      if (!expectedColumns.containsKey(name)) {
+        throw new SqlException("Unexpected column parameter '" + name + "'");
+      }
+      if (entry.getValue().size() != rowCount) {
+        throw new SqlException("Expected " + rowCount + " values for column '" + name + "'");
+      }
+      if (normalizedColumns.putIfAbsent(name, entry.getValue()) != null) {
+        throw new SqlException("Duplicate expression column name '" + name + "'");
+      }
+    }
+    for (String column : referencedColumns) {
+      List<Value> values = normalizedColumns.get(column);
+      if (values == null) {
+        throw new SqlException("Incomplete column parameters " + column);
+      }
+      EvaluateBatchRequest.Column.Builder columnBuilder = request.addColumnsBuilder();
+      columnBuilder.setName(column);
+      for (Value value : values) {
+        columnBuilder.addValues(value.serialize());
+      }
+    }
+    final Map<String, Value> normalizedParameters =
+        normalizeParameters(parameters, expectedParameters, "query");
+    for (String param : referencedParameters) {
+      Value value = normalizedParameters.get(param);
+      if (value == null) {
+        throw new SqlException("Incomplete query parameters " + param);
+      }
+      request.addParams(serializeParameter(param, value));
+    }
+
+    final EvaluateBatchResponse resp;
+    try {
+      resp = Client.getStub().evaluateBatch(request.build());
+    } catch (StatusRuntimeException e) {
+      throw new SqlException(e);
+    }
+
+    ImmutableList.Builder<Value> results = ImmutableList.builderWithExpectedSize(rowCount);
+    for (ValueProto value : resp.getValuesList()) {
+      results.add(Value.deserialize(outputType, value));
+    }
+    return results.build();
+  }
+
   private EvaluateRequest buildRequest(Map<String, Value> columns, Map<String, Value> parameters) {
     Preconditions.checkNotNull(columns);
     Preconditions.checkNotNull(parameters);
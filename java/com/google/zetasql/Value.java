@@ -34,10 +34,12 @@ import com.google.common.hash.Hashing;
 import com.google.common.primitives.Bytes;
 import com.google.errorprone.annotations.Immutable;
 import com.google.protobuf.ByteString;
+import com.google.protobuf.CodedInputStream;
 import com.google.protobuf.DynamicMessage;
 import com.google.protobuf.InvalidProtocolBufferException;
 import com.google.protobuf.Message;
 import com.google.protobuf.TextFormat;
+import com.google.protobuf.Timestamp;
 import com.google.protobuf.util.Timestamps;
 import com.google.zetasql.ZetaSQLType.TypeKind;
 import com.google.zetasql.ZetaSQLValue.ValueProto;
@@ -1248,6 +1250,175 @@ public class Value implements Serializable {
     return new Value(type, proto);
   }
 
+  /**
+   * Decodes rows in the compact encoding of the local service's CompactTableData message. See
+   * zetasql/local_service/compact_table_data.h for the encoding.
+   *
+   * @param columnTypes The types of the columns of each row.
+   * @param stringTable CompactTableData.string_table.
+   * @param rows CompactTableData.rows.
+   */
+  public static ImmutableList<ImmutableList<Value>> deserializeCompactRows(
+      List<Type> columnTypes, List<ByteString> stringTable, ByteString rows) {
+    Preconditions.checkNotNull(columnTypes);
+    Preconditions.checkNotNull(stringTable);
+    Preconditions.checkNotNull(rows);
+    CodedInputStream input = rows.newCodedInput();
+    ImmutableList.Builder<ImmutableList<Value>> result = ImmutableList.builder();
+    try {
+      while (!input.isAtEnd()) {
+        ImmutableList.Builder<Value> row = ImmutableList.builder();
+        for (Type type : columnTypes) {
+          row.add(readCompactValue(type, stringTable, input));
+        }
+        result.add(row.build());
+      }
+    } catch (IOException e) {
+      throw new IllegalArgumentException("Invalid compact rows", e);
+    }
+    return result.build();
+  }
+
+  /**
+   * Reads one value of {@code type} in the compact encoding. Values are constructed directly from
+   * the stream; only the ValueProto that each Value holds is built, and the protos of array
+   * elements and struct fields are shared with their parent instead of being decoded again.
+   */
+  private static Value readCompactValue(
+      Type type, List<ByteString> stringTable, CodedInputStream input) throws IOException {
+    if (input.readRawByte() == 0) {
+      return new Value(type, ValueProto.getDefaultInstance());
+    }
+    switch (type.getKind()) {
+      case TYPE_BOOL:
+        return createBoolValue(input.readRawByte() != 0);
+      case TYPE_INT32:
+        return createInt32Value(input.readSInt32());
+      case TYPE_INT64:
+        return createInt64Value(input.readSInt64());
+      case TYPE_DATE:
+        {
+          int date = input.readSInt32();
+          if (!Type.isValidDate(date)) {
+            throw new IllegalArgumentException("Invalid value for DATE: " + date);
+          }
+          return createDateValue(date);
+        }
+      case TYPE_ENUM:
+        {
+          EnumType enumType = type.asEnum();
+          int n = input.readSInt32();
+          if (enumType.findName(n) == null) {
+            throw new IllegalArgumentException("Invalid value for " + enumType + ": " + n);
+          }
+          return createEnumValue(enumType, n);
+        }
+      case TYPE_UINT32:
+        return createUint32Value(input.readUInt32());
+      case TYPE_UINT64:
+        return createUint64Value(input.readUInt64());
+      case TYPE_FLOAT:
+        return createFloatValue(Float.intBitsToFloat(input.readRawLittleEndian32()));
+      case TYPE_DOUBLE:
+        return createDoubleValue(Double.longBitsToDouble(input.readRawLittleEndian64()));
+      case TYPE_STRING:
+        return createStringValue(readCompactStringTableEntry(stringTable, input).toStringUtf8());
+      case TYPE_BYTES:
+        return createBytesValue(readCompactStringTableEntry(stringTable, input));
+      case TYPE_JSON:
+        return createJsonValue(readCompactStringTableEntry(stringTable, input).toStringUtf8());
+      case TYPE_PROTO:
+        return createProtoValue(type.asProto(), readCompactStringTableEntry(stringTable, input));
+      case TYPE_TIMESTAMP:
+        {
+          Timestamp timestamp =
+              Timestamp.newBuilder()
+                  .setSeconds(input.readSInt64())
+                  .setNanos(input.readUInt32())
+                  .build();
+          if (!Type.isValidTimestamp(timestamp)) {
+            throw new IllegalArgumentException("Invalid value for TIMESTAMP: " + timestamp);
+          }
+          return new Value(type, ValueProto.newBuilder().setTimestampValue(timestamp).build());
+        }
+      case TYPE_DATETIME:
+        {
+          long bitFieldDatetimeSeconds = input.readUInt64();
+          return createDatetimeValue(bitFieldDatetimeSeconds, input.readUInt32());
+        }
+      case TYPE_TIME:
+        return createTimeValue(input.readUInt64());
+      case TYPE_NUMERIC:
+        {
+          ByteString bytes = input.readBytes();
+          return new Value(
+              TypeKind.TYPE_NUMERIC,
+              ValueProto.newBuilder().setNumericValue(bytes).build(),
+              deserializeBigDecimal(
+                  bytes, NUMERIC_SCALE, MAX_NUMERIC_VALUE, MIN_NUMERIC_VALUE, "Numeric"));
+        }
+      case TYPE_BIGNUMERIC:
+        {
+          ByteString bytes = input.readBytes();
+          return new Value(
+              TypeKind.TYPE_BIGNUMERIC,
+              ValueProto.newBuilder().setBignumericValue(bytes).build(),
+              deserializeBigDecimal(
+                  bytes,
+                  BIGNUMERIC_SCALE,
+                  MAX_BIGNUMERIC_VALUE,
+                  MIN_BIGNUMERIC_VALUE,
+                  "BIGNUMERIC"));
+        }
+      case TYPE_INTERVAL:
+        {
+          ByteString bytes = input.readBytes();
+          return new Value(
+              TypeKind.TYPE_INTERVAL,
+              ValueProto.newBuilder().setIntervalValue(bytes).build(),
+              IntervalValue.deserializeInterval(bytes));
+        }
+      case TYPE_ARRAY:
+        {
+          ArrayType arrayType = type.asArray();
+          Type elementType = arrayType.getElementType();
+          Array.Builder array = Array.newBuilder();
+          List<Value> elements = new ArrayList<>();
+          for (long i = input.readUInt64(); i > 0; --i) {
+            Value element = readCompactValue(elementType, stringTable, input);
+            array.addElement(element.proto);
+            elements.add(element);
+          }
+          return new Value(
+              arrayType, ValueProto.newBuilder().setArrayValue(array).build(), elements);
+        }
+      case TYPE_STRUCT:
+        {
+          StructType structType = type.asStruct();
+          Struct.Builder struct = Struct.newBuilder();
+          List<Value> fields = new ArrayList<>(structType.getFieldCount());
+          for (int i = 0; i < structType.getFieldCount(); ++i) {
+            Value field = readCompactValue(structType.getField(i).getType(), stringTable, input);
+            struct.addField(field.proto);
+            fields.add(field);
+          }
+          return new Value(
+              structType, ValueProto.newBuilder().setStructValue(struct).build(), fields);
+        }
+      default:
+        throw new IllegalArgumentException("Unsupported type in compact rows: " + type);
+    }
+  }
+
+  private static ByteString readCompactStringTableEntry(
+      List<ByteString> stringTable, CodedInputStream input) throws IOException {
+    long index = input.readUInt64();
+    if (index < 0 || index >= stringTable.size()) {
+      throw new IllegalArgumentException("Invalid string table index in compact rows: " + index);
+    }
+    return stringTable.get((int) index);
+  }
+
   public static boolean isSupportedTypeKind(Type type) {
     switch (type.getKind()) {
       case TYPE_INT32:
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+package com.google.zetasql;
+
+import com.google.zetasql.LocalService.EvaluateRequest;
+import com.google.zetasql.LocalService.EvaluateResponse;
+import com.google.zetasql.LocalService.PrepareRequest;
+import com.google.zetasql.LocalService.UnprepareRequest;
+import com.google.zetasql.ZetaSQLOptions.ParameterMode;
+import com.google.zetasql.ZetaSQLOptionsProto.AnalyzerOptionsProto;
+import com.google.zetasql.ZetaSQLType.TypeKind;
+import com.google.zetasql.ZetaSQLType.TypeProto;
+import com.google.zetasql.ZetaSQLValue.ValueProto;
+import com.google.zetasql.ZetaSqlLocalServiceGrpc.ZetaSqlLocalServiceBlockingStub;
+import java.util.Arrays;
+
+/**
+ * Compares the latency of small Evaluate calls made over the JNI socketpair channel with the same
+ * calls made through direct JNI calls.
+ *
+ * <p>Usage: JniChannelBenchmark [iterations]
+ */
+public final class JniChannelBenchmark {
+  private static final int WARMUP_ITERATIONS = 10000;
+
+  private JniChannelBenchmark() {}
+
+  /** Evaluates a prepared "@p + 1" {@code iterations} times and returns per-call nanoseconds. */
+  private static long[] run(ZetaSqlLocalServiceBlockingStub stub, int iterations) {
+    AnalyzerOptionsProto options =
+        AnalyzerOptionsProto.newBuilder()
+            .setParameterMode(ParameterMode.PARAMETER_NAMED)
+            .addQueryParameters(
+                AnalyzerOptionsProto.QueryParameterProto.newBuilder()
+                    .setName("p")
+                    .setType(TypeProto.newBuilder().setTypeKind(TypeKind.TYPE_INT64)))
+            .build();
+    long id =
+        stub.prepare(PrepareRequest.newBuilder().setSql("@p + 1").setOptions(options).build())
+            .getPrepared()
+            .getPreparedExpressionId();
+
+    long[] latencies = new long[iterations];
+    for (int i = -WARMUP_ITERATIONS; i < iterations; i++) {
+      EvaluateRequest request =
+          EvaluateRequest.newBuilder()
+              .setPreparedExpressionId(id)
+              .addParams(
+                  EvaluateRequest.Parameter.newBuilder()
+                      .setName("p")
+                      .setValue(ValueProto.newBuilder().setInt64Value(i)))
+              .build();
+      long start = System.nanoTime();
+      EvaluateResponse response = stub.evaluate(request);
+      long elapsed = System.nanoTime() - start;
+      if (response.getValue().getInt64Value() != i + 1) {
+        throw new IllegalStateException("Unexpected result: " + response);
+      }
+      if (i >= 0) {
+        latencies[i] = elapsed;
+      }
+    }
+    stub.unprepare(UnprepareRequest.newBuilder().setPreparedExpressionId(id).build());
+    return latencies;
+  }
+
+  private static void report(String name, long[] latencies) {
+    Arrays.sort(latencies);
+    long total = 0;
+    for (long latency : latencies) {
+      total += latency;
+    }
+    System.out.printf(
+        "%-8s mean %8.1f us  p50 %8.1f us  p99 %8.1f us%n",
+        name,
+        total / 1000.0 / latencies.length,
+        latencies[latencies.length / 2] / 1000.0,
+        latencies[(int) (latencies.length * 0.99)] / 1000.0);
+  }
+
+  public static void main(String[] args) {
+    int iterations = args.length > 0 ? Integer.parseInt(args[0]) : 100000;
+    JniChannelProvider provider = new JniChannelProvider();
+    report(
+        "socket",
+        run(ZetaSqlLocalServiceGrpc.newBlockingStub(provider.newChannel(false)), iterations));
+    report(
+        "direct",
+        run(ZetaSqlLocalServiceGrpc.newBlockingStub(provider.newChannel(true)), iterations));
+  }
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2019 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+package com.google.zetasql;
+
+import static com.google.common.truth.Truth.assertThat;
+import static org.junit.Assert.fail;
+
+import com.google.zetasql.LocalService.EvaluateQueryRequest;
+import com.google.zetasql.LocalService.EvaluateQueryResponse;
+import com.google.zetasql.LocalService.EvaluateRequest;
+import com.google.zetasql.LocalService.EvaluateResponse;
+import com.google.zetasql.ZetaSqlLocalServiceGrpc.ZetaSqlLocalServiceBlockingStub;
+import io.grpc.Status;
+import io.grpc.StatusRuntimeException;
+import java.util.Iterator;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.junit.runners.JUnit4;
+
+/**
+ * Checks that calls made through direct JNI calls behave like the same calls made over the
+ * socketpair channel.
+ */
+@RunWith(JUnit4.class)
+public class JniChannelProviderTest {
+  private final JniChannelProvider provider = new JniChannelProvider();
+  private final ZetaSqlLocalServiceBlockingStub socketStub =
+      ZetaSqlLocalServiceGrpc.newBlockingStub(provider.newChannel(false));
+  private final ZetaSqlLocalServiceBlockingStub directStub =
+      ZetaSqlLocalServiceGrpc.newBlockingStub(provider.newChannel(true));
+
+  @Test
+  public void testEvaluateMatchesSocketChannel() {
+    EvaluateRequest request =
+        EvaluateRequest.newBuilder().setSql("concat('naïve', ' ', 'café')").build();
+    EvaluateResponse expected = socketStub.evaluate(request);
+    EvaluateResponse actual = directStub.evaluate(request);
+    assertThat(actual.getValue().getStringValue()).isEqualTo("naïve café");
+    assertThat(actual).isEqualTo(expected);
+  }
+
+  @Test
+  public void testEvaluateErrorMatchesSocketChannel() {
+    // The message is not ASCII, so it must be passed through JNI as UTF-8.
+    EvaluateRequest request = EvaluateRequest.newBuilder().setSql("error('bäd välue ✗')").build();
+    Status expected = getErrorStatus(socketStub, request);
+    Status actual = getErrorStatus(directStub, request);
+    assertThat(actual.getCode()).isEqualTo(Status.Code.OUT_OF_RANGE);
+    assertThat(actual.getDescription()).contains("bäd välue ✗");
+    assertThat(actual.getCode()).isEqualTo(expected.getCode());
+    assertThat(actual.getDescription()).isEqualTo(expected.getDescription());
+  }
+
+  @Test
+  public void testStreamingCallsUseSocketChannel() {
+    EvaluateQueryRequest request =
+        EvaluateQueryRequest.newBuilder()
+            .setSql("SELECT x FROM UNNEST(GENERATE_ARRAY(1, 100)) AS x")
+            .setMaxChunkBytes(100)
+            .build();
+    int numRows = 0;
+    for (Iterator<EvaluateQueryResponse> it = directStub.evaluateQueryChunked(request);
+        it.hasNext(); ) {
+      numRows += it.next().getContent().getTableData().getRowCount();
+    }
+    assertThat(numRows).isEqualTo(100);
+  }
+
+  private static Status getErrorStatus(
+      ZetaSqlLocalServiceBlockingStub stub, EvaluateRequest request) {
+    try {
+      stub.evaluate(request);
+      fail("Expected evaluate() to fail");
+      return null;
+    } catch (StatusRuntimeException e) {
+      return e.getStatus();
+    }
+  }
+}
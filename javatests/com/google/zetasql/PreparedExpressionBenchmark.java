@@ -0,0 +1,90 @@
+/*
+ * Copyright 2019 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+package com.google.zetasql;
+
+import com.google.common.collect.ImmutableList;
+import com.google.common.collect.ImmutableMap;
+import com.google.zetasql.ZetaSQLType.TypeKind;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Compares evaluating a prepared predicate over a batch of rows with execute() per row against a
+ * single executeBatch() call.
+ *
+ * <p>Usage: PreparedExpressionBenchmark [rows per batch] [measured iterations]
+ */
+public final class PreparedExpressionBenchmark {
+  private static final int WARMUP_ITERATIONS = 5;
+
+  private PreparedExpressionBenchmark() {}
+
+  private interface Batch {
+    void run();
+  }
+
+  /** Runs {@code batch} and prints the mean time per batch and per row. */
+  private static void measure(String name, int rows, int iterations, Batch batch) {
+    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+      batch.run();
+    }
+    long start = System.nanoTime();
+    for (int i = 0; i < iterations; i++) {
+      batch.run();
+    }
+    double nanosPerBatch = (System.nanoTime() - start) / (double) iterations;
+    System.out.printf(
+        "%-8s %10.3f ms/batch %10.3f us/row%n",
+        name, nanosPerBatch / 1e6, nanosPerBatch / 1e3 / rows);
+  }
+
+  public static void main(String[] args) {
+    int rows = args.length > 0 ? Integer.parseInt(args[0]) : 10000;
+    int iterations = args.length > 1 ? Integer.parseInt(args[1]) : 20;
+
+    ImmutableList.Builder<Value> ids = ImmutableList.builder();
+    for (int i = 0; i < rows; i++) {
+      ids.add(Value.createInt64Value(i));
+    }
+    List<Value> column = ids.build();
+    Map<String, Value> parameters = ImmutableMap.of("threshold", Value.createInt64Value(rows / 2));
+
+    try (PreparedExpression expression = new PreparedExpression("id >= @threshold")) {
+      AnalyzerOptions options = new AnalyzerOptions();
+      Type int64 = TypeFactory.createSimpleType(TypeKind.TYPE_INT64);
+      options.addExpressionColumn("id", int64);
+      options.addQueryParameter("threshold", int64);
+      expression.prepare(options);
+
+      measure(
+          "execute",
+          rows,
+          iterations,
+          () -> {
+            for (Value id : column) {
+              expression.execute(ImmutableMap.of("id", id), parameters);
+            }
+          });
+      measure(
+          "batch",
+          rows,
+          iterations,
+          () -> expression.executeBatch(rows, ImmutableMap.of("id", column), parameters));
+    }
+  }
+}
@@ -23,6 +23,7 @@ import static com.google.zetasql.TypeTestBase.getDescriptorPoolWithTypeProtoAndT
 import static org.junit.Assert.fail;
 
 import com.google.common.base.Strings;
+import com.google.common.collect.ImmutableList;
 import com.google.common.collect.ImmutableMap;
 import com.google.protobuf.InvalidProtocolBufferException;
 import com.google.zetasql.ZetaSQLOptions.ErrorMessageMode;
@@ -271,6 +272,61 @@ public class PreparedExpressionTest {
     }
   }
 
+  @Test
+  public void testExecuteBatch() {
+    try (PreparedExpression exp = new PreparedExpression("a * @p")) {
+      AnalyzerOptions options = new AnalyzerOptions();
+      Type int64 = TypeFactory.createSimpleType(TypeKind.TYPE_INT64);
+      options.addExpressionColumn("a", int64);
+      options.addQueryParameter("p", int64);
+      exp.prepare(options);
+
+      ImmutableList<Value> values =
+          exp.executeBatch(
+              3,
+              ImmutableMap.of(
+                  "A",
+                  ImmutableList.of(
+                      Value.createInt64Value(1),
+                      Value.createInt64Value(2),
+                      Value.createSimpleNullValue(TypeKind.TYPE_INT64))),
+              ImmutableMap.of("p", Value.createInt64Value(10)));
+      assertThat(values)
+          .containsExactly(
+              Value.createInt64Value(10),
+              Value.createInt64Value(20),
+              Value.createSimpleNullValue(TypeKind.TYPE_INT64))
+          .inOrder();
+
+      assertThat(
+              exp.executeBatch(
+                  0,
+                  ImmutableMap.of("a", ImmutableList.<Value>of()),
+                  ImmutableMap.of("p", Value.createInt64Value(10))))
+          .isEmpty();
+
+      try {
+        exp.executeBatch(
+            2,
+            ImmutableMap.of("a", ImmutableList.of(Value.createInt64Value(1))),
+            ImmutableMap.of("p", Value.createInt64Value(10)));
+        fail();
+      } catch (SqlException expected) {
+        checkSqlExceptionErrorSubstr(expected, "Expected 2 values for column 'a'");
+      }
+
+      try {
+        exp.executeBatch(
+            1,
+            ImmutableMap.of("a", ImmutableList.of(Value.createInt64Value(1))),
+            ImmutableMap.of());
+        fail();
+      } catch (SqlException expected) {
+        checkSqlExceptionErrorSubstr(expected, "Incomplete query parameters");
+      }
+    }
+  }
+
   @Test
   public void testPrepareWithColumns() {
     try (PreparedExpression exp = new PreparedExpression("IF(true, a, b.type_kind)")) {
@@ -27,6 +27,7 @@ import com.google.common.collect.ImmutableMap;
 import com.google.common.testing.EqualsTester;
 import com.google.common.testing.SerializableTester;
 import com.google.protobuf.ByteString;
+import com.google.protobuf.CodedOutputStream;
 import com.google.protobuf.InvalidProtocolBufferException;
 import com.google.protobuf.Message;
 import com.google.protobuf.TextFormat;
@@ -2288,6 +2289,65 @@ public class ValueTest {
     assertThat(int32Zero.equals(int32Null)).isFalse();
   }
 
+  @Test
+  public void testDeserializeCompactRows() throws IOException {
+    Type int64 = TypeFactory.createSimpleType(TypeKind.TYPE_INT64);
+    Type string = TypeFactory.createSimpleType(TypeKind.TYPE_STRING);
+    Type timestamp = TypeFactory.createSimpleType(TypeKind.TYPE_TIMESTAMP);
+    ArrayType arrayType = TypeFactory.createArrayType(int64);
+    List<Type> types = Arrays.asList(int64, string, timestamp, arrayType);
+    List<ByteString> stringTable = Arrays.asList(ByteString.copyFromUtf8("abc"));
+
+    ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+    CodedOutputStream output = CodedOutputStream.newInstance(bytes);
+    // Row 1: -3, "abc", 1970-01-01 00:00:01.5, [NULL, 5].
+    output.writeRawByte(1);
+    output.writeSInt64NoTag(-3);
+    output.writeRawByte(1);
+    output.writeUInt64NoTag(0);
+    output.writeRawByte(1);
+    output.writeSInt64NoTag(1);
+    output.writeUInt32NoTag(500000000);
+    output.writeRawByte(1);
+    output.writeUInt64NoTag(2);
+    output.writeRawByte(0);
+    output.writeRawByte(1);
+    output.writeSInt64NoTag(5);
+    // Row 2: all NULL.
+    for (int i = 0; i < types.size(); ++i) {
+      output.writeRawByte(0);
+    }
+    output.flush();
+
+    List<? extends List<Value>> rows =
+        Value.deserializeCompactRows(types, stringTable, ByteString.copyFrom(bytes.toByteArray()));
+    assertThat(rows).hasSize(2);
+    assertThat(rows.get(0))
+        .containsExactly(
+            Value.createInt64Value(-3),
+            Value.createStringValue("abc"),
+            Value.createTimestampValueFromUnixMicros(1500000),
+            Value.createArrayValue(
+                arrayType,
+                Arrays.asList(Value.createNullValue(int64), Value.createInt64Value(5))))
+        .inOrder();
+    assertThat(rows.get(1))
+        .containsExactly(
+            Value.createNullValue(int64),
+            Value.createNullValue(string),
+            Value.createNullValue(timestamp),
+            Value.createNullValue(arrayType))
+        .inOrder();
+
+    // A string table index that is out of range.
+    ByteString badIndex = ByteString.copyFrom(new byte[] {1, 2});
+    try {
+      Value.deserializeCompactRows(Arrays.asList(string), stringTable, badIndex);
+      fail();
+    } catch (IllegalArgumentException expected) {
+    }
+  }
+
   @Test
   public void testClassAndProtoSize() {
     assertWithMessage(
@@ -0,0 +1,172 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_COMMON_FREQUENT_ITEMS_SKETCH_H_
+#define ZETASQL_COMMON_FREQUENT_ITEMS_SKETCH_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+// Weight operations for FrequentItemsSketch over types with '+=' and '<'.
+template <typename Weight>
+struct DefaultFrequentItemsWeightOps {
+  absl::Status Add(const Weight& weight, Weight* sum) const {
+    *sum += weight;
+    return absl::OkStatus();
+  }
+  bool Less(const Weight& a, const Weight& b) const { return a < b; }
+};
+
+// Heavy-hitters sketch with bounded memory, used to implement
+// APPROX_TOP_COUNT and APPROX_TOP_SUM.
+//
+// The sketch tracks the total weight of at most 2 * 'capacity' keys. When
+// that limit is reached, only the 'capacity' heaviest keys are kept (a batched
+// variant of Misra-Gries/Space-Saving). A key can only be evicted while its
+// weight is below 1/capacity of the total weight, so heavy hitters are
+// retained, and the weights of keys that were never evicted are exact. While
+// fewer than 2 * 'capacity' distinct keys have been added, all results are
+// exact.
+//
+// 'WeightOps' provides
+//   absl::Status Add(const Weight& weight, Weight* sum) const;
+//   bool Less(const Weight& a, const Weight& b) const;
+// so that callers can use weights whose addition may fail (e.g. overflow).
+// Weights are expected to be non-negative.
+//
+// This class is not thread-safe.
+template <typename Key, typename Weight, typename Hash = absl::Hash<Key>,
+          typename Eq = std::equal_to<Key>,
+          typename WeightOps = DefaultFrequentItemsWeightOps<Weight>>
+class FrequentItemsSketch {
+ public:
+  explicit FrequentItemsSketch(int64_t capacity,
+                               WeightOps weight_ops = WeightOps())
+      : capacity_(std::max<int64_t>(capacity, 1)),
+        weight_ops_(std::move(weight_ops)) {}
+
+  FrequentItemsSketch(const FrequentItemsSketch&) = default;
+  FrequentItemsSketch(FrequentItemsSketch&&) = default;
+  FrequentItemsSketch& operator=(const FrequentItemsSketch&) = default;
+  FrequentItemsSketch& operator=(FrequentItemsSketch&&) = default;
+
+  // Adds 'weight' to the weight of 'key'. Returns an error if adding the
+  // weights fails, in which case the sketch is unchanged.
+  absl::Status Add(const Key& key, const Weight& weight) {
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      Weight sum = it->second.weight;
+      ZETASQL_RETURN_IF_ERROR(weight_ops_.Add(weight, &sum));
+      it->second.weight = std::move(sum);
+      return absl::OkStatus();
+    }
+    entries_.emplace(key, Entry{weight, next_sequence_++});
+    if (entries_.size() >= 2 * capacity_) Purge();
+    return absl::OkStatus();
+  }
+
+  // Merges 'other' into this sketch. 'other' must not be this sketch.
+  absl::Status Merge(const FrequentItemsSketch& other) {
+    for (const auto& [key, entry] : other.SortedEntries()) {
+      ZETASQL_RETURN_IF_ERROR(Add(*key, entry->weight));
+    }
+    return absl::OkStatus();
+  }
+
+  bool empty() const { return entries_.empty(); }
+  int64_t capacity() const { return capacity_; }
+
+  // Returns the number of keys currently tracked.
+  int64_t num_retained() const { return entries_.size(); }
+
+  // Returns up to 'n' keys with the largest weights, heaviest first. Keys
+  // with equal weights are returned in the order they were first added.
+  std::vector<std::pair<Key, Weight>> Top(int64_t n) const {
+    std::vector<std::pair<const Key*, const Entry*>> sorted = SortedEntries();
+    if (sorted.size() > n) sorted.resize(n);
+    std::vector<std::pair<Key, Weight>> top;
+    top.reserve(sorted.size());
+    for (const auto& [key, entry] : sorted) {
+      top.emplace_back(*key, entry->weight);
+    }
+    return top;
+  }
+
+  // Calls 'fn(key, weight)' on each tracked key, in no particular order.
+  template <typename Fn>
+  void ForEachRetained(Fn fn) const {
+    for (const auto& [key, entry] : entries_) fn(key, entry.weight);
+  }
+
+ private:
+  struct Entry {
+    Weight weight;
+    // Insertion order, used to break ties deterministically.
+    int64_t sequence;
+  };
+
+  // Returns the tracked entries sorted by decreasing weight, then by
+  // insertion order.
+  std::vector<std::pair<const Key*, const Entry*>> SortedEntries() const {
+    std::vector<std::pair<const Key*, const Entry*>> sorted;
+    sorted.reserve(entries_.size());
+    for (const auto& [key, entry] : entries_) {
+      sorted.emplace_back(&key, &entry);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [this](const std::pair<const Key*, const Entry*>& a,
+                     const std::pair<const Key*, const Entry*>& b) {
+                if (weight_ops_.Less(b.second->weight, a.second->weight)) {
+                  return true;
+                }
+                if (weight_ops_.Less(a.second->weight, b.second->weight)) {
+                  return false;
+                }
+                return a.second->sequence < b.second->sequence;
+              });
+    return sorted;
+  }
+
+  // Evicts all but the 'capacity_' heaviest keys.
+  void Purge() {
+    std::vector<std::pair<const Key*, const Entry*>> sorted = SortedEntries();
+    absl::flat_hash_map<Key, Entry, Hash, Eq> kept;
+    kept.reserve(capacity_);
+    for (int64_t i = 0; i < capacity_ && i < sorted.size(); ++i) {
+      kept.emplace(*sorted[i].first, *sorted[i].second);
+    }
+    entries_ = std::move(kept);
+  }
+
+  int64_t capacity_;
+  WeightOps weight_ops_;
+  absl::flat_hash_map<Key, Entry, Hash, Eq> entries_;
+  int64_t next_sequence_ = 0;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_COMMON_FREQUENT_ITEMS_SKETCH_H_
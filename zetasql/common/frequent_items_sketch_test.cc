@@ -0,0 +1,113 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/common/frequent_items_sketch.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+using ::zetasql_base::testing::StatusIs;
+
+using CountSketch = FrequentItemsSketch<std::string, int64_t>;
+
+TEST(FrequentItemsSketchTest, Empty) {
+  CountSketch sketch(10);
+  EXPECT_TRUE(sketch.empty());
+  EXPECT_TRUE(sketch.Top(5).empty());
+}
+
+TEST(FrequentItemsSketchTest, ExactForFewKeys) {
+  CountSketch sketch(10);
+  for (const char* key :
+       {"apple", "apple", "pear", "pear", "pear", "banana"}) {
+    ZETASQL_ASSERT_OK(sketch.Add(key, 1));
+  }
+  EXPECT_THAT(sketch.Top(2), ElementsAre(Pair("pear", 3), Pair("apple", 2)));
+  EXPECT_THAT(sketch.Top(10), ElementsAre(Pair("pear", 3), Pair("apple", 2),
+                                          Pair("banana", 1)));
+}
+
+TEST(FrequentItemsSketchTest, TiesAreInInsertionOrder) {
+  CountSketch sketch(10);
+  for (const char* key : {"c", "a", "b", "a", "c", "b"}) {
+    ZETASQL_ASSERT_OK(sketch.Add(key, 1));
+  }
+  EXPECT_THAT(sketch.Top(3),
+              ElementsAre(Pair("c", 2), Pair("a", 2), Pair("b", 2)));
+}
+
+TEST(FrequentItemsSketchTest, HeavyHittersSurviveManyKeys) {
+  FrequentItemsSketch<int64_t, int64_t> sketch(100);
+  for (int64_t i = 0; i < 100000; ++i) {
+    ZETASQL_ASSERT_OK(sketch.Add(i, 1));
+    if (i % 10 == 0) {
+      ZETASQL_ASSERT_OK(sketch.Add(-1, 1));
+    }
+    if (i % 20 == 0) {
+      ZETASQL_ASSERT_OK(sketch.Add(-2, 1));
+    }
+  }
+  EXPECT_LT(sketch.num_retained(), 2 * 100);
+  EXPECT_THAT(sketch.Top(2), ElementsAre(Pair(-1, 10000), Pair(-2, 5000)));
+}
+
+TEST(FrequentItemsSketchTest, Merge) {
+  CountSketch left(10);
+  CountSketch right(10);
+  ZETASQL_ASSERT_OK(left.Add("a", 5));
+  ZETASQL_ASSERT_OK(left.Add("b", 1));
+  ZETASQL_ASSERT_OK(right.Add("b", 7));
+  ZETASQL_ASSERT_OK(right.Add("c", 2));
+  ZETASQL_ASSERT_OK(left.Merge(right));
+  EXPECT_THAT(left.Top(3),
+              ElementsAre(Pair("b", 8), Pair("a", 5), Pair("c", 2)));
+}
+
+struct CheckedWeightOps {
+  absl::Status Add(const int64_t& weight, int64_t* sum) const {
+    if (*sum > std::numeric_limits<int64_t>::max() - weight) {
+      return absl::OutOfRangeError("overflow");
+    }
+    *sum += weight;
+    return absl::OkStatus();
+  }
+  bool Less(const int64_t& a, const int64_t& b) const { return a < b; }
+};
+
+TEST(FrequentItemsSketchTest, AddErrorLeavesSketchUnchanged) {
+  FrequentItemsSketch<std::string, int64_t, absl::Hash<std::string>,
+                      std::equal_to<std::string>, CheckedWeightOps>
+      sketch(10);
+  ZETASQL_ASSERT_OK(sketch.Add("a", std::numeric_limits<int64_t>::max()));
+  EXPECT_THAT(sketch.Add("a", 1), StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(sketch.Top(1),
+              ElementsAre(Pair("a", std::numeric_limits<int64_t>::max())));
+}
+
+}  // namespace
+}  // namespace zetasql
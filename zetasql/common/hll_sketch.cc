@@ -0,0 +1,389 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/common/hll_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/bits.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/status_builder.h"
+
+namespace zetasql {
+
+namespace {
+
+// Serialized layout:
+//   byte 0: format version (kFormatVersion)
+//   byte 1: value tag
+//   byte 2: precision
+//   byte 3: sparse precision
+//   byte 4: encoding (kSparseEncoding or kDenseEncoding)
+// followed by, for the sparse encoding, a varint entry count and the sorted
+// entries (index << 6 | rho) as varint deltas; and for the dense encoding,
+// exactly 2^precision register bytes.
+constexpr char kFormatVersion = 1;
+constexpr char kSparseEncoding = 0;
+constexpr char kDenseEncoding = 1;
+constexpr int kHeaderSize = 5;
+constexpr int kRhoBits = 6;
+
+// The sparse representation is converted to the dense one once it holds more
+// than 2^precision / kSparseToDenseRatio entries. A sparse entry costs roughly
+// as much as kSparseToDenseRatio dense registers.
+constexpr int64_t kSparseToDenseRatio = 8;
+
+void AppendVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+bool ReadVarint(absl::string_view* in, uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64 && !in->empty(); shift += 7) {
+    const uint8_t byte = static_cast<uint8_t>(in->front());
+    in->remove_prefix(1);
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+int SparsePrecisionFor(int precision) {
+  return std::min(precision + 5, HllSketch::kMaxSparsePrecision);
+}
+
+// Returns the largest register value for a sketch with 'index_bits' index
+// bits.
+int MaxRho(int index_bits) { return 64 - index_bits + 1; }
+
+// Splits 'hash' into a register index of 'index_bits' bits and the position
+// of the leftmost 1-bit in the remaining bits.
+void SplitHash(uint64_t hash, int index_bits, uint32_t* index, uint8_t* rho) {
+  *index = static_cast<uint32_t>(hash >> (64 - index_bits));
+  const uint64_t remainder = hash << index_bits;
+  *rho = remainder == 0
+             ? MaxRho(index_bits)
+             : zetasql_base::Bits::CountLeadingZeros64(remainder) + 1;
+}
+
+// Helper functions of the improved raw estimator from O. Ertl, "New
+// cardinality estimation algorithms for HyperLogLog sketches" (2017).
+double Sigma(double x) {
+  if (x == 1.0) return std::numeric_limits<double>::infinity();
+  double y = 1.0;
+  double z = x;
+  double z_prev;
+  do {
+    x *= x;
+    z_prev = z;
+    z += x * y;
+    y += y;
+  } while (z != z_prev);
+  return z;
+}
+
+double Tau(double x) {
+  if (x == 0.0 || x == 1.0) return 0.0;
+  double y = 1.0;
+  double z = 1.0 - x;
+  double z_prev;
+  do {
+    x = std::sqrt(x);
+    z_prev = z;
+    y *= 0.5;
+    z -= (1.0 - x) * (1.0 - x) * y;
+  } while (z != z_prev);
+  return z / 3.0;
+}
+
+}  // namespace
+
+absl::StatusOr<HllSketch> HllSketch::Create(int precision, uint8_t value_tag) {
+  if (precision < kMinPrecision || precision > kMaxPrecision) {
+    return ::zetasql_base::OutOfRangeErrorBuilder()
+           << "HLL sketch precision must be between " << kMinPrecision
+           << " and " << kMaxPrecision << ", but was " << precision;
+  }
+  return HllSketch(precision, SparsePrecisionFor(precision), value_tag);
+}
+
+void HllSketch::ReduceRegister(int from_bits, int to_bits, uint32_t* index,
+                               uint8_t* rho) {
+  if (from_bits == to_bits) return;
+  const int dropped_bits = from_bits - to_bits;
+  const uint32_t dropped = *index & ((uint32_t{1} << dropped_bits) - 1);
+  *index >>= dropped_bits;
+  if (dropped != 0) {
+    // The leftmost 1-bit is among the dropped index bits.
+    const int width = 32 - zetasql_base::Bits::CountLeadingZeros32(dropped);
+    *rho = static_cast<uint8_t>(dropped_bits - width + 1);
+  } else {
+    *rho = static_cast<uint8_t>(*rho + dropped_bits);
+  }
+}
+
+void HllSketch::UpdateSparse(uint32_t index, uint8_t rho) {
+  uint8_t& current = sparse_[index];
+  current = std::max(current, rho);
+}
+
+void HllSketch::UpdateDense(uint32_t index, uint8_t rho) {
+  uint8_t& current = registers_[index];
+  current = std::max(current, rho);
+}
+
+void HllSketch::AddHash(uint64_t hash) {
+  uint32_t index;
+  uint8_t rho;
+  if (is_sparse()) {
+    SplitHash(hash, sparse_precision_, &index, &rho);
+    UpdateSparse(index, rho);
+    MaybeConvertToDense();
+  } else {
+    SplitHash(hash, precision_, &index, &rho);
+    UpdateDense(index, rho);
+  }
+}
+
+void HllSketch::MaybeConvertToDense() {
+  if (static_cast<int64_t>(sparse_.size()) * kSparseToDenseRatio >
+      (int64_t{1} << precision_)) {
+    ConvertToDense();
+  }
+}
+
+void HllSketch::ConvertToDense() {
+  registers_.assign(size_t{1} << precision_, 0);
+  for (const auto& [sparse_index, sparse_rho] : sparse_) {
+    uint32_t index = sparse_index;
+    uint8_t rho = sparse_rho;
+    ReduceRegister(sparse_precision_, precision_, &index, &rho);
+    UpdateDense(index, rho);
+  }
+  absl::flat_hash_map<uint32_t, uint8_t>().swap(sparse_);
+}
+
+void HllSketch::Downgrade(int precision, int sparse_precision) {
+  if (is_sparse()) {
+    if (sparse_precision < sparse_precision_) {
+      absl::flat_hash_map<uint32_t, uint8_t> old_sparse;
+      old_sparse.swap(sparse_);
+      for (const auto& [old_index, old_rho] : old_sparse) {
+        uint32_t index = old_index;
+        uint8_t rho = old_rho;
+        ReduceRegister(sparse_precision_, sparse_precision, &index, &rho);
+        UpdateSparse(index, rho);
+      }
+    }
+  } else if (precision < precision_) {
+    std::vector<uint8_t> old_registers(size_t{1} << precision, 0);
+    old_registers.swap(registers_);
+    for (uint32_t i = 0; i < old_registers.size(); ++i) {
+      if (old_registers[i] == 0) continue;
+      uint32_t index = i;
+      uint8_t rho = old_registers[i];
+      ReduceRegister(precision_, precision, &index, &rho);
+      UpdateDense(index, rho);
+    }
+  }
+  precision_ = precision;
+  sparse_precision_ = sparse_precision;
+  if (is_sparse()) MaybeConvertToDense();
+}
+
+absl::Status HllSketch::Merge(const HllSketch& other) {
+  if (value_tag_ != other.value_tag_) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Cannot merge HLL sketches built over different value types";
+  }
+  Downgrade(std::min(precision_, other.precision_),
+            std::min(sparse_precision_, other.sparse_precision_));
+
+  if (other.is_sparse()) {
+    for (const auto& [other_index, other_rho] : other.sparse_) {
+      uint32_t index = other_index;
+      uint8_t rho = other_rho;
+      ReduceRegister(other.sparse_precision_, sparse_precision_, &index, &rho);
+      if (is_sparse()) {
+        UpdateSparse(index, rho);
+      } else {
+        ReduceRegister(sparse_precision_, precision_, &index, &rho);
+        UpdateDense(index, rho);
+      }
+    }
+    if (is_sparse()) MaybeConvertToDense();
+    return absl::OkStatus();
+  }
+
+  if (is_sparse()) ConvertToDense();
+  for (uint32_t i = 0; i < other.registers_.size(); ++i) {
+    if (other.registers_[i] == 0) continue;
+    uint32_t index = i;
+    uint8_t rho = other.registers_[i];
+    ReduceRegister(other.precision_, precision_, &index, &rho);
+    UpdateDense(index, rho);
+  }
+  return absl::OkStatus();
+}
+
+int64_t HllSketch::Estimate() const {
+  if (is_sparse()) {
+    // Linear counting at the sparse precision. The sparse representation is
+    // converted long before the registers fill up, so this stays in the range
+    // where linear counting is accurate.
+    if (sparse_.empty()) return 0;
+    const double m = static_cast<double>(int64_t{1} << sparse_precision_);
+    const double empty_registers = m - static_cast<double>(sparse_.size());
+    return std::llround(m * std::log(m / empty_registers));
+  }
+
+  const int q = 64 - precision_;
+  const double m = static_cast<double>(registers_.size());
+  std::vector<int64_t> histogram(q + 2, 0);
+  for (uint8_t rho : registers_) {
+    ++histogram[rho];
+  }
+  if (histogram[0] == static_cast<int64_t>(registers_.size())) return 0;
+
+  double z = m * Tau(1.0 - histogram[q + 1] / m);
+  for (int k = q; k >= 1; --k) {
+    z = 0.5 * (z + histogram[k]);
+  }
+  z += m * Sigma(histogram[0] / m);
+  const double alpha_infinity = 0.5 / std::log(2.0);
+  return std::llround(alpha_infinity * m * m / z);
+}
+
+std::string HllSketch::Serialize() const {
+  std::string out;
+  out.push_back(kFormatVersion);
+  out.push_back(static_cast<char>(value_tag_));
+  out.push_back(static_cast<char>(precision_));
+  out.push_back(static_cast<char>(sparse_precision_));
+  if (is_sparse()) {
+    out.push_back(kSparseEncoding);
+    std::vector<uint32_t> entries;
+    entries.reserve(sparse_.size());
+    for (const auto& [index, rho] : sparse_) {
+      entries.push_back((index << kRhoBits) | rho);
+    }
+    std::sort(entries.begin(), entries.end());
+    AppendVarint(entries.size(), &out);
+    uint32_t previous = 0;
+    for (uint32_t entry : entries) {
+      AppendVarint(entry - previous, &out);
+      previous = entry;
+    }
+  } else {
+    out.push_back(kDenseEncoding);
+    out.append(registers_.begin(), registers_.end());
+  }
+  return out;
+}
+
+absl::StatusOr<HllSketch> HllSketch::Deserialize(absl::string_view serialized) {
+  if (serialized.size() < kHeaderSize || serialized[0] != kFormatVersion) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Invalid HLL sketch header";
+  }
+  const uint8_t value_tag = static_cast<uint8_t>(serialized[1]);
+  const int precision = static_cast<uint8_t>(serialized[2]);
+  const int sparse_precision = static_cast<uint8_t>(serialized[3]);
+  const char encoding = serialized[4];
+  if (precision < kMinPrecision || precision > kMaxPrecision ||
+      sparse_precision < precision || sparse_precision > kMaxSparsePrecision) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Invalid HLL sketch precision";
+  }
+  HllSketch sketch(precision, sparse_precision, value_tag);
+  absl::string_view payload = serialized.substr(kHeaderSize);
+
+  if (encoding == kDenseEncoding) {
+    if (payload.size() != (size_t{1} << precision)) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder()
+             << "Invalid HLL sketch register count";
+    }
+    sketch.registers_.assign(payload.begin(), payload.end());
+    for (uint8_t rho : sketch.registers_) {
+      if (rho > MaxRho(precision)) {
+        return ::zetasql_base::InvalidArgumentErrorBuilder()
+               << "Invalid HLL sketch register value";
+      }
+    }
+    return sketch;
+  }
+
+  if (encoding != kSparseEncoding) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Invalid HLL sketch encoding";
+  }
+  uint64_t num_entries;
+  // Each entry takes at least one byte, which bounds the entry count before
+  // anything is allocated.
+  if (!ReadVarint(&payload, &num_entries) || num_entries > payload.size()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Invalid HLL sketch entry count";
+  }
+  sketch.sparse_.reserve(num_entries);
+  uint64_t entry = 0;
+  int64_t previous_index = -1;
+  for (uint64_t i = 0; i < num_entries; ++i) {
+    uint64_t delta;
+    if (!ReadVarint(&payload, &delta)) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder()
+             << "Truncated HLL sketch";
+    }
+    entry += delta;
+    const uint64_t index = entry >> kRhoBits;
+    const uint8_t rho = entry & ((1 << kRhoBits) - 1);
+    if (static_cast<int64_t>(index) <= previous_index ||
+        index >= (uint64_t{1} << sparse_precision) || rho == 0 ||
+        rho > MaxRho(sparse_precision)) {
+      return ::zetasql_base::InvalidArgumentErrorBuilder()
+             << "Invalid HLL sketch entry";
+    }
+    previous_index = static_cast<int64_t>(index);
+    sketch.sparse_[static_cast<uint32_t>(index)] = rho;
+  }
+  if (!payload.empty()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Trailing bytes in HLL sketch";
+  }
+  sketch.MaybeConvertToDense();
+  return sketch;
+}
+
+int64_t HllSketch::MemoryUsage() const {
+  // Each sparse slot holds a key/value pair plus one byte of control data.
+  return sizeof(*this) +
+         sparse_.capacity() *
+             (sizeof(std::pair<const uint32_t, uint8_t>) + 1) +
+         registers_.capacity();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,135 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_COMMON_HLL_SKETCH_H_
+#define ZETASQL_COMMON_HLL_SKETCH_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+
+// HyperLogLog++ cardinality sketch, used to implement APPROX_COUNT_DISTINCT
+// and the HLL_COUNT.* family of functions.
+//
+// The sketch consumes 64-bit hashes of the input values; hashing is left to
+// the caller so that the sketch does not depend on the ZetaSQL type system.
+// Callers that persist sketches must use a hash that is stable across
+// processes.
+//
+// A sketch starts out in the sparse representation, which stores only the
+// registers that have been touched, at a higher "sparse precision". Once the
+// sparse representation would use more memory than the dense one it is
+// converted to a dense array of 2^precision one-byte registers. Memory usage
+// is therefore bounded by 2^precision bytes (32KB at the default precision of
+// 15) regardless of the number of distinct inputs.
+//
+// Estimates use linear counting over the sparse registers, and the
+// bias-free "improved raw estimator" of Ertl (2017) over dense registers, so
+// no empirical bias correction tables are needed.
+//
+// Sketches carry an opaque 'value_tag' chosen by the caller (for example the
+// TypeKind of the input values). Sketches with different tags cannot be
+// merged. Sketches with different precisions can be merged; the result has
+// the smaller of the two precisions.
+//
+// This class is not thread-safe.
+class HllSketch {
+ public:
+  static constexpr int kMinPrecision = 10;
+  static constexpr int kMaxPrecision = 24;
+  static constexpr int kDefaultPrecision = 15;
+  static constexpr int kMaxSparsePrecision = 25;
+
+  // Creates an empty sketch. Returns an error if 'precision' is not within
+  // [kMinPrecision, kMaxPrecision].
+  static absl::StatusOr<HllSketch> Create(int precision, uint8_t value_tag);
+
+  // Parses a sketch previously produced by Serialize(). Returns an error if
+  // 'serialized' is not a valid sketch.
+  static absl::StatusOr<HllSketch> Deserialize(absl::string_view serialized);
+
+  HllSketch(const HllSketch&) = default;
+  HllSketch(HllSketch&&) = default;
+  HllSketch& operator=(const HllSketch&) = default;
+  HllSketch& operator=(HllSketch&&) = default;
+
+  // Adds a hashed value to the sketch.
+  void AddHash(uint64_t hash);
+
+  // Merges 'other' into this sketch. Returns an error if the sketches have
+  // different value tags. If the precisions differ, this sketch is downgraded
+  // to the smaller precision.
+  absl::Status Merge(const HllSketch& other);
+
+  // Returns the estimated number of distinct hashes added to the sketch.
+  int64_t Estimate() const;
+
+  // Returns the serialized form of the sketch. The format is private to this
+  // class and versioned; it is only meant to be read back by Deserialize().
+  std::string Serialize() const;
+
+  int precision() const { return precision_; }
+  int sparse_precision() const { return sparse_precision_; }
+  uint8_t value_tag() const { return value_tag_; }
+  bool is_sparse() const { return registers_.empty(); }
+
+  // Returns an estimate of the number of bytes used by the sketch, suitable
+  // for memory accounting.
+  int64_t MemoryUsage() const;
+
+ private:
+  HllSketch(int precision, int sparse_precision, uint8_t value_tag)
+      : precision_(precision),
+        sparse_precision_(sparse_precision),
+        value_tag_(value_tag) {}
+
+  // Maps a register ('index', 'rho') computed with 'from_bits' index bits to
+  // the equivalent register with 'to_bits' index bits. Requires
+  // 'to_bits' <= 'from_bits'.
+  static void ReduceRegister(int from_bits, int to_bits, uint32_t* index,
+                             uint8_t* rho);
+
+  void UpdateSparse(uint32_t index, uint8_t rho);
+  void UpdateDense(uint32_t index, uint8_t rho);
+
+  // Converts to the dense representation if the sparse representation has
+  // grown past the size of the dense one.
+  void MaybeConvertToDense();
+  void ConvertToDense();
+
+  // Lowers the precision of this sketch to 'precision' and 'sparse_precision'.
+  void Downgrade(int precision, int sparse_precision);
+
+  int precision_;
+  int sparse_precision_;
+  uint8_t value_tag_;
+  // Sparse registers, keyed by index at 'sparse_precision_'. Only used while
+  // 'registers_' is empty.
+  absl::flat_hash_map<uint32_t, uint8_t> sparse_;
+  // Dense registers, with 2^precision_ entries once converted.
+  std::vector<uint8_t> registers_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_COMMON_HLL_SKETCH_H_
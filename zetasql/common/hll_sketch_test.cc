@@ -0,0 +1,158 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/common/hll_sketch.h"
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+namespace {
+
+using ::zetasql_base::testing::StatusIs;
+
+// SplitMix64 finalizer, a cheap well-mixed hash for test inputs.
+uint64_t Mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+  return x ^ (x >> 31);
+}
+
+HllSketch MakeSketch(int precision, int64_t begin, int64_t end,
+                     uint8_t tag = 1) {
+  HllSketch sketch = HllSketch::Create(precision, tag).value();
+  for (int64_t i = begin; i < end; ++i) {
+    sketch.AddHash(Mix(i));
+  }
+  return sketch;
+}
+
+// Returns true if 'estimate' is within 'relative_error' of 'expected'.
+bool IsClose(int64_t estimate, int64_t expected, double relative_error) {
+  return std::abs(static_cast<double>(estimate - expected)) <=
+         relative_error * expected;
+}
+
+TEST(HllSketchTest, InvalidPrecision) {
+  EXPECT_THAT(HllSketch::Create(9, 0),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(HllSketch::Create(25, 0),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(HllSketchTest, Empty) {
+  HllSketch sketch = MakeSketch(HllSketch::kDefaultPrecision, 0, 0);
+  EXPECT_TRUE(sketch.is_sparse());
+  EXPECT_EQ(sketch.Estimate(), 0);
+}
+
+TEST(HllSketchTest, SmallCardinalitiesAreExact) {
+  for (int64_t n : {1, 2, 10, 100, 500}) {
+    HllSketch sketch = MakeSketch(HllSketch::kDefaultPrecision, 0, n);
+    // Duplicates do not change the estimate.
+    for (int64_t i = 0; i < n; ++i) {
+      sketch.AddHash(Mix(i));
+    }
+    EXPECT_TRUE(sketch.is_sparse());
+    EXPECT_EQ(sketch.Estimate(), n);
+  }
+}
+
+TEST(HllSketchTest, LargeCardinalities) {
+  for (int precision : {10, 15, 20}) {
+    for (int64_t n : {10000, 100000, 1000000}) {
+      HllSketch sketch = MakeSketch(precision, 0, n);
+      // The standard error is 1.04 / sqrt(2^precision); allow four of them.
+      const double error = 4 * 1.04 / std::sqrt(1 << precision);
+      EXPECT_TRUE(IsClose(sketch.Estimate(), n, error))
+          << "precision=" << precision << " n=" << n
+          << " estimate=" << sketch.Estimate();
+    }
+  }
+}
+
+TEST(HllSketchTest, MemoryIsBounded) {
+  HllSketch sketch = MakeSketch(HllSketch::kDefaultPrecision, 0, 1000000);
+  EXPECT_FALSE(sketch.is_sparse());
+  EXPECT_LT(sketch.MemoryUsage(),
+            (int64_t{1} << HllSketch::kDefaultPrecision) + 1024);
+}
+
+TEST(HllSketchTest, SerializeRoundTrip) {
+  for (int64_t n : {0, 1, 100, 100000}) {
+    HllSketch sketch = MakeSketch(14, 0, n, /*tag=*/7);
+    ZETASQL_ASSERT_OK_AND_ASSIGN(HllSketch copy,
+                         HllSketch::Deserialize(sketch.Serialize()));
+    EXPECT_EQ(copy.precision(), 14);
+    EXPECT_EQ(copy.value_tag(), 7);
+    EXPECT_EQ(copy.is_sparse(), sketch.is_sparse());
+    EXPECT_EQ(copy.Estimate(), sketch.Estimate());
+    EXPECT_EQ(copy.Serialize(), sketch.Serialize());
+  }
+}
+
+TEST(HllSketchTest, DeserializeInvalid) {
+  EXPECT_FALSE(HllSketch::Deserialize("").ok());
+  EXPECT_FALSE(HllSketch::Deserialize("garbage").ok());
+
+  std::string sparse = MakeSketch(12, 0, 50).Serialize();
+  EXPECT_FALSE(HllSketch::Deserialize(sparse + "x").ok());
+  sparse.pop_back();
+  EXPECT_FALSE(HllSketch::Deserialize(sparse).ok());
+
+  std::string dense = MakeSketch(10, 0, 100000).Serialize();
+  EXPECT_FALSE(HllSketch::Deserialize(dense + "x").ok());
+  dense.back() = static_cast<char>(100);
+  EXPECT_FALSE(HllSketch::Deserialize(dense).ok());
+}
+
+TEST(HllSketchTest, MergeSparse) {
+  HllSketch sketch = MakeSketch(15, 0, 5);
+  ZETASQL_ASSERT_OK(sketch.Merge(MakeSketch(16, 3, 6)));
+  ZETASQL_ASSERT_OK(sketch.Merge(MakeSketch(17, 5, 10)));
+  EXPECT_EQ(sketch.precision(), 15);
+  EXPECT_EQ(sketch.Estimate(), 10);
+}
+
+TEST(HllSketchTest, MergeDense) {
+  HllSketch sketch = MakeSketch(14, 0, 60000);
+  ZETASQL_ASSERT_OK(sketch.Merge(MakeSketch(12, 40000, 100000)));
+  ZETASQL_ASSERT_OK(sketch.Merge(MakeSketch(16, 90000, 90100)));
+  EXPECT_EQ(sketch.precision(), 12);
+  EXPECT_FALSE(sketch.is_sparse());
+  EXPECT_TRUE(IsClose(sketch.Estimate(), 100000, 4 * 1.04 / 64));
+}
+
+TEST(HllSketchTest, MergeMatchesSingleSketch) {
+  HllSketch merged = MakeSketch(13, 0, 30000);
+  ZETASQL_ASSERT_OK(merged.Merge(MakeSketch(13, 20000, 50000)));
+  EXPECT_EQ(merged.Serialize(), MakeSketch(13, 0, 50000).Serialize());
+}
+
+TEST(HllSketchTest, MergeIncompatibleTags) {
+  HllSketch sketch = MakeSketch(15, 0, 5, /*tag=*/1);
+  EXPECT_THAT(sketch.Merge(MakeSketch(15, 0, 5, /*tag=*/2)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -0,0 +1,213 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_COMMON_KLL_SKETCH_H_
+#define ZETASQL_COMMON_KLL_SKETCH_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/logging.h"
+#include "absl/types/optional.h"
+
+namespace zetasql {
+
+// KLL quantile sketch (Karnin, Lang and Liberty, 2016), used to implement
+// APPROX_QUANTILES with memory that does not grow with the number of inputs.
+//
+// The sketch keeps a hierarchy of "compactors". Items are added to level 0.
+// When a level fills up it is sorted and every other item is promoted to the
+// next level, where each item stands for twice as many inputs. Level capacities
+// shrink geometrically towards the bottom, so the sketch retains O(k) items
+// and the rank error is O(1/k) with high probability.
+//
+// Until more than 'k' items have been added, nothing is compacted and
+// quantiles are exact. The minimum and maximum are always tracked exactly.
+//
+// Compaction alternates between keeping the odd and the even items instead of
+// flipping a random coin, so the results only depend on the input order.
+//
+// 'Less' must be a strict weak ordering over T. This class is not thread-safe.
+template <typename T, typename Less = std::less<T>>
+class KllSketch {
+ public:
+  static constexpr int kMinK = 8;
+  static constexpr int kDefaultK = 200;
+
+  // 'k' controls the accuracy and size of the sketch; it is clamped to at
+  // least kMinK.
+  explicit KllSketch(int k = kDefaultK, Less less = Less())
+      : k_(std::max(k, kMinK)), less_(std::move(less)), levels_(1) {}
+
+  KllSketch(const KllSketch&) = default;
+  KllSketch(KllSketch&&) = default;
+  KllSketch& operator=(const KllSketch&) = default;
+  KllSketch& operator=(KllSketch&&) = default;
+
+  void Add(T item) {
+    UpdateMinMax(item);
+    ++num_items_;
+    levels_[0].push_back(std::move(item));
+    ++num_retained_;
+    Compress();
+  }
+
+  // Merges 'other' into this sketch. Both sketches should use the same 'k';
+  // the result keeps the 'k' of this sketch.
+  void Merge(const KllSketch& other) {
+    if (other.empty()) return;
+    UpdateMinMax(*other.min_);
+    UpdateMinMax(*other.max_);
+    num_items_ += other.num_items_;
+    if (levels_.size() < other.levels_.size()) {
+      levels_.resize(other.levels_.size());
+    }
+    for (int level = 0; level < other.levels_.size(); ++level) {
+      levels_[level].insert(levels_[level].end(), other.levels_[level].begin(),
+                            other.levels_[level].end());
+    }
+    num_retained_ += other.num_retained_;
+    Compress();
+  }
+
+  bool empty() const { return num_items_ == 0; }
+  int k() const { return k_; }
+
+  // Returns the number of items added to the sketch, including through
+  // Merge().
+  int64_t num_items() const { return num_items_; }
+
+  // Returns the number of items currently stored in the sketch.
+  int64_t num_retained() const { return num_retained_; }
+
+  // Requires !empty().
+  const T& min() const { return *min_; }
+  const T& max() const { return *max_; }
+
+  // Returns 'number' + 1 approximate quantile boundaries: the minimum, the
+  // approximate 1/number, 2/number, ... quantiles, and the maximum. The i-th
+  // boundary is the smallest retained item whose estimated rank is at least
+  // ceil(i * num_items() / number). Requires !empty() and 'number' > 0.
+  std::vector<T> Quantiles(int64_t number) const {
+    ZETASQL_DCHECK(!empty());
+    ZETASQL_DCHECK_GT(number, 0);
+    std::vector<std::pair<const T*, int64_t>> weighted;
+    weighted.reserve(num_retained_);
+    for (int level = 0; level < levels_.size(); ++level) {
+      for (const T& item : levels_[level]) {
+        weighted.emplace_back(&item, int64_t{1} << level);
+      }
+    }
+    std::stable_sort(weighted.begin(), weighted.end(),
+                     [this](const std::pair<const T*, int64_t>& a,
+                            const std::pair<const T*, int64_t>& b) {
+                       return less_(*a.first, *b.first);
+                     });
+
+    std::vector<T> quantiles;
+    quantiles.reserve(number + 1);
+    quantiles.push_back(*min_);
+    int64_t cumulative_weight = 0;
+    int pos = 0;
+    for (int64_t i = 1; i < number; ++i) {
+      // ceil(i * n / number), computed in 128 bits to avoid overflow.
+      const int64_t target_rank = static_cast<int64_t>(
+          (static_cast<__int128>(i) * num_items_ + number - 1) / number);
+      while (pos < weighted.size() - 1 &&
+             cumulative_weight + weighted[pos].second < target_rank) {
+        cumulative_weight += weighted[pos].second;
+        ++pos;
+      }
+      quantiles.push_back(*weighted[pos].first);
+    }
+    quantiles.push_back(*max_);
+    return quantiles;
+  }
+
+  // Calls 'fn' on each retained item, in no particular order.
+  template <typename Fn>
+  void ForEachRetained(Fn fn) const {
+    for (const std::vector<T>& level : levels_) {
+      for (const T& item : level) fn(item);
+    }
+  }
+
+ private:
+  void UpdateMinMax(const T& item) {
+    if (!min_.has_value() || less_(item, *min_)) min_ = item;
+    if (!max_.has_value() || less_(*max_, item)) max_ = item;
+  }
+
+  // Returns the capacity of 'level'. The top level has capacity 'k_', and
+  // each level below it has 2/3 of the capacity of the level above.
+  int64_t LevelCapacity(int level) const {
+    const int depth = static_cast<int>(levels_.size()) - 1 - level;
+    return std::max<int64_t>(
+        2, static_cast<int64_t>(std::ceil(k_ * std::pow(2.0 / 3.0, depth))));
+  }
+
+  // Compacts levels until the sketch fits in its total capacity.
+  void Compress() {
+    while (true) {
+      int64_t total_capacity = 0;
+      for (int level = 0; level < levels_.size(); ++level) {
+        total_capacity += LevelCapacity(level);
+      }
+      if (num_retained_ <= total_capacity) return;
+      for (int level = 0; level < levels_.size(); ++level) {
+        if (levels_[level].size() >= LevelCapacity(level)) {
+          CompactLevel(level);
+          break;
+        }
+      }
+    }
+  }
+
+  // Sorts 'level' and promotes every other item to the level above. If the
+  // level has an odd number of items, the smallest one stays behind.
+  void CompactLevel(int level) {
+    if (level + 1 == levels_.size()) levels_.emplace_back();
+    std::vector<T>& items = levels_[level];
+    std::sort(items.begin(), items.end(), less_);
+    const int64_t begin = items.size() % 2;
+    const int64_t offset = odd_compaction_ ? 1 : 0;
+    odd_compaction_ = !odd_compaction_;
+    std::vector<T>& next = levels_[level + 1];
+    for (int64_t i = begin + offset; i < items.size(); i += 2) {
+      next.push_back(std::move(items[i]));
+    }
+    num_retained_ -= (items.size() - begin) / 2;
+    items.erase(items.begin() + begin, items.end());
+  }
+
+  int k_;
+  Less less_;
+  int64_t num_items_ = 0;
+  int64_t num_retained_ = 0;
+  absl::optional<T> min_;
+  absl::optional<T> max_;
+  // Items at level 'i' each represent 2^i inputs.
+  std::vector<std::vector<T>> levels_;
+  bool odd_compaction_ = false;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_COMMON_KLL_SKETCH_H_
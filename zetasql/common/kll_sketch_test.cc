@@ -0,0 +1,135 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/common/kll_sketch.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Returns a permutation of [0, n) that is far from sorted.
+std::vector<int64_t> Shuffled(int64_t n) {
+  std::vector<int64_t> values;
+  values.reserve(n);
+  // 7919 is prime, so i * 7919 mod n is a permutation when n is not a
+  // multiple of it.
+  for (int64_t i = 0; i < n; ++i) {
+    values.push_back((i * 7919) % n);
+  }
+  return values;
+}
+
+TEST(KllSketchTest, Empty) {
+  KllSketch<int64_t> sketch;
+  EXPECT_TRUE(sketch.empty());
+  EXPECT_EQ(sketch.num_items(), 0);
+  EXPECT_EQ(sketch.num_retained(), 0);
+}
+
+TEST(KllSketchTest, SmallInputsAreExact) {
+  KllSketch<int64_t> sketch;
+  for (int64_t value : {1, 1, 1, 4, 5, 6, 7, 8, 9, 10}) {
+    sketch.Add(value);
+  }
+  EXPECT_THAT(sketch.Quantiles(1), ElementsAre(1, 10));
+  EXPECT_THAT(sketch.Quantiles(2), ElementsAre(1, 5, 10));
+  EXPECT_THAT(sketch.Quantiles(5), ElementsAre(1, 1, 4, 6, 8, 10));
+}
+
+TEST(KllSketchTest, MoreQuantilesThanItems) {
+  KllSketch<std::string> sketch;
+  sketch.Add("b");
+  sketch.Add("a");
+  EXPECT_THAT(sketch.Quantiles(4), ElementsAre("a", "a", "a", "b", "b"));
+}
+
+TEST(KllSketchTest, CustomOrdering) {
+  KllSketch<int64_t, std::greater<int64_t>> sketch;
+  for (int64_t value = 0; value < 5; ++value) {
+    sketch.Add(value);
+  }
+  EXPECT_EQ(sketch.min(), 4);
+  EXPECT_EQ(sketch.max(), 0);
+  EXPECT_THAT(sketch.Quantiles(2), ElementsAre(4, 2, 0));
+}
+
+TEST(KllSketchTest, LargeInputIsBoundedAndAccurate) {
+  const int64_t n = 1000000;
+  KllSketch<int64_t> sketch(/*k=*/200);
+  for (int64_t value : Shuffled(n)) {
+    sketch.Add(value);
+  }
+  EXPECT_EQ(sketch.num_items(), n);
+  EXPECT_LT(sketch.num_retained(), 3 * 200 + 64);
+
+  const int64_t number = 10;
+  std::vector<int64_t> quantiles = sketch.Quantiles(number);
+  ASSERT_EQ(quantiles.size(), number + 1);
+  EXPECT_EQ(quantiles.front(), 0);
+  EXPECT_EQ(quantiles.back(), n - 1);
+  for (int64_t i = 1; i < number; ++i) {
+    EXPECT_LE(std::abs(quantiles[i] - i * n / number), n / 50)
+        << "quantile " << i;
+    EXPECT_LE(quantiles[i - 1], quantiles[i]);
+  }
+}
+
+TEST(KllSketchTest, Merge) {
+  const int64_t n = 200000;
+  KllSketch<int64_t> left(/*k=*/200);
+  KllSketch<int64_t> right(/*k=*/200);
+  for (int64_t value : Shuffled(n)) {
+    (value % 2 == 0 ? left : right).Add(value);
+  }
+  left.Merge(right);
+  EXPECT_EQ(left.num_items(), n);
+  EXPECT_LT(left.num_retained(), 3 * 200 + 64);
+  std::vector<int64_t> quantiles = left.Quantiles(4);
+  EXPECT_EQ(quantiles.front(), 0);
+  EXPECT_EQ(quantiles.back(), n - 1);
+  EXPECT_LE(std::abs(quantiles[2] - n / 2), n / 50);
+
+  KllSketch<int64_t> empty;
+  left.Merge(empty);
+  EXPECT_EQ(left.num_items(), n);
+  empty.Merge(left);
+  EXPECT_EQ(empty.num_items(), n);
+  EXPECT_EQ(empty.min(), 0);
+  EXPECT_EQ(empty.max(), n - 1);
+}
+
+TEST(KllSketchTest, Deterministic) {
+  KllSketch<int64_t> a(/*k=*/50);
+  KllSketch<int64_t> b(/*k=*/50);
+  for (int64_t value : Shuffled(10000)) {
+    a.Add(value);
+    b.Add(value);
+  }
+  EXPECT_EQ(a.Quantiles(100), b.Quantiles(100));
+}
+
+}  // namespace
+}  // namespace zetasql
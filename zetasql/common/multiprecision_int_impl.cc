@@ -16,22 +16,51 @@
 
 #include "zetasql/common/multiprecision_int_impl.h"
 
+#include <array>
 #include <cstdint>
 
 namespace zetasql {
 namespace multiprecision_int_impl {
 
+// "00", "01", ..., "99" concatenated.
+constexpr std::array<char, 200> kTwoDigits = [] {
+  std::array<char, 200> digits{};
+  for (int i = 0; i < 100; ++i) {
+    digits[2 * i] = static_cast<char>('0' + i / 10);
+    digits[2 * i + 1] = static_cast<char>('0' + i % 10);
+  }
+  return digits;
+}();
+
 inline int Print9Digits(uint32_t digits, bool skip_leading_zeros,
                         char output[9]) {
-  for (int j = 8; j >= 0; --j) {
-    output[j] = static_cast<char>(digits % 10) + '0';
-    digits /= 10;
-    if (skip_leading_zeros && digits == 0) {
-      memmove(output, output + j, 9 - j);
-      return 9 - j;
+  int num_digits = 9;
+  if (skip_leading_zeros) {
+    static constexpr uint32_t kPowersOf10[] = {
+        10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    num_digits = 1;
+    while (num_digits < 9 && digits >= kPowersOf10[num_digits - 1]) {
+      ++num_digits;
     }
   }
-  return 9;
+  // Print two digits at a time from the right end.
+  char* ptr = output + num_digits;
+  while (digits >= 100) {
+    ptr -= 2;
+    memcpy(ptr, &kTwoDigits[(digits % 100) * 2], 2);
+    digits /= 100;
+  }
+  if (digits >= 10) {
+    ptr -= 2;
+    memcpy(ptr, &kTwoDigits[digits * 2], 2);
+  } else {
+    *--ptr = static_cast<char>('0' + digits);
+  }
+  // Without skip_leading_zeros, pad on the left to 9 digits.
+  if (ptr != output) {
+    memset(output, '0', ptr - output);
+  }
+  return num_digits;
 }
 
 void AppendSegmentsToString(const uint32_t segments[], size_t num_segments,
@@ -49,6 +49,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 #include "absl/types/optional.h"
 #include "zetasql/base/mathutil.h"
 
@@ -1412,6 +1413,28 @@ TYPED_TEST(FixedIntGoldenDataTest, ParseFromStringStrict) {
   }
 }
 
+// Parsing handles 8 digits at a time; verify that every digit value and every
+// kind of invalid character is recognized at every position of a chunk.
+TEST(FixedUintTest, ParseFromStringStrictEveryPosition) {
+  const std::string digits = "123456789012345678901234567890";
+  for (size_t pos = 0; pos < digits.size(); ++pos) {
+    for (char c = '0'; c <= '9'; ++c) {
+      std::string str = digits;
+      str[pos] = c;
+      FixedUint<64, 2> value;
+      EXPECT_TRUE(value.ParseFromStringStrict(str)) << str;
+      EXPECT_EQ(absl::StripPrefix(str, "0"), value.ToString());
+    }
+    for (char c : {'/', ':', ' ', '.', '-', 'a', '\0', '\x80', '\xb0',
+                   '\xff'}) {
+      std::string str = digits;
+      str[pos] = c;
+      FixedUint<64, 2> value;
+      EXPECT_FALSE(value.ParseFromStringStrict(str)) << str;
+    }
+  }
+}
+
 template <typename TypeParam>
 bool SplitAndParseStringSegments(absl::string_view str, TypeParam* value) {
   std::vector<absl::string_view> parts = absl::StrSplit(str, ',');
@@ -17,6 +17,7 @@
 #include "zetasql/common/utf_util.h"
 
 #include <cstdint>
+#include <cstring>
 
 #include "zetasql/base/logging.h"
 #include "absl/strings/ascii.h"
@@ -26,12 +27,42 @@
 #include "unicode/utf8.h"
 #include "zetasql/base/ret_check.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace zetasql {
 
 constexpr absl::string_view kReplacementCharacter = "\uFFFD";
 
+absl::string_view::size_type SpanAscii(absl::string_view s) {
+  const char* const begin = s.data();
+  const char* const end = begin + s.length();
+  const char* p = begin;
+#ifdef __SSE2__
+  // _mm_movemask_epi8 collects the high bit of each byte.
+  for (; end - p >= 16; p += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    if (_mm_movemask_epi8(chunk) != 0) break;
+  }
+#endif
+  for (; end - p >= 8; p += 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    if ((word & 0x8080808080808080ull) != 0) break;
+  }
+  // Find the exact position of the first non-ASCII byte, if any.
+  for (; p < end; ++p) {
+    if ((static_cast<uint8_t>(*p) & 0x80) != 0) break;
+  }
+  return p - begin;
+}
+
 static int SpanWellFormedUTF8(const char* s, int length) {
   for (int i = 0; i < length;) {
+    // ASCII characters are always well formed.
+    i += static_cast<int>(SpanAscii(absl::string_view(s + i, length - i)));
+    if (i == length) break;
     int start = i;
     UChar32 c;
     U8_NEXT(s, i, length, c);
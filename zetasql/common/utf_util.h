@@ -29,6 +29,15 @@
 // and CheckAndCastStrLength.
 namespace zetasql {
 
+// Returns the length of the longest prefix of `s` that only contains ASCII
+// characters (bytes below 0x80). Scans 16 bytes at a time with SSE2 where
+// available, and 8 bytes at a time otherwise.
+absl::string_view::size_type SpanAscii(absl::string_view s);
+
+inline bool IsAscii(absl::string_view s) {
+  return SpanAscii(s) == s.length();
+}
+
 // Returns the length of `s` that is well formed UTF8. This will return
 // `s.length()` if it is completely well formed UTF8.
 absl::string_view::size_type SpanWellFormedUTF8(absl::string_view s);
@@ -75,6 +75,38 @@ TEST(UtfUtilTest, WellFormedUTF8) {
   TestIllFormedString("ABC\xf0\x90", 3);
 }
 
+TEST(UtfUtilTest, WellFormedUTF8LongStrings) {
+  // Exercises the ASCII fast path with a non-ASCII character at every
+  // position relative to the 8 and 16 byte blocks it scans.
+  for (int i = 0; i < 40; ++i) {
+    std::string str(40, 'a');
+    TestWellFormedString(str.replace(i, 1, "\xc2\xbf"));
+    str = std::string(40, 'a');
+    TestIllFormedString(str.replace(i, 1, "\xc2"), i);
+  }
+}
+
+TEST(UtfUtilTest, SpanAscii) {
+  EXPECT_EQ(SpanAscii(""), 0);
+  EXPECT_EQ(SpanAscii("abc"), 3);
+  EXPECT_EQ(SpanAscii("\xc2\xbf"), 0);
+  EXPECT_EQ(SpanAscii(kInvalidUtf8Str), 1);
+  EXPECT_TRUE(IsAscii(""));
+  EXPECT_TRUE(IsAscii("\x7f\n\t abc"));
+  EXPECT_FALSE(IsAscii("\xe8\xb0\xb7"));
+
+  for (int length = 1; length < 50; ++length) {
+    const std::string ascii(length, 'x');
+    EXPECT_EQ(SpanAscii(ascii), length);
+    for (int i = 0; i < length; ++i) {
+      std::string str = ascii;
+      str[i] = '\x80';
+      EXPECT_EQ(SpanAscii(str), i) << "length=" << length;
+      EXPECT_FALSE(IsAscii(str));
+    }
+  }
+}
+
 void TestCoerce(std::string str, std::string expected) {
   if (str == expected) {
     // Sanity check.
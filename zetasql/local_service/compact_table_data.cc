@@ -0,0 +1,484 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/local_service/compact_table_data.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/civil_time.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "zetasql/public/interval_value.h"
+#include "zetasql/public/numeric_value.h"
+#include "absl/base/casts.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "zetasql/base/endian.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_builder.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+
+namespace {
+
+constexpr char kNull = 0;
+constexpr char kNotNull = 1;
+
+// Rows without columns take no bytes, so their count is not bounded by the
+// size of the encoding.
+constexpr int64_t kMaxRowsWithoutColumns = int64_t{1} << 20;
+
+// Reads the encoding written by CompactTableDataWriter.
+class CompactTableDataReader {
+ public:
+  explicit CompactTableDataReader(const CompactTableData& data)
+      : data_(data), remaining_(data.rows()) {}
+
+  bool AtEnd() const { return remaining_.empty(); }
+
+  absl::StatusOr<Value> ReadValue(const Type* type);
+
+ private:
+  absl::StatusOr<uint64_t> ReadVarint();
+  absl::StatusOr<int64_t> ReadZigZag() {
+    ZETASQL_ASSIGN_OR_RETURN(const uint64_t value, ReadVarint());
+    return static_cast<int64_t>((value >> 1) ^ -(value & 1));
+  }
+  absl::StatusOr<absl::string_view> ReadBytes(int64_t length);
+  absl::StatusOr<absl::string_view> ReadLengthPrefixedBytes() {
+    ZETASQL_ASSIGN_OR_RETURN(const uint64_t length, ReadVarint());
+    return ReadBytes(length);
+  }
+  absl::StatusOr<const std::string*> ReadStringTableEntry();
+
+  absl::Status Truncated() const {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "Truncated CompactTableData";
+  }
+
+  const CompactTableData& data_;
+  absl::string_view remaining_;
+};
+
+absl::StatusOr<uint64_t> CompactTableDataReader::ReadVarint() {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (remaining_.empty()) {
+      return Truncated();
+    }
+    const uint8_t byte = static_cast<uint8_t>(remaining_.front());
+    remaining_.remove_prefix(1);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  return zetasql_base::InvalidArgumentErrorBuilder()
+         << "Invalid varint in CompactTableData";
+}
+
+absl::StatusOr<absl::string_view> CompactTableDataReader::ReadBytes(
+    int64_t length) {
+  if (length < 0 || length > remaining_.size()) {
+    return Truncated();
+  }
+  const absl::string_view bytes = remaining_.substr(0, length);
+  remaining_.remove_prefix(length);
+  return bytes;
+}
+
+absl::StatusOr<const std::string*>
+CompactTableDataReader::ReadStringTableEntry() {
+  ZETASQL_ASSIGN_OR_RETURN(const uint64_t index, ReadVarint());
+  if (index >= data_.string_table_size()) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "Invalid string table index in CompactTableData: " << index;
+  }
+  return &data_.string_table(index);
+}
+
+absl::StatusOr<Value> CompactTableDataReader::ReadValue(const Type* type) {
+  ZETASQL_ASSIGN_OR_RETURN(absl::string_view marker, ReadBytes(1));
+  if (marker[0] == kNull) {
+    return Value::Null(type);
+  }
+  if (marker[0] != kNotNull) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "Invalid NULL marker in CompactTableData";
+  }
+  switch (type->kind()) {
+    case TYPE_BOOL: {
+      ZETASQL_ASSIGN_OR_RETURN(absl::string_view byte, ReadBytes(1));
+      return Value::Bool(byte[0] != 0);
+    }
+    case TYPE_INT32: {
+      ZETASQL_ASSIGN_OR_RETURN(const int64_t value, ReadZigZag());
+      return Value::Int32(static_cast<int32_t>(value));
+    }
+    case TYPE_INT64: {
+      ZETASQL_ASSIGN_OR_RETURN(const int64_t value, ReadZigZag());
+      return Value::Int64(value);
+    }
+    case TYPE_DATE: {
+      ZETASQL_ASSIGN_OR_RETURN(const int64_t value, ReadZigZag());
+      if (value < std::numeric_limits<int32_t>::min() ||
+          value > std::numeric_limits<int32_t>::max() ||
+          !functions::IsValidDate(static_cast<int32_t>(value))) {
+        return zetasql_base::InvalidArgumentErrorBuilder()
+               << "Invalid DATE in CompactTableData: " << value;
+      }
+      return Value::Date(static_cast<int32_t>(value));
+    }
+    case TYPE_ENUM: {
+      ZETASQL_ASSIGN_OR_RETURN(const int64_t value, ReadZigZag());
+      Value enum_value = Value::Enum(type->AsEnum(), value);
+      if (!enum_value.is_valid()) {
+        return zetasql_base::InvalidArgumentErrorBuilder()
+               << "Invalid value for " << type->DebugString()
+               << " in CompactTableData: " << value;
+      }
+      return enum_value;
+    }
+    case TYPE_UINT32: {
+      ZETASQL_ASSIGN_OR_RETURN(const uint64_t value, ReadVarint());
+      return Value::Uint32(static_cast<uint32_t>(value));
+    }
+    case TYPE_UINT64: {
+      ZETASQL_ASSIGN_OR_RETURN(const uint64_t value, ReadVarint());
+      return Value::Uint64(value);
+    }
+    case TYPE_FLOAT: {
+      ZETASQL_ASSIGN_OR_RETURN(absl::string_view bytes, ReadBytes(4));
+      return Value::Float(absl::bit_cast<float>(
+          zetasql_base::LittleEndian::Load32(bytes.data())));
+    }
+    case TYPE_DOUBLE: {
+      ZETASQL_ASSIGN_OR_RETURN(absl::string_view bytes, ReadBytes(8));
+      return Value::Double(absl::bit_cast<double>(
+          zetasql_base::LittleEndian::Load64(bytes.data())));
+    }
+    case TYPE_STRING: {
+      ZETASQL_ASSIGN_OR_RETURN(const std::string* value, ReadStringTableEntry());
+      return Value::String(*value);
+    }
+    case TYPE_BYTES: {
+      ZETASQL_ASSIGN_OR_RETURN(const std::string* value, ReadStringTableEntry());
+      return Value::Bytes(*value);
+    }
+    case TYPE_JSON: {
+      ZETASQL_ASSIGN_OR_RETURN(const std::string* value, ReadStringTableEntry());
+      return Value::UnvalidatedJsonString(*value);
+    }
+    case TYPE_PROTO: {
+      ZETASQL_ASSIGN_OR_RETURN(const std::string* value, ReadStringTableEntry());
+      return Value::Proto(type->AsProto(), absl::Cord(*value));
+    }
+    case TYPE_TIMESTAMP: {
+      ZETASQL_ASSIGN_OR_RETURN(const int64_t seconds, ReadZigZag());
+      ZETASQL_ASSIGN_OR_RETURN(const uint64_t nanos, ReadVarint());
+      if (nanos >= 1000000000) {
+        return zetasql_base::InvalidArgumentErrorBuilder()
+               << "Invalid TIMESTAMP nanoseconds in CompactTableData: "
+               << nanos;
+      }
+      const absl::Time timestamp =
+          absl::FromUnixSeconds(seconds) + absl::Nanoseconds(nanos);
+      if (!functions::IsValidTime(timestamp)) {
+        return zetasql_base::InvalidArgumentErrorBuilder()
+               << "Invalid TIMESTAMP in CompactTableData: " << seconds
+               << " seconds";
+      }
+      return Value::Timestamp(timestamp);
+    }
+    case TYPE_DATETIME: {
+      ZETASQL_ASSIGN_OR_RETURN(const uint64_t bit_field, ReadVarint());
+      ZETASQL_ASSIGN_OR_RETURN(const uint64_t nanos, ReadVarint());
+      const DatetimeValue datetime = DatetimeValue::FromPacked64SecondsAndNanos(
+          absl::bit_cast<int64_t>(bit_field), static_cast<int32_t>(nanos));
+      if (!datetime.IsValid()) {
+        return zetasql_base::InvalidArgumentErrorBuilder()
+               << "Invalid DATETIME in CompactTableData";
+      }
+      return Value::Datetime(datetime);
+    }
+    case TYPE_TIME: {
+      ZETASQL_ASSIGN_OR_RETURN(const uint64_t bit_field, ReadVarint());
+      const TimeValue time =
+          TimeValue::FromPacked64Nanos(absl::bit_cast<int64_t>(bit_field));
+      if (!time.IsValid()) {
+        return zetasql_base::InvalidArgumentErrorBuilder()
+               << "Invalid TIME in CompactTableData";
+      }
+      return Value::Time(time);
+    }
+    case TYPE_NUMERIC: {
+      ZETASQL_ASSIGN_OR_RETURN(absl::string_view bytes, ReadLengthPrefixedBytes());
+      ZETASQL_ASSIGN_OR_RETURN(NumericValue value,
+                       NumericValue::DeserializeFromProtoBytes(bytes));
+      return Value::Numeric(value);
+    }
+    case TYPE_BIGNUMERIC: {
+      ZETASQL_ASSIGN_OR_RETURN(absl::string_view bytes, ReadLengthPrefixedBytes());
+      ZETASQL_ASSIGN_OR_RETURN(BigNumericValue value,
+                       BigNumericValue::DeserializeFromProtoBytes(bytes));
+      return Value::BigNumeric(value);
+    }
+    case TYPE_INTERVAL: {
+      ZETASQL_ASSIGN_OR_RETURN(absl::string_view bytes, ReadLengthPrefixedBytes());
+      ZETASQL_ASSIGN_OR_RETURN(IntervalValue value,
+                       IntervalValue::DeserializeFromBytes(bytes));
+      return Value::Interval(value);
+    }
+    case TYPE_ARRAY: {
+      ZETASQL_ASSIGN_OR_RETURN(const uint64_t num_elements, ReadVarint());
+      // Each element takes at least one byte, which bounds the reservation.
+      if (num_elements > remaining_.size()) {
+        return Truncated();
+      }
+      const Type* element_type = type->AsArray()->element_type();
+      std::vector<Value> elements;
+      elements.reserve(num_elements);
+      for (uint64_t i = 0; i < num_elements; ++i) {
+        ZETASQL_ASSIGN_OR_RETURN(Value element, ReadValue(element_type));
+        elements.push_back(std::move(element));
+      }
+      return Value::MakeArray(type->AsArray(), std::move(elements));
+    }
+    case TYPE_STRUCT: {
+      const StructType* struct_type = type->AsStruct();
+      std::vector<Value> fields;
+      fields.reserve(struct_type->num_fields());
+      for (const StructField& field : struct_type->fields()) {
+        ZETASQL_ASSIGN_OR_RETURN(Value value, ReadValue(field.type));
+        fields.push_back(std::move(value));
+      }
+      return Value::MakeStruct(struct_type, std::move(fields));
+    }
+    default:
+      return zetasql_base::InvalidArgumentErrorBuilder()
+             << "CompactTableData does not support type "
+             << type->DebugString();
+  }
+}
+
+}  // namespace
+
+bool SupportsCompactEncoding(const Type* type) {
+  switch (type->kind()) {
+    case TYPE_BOOL:
+    case TYPE_INT32:
+    case TYPE_INT64:
+    case TYPE_UINT32:
+    case TYPE_UINT64:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_STRING:
+    case TYPE_BYTES:
+    case TYPE_JSON:
+    case TYPE_PROTO:
+    case TYPE_ENUM:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_DATETIME:
+    case TYPE_TIME:
+    case TYPE_NUMERIC:
+    case TYPE_BIGNUMERIC:
+    case TYPE_INTERVAL:
+      return true;
+    case TYPE_ARRAY:
+      return SupportsCompactEncoding(type->AsArray()->element_type());
+    case TYPE_STRUCT:
+      for (const StructField& field : type->AsStruct()->fields()) {
+        if (!SupportsCompactEncoding(field.type)) {
+          return false;
+        }
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+CompactTableDataWriter::CompactTableDataWriter(CompactTableData* data)
+    : data_(data) {
+  for (int i = 0; i < data_->string_table_size(); ++i) {
+    string_table_indexes_.emplace(data_->string_table(i), i);
+  }
+}
+
+void CompactTableDataWriter::AppendVarint(uint64_t value) {
+  char buffer[10];
+  int size = 0;
+  while (value >= 0x80) {
+    buffer[size++] = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  buffer[size++] = static_cast<char>(value);
+  data_->mutable_rows()->append(buffer, size);
+}
+
+void CompactTableDataWriter::AppendBytes(absl::string_view bytes) {
+  AppendVarint(bytes.size());
+  data_->mutable_rows()->append(bytes.data(), bytes.size());
+}
+
+void CompactTableDataWriter::AppendStringTableIndex(absl::string_view value) {
+  auto it = string_table_indexes_.find(value);
+  if (it == string_table_indexes_.end()) {
+    it = string_table_indexes_
+             .emplace(std::string(value), data_->string_table_size())
+             .first;
+    data_->add_string_table(it->first);
+  }
+  AppendVarint(it->second);
+}
+
+absl::Status CompactTableDataWriter::AddValue(const Value& value) {
+  std::string* rows = data_->mutable_rows();
+  if (value.is_null()) {
+    rows->push_back(kNull);
+    return absl::OkStatus();
+  }
+  rows->push_back(kNotNull);
+  switch (value.type_kind()) {
+    case TYPE_BOOL:
+      rows->push_back(value.bool_value() ? 1 : 0);
+      break;
+    case TYPE_INT32:
+      AppendZigZag(value.int32_value());
+      break;
+    case TYPE_INT64:
+      AppendZigZag(value.int64_value());
+      break;
+    case TYPE_DATE:
+      AppendZigZag(value.date_value());
+      break;
+    case TYPE_ENUM:
+      AppendZigZag(value.enum_value());
+      break;
+    case TYPE_UINT32:
+      AppendVarint(value.uint32_value());
+      break;
+    case TYPE_UINT64:
+      AppendVarint(value.uint64_value());
+      break;
+    case TYPE_FLOAT: {
+      char bytes[4];
+      zetasql_base::LittleEndian::Store32(
+          bytes, absl::bit_cast<uint32_t>(value.float_value()));
+      rows->append(bytes, sizeof(bytes));
+      break;
+    }
+    case TYPE_DOUBLE: {
+      char bytes[8];
+      zetasql_base::LittleEndian::Store64(
+          bytes, absl::bit_cast<uint64_t>(value.double_value()));
+      rows->append(bytes, sizeof(bytes));
+      break;
+    }
+    case TYPE_STRING:
+      AppendStringTableIndex(value.string_value());
+      break;
+    case TYPE_BYTES:
+      AppendStringTableIndex(value.bytes_value());
+      break;
+    case TYPE_JSON:
+      AppendStringTableIndex(value.json_string());
+      break;
+    case TYPE_PROTO:
+      AppendStringTableIndex(std::string(value.ToCord()));
+      break;
+    case TYPE_TIMESTAMP: {
+      const absl::Time time = value.ToTime();
+      const int64_t seconds = absl::ToUnixSeconds(time);
+      AppendZigZag(seconds);
+      AppendVarint((time - absl::FromUnixSeconds(seconds)) /
+                   absl::Nanoseconds(1));
+      break;
+    }
+    case TYPE_DATETIME:
+      AppendVarint(absl::bit_cast<uint64_t>(
+          value.datetime_value().Packed64DatetimeSeconds()));
+      AppendVarint(value.datetime_value().Nanoseconds());
+      break;
+    case TYPE_TIME:
+      AppendVarint(
+          absl::bit_cast<uint64_t>(value.time_value().Packed64TimeNanos()));
+      break;
+    case TYPE_NUMERIC:
+      AppendBytes(value.numeric_value().SerializeAsProtoBytes());
+      break;
+    case TYPE_BIGNUMERIC:
+      AppendBytes(value.bignumeric_value().SerializeAsProtoBytes());
+      break;
+    case TYPE_INTERVAL:
+      AppendBytes(value.interval_value().SerializeAsBytes());
+      break;
+    case TYPE_ARRAY:
+      AppendVarint(value.num_elements());
+      for (const Value& element : value.elements()) {
+        ZETASQL_RETURN_IF_ERROR(AddValue(element));
+      }
+      break;
+    case TYPE_STRUCT:
+      for (const Value& field : value.fields()) {
+        ZETASQL_RETURN_IF_ERROR(AddValue(field));
+      }
+      break;
+    default:
+      return zetasql_base::InvalidArgumentErrorBuilder()
+             << "CompactTableData does not support type "
+             << value.type()->DebugString();
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<std::vector<Value>>> DecodeCompactTableData(
+    const CompactTableData& data, absl::Span<const Type* const> column_types) {
+  // Each value takes at least one byte, which bounds the number of rows.
+  const int64_t max_rows = column_types.empty() ? kMaxRowsWithoutColumns
+                                                : data.rows().size();
+  if (data.row_count() < 0 || data.row_count() > max_rows) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "Invalid row count in CompactTableData: " << data.row_count();
+  }
+  CompactTableDataReader reader(data);
+  std::vector<std::vector<Value>> rows;
+  rows.reserve(data.row_count());
+  for (int64_t i = 0; i < data.row_count(); ++i) {
+    std::vector<Value> row;
+    row.reserve(column_types.size());
+    for (const Type* type : column_types) {
+      ZETASQL_ASSIGN_OR_RETURN(Value value, reader.ReadValue(type));
+      row.push_back(std::move(value));
+    }
+    rows.push_back(std::move(row));
+  }
+  if (!reader.AtEnd()) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "CompactTableData has more bytes than its " << data.row_count()
+           << " rows";
+  }
+  return rows;
+}
+
+}  // namespace local_service
+}  // namespace zetasql
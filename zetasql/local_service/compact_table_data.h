@@ -0,0 +1,103 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Encoding and decoding of CompactTableData (see local_service.proto).
+//
+// CompactTableData::rows holds the values of each row in column order, and the
+// rows one after another. Since the column types are known to both sides, no
+// type information or field tags are encoded. Each value starts with one byte
+// that is 0 for NULL, in which case nothing follows, and 1 otherwise, followed
+// by:
+//   BOOL                     One byte, 0 or 1.
+//   INT32, INT64, DATE, ENUM ZigZag varint.
+//   UINT32, UINT64           Varint.
+//   FLOAT, DOUBLE            4 or 8 bytes, IEEE 754 little-endian.
+//   STRING, BYTES, JSON,     Varint index into CompactTableData::string_table,
+//   PROTO                    which holds each distinct value once.
+//   TIMESTAMP                ZigZag varint seconds since the Unix epoch, then
+//                            varint nanoseconds within the second.
+//   DATETIME                 Varint DatetimeValue::Packed64DatetimeSeconds(),
+//                            then varint nanoseconds.
+//   TIME                     Varint TimeValue::Packed64TimeNanos().
+//   NUMERIC, BIGNUMERIC,     Varint length, then the bytes of the value in
+//   INTERVAL                 ValueProto.
+//   ARRAY                    Varint number of elements, then the elements.
+//   STRUCT                   The fields in order.
+// Varints are as in the protocol buffer wire format. Other types, such as
+// GEOGRAPHY, are not supported.
+//
+// java/com/google/zetasql/Value.java implements the decoding for the Java
+// client.
+
+#ifndef ZETASQL_LOCAL_SERVICE_COMPACT_TABLE_DATA_H_
+#define ZETASQL_LOCAL_SERVICE_COMPACT_TABLE_DATA_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zetasql/local_service/local_service.pb.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace local_service {
+
+// Returns true if values of 'type' can be encoded in CompactTableData.
+bool SupportsCompactEncoding(const Type* type);
+
+// Appends rows to a CompactTableData.
+class CompactTableDataWriter {
+ public:
+  // Does not take ownership of 'data', which must outlive this object.
+  explicit CompactTableDataWriter(CompactTableData* data);
+  CompactTableDataWriter(const CompactTableDataWriter&) = delete;
+  CompactTableDataWriter& operator=(const CompactTableDataWriter&) = delete;
+
+  // Appends 'value' to the current row. The values of a row must be added in
+  // column order.
+  absl::Status AddValue(const Value& value);
+
+  // Ends the current row.
+  void EndRow() { data_->set_row_count(data_->row_count() + 1); }
+
+ private:
+  void AppendVarint(uint64_t value);
+  void AppendZigZag(int64_t value) {
+    AppendVarint((static_cast<uint64_t>(value) << 1) ^
+                 static_cast<uint64_t>(value >> 63));
+  }
+  void AppendBytes(absl::string_view bytes);
+  void AppendStringTableIndex(absl::string_view value);
+
+  CompactTableData* data_;
+  // The index of each value in data_->string_table().
+  absl::flat_hash_map<std::string, int64_t> string_table_indexes_;
+};
+
+// Decodes the rows of 'data', whose columns have types 'column_types'.
+absl::StatusOr<std::vector<std::vector<Value>>> DecodeCompactTableData(
+    const CompactTableData& data, absl::Span<const Type* const> column_types);
+
+}  // namespace local_service
+}  // namespace zetasql
+
+#endif  // ZETASQL_LOCAL_SERVICE_COMPACT_TABLE_DATA_H_
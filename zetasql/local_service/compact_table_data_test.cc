@@ -0,0 +1,240 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/local_service/compact_table_data.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/local_service/local_service.pb.h"
+#include "zetasql/public/civil_time.h"
+#include "zetasql/public/interval_value.h"
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/testdata/test_schema.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace local_service {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::zetasql_base::testing::IsOkAndHolds;
+using ::zetasql_base::testing::StatusIs;
+
+// Encodes 'rows' and checks that decoding them with 'column_types' returns
+// them unchanged.
+CompactTableData RoundTrip(const std::vector<const Type*>& column_types,
+                           const std::vector<std::vector<Value>>& rows) {
+  CompactTableData data;
+  CompactTableDataWriter writer(&data);
+  for (const std::vector<Value>& row : rows) {
+    for (const Value& value : row) {
+      ZETASQL_EXPECT_OK(writer.AddValue(value));
+    }
+    writer.EndRow();
+  }
+  EXPECT_EQ(data.row_count(), rows.size());
+  EXPECT_THAT(DecodeCompactTableData(data, column_types), IsOkAndHolds(rows));
+  return data;
+}
+
+TEST(CompactTableDataTest, SimpleTypes) {
+  const std::vector<const Type*> types = {
+      types::BoolType(),      types::Int32Type(),      types::Int64Type(),
+      types::Uint32Type(),    types::Uint64Type(),     types::FloatType(),
+      types::DoubleType(),    types::StringType(),     types::BytesType(),
+      types::DateType(),      types::TimestampType(),  types::DatetimeType(),
+      types::TimeType(),      types::NumericType(),    types::BigNumericType(),
+      types::IntervalType(),
+  };
+  std::vector<std::vector<Value>> rows;
+  rows.push_back({
+      Value::Bool(true),
+      Value::Int32(-7),
+      Value::Int64(int64_t{-1234567890123}),
+      Value::Uint32(4000000000),
+      Value::Uint64(uint64_t{18000000000000000000u}),
+      Value::Float(1.5f),
+      Value::Double(-0.25),
+      Value::String("apple"),
+      Value::Bytes("\x01\x02"),
+      Value::Date(18000),
+      Value::Timestamp(absl::FromUnixNanos(int64_t{-1234567890123456789})),
+      Value::Datetime(DatetimeValue::FromYMDHMSAndNanos(2021, 2, 3, 4, 5, 6,
+                                                         789123456)),
+      Value::Time(TimeValue::FromHMSAndNanos(23, 59, 58, 1)),
+      Value::Numeric(NumericValue::FromString("-123.456").value()),
+      Value::BigNumeric(BigNumericValue::FromString("1e30").value()),
+      Value::Interval(IntervalValue::FromYMDHMS(1, 2, 3, 4, 5, 6).value()),
+  });
+  std::vector<Value> null_row;
+  for (const Type* type : types) {
+    null_row.push_back(Value::Null(type));
+  }
+  rows.push_back(null_row);
+  RoundTrip(types, rows);
+}
+
+TEST(CompactTableDataTest, NestedAndProtoTypes) {
+  TypeFactory type_factory;
+  const ArrayType* array_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeArrayType(types::Int64Type(), &array_type));
+  const StructType* struct_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeStructType(
+      {{"a", types::StringType()}, {"b", array_type}}, &struct_type));
+  const EnumType* enum_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeEnumType(
+      zetasql_test__::TestEnum_descriptor(), &enum_type));
+  const ProtoType* proto_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeProtoType(
+      zetasql_test__::KitchenSinkPB::descriptor(), &proto_type));
+  const std::vector<const Type*> types = {array_type, struct_type, enum_type,
+                                          proto_type, types::JsonType()};
+
+  zetasql_test__::KitchenSinkPB proto;
+  proto.set_int64_key_1(1);
+  proto.set_int64_key_2(2);
+  const Value array = Value::Array(
+      array_type, {Value::Int64(1), Value::NullInt64(), Value::Int64(-3)});
+  RoundTrip(types, {{array, Value::Struct(struct_type, {Value::String("x"),
+                                                       array}),
+                     Value::Enum(enum_type, 1),
+                     Value::Proto(proto_type, absl::Cord(
+                                                  proto.SerializeAsString())),
+                     Value::UnvalidatedJsonString(R"({"a": 1})")},
+                    {Value::EmptyArray(array_type),
+                     Value::Struct(struct_type, {Value::NullString(),
+                                                 Value::Null(array_type)}),
+                     Value::Null(enum_type), Value::Null(proto_type),
+                     Value::NullJson()}});
+}
+
+TEST(CompactTableDataTest, SharesStrings) {
+  const std::vector<const Type*> types = {types::StringType(),
+                                          types::BytesType()};
+  const CompactTableData data = RoundTrip(
+      types, {{Value::String("a"), Value::Bytes("b")},
+              {Value::String("b"), Value::Bytes("a")},
+              {Value::String("a"), Value::Bytes("a")}});
+  EXPECT_THAT(data.string_table(), ElementsAre("a", "b"));
+}
+
+TEST(CompactTableDataTest, SupportsCompactEncoding) {
+  TypeFactory type_factory;
+  const ArrayType* array_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeArrayType(types::StringType(), &array_type));
+  EXPECT_TRUE(SupportsCompactEncoding(types::Int64Type()));
+  EXPECT_TRUE(SupportsCompactEncoding(array_type));
+  EXPECT_FALSE(SupportsCompactEncoding(types::GeographyType()));
+
+  const StructType* struct_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeStructType(
+      {{"a", types::StringType()}, {"b", types::GeographyType()}},
+      &struct_type));
+  EXPECT_FALSE(SupportsCompactEncoding(struct_type));
+}
+
+TEST(CompactTableDataTest, InvalidData) {
+  const std::vector<const Type*> types = {types::StringType()};
+  CompactTableData data;
+  CompactTableDataWriter writer(&data);
+  ZETASQL_ASSERT_OK(writer.AddValue(Value::String("abc")));
+  writer.EndRow();
+
+  CompactTableData truncated = data;
+  truncated.mutable_rows()->pop_back();
+  EXPECT_THAT(DecodeCompactTableData(truncated, types),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Truncated")));
+
+  CompactTableData bad_index = data;
+  bad_index.clear_string_table();
+  EXPECT_THAT(DecodeCompactTableData(bad_index, types),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("string table index")));
+
+  CompactTableData extra_bytes = data;
+  extra_bytes.mutable_rows()->push_back('\0');
+  EXPECT_THAT(DecodeCompactTableData(extra_bytes, types),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("more bytes")));
+
+  CompactTableData negative_row_count = data;
+  negative_row_count.set_row_count(-1);
+  EXPECT_THAT(DecodeCompactTableData(negative_row_count, types),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid row count")));
+
+  CompactTableData too_many_rows = data;
+  too_many_rows.set_row_count(int64_t{1} << 40);
+  EXPECT_THAT(DecodeCompactTableData(too_many_rows, types),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid row count")));
+  EXPECT_THAT(DecodeCompactTableData(too_many_rows, {}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid row count")));
+}
+
+// Encodes 'value' and decodes the same bytes as a single value of 'type'.
+absl::Status DecodeAs(const Value& value, const Type* type,
+                      absl::string_view suffix = "") {
+  CompactTableData data;
+  CompactTableDataWriter writer(&data);
+  ZETASQL_RETURN_IF_ERROR(writer.AddValue(value));
+  writer.EndRow();
+  data.mutable_rows()->append(suffix.data(), suffix.size());
+  return DecodeCompactTableData(data, {type}).status();
+}
+
+TEST(CompactTableDataTest, OutOfRangeValues) {
+  EXPECT_THAT(DecodeAs(Value::Int64(3000000), types::DateType()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid DATE")));
+  EXPECT_THAT(DecodeAs(Value::Int64(int64_t{1} << 40), types::DateType()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid DATE")));
+  // The nanoseconds of the TIMESTAMP follow its seconds.
+  EXPECT_THAT(DecodeAs(Value::Int64(int64_t{300000000000}),
+                       types::TimestampType(), absl::string_view("\0", 1)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid TIMESTAMP")));
+
+  TypeFactory type_factory;
+  const EnumType* enum_type;
+  ZETASQL_ASSERT_OK(type_factory.MakeEnumType(
+      zetasql_test__::TestEnum_descriptor(), &enum_type));
+  ZETASQL_EXPECT_OK(DecodeAs(Value::Int64(-1), enum_type));
+  EXPECT_THAT(DecodeAs(Value::Int64(3), enum_type),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid value for")));
+  EXPECT_THAT(DecodeAs(Value::Int64(int64_t{1} << 40), enum_type),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid value for")));
+}
+
+}  // namespace
+}  // namespace local_service
+}  // namespace zetasql
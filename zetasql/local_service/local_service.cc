@@ -19,16 +19,20 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "zetasql/base/logging.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
 #include "zetasql/common/errors.h"
 #include "zetasql/common/proto_helper.h"
+#include "zetasql/local_service/compact_table_data.h"
 #include "zetasql/local_service/local_service.pb.h"
 #include "zetasql/local_service/state.h"
 #include "zetasql/parser/parse_tree.pb.h"
@@ -51,9 +55,13 @@
 #include "zetasql/resolved_ast/sql_builder.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/cleanup/cleanup.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/source_location.h"
@@ -150,6 +158,21 @@ absl::StatusOr<EvaluateModifyResponse::Row::Operation> SerializeModifyOperation(
   }
 }
 
+// The default EvaluateQueryRequest.max_chunk_bytes.
+constexpr int64_t kDefaultMaxChunkBytes = int64_t{1} << 20;
+
+// How often EvaluateQueryChunked checks whether the caller cancelled it.
+constexpr absl::Duration kCancellationPollInterval = absl::Milliseconds(20);
+
+// Appends the serialized 'message' to the cache key 'key' and returns its size,
+// which is used as its cost in the cache. The key holds the whole definition
+// rather than a hash of it, so a cache hit is never for a different one.
+int64_t AppendCacheKey(const google::protobuf::Message& message, std::string* key) {
+  const std::string bytes = message.SerializeAsString();
+  absl::StrAppend(key, bytes.size(), ":", bytes, ";");
+  return bytes.size();
+}
+
 }  // namespace
 
 class RegisteredDescriptorPoolState : public GenericState {
@@ -473,7 +496,22 @@ class RegisteredCatalogState : public GenericState {
                      SimpleTable::Deserialize(proto, type_deserializer));
 
     const TableContent* table_content = zetasql_base::FindOrNull(tables_contents, name);
-    if (table_content == nullptr || !table_content->has_table_data()) {
+    if (table_content == nullptr) {
+      return table;
+    }
+    if (table_content->has_compact_table_data()) {
+      std::vector<const Type*> column_types;
+      column_types.reserve(table->NumColumns());
+      for (int i = 0; i < table->NumColumns(); ++i) {
+        column_types.push_back(table->GetColumn(i)->GetType());
+      }
+      ZETASQL_ASSIGN_OR_RETURN(std::vector<std::vector<Value>> content,
+                       DecodeCompactTableData(
+                           table_content->compact_table_data(), column_types));
+      table->SetContents(std::move(content));
+      return table;
+    }
+    if (!table_content->has_table_data()) {
       return table;
     }
 
@@ -501,12 +539,30 @@ class RegisteredCatalogState : public GenericState {
 
 class RegisteredCatalogPool : public SharedStatePool<RegisteredCatalogState> {};
 
+// A catalog in catalog_cache_, along with the descriptor pools its types come
+// from. Holding on to the pools keeps them alive for as long as the catalog
+// is, and keeps their addresses, which are part of the cache key, from being
+// reused by other pools.
+struct CachedCatalog {
+  std::shared_ptr<RegisteredCatalogState> catalog;
+  std::vector<std::shared_ptr<RegisteredDescriptorPoolState>> pool_states;
+};
+
 ZetaSqlLocalServiceImpl::ZetaSqlLocalServiceImpl()
+    : ZetaSqlLocalServiceImpl(LocalServiceCacheOptions()) {}
+
+ZetaSqlLocalServiceImpl::ZetaSqlLocalServiceImpl(
+    const LocalServiceCacheOptions& options)
     : registered_descriptor_pools_(new RegisteredDescriptorPoolPool()),
       registered_catalogs_(new RegisteredCatalogPool()),
       prepared_expressions_(new PreparedExpressionPool()),
       prepared_queries_(new PreparedQueryPool()),
-      prepared_modifies_(new PreparedModifyPool()) {}
+      prepared_modifies_(new PreparedModifyPool()),
+      descriptor_pool_cache_(new StateCache<RegisteredDescriptorPoolState>(
+          options.max_cached_descriptor_pools,
+          options.max_descriptor_pool_cache_bytes)),
+      catalog_cache_(new StateCache<CachedCatalog>(
+          options.max_cached_catalogs, options.max_catalog_cache_bytes)) {}
 
 ZetaSqlLocalServiceImpl::~ZetaSqlLocalServiceImpl() {}
 
@@ -873,6 +929,82 @@ absl::Status ZetaSqlLocalServiceImpl::Evaluate(const EvaluateRequest& request,
   return absl::OkStatus();
 }
 
+absl::Status ZetaSqlLocalServiceImpl::EvaluateBatch(
+    const EvaluateBatchRequest& request, EvaluateBatchResponse* response) {
+  if (!request.has_prepared_expression_id()) {
+    return MakeSqlError() << "EvaluateBatch requires a prepared expression";
+  }
+  int64_t id = request.prepared_expression_id();
+  std::shared_ptr<InternalPreparedExpressionState> state =
+      prepared_expressions_->Get(id);
+  if (state == nullptr) {
+    return MakeSqlError() << "Prepared expression " << id << " unknown.";
+  }
+  const PreparedExpression* expression = state->GetExpression();
+  const AnalyzerOptions& analyzer_options = state->GetAnalyzerOptions();
+
+  // Arrange the columns in the order expected by ExecuteBatchAfterPrepare().
+  ZETASQL_ASSIGN_OR_RETURN(std::vector<std::string> column_names,
+                   expression->GetReferencedColumns());
+  absl::flat_hash_map<std::string, int> column_indexes;
+  for (int i = 0; i < column_names.size(); ++i) {
+    column_indexes[absl::AsciiStrToLower(column_names[i])] = i;
+  }
+  std::vector<ParameterValueList> columns(column_names.size());
+  std::vector<bool> has_column(column_names.size(), false);
+  for (const auto& column : request.columns()) {
+    std::string name = absl::AsciiStrToLower(column.name());
+    const Type* type =
+        zetasql_base::FindPtrOrNull(analyzer_options.expression_columns(), name);
+    ZETASQL_RET_CHECK(type != nullptr) << "Type not found for '" << name << "'";
+    auto it = column_indexes.find(name);
+    if (it == column_indexes.end()) {
+      // Not referenced by the expression.
+      continue;
+    }
+    if (has_column[it->second]) {
+      return MakeSqlError() << "Duplicate column '" << name << "'";
+    }
+    has_column[it->second] = true;
+    ParameterValueList& values = columns[it->second];
+    values.reserve(column.values_size());
+    for (const ValueProto& value_proto : column.values()) {
+      ZETASQL_ASSIGN_OR_RETURN(Value value, Value::Deserialize(value_proto, type));
+      values.push_back(std::move(value));
+    }
+  }
+  for (int i = 0; i < column_names.size(); ++i) {
+    if (!has_column[i]) {
+      return MakeSqlError() << "Incomplete column parameters "
+                            << column_names[i];
+    }
+  }
+
+  ParameterValueMap params_map;
+  ZETASQL_RETURN_IF_ERROR(RepeatedParametersToMap(
+      request.params(), analyzer_options.query_parameters(), &params_map));
+  ZETASQL_ASSIGN_OR_RETURN(std::vector<std::string> param_names,
+                   expression->GetReferencedParameters());
+  ParameterValueList params;
+  params.reserve(param_names.size());
+  for (const std::string& param_name : param_names) {
+    auto it = params_map.find(absl::AsciiStrToLower(param_name));
+    if (it == params_map.end()) {
+      return MakeSqlError() << "Incomplete query parameters " << param_name;
+    }
+    params.push_back(it->second);
+  }
+
+  ZETASQL_ASSIGN_OR_RETURN(std::vector<Value> results,
+                   expression->ExecuteBatchAfterPrepare(columns, params,
+                                                        request.row_count()));
+  response->mutable_values()->Reserve(static_cast<int>(results.size()));
+  for (const Value& value : results) {
+    ZETASQL_RETURN_IF_ERROR(value.Serialize(response->add_values()));
+  }
+  return absl::OkStatus();
+}
+
 absl::Status ZetaSqlLocalServiceImpl::EvaluateQuery(
     const EvaluateQueryRequest& request, EvaluateQueryResponse* response) {
   absl::optional<int64_t> prepared_query_id_opt =
@@ -883,6 +1015,21 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluateQuery(
                       *prepared_queries_, "query", response);
 }
 
+absl::Status ZetaSqlLocalServiceImpl::EvaluateQueryChunked(
+    const EvaluateQueryRequest& request,
+    const std::function<bool(const EvaluateQueryResponse&)>& write_chunk,
+    const std::function<bool()>& is_cancelled) {
+  ZETASQL_RET_CHECK(write_chunk != nullptr);
+  absl::optional<int64_t> prepared_query_id_opt =
+      request.has_prepared_query_id()
+          ? absl::optional<int64_t>(request.prepared_query_id())
+          : std::nullopt;
+  EvaluateQueryResponse response;
+  return EvaluateImpl(request, request.table_content(), prepared_query_id_opt,
+                      *prepared_queries_, "query", &response, write_chunk,
+                      is_cancelled);
+}
+
 absl::Status ZetaSqlLocalServiceImpl::EvaluateModify(
     const EvaluateModifyRequest& request, EvaluateModifyResponse* response) {
   absl::optional<int64_t> prepared_modify_id_opt =
@@ -899,7 +1046,9 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluateImpl(
     const google::protobuf::Map<std::string, TableContent>& tables_contents,
     absl::optional<int64_t>& prepared_statement_id_opt,
     SharedStatePool<InternalStateT>& prepared_statements_pool,
-    absl::string_view statement_type, ResponseT* response) {
+    absl::string_view statement_type, ResponseT* response,
+    const std::function<bool(const ResponseT&)>& write_chunk,
+    const std::function<bool()>& is_cancelled) {
   std::shared_ptr<InternalStateT> internal_state;
 
   std::vector<const google::protobuf::DescriptorPool*> pools;
@@ -929,11 +1078,9 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluateImpl(
              << "Prepared " << statement_type << " " << id << " unknown.";
     }
   } else {
-    ZETASQL_RETURN_IF_ERROR(GetDescriptorPools(request.descriptor_pool_list(),
-                                       descriptor_pool_states, pools));
-
-    ZETASQL_RETURN_IF_ERROR(
-        GetCatalogState(request, tables_contents, pools, catalog_state));
+    ZETASQL_RETURN_IF_ERROR(GetCachedDescriptorPoolsAndCatalogState(
+        request, tables_contents, descriptor_pool_states, pools,
+        catalog_state));
 
     ZETASQL_RETURN_IF_ERROR(
         CreateAndPrepare(request.sql(), request.options(), catalog_state, pools,
@@ -950,8 +1097,8 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluateImpl(
   // does not have its content set.
   // Here we converting the Unimplemented error into Unimplemented
   // which is more appropriate
-  absl::Status evaluate_status =
-      EvaluatePrepared(request, internal_state.get(), response);
+  absl::Status evaluate_status = EvaluatePrepared(
+      request, internal_state.get(), response, write_chunk, is_cancelled);
 
   if (evaluate_status.code() == absl::StatusCode::kUnimplemented) {
     return zetasql_base::InvalidArgumentErrorBuilder()
@@ -990,7 +1137,9 @@ template <>
 absl::Status ZetaSqlLocalServiceImpl::EvaluatePrepared(
     const EvaluateQueryRequest& request,
     InternalPreparedQueryState* internal_state,
-    EvaluateQueryResponse* response) {
+    EvaluateQueryResponse* response,
+    const std::function<bool(const EvaluateQueryResponse&)>& write_chunk,
+    const std::function<bool()>& is_cancelled) {
   const AnalyzerOptions& analyzer_options =
       internal_state->GetAnalyzerOptions();
 
@@ -1004,23 +1153,116 @@ absl::Status ZetaSqlLocalServiceImpl::EvaluatePrepared(
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> results_iterator,
                    internal_state->GetQuery()->ExecuteAfterPrepare(options));
 
-  TableData* table_data = response->mutable_content()->mutable_table_data();
+  // NextRow() can block for a long time, e.g. in a sort before the first row,
+  // so cancellation is watched for on another thread. The watcher is stopped
+  // before <results_iterator> goes away.
+  absl::Notification evaluation_done;
+  std::thread cancellation_watcher;
+  if (is_cancelled != nullptr) {
+    cancellation_watcher = std::thread([&] {
+      while (!evaluation_done.WaitForNotificationWithTimeout(
+          kCancellationPollInterval)) {
+        if (is_cancelled()) {
+          // Best effort: NextRow() reports whether the query was cancelled.
+          results_iterator->Cancel().IgnoreError();
+          return;
+        }
+      }
+    });
+  }
+  auto stop_cancellation_watcher = absl::MakeCleanup([&] {
+    evaluation_done.Notify();
+    if (cancellation_watcher.joinable()) cancellation_watcher.join();
+  });
+
+  bool compact = request.row_encoding() == EvaluateQueryRequest::COMPACT;
+  for (int i = 0; compact && i < results_iterator->NumColumns(); i++) {
+    compact = SupportsCompactEncoding(results_iterator->GetColumnType(i));
+  }
+  const int64_t max_chunk_bytes = request.has_max_chunk_bytes()
+                                      ? request.max_chunk_bytes()
+                                      : kDefaultMaxChunkBytes;
+
+  // The serialized size of the rows in <response> so far, and the number of
+  // string table entries counted in it.
+  int64_t chunk_bytes = 0;
+  int num_counted_strings = 0;
+  bool wrote_chunk = false;
+  // Each chunk has its own string table, so each chunk gets its own writer.
+  std::unique_ptr<CompactTableDataWriter> writer;
+  TableData* table_data = nullptr;
+  auto start_chunk = [&]() {
+    if (compact) {
+      writer = absl::make_unique<CompactTableDataWriter>(
+          response->mutable_content()->mutable_compact_table_data());
+    } else {
+      table_data = response->mutable_content()->mutable_table_data();
+    }
+  };
+  auto write_response = [&]() -> absl::Status {
+    if (!write_chunk(*response)) {
+      // Best effort: the client went away, and the CANCELLED error below is
+      // what the caller gets regardless of whether cancelling succeeded.
+      results_iterator->Cancel().IgnoreError();
+      return zetasql_base::CancelledErrorBuilder()
+             << "EvaluateQueryChunked was cancelled";
+    }
+    wrote_chunk = true;
+    response->Clear();
+    chunk_bytes = 0;
+    num_counted_strings = 0;
+    start_chunk();
+    return absl::OkStatus();
+  };
+
+  start_chunk();
   while (results_iterator->NextRow()) {
-    TableData::Row* row = table_data->add_row();
-    for (int i = 0; i < results_iterator->NumColumns(); i++) {
-      ValueProto* value = row->add_cell();
-      ZETASQL_RETURN_IF_ERROR(results_iterator->GetValue(i).Serialize(value));
+    if (compact) {
+      const CompactTableData& data =
+          response->content().compact_table_data();
+      const int64_t rows_bytes_before = data.rows().size();
+      for (int i = 0; i < results_iterator->NumColumns(); i++) {
+        ZETASQL_RETURN_IF_ERROR(writer->AddValue(results_iterator->GetValue(i)));
+      }
+      writer->EndRow();
+      chunk_bytes += data.rows().size() - rows_bytes_before;
+      for (; num_counted_strings < data.string_table_size();
+           ++num_counted_strings) {
+        chunk_bytes += data.string_table(num_counted_strings).size();
+      }
+    } else {
+      TableData::Row* row = table_data->add_row();
+      for (int i = 0; i < results_iterator->NumColumns(); i++) {
+        ValueProto* value = row->add_cell();
+        ZETASQL_RETURN_IF_ERROR(results_iterator->GetValue(i).Serialize(value));
+      }
+      if (write_chunk != nullptr) {
+        chunk_bytes += row->ByteSizeLong();
+      }
+    }
+    if (write_chunk != nullptr && chunk_bytes >= max_chunk_bytes) {
+      ZETASQL_RETURN_IF_ERROR(write_response());
     }
   }
+  ZETASQL_RETURN_IF_ERROR(results_iterator->Status());
 
-  return results_iterator->Status();
+  if (write_chunk != nullptr && (chunk_bytes > 0 || !wrote_chunk)) {
+    ZETASQL_RETURN_IF_ERROR(write_response());
+  }
+  return absl::OkStatus();
 }
 
 template <>
 absl::Status ZetaSqlLocalServiceImpl::EvaluatePrepared(
     const EvaluateModifyRequest& request,
     InternalPreparedModifyState* internal_state,
-    EvaluateModifyResponse* response) {
+    EvaluateModifyResponse* response,
+    const std::function<bool(const EvaluateModifyResponse&)>& write_chunk,
+    const std::function<bool()>& is_cancelled) {
+  ZETASQL_RET_CHECK(write_chunk == nullptr)
+      << "Chunked responses are only supported for queries";
+  ZETASQL_RET_CHECK(is_cancelled == nullptr)
+      << "Cancellation is only supported for queries";
   const AnalyzerOptions& analyzer_options =
       internal_state->GetAnalyzerOptions();
 
@@ -1106,7 +1348,8 @@ absl::Status ZetaSqlLocalServiceImpl::GetDescriptorPools(
     const DescriptorPoolListProto& descriptor_pool_list,
     std::vector<std::shared_ptr<RegisteredDescriptorPoolState>>&
         descriptor_pool_states,
-    std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools) {
+    std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools,
+    bool use_cache) {
   using Definition = DescriptorPoolListProto::Definition;
   descriptor_pool_states.clear();
   descriptor_pools.clear();
@@ -1114,8 +1357,19 @@ absl::Status ZetaSqlLocalServiceImpl::GetDescriptorPools(
     std::shared_ptr<RegisteredDescriptorPoolState> state;
     switch (definition.definition_case()) {
       case Definition::kFileDescriptorSet: {
-        ZETASQL_ASSIGN_OR_RETURN(state, RegisteredDescriptorPoolState::Create(
-                                    definition.file_descriptor_set()));
+        std::string key;
+        int64_t cost = 0;
+        if (use_cache) {
+          cost = AppendCacheKey(definition.file_descriptor_set(), &key);
+          state = descriptor_pool_cache_->Lookup(key);
+        }
+        if (state == nullptr) {
+          ZETASQL_ASSIGN_OR_RETURN(state, RegisteredDescriptorPoolState::Create(
+                                      definition.file_descriptor_set()));
+          if (use_cache) {
+            descriptor_pool_cache_->Insert(key, state, cost);
+          }
+        }
         break;
       }
       case Definition::kRegisteredId: {
@@ -1175,6 +1429,56 @@ absl::Status ZetaSqlLocalServiceImpl::GetCatalogState(
   return absl::OkStatus();
 }
 
+template <typename RequestProto>
+absl::Status ZetaSqlLocalServiceImpl::GetCachedDescriptorPoolsAndCatalogState(
+    const RequestProto& request,
+    const google::protobuf::Map<std::string, TableContent>& tables_contents,
+    std::vector<std::shared_ptr<RegisteredDescriptorPoolState>>&
+        pool_states_out,
+    std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools,
+    std::shared_ptr<RegisteredCatalogState>& state) {
+  ZETASQL_RETURN_IF_ERROR(GetDescriptorPools(request.descriptor_pool_list(),
+                                     pool_states_out, descriptor_pools,
+                                     /*use_cache=*/true));
+  if (request.has_registered_catalog_id()) {
+    return GetCatalogState(request, tables_contents, descriptor_pools, state);
+  }
+
+  // The catalog refers to descriptors of the pools, so the same definitions
+  // with different pools give a different catalog.
+  std::string key;
+  for (const google::protobuf::DescriptorPool* pool : descriptor_pools) {
+    absl::StrAppend(&key, reinterpret_cast<uintptr_t>(pool), ",");
+  }
+  int64_t cost = AppendCacheKey(request.simple_catalog(), &key);
+  std::vector<std::string> table_names;
+  table_names.reserve(tables_contents.size());
+  for (const auto& [name, content] : tables_contents) {
+    table_names.push_back(name);
+  }
+  // Map iteration order is unspecified.
+  std::sort(table_names.begin(), table_names.end());
+  for (const std::string& name : table_names) {
+    absl::StrAppend(&key, name.size(), ":", name, ";");
+    cost += AppendCacheKey(tables_contents.at(name), &key);
+  }
+
+  if (std::shared_ptr<CachedCatalog> cached = catalog_cache_->Lookup(key);
+      cached != nullptr) {
+    state = cached->catalog;
+    return absl::OkStatus();
+  }
+  ZETASQL_ASSIGN_OR_RETURN(state,
+                   RegisteredCatalogState::Create(request.simple_catalog(),
+                                                  tables_contents,
+                                                  descriptor_pools));
+  catalog_cache_->Insert(
+      key,
+      std::make_shared<CachedCatalog>(CachedCatalog{state, pool_states_out}),
+      cost);
+  return absl::OkStatus();
+}
+
 absl::StatusOr<std::vector<const google::protobuf::DescriptorPool*>>
 ToDescriptorPoolVector(
     const std::vector<std::shared_ptr<RegisteredDescriptorPoolState>>& states) {
@@ -1194,9 +1498,8 @@ absl::Status ZetaSqlLocalServiceImpl::Analyze(const AnalyzeRequest& request,
   std::vector<std::shared_ptr<RegisteredDescriptorPoolState>>
       descriptor_pool_states;
 
-  ZETASQL_RETURN_IF_ERROR(GetDescriptorPools(request.descriptor_pool_list(),
-                                     descriptor_pool_states, pools));
-  ZETASQL_RETURN_IF_ERROR(GetCatalogState(request, {}, pools, catalog_state));
+  ZETASQL_RETURN_IF_ERROR(GetCachedDescriptorPoolsAndCatalogState(
+      request, {}, descriptor_pool_states, pools, catalog_state));
   if (request.has_sql_expression()) {
     return AnalyzeExpressionImpl(request, pools, catalog_state->GetCatalog(),
                                  response);
@@ -1274,9 +1577,8 @@ absl::Status ZetaSqlLocalServiceImpl::BuildSql(const BuildSqlRequest& request,
   std::vector<std::shared_ptr<RegisteredDescriptorPoolState>>
       descriptor_pool_states;
 
-  ZETASQL_RETURN_IF_ERROR(GetDescriptorPools(request.descriptor_pool_list(),
-                                     descriptor_pool_states, pools));
-  ZETASQL_RETURN_IF_ERROR(GetCatalogState(request, {}, pools, catalog_state));
+  ZETASQL_RETURN_IF_ERROR(GetCachedDescriptorPoolsAndCatalogState(
+      request, {}, descriptor_pool_states, pools, catalog_state));
   IdStringPool string_pool;
   ResolvedNode::RestoreParams restore_params(
       pools, catalog_state->GetCatalog(),
@@ -1533,5 +1835,13 @@ size_t ZetaSqlLocalServiceImpl::NumSavedPreparedModifies() const {
   return prepared_modifies_->NumSavedStates();
 }
 
+size_t ZetaSqlLocalServiceImpl::NumCachedDescriptorPools() const {
+  return descriptor_pool_cache_->NumEntries();
+}
+
+size_t ZetaSqlLocalServiceImpl::NumCachedCatalogs() const {
+  return catalog_cache_->NumEntries();
+}
+
 }  // namespace local_service
 }  // namespace zetasql
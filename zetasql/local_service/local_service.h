@@ -20,6 +20,7 @@
 #include <stddef.h>
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -38,6 +39,7 @@
 namespace zetasql {
 namespace local_service {
 
+struct CachedCatalog;
 class InternalPreparedExpressionState;
 class InternalPreparedModifyState;
 class InternalPreparedQueryState;
@@ -49,10 +51,23 @@ class RegisteredCatalogState;
 class RegisteredDescriptorPoolPool;
 class RegisteredDescriptorPoolState;
 
+// Limits of the caches of descriptor pools and catalogs that
+// ZetaSqlLocalServiceImpl builds from definitions sent inline with requests
+// (rather than as registered ids). Sizes are measured as the serialized size of
+// the definitions, including any table contents. A limit of zero disables the
+// cache.
+struct LocalServiceCacheOptions {
+  int64_t max_cached_descriptor_pools = 64;
+  int64_t max_descriptor_pool_cache_bytes = int64_t{256} << 20;
+  int64_t max_cached_catalogs = 64;
+  int64_t max_catalog_cache_bytes = int64_t{256} << 20;
+};
+
 // Implementation of ZetaSqlLocalService RPC service.
 class ZetaSqlLocalServiceImpl {
  public:
   ZetaSqlLocalServiceImpl();
+  explicit ZetaSqlLocalServiceImpl(const LocalServiceCacheOptions& options);
   ZetaSqlLocalServiceImpl(const ZetaSqlLocalServiceImpl&) = delete;
   ZetaSqlLocalServiceImpl& operator=(const ZetaSqlLocalServiceImpl&) =
       delete;
@@ -66,6 +81,11 @@ class ZetaSqlLocalServiceImpl {
   absl::Status Evaluate(const EvaluateRequest& request,
                         EvaluateResponse* response);
 
+  // Evaluates a prepared expression for every row of a columnar batch. See
+  // EvaluateBatch in local_service.proto.
+  absl::Status EvaluateBatch(const EvaluateBatchRequest& request,
+                             EvaluateBatchResponse* response);
+
   absl::Status PrepareQuery(const PrepareQueryRequest& request,
                             PrepareQueryResponse* response);
 
@@ -74,6 +94,18 @@ class ZetaSqlLocalServiceImpl {
   absl::Status EvaluateQuery(const EvaluateQueryRequest& request,
                              EvaluateQueryResponse* response);
 
+  // Like EvaluateQuery(), but passes the response to <write_chunk> in chunks as
+  // the rows are evaluated, rather than building it in full (see
+  // EvaluateQueryChunked in local_service.proto). If <write_chunk> returns
+  // false, the query is cancelled and a kCancelled error is returned.
+  // If <is_cancelled> is set, it is polled from another thread while the query
+  // runs, and the query is cancelled as soon as it returns true, even while
+  // the first row is still being computed.
+  absl::Status EvaluateQueryChunked(
+      const EvaluateQueryRequest& request,
+      const std::function<bool(const EvaluateQueryResponse&)>& write_chunk,
+      const std::function<bool()>& is_cancelled = nullptr);
+
   absl::Status PrepareModify(const PrepareModifyRequest& request,
                              PrepareModifyResponse* response);
 
@@ -146,11 +178,15 @@ class ZetaSqlLocalServiceImpl {
   // convenience for calls into the google Deserialize calls..
   // This will _not_ register the returned states, although it will retrieve
   // states based on registered_id as necessary.
+  // If <use_cache> is true, pools defined by a file_descriptor_set are taken
+  // from, or added to, descriptor_pool_cache_. The returned states must then
+  // never be registered, since they may be shared with other requests.
   absl::Status GetDescriptorPools(
       const DescriptorPoolListProto& descriptor_pool_list,
       std::vector<std::shared_ptr<RegisteredDescriptorPoolState>>&
           pool_states_out,
-      std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools);
+      std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools,
+      bool use_cache = false);
 
   // Registers each entry in <descriptor_pool_states> if not already registered
   // and returns a list of the newly registered objects in
@@ -170,11 +206,27 @@ class ZetaSqlLocalServiceImpl {
       const std::vector<const google::protobuf::DescriptorPool*>& pools,
       std::shared_ptr<RegisteredCatalogState>& state);
 
+  // Like GetDescriptorPools() followed by GetCatalogState(), but reuses the
+  // descriptor pools and the catalog built for an earlier request with the same
+  // inline definitions. Only for requests that do not register the returned
+  // states.
+  template <typename RequestProto>
+  absl::Status GetCachedDescriptorPoolsAndCatalogState(
+      const RequestProto& request,
+      const google::protobuf::Map<std::string, TableContent>& tables_contents,
+      std::vector<std::shared_ptr<RegisteredDescriptorPoolState>>&
+          pool_states_out,
+      std::vector<const google::protobuf::DescriptorPool*>& descriptor_pools,
+      std::shared_ptr<RegisteredCatalogState>& state);
+
   std::unique_ptr<RegisteredDescriptorPoolPool> registered_descriptor_pools_;
   std::unique_ptr<RegisteredCatalogPool> registered_catalogs_;
   std::unique_ptr<PreparedExpressionPool> prepared_expressions_;
   std::unique_ptr<PreparedQueryPool> prepared_queries_;
   std::unique_ptr<PreparedModifyPool> prepared_modifies_;
+  std::unique_ptr<StateCache<RegisteredDescriptorPoolState>>
+      descriptor_pool_cache_;
+  std::unique_ptr<StateCache<CachedCatalog>> catalog_cache_;
 
   template <typename InternalStateT>
   absl::Status CreateAndPrepare(
@@ -211,12 +263,20 @@ class ZetaSqlLocalServiceImpl {
       const google::protobuf::Map<std::string, TableContent>& tables_contents,
       absl::optional<int64_t>& prepared_statement_id_opt,
       SharedStatePool<InternalStateT>& prepared_statements_pool,
-      absl::string_view statement_type, ResponseT* response);
-
+      absl::string_view statement_type, ResponseT* response,
+      const std::function<bool(const ResponseT&)>& write_chunk = nullptr,
+      const std::function<bool()>& is_cancelled = nullptr);
+
+  // If <write_chunk> is set, passes <response> to it whenever its content
+  // reaches the chunk size, and clears it. If <is_cancelled> is set, the
+  // evaluation is cancelled once it returns true. Both are only supported for
+  // queries.
   template <typename RequestT, typename ResponseT, typename InternalStateT>
-  absl::Status EvaluatePrepared(const RequestT& request,
-                                ResponseT* internal_state,
-                                InternalStateT* response);
+  absl::Status EvaluatePrepared(
+      const RequestT& request, ResponseT* internal_state,
+      InternalStateT* response,
+      const std::function<bool(const InternalStateT&)>& write_chunk,
+      const std::function<bool()>& is_cancelled);
 
   absl::Status EvaluatePreparedExpression(
       const EvaluateRequest& request,
@@ -234,6 +294,8 @@ class ZetaSqlLocalServiceImpl {
   size_t NumSavedPreparedExpression() const;
   size_t NumSavedPreparedQueries() const;
   size_t NumSavedPreparedModifies() const;
+  size_t NumCachedDescriptorPools() const;
+  size_t NumCachedCatalogs() const;
 
   friend class ZetaSqlLocalServiceImplTest;
 };
@@ -100,6 +100,12 @@ grpc::Status ZetaSqlLocalServiceGrpcImpl::Evaluate(
   return ToGrpcStatus(service_.Evaluate(*req, resp));
 }
 
+grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateBatch(
+    grpc::ServerContext* context, const EvaluateBatchRequest* req,
+    EvaluateBatchResponse* resp) {
+  return ToGrpcStatus(service_.EvaluateBatch(*req, resp));
+}
+
 grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateStream(
     grpc::ServerContext* context,
     grpc::ServerReaderWriter<EvaluateResponseBatch, EvaluateRequestBatch>*
@@ -174,6 +180,19 @@ grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateQueryStream(
   return grpc::Status();
 }
 
+grpc::Status ZetaSqlLocalServiceGrpcImpl::EvaluateQueryChunked(
+    grpc::ServerContext* context, const EvaluateQueryRequest* req,
+    grpc::ServerWriter<EvaluateQueryResponse>* writer) {
+  return ToGrpcStatus(service_.EvaluateQueryChunked(
+      *req,
+      [context, writer](const EvaluateQueryResponse& chunk) {
+        // Write() blocks while the client has no room for the chunk, and
+        // fails once the call is done, e.g. because the client cancelled it.
+        return !context->IsCancelled() && writer->Write(chunk);
+      },
+      [context] { return context->IsCancelled(); }));
+}
+
 grpc::Status ZetaSqlLocalServiceGrpcImpl::PrepareModify(
     grpc::ServerContext* context, const PrepareModifyRequest* req,
     PrepareModifyResponse* resp) {
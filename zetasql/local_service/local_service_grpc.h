@@ -42,6 +42,10 @@ class ZetaSqlLocalServiceGrpcImpl
                         const EvaluateRequest* req,
                         EvaluateResponse* resp) override;
 
+  grpc::Status EvaluateBatch(grpc::ServerContext* context,
+                             const EvaluateBatchRequest* req,
+                             EvaluateBatchResponse* resp) override;
+
   grpc::Status EvaluateStream(
       grpc::ServerContext* context,
       grpc::ServerReaderWriter<EvaluateResponseBatch, EvaluateRequestBatch>*
@@ -64,6 +68,10 @@ class ZetaSqlLocalServiceGrpcImpl
       grpc::ServerReaderWriter<EvaluateQueryBatchResponse,
                                EvaluateQueryBatchRequest>* stream) override;
 
+  grpc::Status EvaluateQueryChunked(
+      grpc::ServerContext* context, const EvaluateQueryRequest* req,
+      grpc::ServerWriter<EvaluateQueryResponse>* writer) override;
+
   grpc::Status PrepareModify(grpc::ServerContext* context,
                              const PrepareModifyRequest* req,
                              PrepareModifyResponse* resp) override;
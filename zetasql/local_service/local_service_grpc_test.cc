@@ -30,6 +30,8 @@
 #include "zetasql/public/value.pb.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 
 namespace zetasql::local_service {
 
@@ -122,6 +124,79 @@ TEST_F(ZetaSqlLocalServiceGrpcImplTest, EvaluateStreamPreparedBigResponse) {
   EXPECT_OK_GRPC(stream->Finish());
 }
 
+TEST_F(ZetaSqlLocalServiceGrpcImplTest, EvaluateQueryChunked) {
+  grpc::ChannelArguments channel_args;
+  std::unique_ptr<ZetaSqlLocalService::Stub> stub(
+      ZetaSqlLocalService::NewStub(
+          server_->InProcessChannel(channel_args)));
+
+  EvaluateQueryRequest request;
+  request.set_sql("SELECT x FROM UNNEST(GENERATE_ARRAY(1, 1000)) AS x");
+  request.set_max_chunk_bytes(100);
+
+  grpc::ClientContext context;
+  std::unique_ptr<grpc::ClientReader<EvaluateQueryResponse>> reader =
+      stub->EvaluateQueryChunked(&context, request);
+  EvaluateQueryResponse response;
+  int num_chunks = 0;
+  int num_rows = 0;
+  while (reader->Read(&response)) {
+    EXPECT_EQ(response.has_prepared(), num_chunks == 0);
+    ++num_chunks;
+    num_rows += response.content().table_data().row_size();
+  }
+  EXPECT_OK_GRPC(reader->Finish());
+  EXPECT_EQ(num_rows, 1000);
+  EXPECT_GT(num_chunks, 1);
+}
+
+TEST_F(ZetaSqlLocalServiceGrpcImplTest, EvaluateQueryChunkedCancel) {
+  grpc::ChannelArguments channel_args;
+  std::unique_ptr<ZetaSqlLocalService::Stub> stub(
+      ZetaSqlLocalService::NewStub(
+          server_->InProcessChannel(channel_args)));
+
+  EvaluateQueryRequest request;
+  request.set_sql("SELECT x FROM UNNEST(GENERATE_ARRAY(1, 1000000)) AS x");
+  request.set_max_chunk_bytes(100);
+
+  grpc::ClientContext context;
+  std::unique_ptr<grpc::ClientReader<EvaluateQueryResponse>> reader =
+      stub->EvaluateQueryChunked(&context, request);
+  EvaluateQueryResponse response;
+  ASSERT_TRUE(reader->Read(&response));
+  context.TryCancel();
+  while (reader->Read(&response)) {
+  }
+  EXPECT_EQ(reader->Finish().error_code(), grpc::StatusCode::CANCELLED);
+}
+
+TEST_F(ZetaSqlLocalServiceGrpcImplTest,
+       EvaluateQueryChunkedCancelBeforeFirstRow) {
+  grpc::ChannelArguments channel_args;
+  std::unique_ptr<ZetaSqlLocalService::Stub> stub(
+      ZetaSqlLocalService::NewStub(
+          server_->InProcessChannel(channel_args)));
+
+  // Counting a billion rows does not finish unless the server notices the
+  // cancellation while it computes the only row. Otherwise shutting down the
+  // server at the end of the test waits for it.
+  EvaluateQueryRequest request;
+  request.set_sql(
+      "SELECT COUNT(*) FROM UNNEST(GENERATE_ARRAY(1, 1000)) AS a, "
+      "UNNEST(GENERATE_ARRAY(1, 1000)) AS b, "
+      "UNNEST(GENERATE_ARRAY(1, 1000)) AS c");
+
+  grpc::ClientContext context;
+  std::unique_ptr<grpc::ClientReader<EvaluateQueryResponse>> reader =
+      stub->EvaluateQueryChunked(&context, request);
+  absl::SleepFor(absl::Milliseconds(100));
+  context.TryCancel();
+  EvaluateQueryResponse response;
+  EXPECT_FALSE(reader->Read(&response));
+  EXPECT_EQ(reader->Finish().error_code(), grpc::StatusCode::CANCELLED);
+}
+
 }  // namespace
 
 }  // namespace zetasql::local_service
@@ -26,20 +26,28 @@
 #include <unistd.h>
 
 #include <memory>
+#include <string>
 
 #include "zetasql/local_service/local_service_grpc.h"
+#include "absl/container/flat_hash_map.h"
 
 namespace zetasql {
 namespace local_service {
 namespace {
 
+// The service is shared by the gRPC server and direct calls, so both see the
+// same prepared and registered state. It must remain for the lifetime of the
+// server.
+static ZetaSqlLocalServiceGrpcImpl* GetService() {
+  static ZetaSqlLocalServiceGrpcImpl* service =
+      new ZetaSqlLocalServiceGrpcImpl();
+  return service;
+}
+
 static grpc::Server* GetServer() {
   static grpc::Server* server = []() {
-    // The service must remain for the lifetime of the server.
-    static ZetaSqlLocalServiceGrpcImpl* service =
-        new ZetaSqlLocalServiceGrpcImpl();
     grpc::ServerBuilder builder;
-    builder.RegisterService(service);
+    builder.RegisterService(GetService());
     return builder.BuildAndStart().release();
   }();
   return server;
@@ -105,8 +113,158 @@ static jobject WrapFileDescriptor(JNIEnv* env, const int fd) {
   return javafd;
 }
 
+// Exception class thrown by CallDirect, resolved in JNI_OnLoad.
+static jclass direct_call_exception = nullptr;
+static jmethodID direct_call_exception_init = nullptr;
+
+static void ThrowDirectCallException(JNIEnv* env, const grpc::Status& status) {
+  // The message is passed as UTF-8 bytes and decoded in java: NewStringUTF
+  // requires modified UTF-8, and error messages echo arbitrary user SQL, which
+  // may contain NULs and supplementary characters.
+  const std::string& error_message = status.error_message();
+  jbyteArray message =
+      env->NewByteArray(static_cast<jsize>(error_message.size()));
+  if (message == nullptr) {
+    return;
+  }
+  env->SetByteArrayRegion(message, 0, static_cast<jsize>(error_message.size()),
+                          reinterpret_cast<const jbyte*>(error_message.data()));
+  jobject exception =
+      env->NewObject(direct_call_exception, direct_call_exception_init,
+                     static_cast<jint>(status.error_code()), message);
+  if (exception != nullptr) {
+    env->Throw(static_cast<jthrowable>(exception));
+  }
+}
+
+// Runs one unary method on a serialized request and returns the serialized
+// response, or throws and returns nullptr.
+using DirectCall = jbyteArray (*)(JNIEnv* env, const void* request,
+                                  jint length);
+
+template <class Request, class Response,
+          grpc::Status (ZetaSqlLocalServiceGrpcImpl::*method)(
+              grpc::ServerContext*, const Request*, Response*)>
+jbyteArray CallMethod(JNIEnv* env, const void* data, jint length) {
+  Request request;
+  if (!request.ParseFromArray(data, length)) {
+    ThrowDirectCallException(
+        env, grpc::Status(grpc::INVALID_ARGUMENT, "Failed to parse request"));
+    return nullptr;
+  }
+  Response response;
+  grpc::ServerContext context;
+  grpc::Status status = (GetService()->*method)(&context, &request, &response);
+  if (!status.ok()) {
+    ThrowDirectCallException(env, status);
+    return nullptr;
+  }
+
+  // Serialize straight into the java array to avoid an intermediate copy.
+  const size_t size = response.ByteSizeLong();
+  jbyteArray output = env->NewByteArray(static_cast<jsize>(size));
+  if (output == nullptr) {
+    return nullptr;
+  }
+  void* buffer = env->GetPrimitiveArrayCritical(output, nullptr);
+  if (buffer == nullptr) {
+    return nullptr;
+  }
+  const bool serialized =
+      response.SerializeWithCachedSizesToArray(static_cast<uint8_t*>(buffer)) -
+          static_cast<uint8_t*>(buffer) ==
+      size;
+  env->ReleasePrimitiveArrayCritical(output, buffer, 0);
+  if (!serialized) {
+    ThrowDirectCallException(
+        env, grpc::Status(grpc::INTERNAL, "Failed to serialize response"));
+    return nullptr;
+  }
+  return output;
+}
+
+#define ZETASQL_DIRECT_CALL(name, request, response) \
+  {#name, &CallMethod<request, response, &ZetaSqlLocalServiceGrpcImpl::name>}
+
+// Unary methods of ZetaSqlLocalService keyed by their bare method name.
+// Streaming methods are only served through the gRPC server.
+static const absl::flat_hash_map<std::string, DirectCall>& GetDirectCalls() {
+  static const auto* calls = new absl::flat_hash_map<std::string, DirectCall>({
+      ZETASQL_DIRECT_CALL(Prepare, PrepareRequest, PrepareResponse),
+      ZETASQL_DIRECT_CALL(Unprepare, UnprepareRequest, google::protobuf::Empty),
+      ZETASQL_DIRECT_CALL(Evaluate, EvaluateRequest, EvaluateResponse),
+      ZETASQL_DIRECT_CALL(EvaluateBatch, EvaluateBatchRequest,
+                          EvaluateBatchResponse),
+      ZETASQL_DIRECT_CALL(PrepareQuery, PrepareQueryRequest,
+                          PrepareQueryResponse),
+      ZETASQL_DIRECT_CALL(UnprepareQuery, UnprepareQueryRequest,
+                          google::protobuf::Empty),
+      ZETASQL_DIRECT_CALL(EvaluateQuery, EvaluateQueryRequest,
+                          EvaluateQueryResponse),
+      ZETASQL_DIRECT_CALL(PrepareModify, PrepareModifyRequest,
+                          PrepareModifyResponse),
+      ZETASQL_DIRECT_CALL(UnprepareModify, UnprepareModifyRequest,
+                          google::protobuf::Empty),
+      ZETASQL_DIRECT_CALL(EvaluateModify, EvaluateModifyRequest,
+                          EvaluateModifyResponse),
+      ZETASQL_DIRECT_CALL(GetTableFromProto, TableFromProtoRequest,
+                          SimpleTableProto),
+      ZETASQL_DIRECT_CALL(Analyze, AnalyzeRequest, AnalyzeResponse),
+      ZETASQL_DIRECT_CALL(BuildSql, BuildSqlRequest, BuildSqlResponse),
+      ZETASQL_DIRECT_CALL(ExtractTableNamesFromStatement,
+                          ExtractTableNamesFromStatementRequest,
+                          ExtractTableNamesFromStatementResponse),
+      ZETASQL_DIRECT_CALL(ExtractTableNamesFromNextStatement,
+                          ExtractTableNamesFromNextStatementRequest,
+                          ExtractTableNamesFromNextStatementResponse),
+      ZETASQL_DIRECT_CALL(FormatSql, FormatSqlRequest, FormatSqlResponse),
+      ZETASQL_DIRECT_CALL(RegisterCatalog, RegisterCatalogRequest,
+                          RegisterResponse),
+      ZETASQL_DIRECT_CALL(UnregisterCatalog, UnregisterRequest,
+                          google::protobuf::Empty),
+      ZETASQL_DIRECT_CALL(GetBuiltinFunctions,
+                          ZetaSQLBuiltinFunctionOptionsProto,
+                          GetBuiltinFunctionsResponse),
+      ZETASQL_DIRECT_CALL(GetLanguageOptions, LanguageOptionsRequest,
+                          LanguageOptionsProto),
+      ZETASQL_DIRECT_CALL(GetAnalyzerOptions, AnalyzerOptionsRequest,
+                          AnalyzerOptionsProto),
+      ZETASQL_DIRECT_CALL(Parse, ParseRequest, ParseResponse),
+  });
+  return *calls;
+}
+
+#undef ZETASQL_DIRECT_CALL
+
 }  // namespace
 
+jbyteArray CallDirect(JNIEnv* env, jclass clazz, jstring method,
+                      jobject request, jint length) {
+  const char* method_str = env->GetStringUTFChars(method, nullptr);
+  if (method_str == nullptr) {
+    return nullptr;
+  }
+  const auto& calls = GetDirectCalls();
+  auto it = calls.find(method_str);
+  env->ReleaseStringUTFChars(method, method_str);
+  if (it == calls.end()) {
+    ThrowDirectCallException(
+        env, grpc::Status(grpc::UNIMPLEMENTED,
+                          "Method is not available for direct calls"));
+    return nullptr;
+  }
+
+  const void* data = env->GetDirectBufferAddress(request);
+  if (data == nullptr || length < 0 ||
+      length > env->GetDirectBufferCapacity(request)) {
+    ThrowDirectCallException(
+        env, grpc::Status(grpc::INVALID_ARGUMENT,
+                          "Request must be in a direct ByteBuffer"));
+    return nullptr;
+  }
+  return it->second(env, data, length);
+}
+
 jobject GetSocketChannel(JNIEnv* env) {
   jclass impl = env->FindClass("sun/nio/ch/SocketChannelImpl");
   if (impl == nullptr) {
@@ -168,15 +326,32 @@ extern "C" JNIEXPORT jint JNICALL JNI_OnLoad_zetasql_local_service(JavaVM* vm,
 
   const char* classnamestr = env->GetStringUTFChars(classname, nullptr);
   jclass clazz = env->FindClass(classnamestr);
+  const std::string exceptionname =
+      std::string(classnamestr) + "$DirectCallException";
   env->ReleaseStringUTFChars(classname, classnamestr);
   classnamestr = nullptr;
   if (clazz == nullptr) {
     return -1;
   }
 
+  jclass exception = env->FindClass(exceptionname.c_str());
+  if (exception == nullptr) {
+    return -1;
+  }
+  direct_call_exception = (jclass)env->NewGlobalRef(exception);
+  direct_call_exception_init =
+      env->GetMethodID(exception, "<init>", "(I[B)V");
+  if (direct_call_exception == nullptr ||
+      direct_call_exception_init == nullptr) {
+    return -1;
+  }
+
   static JNINativeMethod methods[] = {
       {(char*)"getSocketChannel", (char*)"()Ljava/nio/channels/SocketChannel;",
        (void*)GetSocketChannel},
+      {(char*)"callDirect",
+       (char*)"(Ljava/lang/String;Ljava/nio/ByteBuffer;I)[B",
+       (void*)CallDirect},
   };
   if (env->RegisterNatives(clazz, methods,
                            sizeof(methods) / sizeof(JNINativeMethod)) !=
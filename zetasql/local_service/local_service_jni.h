@@ -26,6 +26,13 @@ namespace local_service {
 // and connects the other end to the local_service gRPC server.
 jobject GetSocketChannel(JNIEnv* env);
 
+// Runs the unary local_service method named 'method' in-process, bypassing
+// gRPC. 'request' is a direct ByteBuffer holding 'length' bytes of the
+// serialized request. Returns the serialized response, or throws a
+// DirectCallException carrying the grpc status code and message.
+jbyteArray CallDirect(JNIEnv* env, jclass clazz, jstring method,
+                      jobject request, jint length);
+
 }  // namespace local_service
 }  // namespace zetasql
 
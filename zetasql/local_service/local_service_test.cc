@@ -31,6 +31,7 @@
 #include "zetasql/common/testing/proto_matchers.h"
 #include "zetasql/base/testing/status_matchers.h"
 #include "zetasql/common/testing/testing_proto_util.h"
+#include "zetasql/local_service/compact_table_data.h"
 #include "zetasql/proto/function.pb.h"
 #include "zetasql/proto/simple_catalog.pb.h"
 #include "zetasql/public/functions/date_time_util.h"
@@ -53,9 +54,12 @@ namespace zetasql {
 
 using google::protobuf::Int64Value;
 using ::zetasql::testing::EqualsProto;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
 using ::testing::IsEmpty;
 using ::testing::Not;
 using ::zetasql_base::testing::IsOk;
+using ::zetasql_base::testing::IsOkAndHolds;
 using ::zetasql_base::testing::StatusIs;
 namespace local_service {
 
@@ -115,6 +119,11 @@ class ZetaSqlLocalServiceImplTest : public ::testing::Test {
     return service_.Evaluate(request, response);
   }
 
+  absl::Status EvaluateBatch(const EvaluateBatchRequest& request,
+                             EvaluateBatchResponse* response) {
+    return service_.EvaluateBatch(request, response);
+  }
+
   absl::Status EvaluateQuery(const EvaluateQueryRequest& request,
                              EvaluateQueryResponse* response) {
     return service_.EvaluateQuery(request, response);
@@ -177,6 +186,15 @@ class ZetaSqlLocalServiceImplTest : public ::testing::Test {
     return service_.NumSavedPreparedModifies();
   }
 
+  static size_t NumCachedDescriptorPools(
+      const ZetaSqlLocalServiceImpl& service) {
+    return service.NumCachedDescriptorPools();
+  }
+
+  static size_t NumCachedCatalogs(const ZetaSqlLocalServiceImpl& service) {
+    return service.NumCachedCatalogs();
+  }
+
   absl::Status GetTableFromProto(const TableFromProtoRequest& request,
                                  SimpleTableProto* response) {
     return service_.GetTableFromProto(request, response);
@@ -369,6 +387,66 @@ TEST_F(ZetaSqlLocalServiceImplTest, EvaluateWithWrongId) {
   EXPECT_EQ(0, NumSavedPreparedExpression());
 }
 
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateBatch) {
+  PrepareRequest prepare_request;
+  prepare_request.set_sql("foo * @bar");
+  auto* column_type =
+      prepare_request.mutable_options()->add_expression_columns();
+  column_type->set_name("foo");
+  column_type->mutable_type()->set_type_kind(TYPE_INT64);
+  auto* param_type = prepare_request.mutable_options()->add_query_parameters();
+  param_type->set_name("bar");
+  param_type->mutable_type()->set_type_kind(TYPE_INT64);
+  PrepareResponse prepare_response;
+  ZETASQL_ASSERT_OK(Prepare(prepare_request, &prepare_response));
+  const int64_t id = prepare_response.prepared().prepared_expression_id();
+
+  EvaluateBatchRequest request;
+  request.set_prepared_expression_id(id);
+  request.set_row_count(3);
+  auto* column = request.add_columns();
+  column->set_name("FOO");
+  column->add_values()->set_int64_value(1);
+  column->add_values()->set_int64_value(2);
+  column->add_values();
+  auto* param = request.add_params();
+  param->set_name("bar");
+  param->mutable_value()->set_int64_value(10);
+
+  EvaluateBatchResponse response;
+  ZETASQL_ASSERT_OK(EvaluateBatch(request, &response));
+  ASSERT_EQ(response.values_size(), 3);
+  EXPECT_EQ(response.values(0).int64_value(), 10);
+  EXPECT_EQ(response.values(1).int64_value(), 20);
+  EXPECT_EQ(response.values(2).value_case(), ValueProto::VALUE_NOT_SET);
+
+  EvaluateBatchRequest bad_request = request;
+  bad_request.set_row_count(2);
+  EXPECT_THAT(EvaluateBatch(bad_request, &response),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected 2 values for each column")));
+
+  bad_request = request;
+  bad_request.clear_columns();
+  EXPECT_THAT(EvaluateBatch(bad_request, &response),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Incomplete column parameters foo")));
+
+  bad_request = request;
+  bad_request.clear_params();
+  EXPECT_THAT(EvaluateBatch(bad_request, &response),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Incomplete query parameters bar")));
+
+  bad_request = request;
+  bad_request.set_prepared_expression_id(id + 1);
+  EXPECT_THAT(EvaluateBatch(bad_request, &response),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("unknown")));
+
+  ZETASQL_EXPECT_OK(Unprepare(id));
+}
+
 TEST_F(ZetaSqlLocalServiceImplTest, EvaluateFailuresNoRegister) {
   EvaluateRequest request;
   EvaluateResponse response;
@@ -2636,6 +2714,126 @@ TEST_F(ZetaSqlLocalServiceImplTest, EvaluateQueryWithSqlWithParam) {
   ExpectValueIsString(row_0.cell(0), "cherry");
 }
 
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateQueryWithCompactRows) {
+  EvaluateQueryRequest evaluate_request;
+  evaluate_request.set_sql(
+      "SELECT x, CAST(x AS STRING) AS s FROM UNNEST([1, 2, 1]) AS x "
+      "WITH OFFSET AS pos ORDER BY pos");
+  evaluate_request.set_row_encoding(EvaluateQueryRequest::COMPACT);
+
+  EvaluateQueryResponse evaluate_response;
+  ZETASQL_ASSERT_OK(EvaluateQuery(evaluate_request, &evaluate_response));
+  ASSERT_EQ(evaluate_response.prepared().columns_size(), 2);
+  EXPECT_FALSE(evaluate_response.content().has_table_data());
+  const CompactTableData& data =
+      evaluate_response.content().compact_table_data();
+  EXPECT_EQ(data.row_count(), 3);
+  // The string table holds "1" once.
+  EXPECT_THAT(data.string_table(), ElementsAre("1", "2"));
+
+  const std::vector<const Type*> column_types = {types::Int64Type(),
+                                                 types::StringType()};
+  EXPECT_THAT(DecodeCompactTableData(data, column_types),
+              IsOkAndHolds(ElementsAre(
+                  ElementsAre(Value::Int64(1), Value::String("1")),
+                  ElementsAre(Value::Int64(2), Value::String("2")),
+                  ElementsAre(Value::Int64(1), Value::String("1")))));
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateQueryChunked) {
+  EvaluateQueryRequest request;
+  request.set_sql(
+      "SELECT x, CAST(MOD(x, 3) AS STRING) AS s "
+      "FROM UNNEST(GENERATE_ARRAY(1, 100)) AS x WITH OFFSET AS pos "
+      "ORDER BY pos");
+  request.set_max_chunk_bytes(64);
+
+  for (auto encoding :
+       {EvaluateQueryRequest::VALUE_PROTO, EvaluateQueryRequest::COMPACT}) {
+    request.set_row_encoding(encoding);
+    std::vector<EvaluateQueryResponse> chunks;
+    ZETASQL_ASSERT_OK(service_.EvaluateQueryChunked(
+        request, [&chunks](const EvaluateQueryResponse& chunk) {
+          chunks.push_back(chunk);
+          return true;
+        }));
+    ASSERT_GT(chunks.size(), 1);
+    EXPECT_EQ(chunks[0].prepared().columns_size(), 2);
+
+    int64_t next_x = 1;
+    for (int i = 0; i < chunks.size(); ++i) {
+      EXPECT_EQ(chunks[i].has_prepared(), i == 0);
+      std::vector<std::vector<Value>> rows;
+      if (encoding == EvaluateQueryRequest::COMPACT) {
+        // Each chunk has its own string table.
+        ZETASQL_ASSERT_OK_AND_ASSIGN(
+            rows, DecodeCompactTableData(
+                      chunks[i].content().compact_table_data(),
+                      {types::Int64Type(), types::StringType()}));
+      } else {
+        for (const TableData::Row& row :
+             chunks[i].content().table_data().row()) {
+          rows.push_back({Value::Int64(row.cell(0).int64_value())});
+        }
+      }
+      EXPECT_FALSE(rows.empty());
+      for (const std::vector<Value>& row : rows) {
+        EXPECT_EQ(row[0], Value::Int64(next_x++));
+      }
+    }
+    EXPECT_EQ(next_x, 101);
+  }
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateQueryChunkedEmptyResult) {
+  EvaluateQueryRequest request;
+  request.set_sql("SELECT 1 AS x LIMIT 0");
+  std::vector<EvaluateQueryResponse> chunks;
+  ZETASQL_ASSERT_OK(service_.EvaluateQueryChunked(
+      request, [&chunks](const EvaluateQueryResponse& chunk) {
+        chunks.push_back(chunk);
+        return true;
+      }));
+  ASSERT_EQ(chunks.size(), 1);
+  EXPECT_EQ(chunks[0].prepared().columns_size(), 1);
+  EXPECT_EQ(chunks[0].content().table_data().row_size(), 0);
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateQueryChunkedCancelled) {
+  EvaluateQueryRequest request;
+  request.set_sql("SELECT x FROM UNNEST(GENERATE_ARRAY(1, 1000)) AS x");
+  request.set_max_chunk_bytes(16);
+  int num_chunks = 0;
+  EXPECT_THAT(service_.EvaluateQueryChunked(
+                  request,
+                  [&num_chunks](const EvaluateQueryResponse& chunk) {
+                    return ++num_chunks < 2;
+                  }),
+              StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_EQ(num_chunks, 2);
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest,
+       EvaluateQueryChunkedCancelledBeforeFirstRow) {
+  // Counting a billion rows does not finish unless the query is cancelled
+  // while it computes its only row.
+  EvaluateQueryRequest request;
+  request.set_sql(
+      "SELECT COUNT(*) FROM UNNEST(GENERATE_ARRAY(1, 1000)) AS a, "
+      "UNNEST(GENERATE_ARRAY(1, 1000)) AS b, "
+      "UNNEST(GENERATE_ARRAY(1, 1000)) AS c");
+  int num_chunks = 0;
+  EXPECT_THAT(service_.EvaluateQueryChunked(
+                  request,
+                  [&num_chunks](const EvaluateQueryResponse& chunk) {
+                    ++num_chunks;
+                    return true;
+                  },
+                  /*is_cancelled=*/[] { return true; }),
+              StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_EQ(num_chunks, 0);
+}
+
 TEST_F(ZetaSqlLocalServiceImplTest,
        EvaluateQueryWithDescriptorPoolListProto) {
   // Evaluate Query
@@ -2820,6 +3018,86 @@ TEST_F(ZetaSqlLocalServiceImplTest, EvaluateQueryWithFullCatalogTableData) {
   ExpectValueIsInt32(row_0.cell(0), 123);
 }
 
+
+TEST_F(ZetaSqlLocalServiceImplTest, AnalyzeReusesInlineCatalog) {
+  AnalyzeRequest request;
+  request.set_sql_statement("select column_int from TestTable;");
+  AddBuiltin(request.mutable_descriptor_pool_list());
+  AddKitchenSinkDescriptorPool(request.mutable_descriptor_pool_list());
+  AddTestTable(request.mutable_simple_catalog()->add_table(), "TestTable");
+
+  AnalyzeResponse response;
+  ZETASQL_ASSERT_OK(Analyze(request, &response));
+  AnalyzeResponse cached_response;
+  ZETASQL_ASSERT_OK(Analyze(request, &cached_response));
+  EXPECT_THAT(cached_response, EqualsProto(response));
+  EXPECT_EQ(1, NumCachedDescriptorPools(service_));
+  EXPECT_EQ(1, NumCachedCatalogs(service_));
+
+  // A different catalog with the same descriptor pools.
+  AddTestTable(request.mutable_simple_catalog()->add_table(), "OtherTable");
+  ZETASQL_ASSERT_OK(Analyze(request, &response));
+  EXPECT_EQ(1, NumCachedDescriptorPools(service_));
+  EXPECT_EQ(2, NumCachedCatalogs(service_));
+
+  // Registering descriptor pools never uses the cache.
+  PrepareRequest prepare_request;
+  prepare_request.set_sql("1");
+  AddKitchenSinkDescriptorPool(prepare_request.mutable_descriptor_pool_list());
+  PrepareResponse prepare_response;
+  ZETASQL_ASSERT_OK(Prepare(prepare_request, &prepare_response));
+  EXPECT_EQ(1, NumCachedDescriptorPools(service_));
+  ZETASQL_EXPECT_OK(
+      Unprepare(prepare_response.prepared().prepared_expression_id()));
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, EvaluateQueryCachesCatalogPerContent) {
+  EvaluateQueryRequest request;
+  request.set_sql(
+      R"(SELECT column_int FROM TestTable WHERE column_str = "string_1")");
+  request.mutable_simple_catalog()->mutable_builtin_function_options();
+  AddTestTable(request.mutable_simple_catalog()->add_table(), "TestTable");
+  InsertTestTableContent(request.mutable_table_content(), "TestTable");
+
+  for (int i = 0; i < 2; ++i) {
+    EvaluateQueryResponse response;
+    ZETASQL_ASSERT_OK(EvaluateQuery(request, &response));
+    ASSERT_EQ(response.content().table_data().row_size(), 1);
+    ExpectValueIsInt32(response.content().table_data().row(0).cell(0), 123);
+  }
+  EXPECT_EQ(1, NumCachedCatalogs(service_));
+
+  // New table contents must not be served from the cached catalog.
+  (*request.mutable_table_content())["TestTable"]
+      .mutable_table_data()
+      ->mutable_row(0)
+      ->mutable_cell(2)
+      ->set_int32_value(456);
+  EvaluateQueryResponse response;
+  ZETASQL_ASSERT_OK(EvaluateQuery(request, &response));
+  ASSERT_EQ(response.content().table_data().row_size(), 1);
+  ExpectValueIsInt32(response.content().table_data().row(0).cell(0), 456);
+  EXPECT_EQ(2, NumCachedCatalogs(service_));
+}
+
+TEST_F(ZetaSqlLocalServiceImplTest, CacheLimits) {
+  LocalServiceCacheOptions options;
+  options.max_cached_catalogs = 1;
+  options.max_descriptor_pool_cache_bytes = 0;
+  ZetaSqlLocalServiceImpl service(options);
+
+  AnalyzeRequest request;
+  request.set_sql_statement("select 1;");
+  AddKitchenSinkDescriptorPool(request.mutable_descriptor_pool_list());
+  AnalyzeResponse response;
+  ZETASQL_ASSERT_OK(service.Analyze(request, &response));
+  EXPECT_EQ(0, NumCachedDescriptorPools(service));
+  EXPECT_EQ(1, NumCachedCatalogs(service));
+
+  request.mutable_descriptor_pool_list()->Clear();
+  ZETASQL_ASSERT_OK(service.Analyze(request, &response));
+  EXPECT_EQ(1, NumCachedCatalogs(service));
+}
 TEST_F(ZetaSqlLocalServiceImplTest,
        EvaluateQueryWithDescriptorPoolListProtoWithFullCatalogTableData) {
   // Evaluate Query
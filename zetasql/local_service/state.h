@@ -20,11 +20,17 @@
 #include <stddef.h>
 
 #include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
+#include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "zetasql/base/map_util.h"
 
@@ -121,6 +127,89 @@ class SharedStatePool {
       "SharedStatePool only works with subclass of GenericState");
 };
 
+// Least-recently-used cache of states built from definitions that requests
+// carry inline, keyed by those serialized definitions. Holds at most
+// 'max_entries' states whose costs add up to at most 'max_cost'. Unlike
+// SharedStatePool, states are not registered and are never handed out by id;
+// an evicted state is deleted once no other thread holds it.
+template <class T>
+class StateCache {
+ public:
+  StateCache(int64_t max_entries, int64_t max_cost)
+      : max_entries_(max_entries), max_cost_(max_cost) {}
+  StateCache(const StateCache&) = delete;
+  StateCache& operator=(const StateCache&) = delete;
+
+  // Returns the state cached under 'key' and marks it as the most recently
+  // used one, or returns null if there is none.
+  std::shared_ptr<T> Lookup(const std::string& key) {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->state;
+  }
+
+  // Caches 'state' under 'key', replacing any state already cached under it,
+  // and evicts the least recently used states that no longer fit. A state
+  // whose 'cost' alone exceeds the limit is not cached.
+  void Insert(const std::string& key, std::shared_ptr<T> state,
+              int64_t cost) {
+    if (state == nullptr || max_entries_ <= 0 || cost > max_cost_) {
+      return;
+    }
+    // Evicted states are deleted after releasing the lock, since deleting a
+    // large state can take a while.
+    std::vector<std::shared_ptr<T>> evicted;
+    absl::MutexLock lock(&mutex_);
+    if (auto it = index_.find(key); it != index_.end()) {
+      const auto entry = it->second;
+      evicted.push_back(std::move(entry->state));
+      total_cost_ -= entry->cost;
+      index_.erase(it);
+      entries_.erase(entry);
+    }
+    entries_.push_front({key, std::move(state), cost});
+    index_[entries_.front().key] = entries_.begin();
+    total_cost_ += cost;
+    while (static_cast<int64_t>(entries_.size()) > max_entries_ ||
+           total_cost_ > max_cost_) {
+      Entry& lru = entries_.back();
+      evicted.push_back(std::move(lru.state));
+      total_cost_ -= lru.cost;
+      index_.erase(lru.key);
+      entries_.pop_back();
+    }
+  }
+
+  size_t NumEntries() const {
+    absl::MutexLock lock(&mutex_);
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    std::shared_ptr<T> state;
+    int64_t cost;
+  };
+
+  const int64_t max_entries_;
+  const int64_t max_cost_;
+
+  mutable absl::Mutex mutex_;
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  // Keys point into the 'key' of the corresponding entry, since keys can be
+  // as large as the definitions they are built from.
+  absl::flat_hash_map<absl::string_view,
+                      typename std::list<Entry>::iterator>
+      index_ ABSL_GUARDED_BY(mutex_);
+  int64_t total_cost_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
 // Base class of saved states with an int64_t id.
 class GenericState {
  public:
@@ -16,8 +16,10 @@
 
 #include "zetasql/public/evaluator_base.h"
 
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -47,7 +49,10 @@
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
@@ -98,7 +103,8 @@ class ParameterValues {
       parameters_;
 };
 
-// Implements EvaluatorTableModifyIterator by wrapping a vector of updated rows.
+// Implements EvaluatorTableModifyIterator by wrapping an array of updated rows.
+// The array is shared with the DML output value rather than copied.
 //
 // Requires the same operation for all rows.
 //
@@ -111,7 +117,7 @@ class ParameterValues {
 // This is currently used by Evaluator to detect outliving iterators.
 class VectorEvaluatorTableModifyIterator : public EvaluatorTableModifyIterator {
  public:
-  VectorEvaluatorTableModifyIterator(const std::vector<Value>& rows,
+  VectorEvaluatorTableModifyIterator(const Value& rows,
                                      const Table* table, Operation operation,
                                      const std::function<void()>& deletion_cb)
       : rows_(rows),
@@ -121,12 +127,12 @@ class VectorEvaluatorTableModifyIterator : public EvaluatorTableModifyIterator {
 
   ~VectorEvaluatorTableModifyIterator() override { deletion_cb_(); }
 
-  bool NextRow() override { return ++row_idx_ < rows_.size(); }
+  bool NextRow() override { return ++row_idx_ < rows_.num_elements(); }
 
   const Value& GetColumnValue(int i) const override {
     return operation_ == EvaluatorTableModifyIterator::Operation::kDelete
                ? invalid_value_
-               : rows_[row_idx_].field(i);
+               : rows_.element(row_idx_).field(i);
   }
 
   absl::Status Status() const override { return absl::OkStatus(); }
@@ -134,7 +140,7 @@ class VectorEvaluatorTableModifyIterator : public EvaluatorTableModifyIterator {
   const Value& GetOriginalKeyValue(int i) const override {
     return operation_ == EvaluatorTableModifyIterator::Operation::kInsert
                ? invalid_value_
-               : rows_[row_idx_].field(table_->PrimaryKey()->at(i));
+               : rows_.element(row_idx_).field(table_->PrimaryKey()->at(i));
   }
 
   Operation GetOperation() const override { return operation_; }
@@ -142,8 +148,9 @@ class VectorEvaluatorTableModifyIterator : public EvaluatorTableModifyIterator {
   const Table* table() const override { return table_; }
 
  private:
-  // The content of the iterator. Each item represents a row update operation.
-  const std::vector<Value> rows_;
+  // The content of the iterator, an array in which each element represents a
+  // row update operation.
+  const Value rows_;
   // The table to be updated.
   const Table* table_;
   // The type of operation for all rows.
@@ -198,30 +205,39 @@ class Evaluator {
   }
 
   // For expressions, populates 'expression_output_value'. For queries,
-  // populates 'query_output_iterator'.
+  // populates 'query_output_iterator', and if 'profile' is non-NULL, profiles
+  // the execution and populates 'profile' when the iterator is destroyed.
   absl::Status Execute(
       const ExpressionOptions& options, Value* expression_output_value,
-      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator)
-      ABSL_LOCKS_EXCLUDED(mutex_);
+      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+      OperatorProfile* profile = nullptr) ABSL_LOCKS_EXCLUDED(mutex_);
 
   absl::Status ExecuteAfterPrepare(
       const ExpressionOptions& options, Value* expression_output_value,
-      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const
-      ABSL_LOCKS_EXCLUDED(mutex_) {
+      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+      OperatorProfile* profile = nullptr) const ABSL_LOCKS_EXCLUDED(mutex_) {
     absl::ReaderMutexLock l(&mutex_);
     return ExecuteAfterPrepareLocked(options, expression_output_value,
-                                     query_output_iterator);
+                                     query_output_iterator, profile);
   }
 
   absl::Status ExecuteAfterPrepareWithOrderedParams(
       const ExpressionOptions& options, Value* expression_output_value,
-      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const
-      ABSL_LOCKS_EXCLUDED(mutex_) {
+      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+      OperatorProfile* profile = nullptr) const ABSL_LOCKS_EXCLUDED(mutex_) {
     absl::ReaderMutexLock l(&mutex_);
     return ExecuteAfterPrepareWithOrderedParamsLocked(
-        options, expression_output_value, query_output_iterator);
+        options, expression_output_value, query_output_iterator, profile);
   }
 
+  // Evaluates the prepared expression once per row, reusing one
+  // EvaluationContext and parameter tuple. See
+  // PreparedExpressionBase::ExecuteBatchAfterPrepare().
+  absl::Status ExecuteBatchAfterPrepare(
+      absl::Span<const ParameterValueList> columns,
+      const ParameterValueList& parameters, int64_t num_rows,
+      std::vector<Value>* output) const ABSL_LOCKS_EXCLUDED(mutex_);
+
   absl::StatusOr<std::string> ExplainAfterPrepare() const
       ABSL_LOCKS_EXCLUDED(mutex_);
 
@@ -305,19 +321,25 @@ class Evaluator {
   absl::Status PrepareLocked(const AnalyzerOptions& options, Catalog* catalog)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Implements PrepareLocked(). Records the time of each phase in 'event'
+  // unless it is NULL.
+  absl::Status PrepareLockedImpl(const AnalyzerOptions& options,
+                                 Catalog* catalog, EvaluatorPrepareEvent* event)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // Same as ExecuteAfterPrepare(), but the mutex is already locked (possibly
   // with a write lock).
   absl::Status ExecuteAfterPrepareLocked(
       const ExpressionOptions& options, Value* expression_output_value,
-      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const
-      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+      OperatorProfile* profile) const ABSL_SHARED_LOCKS_REQUIRED(mutex_);
 
   // Same as ExecuteAfterPrepareWithOrderedParams(), but with the mutex already
   // locked.
   absl::Status ExecuteAfterPrepareWithOrderedParamsLocked(
       const ExpressionOptions& options, Value* expression_output_value,
-      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const
-      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+      std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+      OperatorProfile* profile) const ABSL_SHARED_LOCKS_REQUIRED(mutex_);
 
   // Checks if 'parameters_map' specifies valid values for all variables from
   // resolved variable map 'variable_map', and populates 'values' with the
@@ -461,10 +483,44 @@ namespace {
 static std::string HideInternalName(const std::string& name) {
   return IsInternalAlias(name) ? "" : name;
 }
+
+// Adds the time from its construction to its destruction to '*duration',
+// unless 'duration' is NULL.
+class ScopedPhaseTimer {
+ public:
+  explicit ScopedPhaseTimer(absl::Duration* duration) : duration_(duration) {
+    if (duration_ != nullptr) start_ = absl::Now();
+  }
+  ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+  ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+  ~ScopedPhaseTimer() {
+    if (duration_ != nullptr) *duration_ += absl::Now() - start_;
+  }
+
+ private:
+  absl::Duration* const duration_;
+  absl::Time start_;
+};
 }  // namespace
 
 absl::Status Evaluator::PrepareLocked(const AnalyzerOptions& options,
                                       Catalog* catalog) {
+  EvaluatorListener* listener = evaluator_options_.listener;
+  if (listener == nullptr) {
+    return PrepareLockedImpl(options, catalog, /*event=*/nullptr);
+  }
+  EvaluatorPrepareEvent event;
+  event.sql = sql_;
+  event.start_time = absl::Now();
+  event.status = PrepareLockedImpl(options, catalog, &event);
+  listener->OnPrepare(event);
+  return event.status;
+}
+
+absl::Status Evaluator::PrepareLockedImpl(const AnalyzerOptions& options,
+                                          Catalog* catalog,
+                                          EvaluatorPrepareEvent* event) {
   if (is_prepared()) {
     return ::zetasql_base::InvalidArgumentErrorBuilder() << "Prepare called twice";
   }
@@ -488,10 +544,15 @@ absl::Status Evaluator::PrepareLocked(const AnalyzerOptions& options,
   algebrizer_options.allow_hash_join = true;
   algebrizer_options.allow_order_by_limit_operator = true;
   algebrizer_options.push_down_filters = true;
+  // Safe because CreateEvaluationContext() never asks for all rows from DML.
+  algebrizer_options.push_down_dml_filters = true;
   algebrizer_options.inline_with_entries = true;
+  algebrizer_options.share_with_entry_scans = true;
+  algebrizer_options.push_down_row_count_hints = true;
 
   if (!is_expr_) {
     if (statement_ == nullptr) {
+      ScopedPhaseTimer timer(event == nullptr ? nullptr : &event->analyze_time);
       ZETASQL_RETURN_IF_ERROR(AnalyzeStatement(sql_, analyzer_options_, catalog,
                                        evaluator_options_.type_factory,
                                        &analyzer_output_));
@@ -499,11 +560,15 @@ absl::Status Evaluator::PrepareLocked(const AnalyzerOptions& options,
     } else {
       // TODO: When we're confident that it's no longer possible to
       // crash the reference implementation, remove this validation step.
+      ScopedPhaseTimer timer(event == nullptr ? nullptr
+                                              : &event->validate_time);
       ZETASQL_RETURN_IF_ERROR(
           Validator(options.language()).ValidateResolvedStatement(statement_));
     }
 
     // Algebrize.
+    ScopedPhaseTimer timer(event == nullptr ? nullptr
+                                            : &event->algebrize_time);
     if (analyzer_options_.parameter_mode() == PARAMETER_POSITIONAL) {
       algebrizer_parameters_.set_named(false);
     }
@@ -542,6 +607,7 @@ absl::Status Evaluator::PrepareLocked(const AnalyzerOptions& options,
     }
   } else {
     if (expr_ == nullptr) {
+      ScopedPhaseTimer timer(event == nullptr ? nullptr : &event->analyze_time);
       ZETASQL_RETURN_IF_ERROR(AnalyzeExpression(sql_, analyzer_options_, catalog,
                                         evaluator_options_.type_factory,
                                         &analyzer_output_));
@@ -549,11 +615,15 @@ absl::Status Evaluator::PrepareLocked(const AnalyzerOptions& options,
     } else {
       // TODO: When we're confident that it's no longer possible to
       // crash the reference implementation, remove this validation step.
+      ScopedPhaseTimer timer(event == nullptr ? nullptr
+                                              : &event->validate_time);
       ZETASQL_RETURN_IF_ERROR(
           Validator(options.language()).ValidateStandaloneResolvedExpr(expr_));
     }
 
     // Algebrize.
+    ScopedPhaseTimer timer(event == nullptr ? nullptr
+                                            : &event->algebrize_time);
     if (analyzer_options_.parameter_mode() == PARAMETER_POSITIONAL) {
       algebrizer_parameters_.set_named(false);
     }
@@ -679,7 +749,8 @@ absl::Status Evaluator::TranslateParameterValueMapToList(
 
 absl::Status Evaluator::Execute(
     const ExpressionOptions& options, Value* expression_output_value,
-    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) {
+    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+    OperatorProfile* profile) {
   {
     const ParameterValues parameters =
         options.parameters.has_value()
@@ -732,12 +803,13 @@ absl::Status Evaluator::Execute(
 
   absl::ReaderMutexLock l(&mutex_);
   return ExecuteAfterPrepareLocked(options, expression_output_value,
-                                   query_output_iterator);
+                                   query_output_iterator, profile);
 }
 
 absl::Status Evaluator::ExecuteAfterPrepareLocked(
     const ExpressionOptions& options, Value* expression_output_value,
-    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const {
+    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+    OperatorProfile* profile) const {
   if (!has_prepare_succeeded()) {
     // Previous Prepare() failed with an analysis error or Prepare was never
     // called. Returns an error for consistency.
@@ -768,7 +840,7 @@ absl::Status Evaluator::ExecuteAfterPrepareLocked(
   new_options.ordered_parameters = parameters_list;
 
   return ExecuteAfterPrepareWithOrderedParamsLocked(
-      new_options, expression_output_value, query_output_iterator);
+      new_options, expression_output_value, query_output_iterator, profile);
 }
 
 absl::StatusOr<std::unique_ptr<EvaluatorTableModifyIterator>>
@@ -805,11 +877,89 @@ Evaluator::MakeUpdateIterator(const Value& value,
   ZETASQL_RET_CHECK(value.field(1).type()->IsArray());
   IncrementNumLiveIterators();
   return absl::make_unique<VectorEvaluatorTableModifyIterator>(
-      value.field(1).elements(), table, operation,
+      value.field(1), table, operation,
       std::bind(&Evaluator::DecrementNumLiveIterators, this));
 }
 
 namespace {
+// Appends to 'profiles' the profiles of the relational operators in the tree
+// rooted at 'node' that are not nested in another relational operator of that
+// tree, omitting those that were never evaluated. Relational operators nested
+// in expressions (e.g., subqueries) become inputs of the closest enclosing
+// relational operator.
+void AppendOperatorProfiles(const AlgebraNode& node,
+                            const OperatorProfiler& profiler,
+                            std::vector<OperatorProfile>* profiles) {
+  const RelationalOp* op = node.AsRelationalOp();
+  if (op == nullptr) {
+    for (const AlgebraArg* arg : node.GetArgs()) {
+      if (arg->has_node()) {
+        AppendOperatorProfiles(*arg->node(), profiler, profiles);
+      }
+    }
+    return;
+  }
+  const OperatorStats* stats = profiler.GetStats(op);
+  if (stats == nullptr) return;
+
+  OperatorProfile profile;
+  // The debug string of an operator starts with its name, e.g., "SortOp(".
+  const std::string debug_string = op->DebugString();
+  profile.name = debug_string.substr(0, debug_string.find('('));
+  profile.num_evaluations = stats->num_iterators;
+  profile.num_next_calls = stats->num_next_calls;
+  profile.num_rows_out = stats->num_rows;
+  profile.wall_time = stats->wall_time;
+  profile.cpu_time = stats->cpu_time;
+  profile.peak_memory_bytes = stats->peak_memory_bytes;
+  profile.counters = stats->counters;
+  for (const AlgebraArg* arg : op->GetArgs()) {
+    if (arg->has_node()) {
+      AppendOperatorProfiles(*arg->node(), profiler, &profile.inputs);
+    }
+  }
+  for (const OperatorProfile& input : profile.inputs) {
+    profile.num_rows_in += input.num_rows_out;
+  }
+  profiles->push_back(std::move(profile));
+}
+
+// Returns the profile of the query evaluated by 'root'.
+OperatorProfile GetOperatorProfile(const RelationalOp& root,
+                                   const OperatorProfiler& profiler) {
+  std::vector<OperatorProfile> profiles;
+  AppendOperatorProfiles(root, profiler, &profiles);
+  if (profiles.empty()) {
+    // The iterator was destroyed before the query started.
+    OperatorProfile profile;
+    const std::string debug_string = root.DebugString();
+    profile.name = debug_string.substr(0, debug_string.find('('));
+    return profile;
+  }
+  return std::move(profiles[0]);
+}
+
+// Returns the event of an execution of 'sql' that started at 'start_time',
+// used 'context' and finished with 'status'.
+EvaluatorExecuteEvent MakeExecuteEvent(absl::string_view sql,
+                                       absl::Time start_time,
+                                       const absl::Status& status,
+                                       EvaluationContext* context) {
+  EvaluatorExecuteEvent event;
+  event.sql = sql;
+  event.status = status;
+  event.start_time = start_time;
+  event.execute_time = absl::Now() - start_time;
+  const EvaluationCounters& counters = *context->counters();
+  event.rows_scanned = counters.rows_scanned;
+  event.intermediate_bytes_requested =
+      context->memory_accountant()->total_requested_bytes();
+  event.peak_intermediate_bytes = context->memory_accountant()->peak_bytes();
+  event.num_regexps_compiled = counters.num_regexps_compiled;
+  event.num_json_parses = counters.num_json_parses;
+  return event;
+}
+
 // An EvaluatorTableIterator representation of a TupleIterator.
 class TupleIteratorAdaptor : public EvaluatorTableIterator {
  public:
@@ -825,6 +975,7 @@ class TupleIteratorAdaptor : public EvaluatorTableIterator {
       : columns_(columns),
         tuple_indexes_(tuple_indexes),
         deletion_cb_(deletion_cb),
+        cancellation_context_(context.get()),
         context_(std::move(context)),
         iter_(std::move(iter)) {}
 
@@ -857,8 +1008,15 @@ class TupleIteratorAdaptor : public EvaluatorTableIterator {
   }
 
   absl::Status Cancel() override {
-    absl::MutexLock l(&mutex_);
-    return context_->CancelStatement();
+    // NextRow() holds 'mutex_' while it evaluates, which can take arbitrarily
+    // long before the first row. Flag the cancellation without the lock so
+    // that the evaluation notices it, and only run the cancellation callbacks
+    // if no row is being evaluated.
+    cancellation_context_->RequestCancellation();
+    if (!mutex_.TryLock()) return absl::OkStatus();
+    const absl::Status status = context_->CancelStatement();
+    mutex_.Unlock();
+    return status;
   }
 
   void SetDeadline(absl::Time deadline) override {
@@ -870,6 +1028,8 @@ class TupleIteratorAdaptor : public EvaluatorTableIterator {
   const std::vector<NameAndType> columns_;
   const std::vector<int> tuple_indexes_;
   const std::function<void()> deletion_cb_;
+  // Same as 'context_', for Cancel() to use without holding 'mutex_'.
+  EvaluationContext* const cancellation_context_;
   mutable absl::Mutex mutex_;
   std::unique_ptr<EvaluationContext> context_ ABSL_GUARDED_BY(mutex_)
       ABSL_PT_GUARDED_BY(mutex_);
@@ -884,7 +1044,8 @@ class TupleIteratorAdaptor : public EvaluatorTableIterator {
 
 absl::Status Evaluator::ExecuteAfterPrepareWithOrderedParamsLocked(
     const ExpressionOptions& options, Value* expression_output_value,
-    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator) const {
+    std::unique_ptr<EvaluatorTableIterator>* query_output_iterator,
+    OperatorProfile* profile) const {
   if (!has_prepare_succeeded()) {
     // Previous Prepare() failed with an analysis error or Prepare was never
     // called. Returns an error for consistency.
@@ -899,8 +1060,17 @@ absl::Status Evaluator::ExecuteAfterPrepareWithOrderedParamsLocked(
   ZETASQL_RETURN_IF_ERROR(ValidateParameters(parameters));
   ZETASQL_RETURN_IF_ERROR(ValidateSystemVariables(system_variables));
 
+  EvaluatorListener* listener = evaluator_options_.listener;
+  absl::Time start_time;
   std::unique_ptr<EvaluationContext> context = CreateEvaluationContext();
   context->SetStatementEvaluationDeadline(options.deadline);
+  if (profile != nullptr && compiled_relational_op_ != nullptr) {
+    context->EnableOperatorProfiling();
+  }
+  if (listener != nullptr) {
+    start_time = absl::Now();
+    context->EnableCounters();
+  }
 
   ParameterValueList params;
   params.reserve(columns.size() + parameters.size() + system_variables.size());
@@ -928,6 +1098,23 @@ absl::Status Evaluator::ExecuteAfterPrepareWithOrderedParamsLocked(
     std::function<void()> deletion_cb = [this]() {
       DecrementNumLiveIterators();
     };
+    if (profile != nullptr || listener != nullptr) {
+      // The iterator owns the EvaluationContext and 'tuple_iter', so they are
+      // still alive when it calls 'deletion_cb' from its destructor.
+      deletion_cb = [this, profile, listener, start_time,
+                     op = compiled_relational_op_.get(),
+                     context_ptr = context.get(), iter = tuple_iter.get()]() {
+        if (profile != nullptr) {
+          *profile =
+              GetOperatorProfile(*op, *context_ptr->operator_profiler());
+        }
+        if (listener != nullptr) {
+          listener->OnExecute(
+              MakeExecuteEvent(sql_, start_time, iter->Status(), context_ptr));
+        }
+        DecrementNumLiveIterators();
+      };
+    }
     *query_output_iterator = absl::make_unique<TupleIteratorAdaptor>(
         output_columns_, tuple_indexes, deletion_cb, std::move(context),
         std::move(tuple_iter));
@@ -936,8 +1123,13 @@ absl::Status Evaluator::ExecuteAfterPrepareWithOrderedParamsLocked(
 
     TupleSlot result;
     absl::Status status;
-    if (!compiled_value_expr_->EvalSimple({&params_data}, context.get(),
-                                          &result, &status)) {
+    const bool success = compiled_value_expr_->EvalSimple(
+        {&params_data}, context.get(), &result, &status);
+    if (listener != nullptr) {
+      listener->OnExecute(
+          MakeExecuteEvent(sql_, start_time, status, context.get()));
+    }
+    if (!success) {
       return status;
     }
     *expression_output_value = result.value();
@@ -946,6 +1138,94 @@ absl::Status Evaluator::ExecuteAfterPrepareWithOrderedParamsLocked(
   return absl::OkStatus();
 }
 
+absl::Status Evaluator::ExecuteBatchAfterPrepare(
+    absl::Span<const ParameterValueList> columns,
+    const ParameterValueList& parameters, int64_t num_rows,
+    std::vector<Value>* output) const {
+  absl::ReaderMutexLock l(&mutex_);
+  if (!has_prepare_succeeded()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Invalid prepared expression/query";
+  }
+  ZETASQL_RET_CHECK(compiled_value_expr_ != nullptr)
+      << "Batch evaluation is only supported for expressions";
+  ZETASQL_RET_CHECK_GE(num_rows, 0);
+
+  if (columns.size() != algebrizer_column_map_.size()) {
+    return zetasql_base::InvalidArgumentErrorBuilder()
+           << "Incorrect number of column parameters. Expected "
+           << algebrizer_column_map_.size() << " but found " << columns.size();
+  }
+  for (const ParameterValueList& column : columns) {
+    if (column.size() != num_rows) {
+      return zetasql_base::InvalidArgumentErrorBuilder()
+             << "Expected " << num_rows << " values for each column but found "
+             << column.size();
+    }
+  }
+  if (num_rows > 0) {
+    // Validate the first row fully, then only check that the remaining rows
+    // have the same types.
+    ParameterValueList first_row;
+    first_row.reserve(columns.size());
+    for (const ParameterValueList& column : columns) {
+      first_row.push_back(column[0]);
+    }
+    ZETASQL_RETURN_IF_ERROR(ValidateColumns(first_row));
+    for (const ParameterValueList& column : columns) {
+      const Type* type = column[0].type();
+      for (const Value& value : column) {
+        if (!value.type()->Equals(type)) {
+          ProductMode product_mode =
+              analyzer_options_.language().product_mode();
+          return zetasql_base::InvalidArgumentErrorBuilder()
+                 << "Expected all values of a column to be of type "
+                 << type->TypeName(product_mode) << " but found "
+                 << value.type()->TypeName(product_mode);
+        }
+      }
+    }
+  }
+  ZETASQL_RETURN_IF_ERROR(ValidateParameters(parameters));
+  ZETASQL_RETURN_IF_ERROR(ValidateSystemVariables(/*system_variables=*/{}));
+
+  EvaluatorListener* listener = evaluator_options_.listener;
+  absl::Time start_time;
+  std::unique_ptr<EvaluationContext> context = CreateEvaluationContext();
+  if (listener != nullptr) {
+    start_time = absl::Now();
+    context->EnableCounters();
+  }
+
+  // The column slots come first and are overwritten for every row, the
+  // parameter slots are shared by all rows.
+  TupleData params_data(static_cast<int>(columns.size() + parameters.size()));
+  for (int i = 0; i < parameters.size(); ++i) {
+    params_data.mutable_slot(static_cast<int>(columns.size()) + i)
+        ->SetValue(parameters[i]);
+  }
+
+  output->clear();
+  output->reserve(num_rows);
+  absl::Status status;
+  for (int64_t row = 0; row < num_rows; ++row) {
+    for (int i = 0; i < columns.size(); ++i) {
+      params_data.mutable_slot(i)->SetValue(columns[i][row]);
+    }
+    TupleSlot result;
+    if (!compiled_value_expr_->EvalSimple({&params_data}, context.get(),
+                                          &result, &status)) {
+      break;
+    }
+    output->push_back(result.value());
+  }
+  if (listener != nullptr) {
+    listener->OnExecute(
+        MakeExecuteEvent(sql_, start_time, status, context.get()));
+  }
+  return status;
+}
+
 absl::StatusOr<std::string> Evaluator::ExplainAfterPrepare() const {
   absl::ReaderMutexLock l(&mutex_);
   ZETASQL_RET_CHECK(is_prepared()) << "Prepare must be called first";
@@ -1137,6 +1417,46 @@ EvaluatorOptions EvaluatorOptionsFromTypeFactory(TypeFactory* type_factory) {
 
 }  // namespace internal
 
+namespace {
+void AppendOperatorProfileDebugString(const OperatorProfile& profile,
+                                      const std::string& indent,
+                                      const std::string& child_indent,
+                                      std::string* output) {
+  absl::Duration self_wall_time = profile.wall_time;
+  for (const OperatorProfile& input : profile.inputs) {
+    self_wall_time -= input.wall_time;
+  }
+  absl::StrAppend(output, indent, profile.name,
+                  ": evaluations=", profile.num_evaluations,
+                  " next_calls=", profile.num_next_calls,
+                  " rows_in=", profile.num_rows_in,
+                  " rows_out=", profile.num_rows_out,
+                  " wall_time=", absl::FormatDuration(profile.wall_time),
+                  " self_wall_time=",
+                  absl::FormatDuration(
+                      std::max(self_wall_time, absl::ZeroDuration())),
+                  " cpu_time=", absl::FormatDuration(profile.cpu_time),
+                  " peak_memory_bytes=", profile.peak_memory_bytes);
+  for (const auto& counter : profile.counters) {
+    absl::StrAppend(output, " ", counter.first, "=", counter.second);
+  }
+  absl::StrAppend(output, "\n");
+  for (int i = 0; i < profile.inputs.size(); ++i) {
+    const bool is_last = i == profile.inputs.size() - 1;
+    AppendOperatorProfileDebugString(
+        profile.inputs[i], absl::StrCat(child_indent, "+-"),
+        absl::StrCat(child_indent, is_last ? "  " : "| "), output);
+  }
+}
+}  // namespace
+
+std::string OperatorProfile::DebugString() const {
+  std::string output;
+  AppendOperatorProfileDebugString(*this, /*indent=*/"", /*child_indent=*/"",
+                                   &output);
+  return output;
+}
+
 PreparedExpressionBase::PreparedExpressionBase(const std::string& sql,
                                                TypeFactory* type_factory)
     : PreparedExpressionBase(
@@ -1295,6 +1615,16 @@ PreparedExpressionBase::ExecuteAfterPrepareWithOrderedParams(
   return ExecuteAfterPrepare(std::move(options));
 }
 
+absl::StatusOr<std::vector<Value>>
+PreparedExpressionBase::ExecuteBatchAfterPrepare(
+    absl::Span<const ParameterValueList> columns,
+    const ParameterValueList& parameters, int64_t num_rows) const {
+  std::vector<Value> output;
+  ZETASQL_RETURN_IF_ERROR(evaluator_->ExecuteBatchAfterPrepare(columns, parameters,
+                                                       num_rows, &output));
+  return output;
+}
+
 absl::StatusOr<std::string> PreparedExpressionBase::ExplainAfterPrepare()
     const {
   return evaluator_->ExplainAfterPrepare();
@@ -1344,7 +1674,7 @@ PreparedQueryBase::Execute(const QueryOptions& options) {
   ZETASQL_RETURN_IF_ERROR(ValidateExpressionOptions(expr_options));
   ZETASQL_RETURN_IF_ERROR(evaluator_->Execute(expr_options,
                                       /*expression_output_value=*/nullptr,
-                                      &output));
+                                      &output, options.profile));
   return output;
 }
 
@@ -1376,14 +1706,14 @@ PreparedQueryBase::ExecuteAfterPrepare(const QueryOptions& options) const {
     ZETASQL_RETURN_IF_ERROR(ValidateExpressionOptions(expr_options));
     ZETASQL_RETURN_IF_ERROR(evaluator_->ExecuteAfterPrepare(
         expr_options,
-        /*expression_output_value=*/nullptr, &output));
+        /*expression_output_value=*/nullptr, &output, options.profile));
   } else {
     expr_options.columns.reset();
     expr_options.ordered_columns = ParameterValueList();
     ZETASQL_RETURN_IF_ERROR(ValidateExpressionOptions(expr_options));
     ZETASQL_RETURN_IF_ERROR(evaluator_->ExecuteAfterPrepareWithOrderedParams(
         expr_options,
-        /*expression_output_value=*/nullptr, &output));
+        /*expression_output_value=*/nullptr, &output, options.profile));
   }
   return output;
 }
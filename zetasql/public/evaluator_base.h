@@ -144,6 +144,27 @@
 // using num_columns(), column_name(), column_type(), etc.  After Execute(), the
 // schema is also available from the EvaluatorTableIterator.
 //
+// ExplainAfterPrepare() shows the operators that evaluate a query. To also see
+// how many rows each of them produced and where the time and memory went,
+// execute the query with QueryOptions::profile set:
+//
+//   OperatorProfile profile;
+//   PreparedQuery::QueryOptions options;
+//   options.profile = &profile;
+//   std::unique_ptr<EvaluatorTableIterator> result =
+//     query.ExecuteAfterPrepare(options).value();
+//   ... Iterate over 'result' ...
+//   result.reset();
+//   std::cout << profile.DebugString();
+//
+// Metrics and traces
+// ------------------
+// To monitor the evaluator in production, set EvaluatorOptions::listener to an
+// EvaluatorListener. It receives the time spent preparing an expression or
+// statement, and for each execution its duration, the rows read per table,
+// the intermediate memory used and the number of regular expressions compiled
+// and JSON strings parsed.
+//
 // Evaluating DML statements
 // ------------------
 // DML statements can be evaluated using PreparedModify. This works
@@ -179,8 +200,12 @@
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/memory/memory.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "zetasql/base/status.h"
 #include "zetasql/base/clock.h"
 
@@ -197,6 +222,76 @@ namespace internal {
 class Evaluator;
 }  // namespace internal
 
+// Describes a call to Prepare() (or the preparation done by the first call to
+// Execute()) for EvaluatorListener::OnPrepare().
+struct EvaluatorPrepareEvent {
+  // The SQL of the expression or statement, or empty if it was constructed
+  // from a resolved AST.
+  absl::string_view sql;
+
+  // The outcome of the preparation.
+  absl::Status status;
+
+  // When the preparation started, and the time spent in each of its phases.
+  // 'analyze_time' covers parsing, resolving and rewriting the SQL, and is zero
+  // for a resolved AST, which is validated instead. 'algebrize_time' covers
+  // compiling the resolved AST into the evaluator's operators.
+  absl::Time start_time;
+  absl::Duration analyze_time;
+  absl::Duration validate_time;
+  absl::Duration algebrize_time;
+};
+
+// Describes an execution for EvaluatorListener::OnExecute().
+struct EvaluatorExecuteEvent {
+  // As in EvaluatorPrepareEvent.
+  absl::string_view sql;
+
+  // The outcome of the execution. For a query, the status of the returned
+  // iterator when it was destroyed.
+  absl::Status status;
+
+  // When the execution started and how long it took. For a query, this is
+  // until the returned iterator was destroyed, so it includes the time the
+  // caller spent between calls to NextRow().
+  absl::Time start_time;
+  absl::Duration execute_time;
+
+  // The number of rows read from each table, by table name.
+  std::map<std::string, int64_t> rows_scanned;
+
+  // The number of bytes of intermediate rows requested over the whole
+  // execution, and the largest number held at once. See
+  // EvaluatorOptions::max_intermediate_byte_size.
+  int64_t intermediate_bytes_requested = 0;
+  int64_t peak_intermediate_bytes = 0;
+
+  // The number of regular expressions compiled during the execution, for
+  // patterns that are not constant, and of JSON strings parsed.
+  int64_t num_regexps_compiled = 0;
+  int64_t num_json_parses = 0;
+};
+
+// Receives events from the preparation and execution of expressions, queries
+// and DML statements, e.g., to export metrics or traces. Set it with
+// EvaluatorOptions::listener. The methods may be called concurrently from the
+// threads that call Prepare() and Execute(), so they must be thread-safe, and
+// they should return quickly. Without a listener, the evaluator does not
+// collect any of this information.
+class EvaluatorListener {
+ public:
+  virtual ~EvaluatorListener() {}
+
+  // Called when a preparation finishes, successfully or not.
+  virtual void OnPrepare(const EvaluatorPrepareEvent& event) {}
+
+  // Called when an execution finishes: when Execute() returns for expressions
+  // and DML statements, and when the returned iterator is destroyed for
+  // queries. Not called if the execution fails before it starts, e.g., because
+  // of invalid parameters.
+  virtual void OnExecute(const EvaluatorExecuteEvent& event) {}
+};
+
 struct EvaluatorOptions {
  public:
   // If 'type_factory' is provided, the return value's Type will
@@ -245,6 +340,49 @@ struct EvaluatorOptions {
   // accounting charges each of them individually. In some cases, it is
   // necessary to set this option to a very large value.
   int64_t max_intermediate_byte_size = 128 * 1024 * 1024;
+
+  // If set, receives the events of the preparation and execution. Does not
+  // take ownership; must outlive the prepared object.
+  EvaluatorListener* listener = nullptr;
+};
+
+// The execution profile of a relational operator of a query and, recursively,
+// of its inputs. See PreparedQueryBase::QueryOptions::profile. The operators
+// are those shown by PreparedQueryBase::ExplainAfterPrepare(). The times and
+// the peak memory of an operator include those of its inputs.
+struct OperatorProfile {
+  // The name of the operator, e.g., "HashJoinOp".
+  std::string name;
+
+  // The number of times the operator was evaluated. For example, an operator
+  // in a correlated subquery is evaluated once per row of the outer query.
+  int64_t num_evaluations = 0;
+
+  // The number of calls to get the next row of the operator's output.
+  int64_t num_next_calls = 0;
+
+  // The number of rows produced by the inputs, and by the operator itself.
+  int64_t num_rows_in = 0;
+  int64_t num_rows_out = 0;
+
+  // Time spent in the operator, including its inputs.
+  absl::Duration wall_time;
+  absl::Duration cpu_time;
+
+  // The largest number of bytes of intermediate rows held at once while the
+  // operator was running. See EvaluatorOptions::max_intermediate_byte_size.
+  int64_t peak_memory_bytes = 0;
+
+  // Operator-specific counters, e.g., "hash_table_keys" for the number of
+  // distinct keys in the hash table of a join or an aggregation.
+  std::map<std::string, int64_t> counters;
+
+  // The profiles of the inputs of the operator, including those of subqueries
+  // in its expressions. Inputs that were never evaluated are omitted.
+  std::vector<OperatorProfile> inputs;
+
+  // Returns the profile as an indented tree with one operator per line.
+  std::string DebugString() const;
 };
 
 class PreparedExpressionBase {
@@ -438,6 +576,23 @@ class PreparedExpressionBase {
       const ParameterValueList& columns, const ParameterValueList& parameters,
       const SystemVariableValuesMap& system_variables = {}) const;
 
+  // Evaluates the expression for each of <num_rows> rows and returns one
+  // result per row. <columns> holds one list per column, in the order returned
+  // by GetReferencedColumns(), each with <num_rows> values. <parameters> are
+  // shared by all rows and ordered as for
+  // ExecuteAfterPrepareWithOrderedParams().
+  //
+  // This is cheaper than calling ExecuteAfterPrepareWithOrderedParams() per
+  // row because the arguments are validated and the evaluation state is set
+  // up once per batch. As a consequence, functions like CURRENT_TIMESTAMP()
+  // return the same value for every row of a batch. Fails with the error of
+  // the first row whose evaluation fails.
+  //
+  // Thread safe. REQUIRES: Prepare() has been called successfully.
+  absl::StatusOr<std::vector<Value>> ExecuteBatchAfterPrepare(
+      absl::Span<const ParameterValueList> columns,
+      const ParameterValueList& parameters, int64_t num_rows) const;
+
   // Returns a human-readable representation of how this expression would
   // actually be executed. Do not try to interpret this string with code, as the
   // format can change at any time. Requires that Prepare has already been
@@ -518,6 +673,7 @@ class PreparedQueryBase {
   // Options struct for Execute() and ExecuteAfterPrepareWithOrderedParams()
   // function calls.
   struct QueryOptions {
+    QueryOptions() {}
     // Parameters for the expression. Represented as a map or unordered list.
     // At most one of these can be specified.
     absl::optional<ParameterValueMap> parameters;
@@ -527,6 +683,11 @@ class PreparedQueryBase {
 
     // Optional system variables for all variants of Execute.
     SystemVariableValuesMap system_variables;
+
+    // If set, the execution is profiled, which makes it slower, and 'profile'
+    // is populated with the profile of the query when the returned iterator is
+    // destroyed. Does not take ownership; 'profile' must outlive the iterator.
+    OperatorProfile* profile = nullptr;
   };
 
   // Execute the query. This object must outlive the return value.
@@ -19,6 +19,8 @@
 #ifndef ZETASQL_PUBLIC_EVALUATOR_TABLE_ITERATOR_H_
 #define ZETASQL_PUBLIC_EVALUATOR_TABLE_ITERATOR_H_
 
+#include <cstdint>
+
 #include "zetasql/public/value.h"
 #include "zetasql/base/status.h"
 
@@ -139,6 +141,16 @@ class EvaluatorTableIterator {
         "EvaluatorTableIterator::SetReadTime() not implemented");
   }
 
+  // Indicates that the caller expects to read at most 'max_rows' rows from the
+  // iterator, e.g. because every row counts toward the LIMIT of the query. This
+  // function must be called prior to the first call to NextRow().
+  //
+  // This is only a hint. The caller may still read more rows, which the
+  // iterator must return as usual. An iterator that fetches, decodes or reads
+  // ahead rows in batches can use it to avoid doing so for rows that will not
+  // be read.
+  virtual void SetRowCountHint(int64_t max_rows) {}
+
   // Returns false if there is no next row. The caller must then check
   // 'Status()'. If NextRow() returns false, the only allowed operations on this
   // iterator are NumColumns(), GetColumnName(), GetColumnType(), and Status().
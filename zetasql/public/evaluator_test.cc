@@ -34,6 +34,7 @@
 #include "zetasql/public/analyzer.h"
 #include "zetasql/public/civil_time.h"
 #include "zetasql/public/evaluator_base.h"
+#include "zetasql/public/evaluator_table_iterator.h"
 #include "zetasql/public/function.h"
 #include "zetasql/public/function.pb.h"
 #include "zetasql/public/functions/date_time_util.h"
@@ -41,6 +42,7 @@
 #include "zetasql/public/language_options.h"
 #include "zetasql/public/options.pb.h"
 #include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/table_valued_function.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/types/type_factory.h"
@@ -83,6 +85,7 @@ using ::testing::ElementsAre;
 using ::testing::Eq;
 using ::testing::HasSubstr;
 using ::testing::IsEmpty;
+using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
 using ::zetasql_base::testing::IsOkAndHolds;
 using ::zetasql_base::testing::StatusIs;
@@ -1114,6 +1117,46 @@ TEST(EvaluatorTest, ExecuteAfterPrepareWithOrderedParamsWithQueryParameters) {
               IsOkAndHolds(Value::Int64(15)));
 }
 
+TEST(EvaluatorTest, ExecuteBatchAfterPrepare) {
+  PreparedExpression expr("(@param1 + col) * 10 / col");
+
+  AnalyzerOptions options;
+  options.set_parameter_mode(PARAMETER_NAMED);
+  ZETASQL_ASSERT_OK(options.AddQueryParameter("param1", types::Int64Type()));
+  ZETASQL_ASSERT_OK(options.AddExpressionColumn("col", types::Int64Type()));
+  ZETASQL_ASSERT_OK(expr.Prepare(options));
+
+  const std::vector<ParameterValueList> columns = {
+      {Value::Int64(1), Value::Int64(2), Value::NullInt64()}};
+  EXPECT_THAT(expr.ExecuteBatchAfterPrepare(columns, {Value::Int64(3)},
+                                            /*num_rows=*/3),
+              IsOkAndHolds(ElementsAre(Value::Double(40), Value::Double(25),
+                                       Value::NullDouble())));
+  EXPECT_THAT(expr.ExecuteBatchAfterPrepare({{}}, {Value::Int64(3)},
+                                            /*num_rows=*/0),
+              IsOkAndHolds(ElementsAre()));
+
+  // Every row is checked, not just the first one.
+  EXPECT_THAT(expr.ExecuteBatchAfterPrepare(
+                  {{Value::Int64(1), Value::Int64(0)}}, {Value::Int64(3)},
+                  /*num_rows=*/2),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       HasSubstr("division by zero")));
+  EXPECT_THAT(expr.ExecuteBatchAfterPrepare(
+                  {{Value::Int64(1), Value::Int32(2)}}, {Value::Int64(3)},
+                  /*num_rows=*/2),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("all values of a column")));
+  EXPECT_THAT(expr.ExecuteBatchAfterPrepare({{Value::Int64(1)}},
+                                            {Value::Int64(3)},
+                                            /*num_rows=*/2),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected 2 values for each column")));
+  EXPECT_THAT(expr.ExecuteBatchAfterPrepare({{Value::Int64(1)}}, {},
+                                            /*num_rows=*/1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(EvaluatorTest,
      ExecuteAfterPrepareWithOrderedParamsWithPositionalQueryParameters) {
   PreparedExpression expr("(? + ?) * col");
@@ -2005,6 +2048,453 @@ TEST_F(UDFEvalTest, UDFEvaluatorRuntimeErrors) {
   }
 }
 
+TEST_F(UDFEvalTest, UDFPropagatesNull) {
+  int num_calls = 0;
+  function_options_.set_propagates_null(true).set_evaluator(
+      [&num_calls](const absl::Span<const Value> args) {
+        ++num_calls;
+        return Value::Int64(args[0].string_value().size());
+      });
+  catalog()->AddOwnedFunction(new Function(
+      "MyUdf", "udf", Function::SCALAR,
+      {{types::Int64Type(), {types::StringType()}, kFunctionId}},
+      function_options_));
+  PreparedExpression expr("myudf(@param)");
+  ZETASQL_ASSERT_OK(expr.Prepare(analyzer_options_, catalog()));
+  EXPECT_EQ(Value::NullInt64(),
+            expr.Execute({}, {{"param", Value::NullString()}}).value());
+  EXPECT_EQ(num_calls, 0);
+  EXPECT_EQ(Value::Int64(3),
+            expr.Execute({}, {{"param", Value::String("foo")}}).value());
+  EXPECT_EQ(num_calls, 1);
+}
+
+TEST_F(UDFEvalTest, FoldableUDFWithConstantArgumentsIsFolded) {
+  int num_calls = 0;
+  FunctionEvaluator evaluator = [&num_calls](const absl::Span<const Value> args)
+      -> absl::StatusOr<Value> {
+    ++num_calls;
+    if (args[0].string_value() == "bad") {
+      return absl::OutOfRangeError("Bad argument");
+    }
+    return Value::Int64(args[0].string_value().size());
+  };
+  catalog()->AddOwnedFunction(new Function(
+      "MyUdf", "udf", Function::SCALAR,
+      {{types::Int64Type(), {types::StringType()}, kFunctionId}},
+      FunctionOptions().set_allows_constant_folding(true).set_evaluator(
+          evaluator)));
+  catalog()->AddOwnedFunction(new Function(
+      "MyDefaultUdf", "udf", Function::SCALAR,
+      {{types::Int64Type(), {types::StringType()}, kFunctionId}},
+      FunctionOptions().set_evaluator(evaluator)));
+  catalog()->AddOwnedFunction(new Function(
+      "MyVolatileUdf", "udf", Function::SCALAR,
+      {{types::Int64Type(), {types::StringType()}, kFunctionId}},
+      FunctionOptions()
+          .set_allows_constant_folding(true)
+          .set_volatility(FunctionEnums::VOLATILE)
+          .set_evaluator(evaluator)));
+
+  PreparedExpression expr("myudf('foo')");
+  ZETASQL_ASSERT_OK(expr.Prepare(analyzer_options_, catalog()));
+  EXPECT_EQ(num_calls, 1);
+  EXPECT_EQ(Value::Int64(3), expr.Execute().value());
+  EXPECT_EQ(Value::Int64(3), expr.Execute().value());
+  EXPECT_EQ(num_calls, 1);
+
+  // Errors are not raised until the expression is executed.
+  num_calls = 0;
+  PreparedExpression bad_expr("myudf('bad')");
+  ZETASQL_ASSERT_OK(bad_expr.Prepare(analyzer_options_, catalog()));
+  EXPECT_THAT(bad_expr.Execute().status(),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       HasSubstr("Bad argument")));
+
+  // Folding is opt-in, even though IMMUTABLE is the default volatility.
+  num_calls = 0;
+  PreparedExpression default_expr("mydefaultudf('foo')");
+  ZETASQL_ASSERT_OK(default_expr.Prepare(analyzer_options_, catalog()));
+  EXPECT_EQ(num_calls, 0);
+  EXPECT_EQ(Value::Int64(3), default_expr.Execute().value());
+  EXPECT_EQ(Value::Int64(3), default_expr.Execute().value());
+  EXPECT_EQ(num_calls, 2);
+
+  num_calls = 0;
+  PreparedExpression volatile_expr("myvolatileudf('foo')");
+  ZETASQL_ASSERT_OK(volatile_expr.Prepare(analyzer_options_, catalog()));
+  EXPECT_EQ(num_calls, 0);
+  EXPECT_EQ(Value::Int64(3), volatile_expr.Execute().value());
+  EXPECT_EQ(Value::Int64(3), volatile_expr.Execute().value());
+  EXPECT_EQ(num_calls, 2);
+}
+
+TEST_F(UDFEvalTest, WithEntryIsEvaluatedOnceAndLazily) {
+  int num_calls = 0;
+  catalog()->AddOwnedFunction(new Function(
+      "CountCalls", "udf", Function::SCALAR,
+      {{types::Int64Type(), {types::Int64Type()}, kFunctionId}},
+      FunctionOptions()
+          .set_volatility(FunctionEnums::VOLATILE)
+          .set_evaluator([&num_calls](const absl::Span<const Value> args) {
+            ++num_calls;
+            return args[0];
+          })));
+
+  // Both references read the same evaluation of 't'.
+  PreparedExpression expr(
+      "(WITH t AS (SELECT countcalls(x) AS y FROM UNNEST([1, 2, 3]) x) "
+      "SELECT (SELECT SUM(y) FROM t) + (SELECT MAX(y) FROM t))");
+  ZETASQL_ASSERT_OK(expr.Prepare(analyzer_options_, catalog()));
+  EXPECT_EQ(Value::Int64(9), expr.Execute().value());
+  EXPECT_EQ(num_calls, 3);
+
+  // 't' is referenced once, but from a subquery that is evaluated for each row.
+  // It is still evaluated once, and only as far as the subquery reads it.
+  num_calls = 0;
+  PreparedExpression lazy_expr(
+      "(WITH t AS (SELECT countcalls(x) AS y FROM UNNEST([1, 2, 3]) x) "
+      "SELECT ARRAY(SELECT (SELECT y FROM t LIMIT 1) "
+      "FROM UNNEST(['a', 'b', 'c', 'd'])))");
+  ZETASQL_ASSERT_OK(lazy_expr.Prepare(analyzer_options_, catalog()));
+  EXPECT_EQ(values::Int64Array({1, 1, 1, 1}), lazy_expr.Execute().value());
+  EXPECT_EQ(num_calls, 1);
+}
+
+// Sums the lengths of its STRING argument.
+class StringLengthSumEvaluator : public AggregateFunctionEvaluator {
+ public:
+  explicit StringLengthSumEvaluator(int* num_evaluators) {
+    ++*num_evaluators;
+  }
+
+  absl::Status Reset() override {
+    sum_ = 0;
+    return absl::OkStatus();
+  }
+
+  absl::Status Accumulate(absl::Span<const Value> args) override {
+    if (args.size() != 1 || args[0].is_null()) {
+      return absl::InternalError("Expected one non-NULL argument");
+    }
+    sum_ += args[0].string_value().size();
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<Value> GetFinalResult() override {
+    return Value::Int64(sum_);
+  }
+
+ private:
+  int64_t sum_ = 0;
+};
+
+TEST_F(UDFEvalTest, UDAEvaluator) {
+  int num_evaluators = 0;
+  catalog()->AddOwnedFunction(new Function(
+      "MyUda", "udf", Function::AGGREGATE,
+      {{types::Int64Type(), {types::StringType()}, kFunctionId}},
+      FunctionOptions(FunctionOptions::ORDER_OPTIONAL,
+                      /*window_framing_support_in=*/true)
+          .set_aggregate_function_evaluator_factory(
+              [&num_evaluators](const FunctionSignature& signature)
+                  -> absl::StatusOr<
+                      std::unique_ptr<AggregateFunctionEvaluator>> {
+                return absl::make_unique<StringLengthSumEvaluator>(
+                    &num_evaluators);
+              })));
+  analyzer_options_.mutable_language()->EnableLanguageFeature(
+      FEATURE_ANALYTIC_FUNCTIONS);
+
+  // NULL arguments are ignored by default.
+  PreparedExpression expr(
+      "(SELECT myuda(s) FROM UNNEST(['a', 'bcd', NULL, @param]) s)");
+  ZETASQL_ASSERT_OK(expr.Prepare(analyzer_options_, catalog()));
+  num_evaluators = 0;
+  EXPECT_EQ(Value::Int64(6),
+            expr.Execute({}, {{"param", Value::String("ef")}}).value());
+  EXPECT_EQ(num_evaluators, 1);
+
+  PreparedExpression grouped_expr(
+      "ARRAY(SELECT myuda(s) FROM UNNEST(['a', 'bb', 'cc', 'ddd']) s "
+      "GROUP BY LENGTH(s) ORDER BY LENGTH(s))");
+  ZETASQL_ASSERT_OK(grouped_expr.Prepare(analyzer_options_, catalog()));
+  EXPECT_EQ(values::Int64Array({1, 4, 3}), grouped_expr.Execute().value());
+
+  PreparedExpression windowed_expr(
+      "ARRAY(SELECT myuda(s) OVER (ORDER BY s ROWS BETWEEN 1 PRECEDING AND "
+      "CURRENT ROW) FROM UNNEST(['a', 'bb', 'ccc']) s ORDER BY s)");
+  ZETASQL_ASSERT_OK(windowed_expr.Prepare(analyzer_options_, catalog()));
+  EXPECT_EQ(values::Int64Array({1, 3, 5}), windowed_expr.Execute().value());
+}
+
+TEST_F(UDFEvalTest, NoUDAEvaluator) {
+  catalog()->AddOwnedFunction(new Function(
+      "MyUda", "udf", Function::AGGREGATE,
+      {{types::Int64Type(), {types::StringType()}, kFunctionId}}));
+  PreparedExpression expr("(SELECT myuda(s) FROM UNNEST(['a']) s)");
+  EXPECT_THAT(expr.Prepare(analyzer_options_, catalog()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("has no evaluator")));
+}
+
+TEST(AggregateFunctionEvaluatorTest, OptionalMethodsAreUnimplemented) {
+  int num_evaluators = 0;
+  StringLengthSumEvaluator evaluator(&num_evaluators);
+  StringLengthSumEvaluator other(&num_evaluators);
+  EXPECT_THAT(evaluator.Merge(other),
+              StatusIs(absl::StatusCode::kUnimplemented));
+  EXPECT_THAT(evaluator.SerializeState(),
+              StatusIs(absl::StatusCode::kUnimplemented));
+  EXPECT_THAT(evaluator.MergeSerializedState(""),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+// Returns the rows computed by 'next_row', which returns false after the last
+// row. Records the number of column filters it is given in 'num_filters', and
+// the row count hint it is given in 'row_count_hint' if that is non-null.
+class GeneratorTableIterator : public EvaluatorTableIterator {
+ public:
+  GeneratorTableIterator(
+      std::vector<TVFSchemaColumn> columns,
+      std::function<bool(const std::vector<TVFSchemaColumn>& columns,
+                         std::vector<Value>* row)>
+          next_row,
+      int* num_filters, int64_t* row_count_hint = nullptr)
+      : columns_(std::move(columns)),
+        next_row_(std::move(next_row)),
+        num_filters_(num_filters),
+        row_count_hint_(row_count_hint) {}
+
+  int NumColumns() const override { return columns_.size(); }
+  std::string GetColumnName(int i) const override { return columns_[i].name; }
+  const Type* GetColumnType(int i) const override { return columns_[i].type; }
+
+  absl::Status SetColumnFilterMap(
+      absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map)
+      override {
+    *num_filters_ = filter_map.size();
+    return absl::OkStatus();
+  }
+
+  void SetRowCountHint(int64_t max_rows) override {
+    if (row_count_hint_ != nullptr) *row_count_hint_ = max_rows;
+  }
+
+  bool NextRow() override {
+    row_.clear();
+    return next_row_(columns_, &row_);
+  }
+
+  const Value& GetValue(int i) const override { return row_[i]; }
+  absl::Status Status() const override { return absl::OkStatus(); }
+  absl::Status Cancel() override { return absl::OkStatus(); }
+
+ private:
+  const std::vector<TVFSchemaColumn> columns_;
+  const std::function<bool(const std::vector<TVFSchemaColumn>&,
+                           std::vector<Value>*)>
+      next_row_;
+  int* num_filters_;
+  int64_t* row_count_hint_;
+  std::vector<Value> row_;
+};
+
+// A TVF with a fixed output schema whose evaluation is done by 'evaluator'.
+class EvaluatorTvf : public FixedOutputSchemaTVF {
+ public:
+  using Evaluator =
+      std::function<absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>(
+          std::vector<TvfEvaluatorArg> input_arguments,
+          const std::vector<TVFSchemaColumn>& output_columns)>;
+
+  EvaluatorTvf(const std::string& name, FunctionArgumentTypeList arguments,
+               const TVFRelation& result_schema, Evaluator evaluator)
+      : FixedOutputSchemaTVF(
+            {name},
+            FunctionSignature(FunctionArgumentType::RelationWithSchema(
+                                  result_schema,
+                                  /*extra_relation_input_columns_allowed=*/
+                                  false),
+                              arguments, /*context_id=*/-1),
+            result_schema),
+        evaluator_(std::move(evaluator)) {}
+
+  absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> CreateEvaluator(
+      std::vector<TvfEvaluatorArg> input_arguments,
+      const std::vector<TVFSchemaColumn>& output_columns,
+      const FunctionSignature* function_call_signature) const override {
+    return evaluator_(std::move(input_arguments), output_columns);
+  }
+
+  bool HasEvaluator() const override { return true; }
+
+ private:
+  const Evaluator evaluator_;
+};
+
+class TVFEvalTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    catalog_.AddZetaSQLFunctions();
+    analyzer_options_.mutable_language()->EnableLanguageFeature(
+        FEATURE_TABLE_VALUED_FUNCTIONS);
+  }
+
+  // Adds range(n), which returns the rows (x, x * x) for x in [0, n).
+  void AddRangeTvf() {
+    catalog_.AddOwnedTableValuedFunction(absl::make_unique<EvaluatorTvf>(
+        "range",
+        FunctionArgumentTypeList{FunctionArgumentType(types::Int64Type())},
+        TVFRelation(
+            {{"x", types::Int64Type()}, {"square", types::Int64Type()}}),
+        [this](std::vector<TableValuedFunction::TvfEvaluatorArg> args,
+               const std::vector<TVFSchemaColumn>& output_columns)
+            -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
+          const int64_t n = args[0].value.int64_value();
+          auto x = std::make_shared<int64_t>(0);
+          return absl::make_unique<GeneratorTableIterator>(
+              output_columns,
+              [n, x](const std::vector<TVFSchemaColumn>& columns,
+                     std::vector<Value>* row) {
+                if (*x >= n) return false;
+                for (const TVFSchemaColumn& column : columns) {
+                  row->push_back(
+                      Value::Int64(column.name == "x" ? *x : *x * *x));
+                }
+                ++*x;
+                return true;
+              },
+              &num_filters_, &row_count_hint_);
+        }));
+  }
+
+  SimpleCatalog catalog_{"tvf_catalog"};
+  AnalyzerOptions analyzer_options_;
+  int num_filters_ = -1;
+  int64_t row_count_hint_ = -1;
+};
+
+TEST_F(TVFEvalTest, ScalarArguments) {
+  AddRangeTvf();
+  PreparedExpression expr(
+      "ARRAY(SELECT square FROM range(@n) WHERE x >= 2 ORDER BY x)");
+  ZETASQL_ASSERT_OK(analyzer_options_.AddQueryParameter("n", types::Int64Type()));
+  ZETASQL_ASSERT_OK(expr.Prepare(analyzer_options_, &catalog_));
+  EXPECT_EQ(values::Int64Array({4, 9}),
+            expr.Execute({}, {{"n", Value::Int64(4)}}).value());
+  // The filter is offered to the TVF, which is free to ignore it.
+  EXPECT_EQ(num_filters_, 1);
+  EXPECT_EQ(values::Int64Array({}),
+            expr.Execute({}, {{"n", Value::Int64(0)}}).value());
+}
+
+TEST_F(TVFEvalTest, RelationArgument) {
+  // lengths(TABLE<s STRING>) returns the length of each input row's string.
+  catalog_.AddOwnedTableValuedFunction(absl::make_unique<EvaluatorTvf>(
+      "lengths",
+      FunctionArgumentTypeList{FunctionArgumentType::RelationWithSchema(
+          TVFRelation({{"s", types::StringType()}}),
+          /*extra_relation_input_columns_allowed=*/false)},
+      TVFRelation({{"len", types::Int64Type()}}),
+      [this](std::vector<TableValuedFunction::TvfEvaluatorArg> args,
+             const std::vector<TVFSchemaColumn>& output_columns)
+          -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
+        std::shared_ptr<EvaluatorTableIterator> input =
+            std::move(args[0].relation);
+        if (input->NumColumns() != 1 || input->GetColumnName(0) != "s") {
+          return absl::InternalError("Unexpected input relation");
+        }
+        return absl::make_unique<GeneratorTableIterator>(
+            output_columns,
+            [input](const std::vector<TVFSchemaColumn>& columns,
+                    std::vector<Value>* row) {
+              if (!input->NextRow()) return false;
+              row->push_back(
+                  Value::Int64(input->GetValue(0).string_value().size()));
+              return true;
+            },
+            &num_filters_);
+      }));
+
+  PreparedExpression expr(
+      "ARRAY(SELECT len FROM lengths((SELECT s FROM UNNEST(['a', 'bcd', 'ef']) "
+      "s)) ORDER BY len)");
+  ZETASQL_ASSERT_OK(expr.Prepare(analyzer_options_, &catalog_));
+  EXPECT_EQ(values::Int64Array({1, 2, 3}), expr.Execute().value());
+}
+
+TEST_F(TVFEvalTest, RowCountHint) {
+  AddRangeTvf();
+  ZETASQL_ASSERT_OK(analyzer_options_.AddQueryParameter("n", types::Int64Type()));
+  ZETASQL_ASSERT_OK(analyzer_options_.AddQueryParameter("k", types::Int64Type()));
+
+  // Table t has the rows 0, 1, 2, 3, 4 in column a.
+  SimpleTable table("t", {{"a", types::Int64Type()}});
+  table.SetEvaluatorTableIteratorFactory(
+      [this](absl::Span<const int> columns)
+          -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
+        auto a = std::make_shared<int64_t>(0);
+        return absl::make_unique<GeneratorTableIterator>(
+            std::vector<TVFSchemaColumn>{
+                TVFSchemaColumn("a", types::Int64Type())},
+            [a](const std::vector<TVFSchemaColumn>& columns,
+                std::vector<Value>* row) {
+              if (*a >= 5) return false;
+              row->push_back(Value::Int64((*a)++));
+              return true;
+            },
+            &num_filters_, &row_count_hint_);
+      });
+  catalog_.AddTable(table.Name(), &table);
+
+  // The number of rows a LIMIT reads is passed to the TVF through the operators
+  // that produce at least one row per input row, and only through those.
+  const std::vector<std::pair<std::string, int64_t>> queries = {
+      {"SELECT x FROM range(@n) LIMIT 2", 2},
+      {"SELECT a FROM t LIMIT 2 OFFSET 2", 4},
+      {"SELECT x + 1 FROM range(@n) LIMIT 2 OFFSET 1", 3},
+      {"SELECT x FROM (SELECT x FROM range(@n) UNION ALL SELECT 10) LIMIT 2",
+       2},
+      {"SELECT r.x FROM range(@n) r LEFT JOIN (SELECT 1 AS y) ON r.x >= y "
+       "LIMIT 2",
+       2},
+      {"SELECT x FROM range(@n) LIMIT @k", -1},
+      {"SELECT x FROM range(@n) WHERE x > 1 LIMIT 2", -1},
+      {"SELECT x FROM range(@n) ORDER BY x LIMIT 2", -1},
+      {"SELECT r.x FROM range(@n) r JOIN (SELECT 1 AS y) ON r.x >= y LIMIT 2",
+       -1},
+      {"SELECT x FROM (SELECT DISTINCT x FROM range(@n)) LIMIT 2", -1},
+  };
+  for (const auto& [sql, expected_hint] : queries) {
+    SCOPED_TRACE(sql);
+    row_count_hint_ = -1;
+    PreparedExpression expr(absl::StrCat("ARRAY(", sql, ")"));
+    ZETASQL_ASSERT_OK(expr.Prepare(analyzer_options_, &catalog_));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        Value result,
+        expr.Execute({}, {{"n", Value::Int64(5)}, {"k", Value::Int64(2)}}));
+    EXPECT_EQ(result.num_elements(), 2);
+    EXPECT_EQ(row_count_hint_, expected_hint);
+  }
+}
+
+TEST_F(TVFEvalTest, NoEvaluator) {
+  const TVFRelation schema({{"x", types::Int64Type()}});
+  catalog_.AddOwnedTableValuedFunction(new FixedOutputSchemaTVF(
+      {"no_evaluator"},
+      FunctionSignature(FunctionArgumentType::RelationWithSchema(
+                            schema,
+                            /*extra_relation_input_columns_allowed=*/false),
+                        FunctionArgumentTypeList(), /*context_id=*/-1),
+      schema));
+  // As for UDFs and UDAs, a missing evaluator is reported by Prepare().
+  PreparedExpression expr("ARRAY(SELECT x FROM no_evaluator())");
+  EXPECT_THAT(expr.Prepare(analyzer_options_, &catalog_),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("has no evaluator")));
+}
+
 TEST(PreparedQuery, ExpressionQuery) {
   PreparedQuery query("select 1 a, 2 b, 'abc'", EvaluatorOptions());
   ZETASQL_EXPECT_OK(query.Prepare(AnalyzerOptions()));
@@ -2576,6 +3066,166 @@ TEST_F(PreparedModifyTest, ExecutesUpdate) {
   ZETASQL_EXPECT_OK(iter->Status());
 }
 
+TEST_F(PreparedModifyTest, ExecutesUpdateWithSubqueryReferencingWithEntry) {
+  // The WITH entry is only referenced from a nested expression subquery, so
+  // the algebrizer shares its scan through an assignment on the statement.
+  AnalyzerOptions analyzer_options = analyzer_options_;
+  analyzer_options.mutable_language()->EnableLanguageFeature(
+      FEATURE_V_1_1_WITH_ON_SUBQUERY);
+  PreparedModify modify(
+      "update test_table set str_val = "
+      "(with w as (select 'foo' x) select (select x from w)) "
+      "where int_val > 1",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(modify.Prepare(analyzer_options, catalog()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableModifyIterator> iter,
+                       modify.Execute());
+
+  ASSERT_TRUE(iter->NextRow());
+  EXPECT_EQ(iter->GetColumnValue(0), Int64(2));
+  EXPECT_EQ(iter->GetColumnValue(1), String("foo"));
+
+  ASSERT_TRUE(iter->NextRow());
+  EXPECT_EQ(iter->GetColumnValue(0), Int64(4));
+  EXPECT_EQ(iter->GetColumnValue(1), String("foo"));
+
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST_F(PreparedModifyTest, DeletesByPrimaryKey) {
+  PreparedModify modify("delete test_table where int_val = @key",
+                        EvaluatorOptions());
+  AnalyzerOptions analyzer_options = PreparedModifyTest::analyzer_options();
+  ZETASQL_ASSERT_OK(analyzer_options.AddQueryParameter("key", types::Int64Type()));
+  ZETASQL_ASSERT_OK(modify.Prepare(analyzer_options, catalog()));
+
+  for (const int64_t key : {1, 4}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<EvaluatorTableModifyIterator> iter,
+        modify.Execute({{"key", Int64(key)}}));
+    ASSERT_TRUE(iter->NextRow());
+    EXPECT_EQ(iter->GetOriginalKeyValue(0), Int64(key));
+    EXPECT_FALSE(iter->NextRow());
+    ZETASQL_EXPECT_OK(iter->Status());
+  }
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableModifyIterator> iter,
+                       modify.Execute({{"key", Int64(3)}}));
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST_F(PreparedModifyTest, UpdatesByPrimaryKey) {
+  // Only the key conjunct can be pushed into the table scan; the other one must
+  // still be evaluated on the rows that the table returns.
+  PreparedModify modify(
+      "update test_table set str_val = 'foo' "
+      "where int_val = 2 and str_val = 'two'",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(modify.Prepare(analyzer_options(), catalog()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableModifyIterator> iter,
+                       modify.Execute());
+  ASSERT_TRUE(iter->NextRow());
+  EXPECT_EQ(iter->GetColumnValue(0), Int64(2));
+  EXPECT_EQ(iter->GetColumnValue(1), String("foo"));
+  EXPECT_EQ(iter->GetOriginalKeyValue(0), Int64(2));
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+
+  PreparedModify no_match(
+      "update test_table set str_val = 'foo' "
+      "where int_val = 2 and str_val = 'four'",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(no_match.Prepare(analyzer_options(), catalog()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(iter, no_match.Execute());
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST_F(PreparedModifyTest, InsertChecksExistingPrimaryKeys) {
+  PreparedModify modify(
+      "insert test_table(int_val, str_val) values(3, 'three'), (4, 'four')",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(modify.Prepare(analyzer_options(), catalog()));
+  EXPECT_THAT(modify.Execute(),
+              StatusIs(absl::StatusCode::kOutOfRange,
+                       HasSubstr("due to previously existing row")));
+
+  PreparedModify replace(
+      "insert or replace test_table(int_val, str_val) "
+      "values(3, 'three'), (4, 'FOUR')",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(replace.Prepare(analyzer_options(), catalog()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableModifyIterator> iter,
+                       replace.Execute());
+  ASSERT_TRUE(iter->NextRow());
+  EXPECT_EQ(iter->GetColumnValue(0), Int64(3));
+  ASSERT_TRUE(iter->NextRow());
+  EXPECT_EQ(iter->GetColumnValue(0), Int64(4));
+  EXPECT_EQ(iter->GetColumnValue(1), String("FOUR"));
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST_F(PreparedModifyTest, SimpleTableHonorsPrimaryKeyFilters) {
+  const Table* table;
+  ZETASQL_ASSERT_OK(catalog()->FindTable({"test_table"}, &table));
+
+  // Column 1 of the scan is the primary key, so its filter is honored.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       table->CreateEvaluatorTableIterator({1, 0}));
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  filter_map.emplace(
+      1, absl::make_unique<ColumnFilter>(std::vector<Value>{Int64(2)}));
+  ZETASQL_ASSERT_OK(iter->SetColumnFilterMap(std::move(filter_map)));
+  ASSERT_TRUE(iter->NextRow());
+  EXPECT_EQ(iter->GetValue(0), String("two"));
+  EXPECT_FALSE(iter->NextRow());
+  ZETASQL_EXPECT_OK(iter->Status());
+
+  // Filters on other columns are ignored.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(iter, table->CreateEvaluatorTableIterator({1, 0}));
+  filter_map.clear();
+  filter_map.emplace(
+      0, absl::make_unique<ColumnFilter>(std::vector<Value>{String("two")}));
+  ZETASQL_ASSERT_OK(iter->SetColumnFilterMap(std::move(filter_map)));
+  int num_rows = 0;
+  while (iter->NextRow()) ++num_rows;
+  EXPECT_EQ(num_rows, 3);
+  ZETASQL_EXPECT_OK(iter->Status());
+}
+
+TEST_F(PreparedModifyTest, DeletesByCollatedPrimaryKey) {
+  auto collated_table = absl::make_unique<SimpleTable>(
+      "collated_table",
+      std::vector<SimpleTable::NameAndType>{{"key", types::StringType()}});
+  collated_table->SetContents({{String("a")}, {String("A")}, {String("b")}});
+  ZETASQL_ASSERT_OK(collated_table->SetPrimaryKey({0}));
+  catalog_.AddOwnedTable(std::move(collated_table));
+
+  AnalyzerOptions analyzer_options = PreparedModifyTest::analyzer_options();
+  analyzer_options.mutable_language()->EnableLanguageFeature(
+      FEATURE_V_1_3_ANNOTATION_FRAMEWORK);
+  analyzer_options.mutable_language()->EnableLanguageFeature(
+      FEATURE_V_1_3_COLLATION_SUPPORT);
+
+  // The table compares keys without collation, so the filter must not be
+  // pushed into its scan, or the 'A' row would be missed.
+  PreparedModify modify(
+      "delete collated_table where key = collate('a', 'und:ci')",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(modify.Prepare(analyzer_options, catalog()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableModifyIterator> iter,
+                       modify.Execute());
+  std::vector<Value> deleted_keys;
+  while (iter->NextRow()) {
+    deleted_keys.push_back(iter->GetOriginalKeyValue(0));
+  }
+  ZETASQL_EXPECT_OK(iter->Status());
+  EXPECT_THAT(deleted_keys, UnorderedElementsAre(String("a"), String("A")));
+}
+
 TEST_F(PreparedModifyTest, IteratorStillLiveOnDestruction) {
   auto query = absl::make_unique<PreparedModify>(
       "delete from test_table where true", EvaluatorOptions());
@@ -3328,6 +3978,238 @@ TEST(PreparedQuery, ExecuteAfterPrepareBuiltinFunction) {
   ASSERT_EQ(sql_builder.sql(), "SELECT 1 + 2 AS x");
 }
 
+// Returns the first operator named 'name' in a pre-order traversal of
+// 'profile', or NULL if there is none.
+const OperatorProfile* FindOperatorProfile(const OperatorProfile& profile,
+                                           absl::string_view name) {
+  if (profile.name == name) return &profile;
+  for (const OperatorProfile& input : profile.inputs) {
+    const OperatorProfile* found = FindOperatorProfile(input, name);
+    if (found != nullptr) return found;
+  }
+  return nullptr;
+}
+
+TEST(PreparedQuery, Profile) {
+  SimpleTable left_table("LeftTable", {{"a", types::Int64Type()}});
+  left_table.SetContents({{Int64(1)},
+                          {Int64(2)},
+                          {Int64(2)},
+                          {Int64(3)},
+                          {Int64(3)},
+                          {Int64(3)}});
+  SimpleTable right_table("RightTable", {{"b", types::Int64Type()}});
+  right_table.SetContents({{Int64(2)}, {Int64(3)}, {Int64(3)}, {Int64(4)}});
+  SimpleCatalog catalog("TestCatalog");
+  catalog.AddZetaSQLFunctions();
+  catalog.AddTable(left_table.Name(), &left_table);
+  catalog.AddTable(right_table.Name(), &right_table);
+
+  PreparedQuery query(
+      "select a, count(*) from LeftTable join RightTable on a = b group by a",
+      EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions(), &catalog));
+
+  OperatorProfile profile;
+  QueryOptions options;
+  options.profile = &profile;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.ExecuteAfterPrepare(options));
+  int num_rows = 0;
+  while (iter->NextRow()) {
+    ++num_rows;
+  }
+  ZETASQL_ASSERT_OK(iter->Status());
+  EXPECT_EQ(num_rows, 2);
+  // The profile is only populated when the iterator is destroyed.
+  EXPECT_EQ(profile.name, "");
+  iter.reset();
+
+  EXPECT_EQ(profile.name, "RootOp");
+  EXPECT_EQ(profile.num_evaluations, 1);
+  EXPECT_EQ(profile.num_next_calls, 3);
+  EXPECT_EQ(profile.num_rows_out, 2);
+  EXPECT_EQ(profile.num_rows_in, 2);
+  EXPECT_GE(profile.wall_time, absl::ZeroDuration());
+
+  const OperatorProfile* aggregate =
+      FindOperatorProfile(profile, "AggregateOp");
+  ASSERT_NE(aggregate, nullptr);
+  EXPECT_EQ(aggregate->num_rows_in, 8);
+  EXPECT_EQ(aggregate->num_rows_out, 2);
+  EXPECT_EQ(aggregate->counters.at("hash_table_keys"), 2);
+  // The aggregation buffers its output rows.
+  EXPECT_GT(aggregate->peak_memory_bytes, 0);
+
+  const OperatorProfile* join = FindOperatorProfile(profile, "JoinOp");
+  ASSERT_NE(join, nullptr);
+  EXPECT_EQ(join->num_evaluations, 1);
+  EXPECT_EQ(join->num_rows_in, 10);
+  EXPECT_EQ(join->num_rows_out, 8);
+  EXPECT_EQ(join->counters.at("hash_table_rows"), 4);
+  EXPECT_EQ(join->counters.at("hash_table_keys"), 3);
+  EXPECT_GE(join->peak_memory_bytes, 0);
+  EXPECT_LE(join->peak_memory_bytes, aggregate->peak_memory_bytes);
+
+  EXPECT_THAT(profile.DebugString(),
+              AllOf(HasSubstr("RootOp: evaluations=1 next_calls=3 rows_in=2 "
+                              "rows_out=2 wall_time="),
+                    HasSubstr("hash_table_keys=3 hash_table_rows=4\n")));
+}
+
+TEST(PreparedQuery, ProfileIsEmptyIfQueryDoesNotStart) {
+  PreparedQuery query("select 1", EvaluatorOptions());
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions()));
+  OperatorProfile profile;
+  QueryOptions options;
+  options.profile = &profile;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.ExecuteAfterPrepare(options));
+  iter.reset();
+  EXPECT_EQ(profile.name, "RootOp");
+  EXPECT_EQ(profile.num_evaluations, 0);
+  EXPECT_TRUE(profile.inputs.empty());
+}
+
+// An EvaluatorListener that records the events it receives.
+class RecordingListener : public EvaluatorListener {
+ public:
+  void OnPrepare(const EvaluatorPrepareEvent& event) override {
+    prepare_events.push_back(event);
+  }
+  void OnExecute(const EvaluatorExecuteEvent& event) override {
+    execute_events.push_back(event);
+  }
+
+  std::vector<EvaluatorPrepareEvent> prepare_events;
+  std::vector<EvaluatorExecuteEvent> execute_events;
+};
+
+TEST(EvaluatorListener, Query) {
+  SimpleTable left_table("LeftTable", {{"a", types::Int64Type()}});
+  left_table.SetContents({{Int64(1)}, {Int64(2)}, {Int64(3)}});
+  SimpleTable right_table("RightTable", {{"b", types::Int64Type()}});
+  right_table.SetContents({{Int64(2)}, {Int64(3)}});
+  SimpleCatalog catalog("TestCatalog");
+  catalog.AddZetaSQLFunctions();
+  catalog.AddTable(left_table.Name(), &left_table);
+  catalog.AddTable(right_table.Name(), &right_table);
+
+  RecordingListener listener;
+  EvaluatorOptions evaluator_options;
+  evaluator_options.listener = &listener;
+  const std::string sql =
+      "select a from LeftTable join RightTable on a = b order by a";
+  PreparedQuery query(sql, evaluator_options);
+  ZETASQL_ASSERT_OK(query.Prepare(AnalyzerOptions(), &catalog));
+  ASSERT_EQ(listener.prepare_events.size(), 1);
+  const EvaluatorPrepareEvent& prepare_event = listener.prepare_events[0];
+  EXPECT_EQ(prepare_event.sql, sql);
+  ZETASQL_EXPECT_OK(prepare_event.status);
+  EXPECT_GT(prepare_event.analyze_time, absl::ZeroDuration());
+  EXPECT_EQ(prepare_event.validate_time, absl::ZeroDuration());
+  EXPECT_GT(prepare_event.algebrize_time, absl::ZeroDuration());
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<EvaluatorTableIterator> iter,
+                       query.ExecuteAfterPrepare());
+  int num_rows = 0;
+  while (iter->NextRow()) {
+    ++num_rows;
+  }
+  ZETASQL_ASSERT_OK(iter->Status());
+  EXPECT_EQ(num_rows, 2);
+  // The execution is only reported when the iterator is destroyed.
+  EXPECT_TRUE(listener.execute_events.empty());
+  iter.reset();
+
+  ASSERT_EQ(listener.execute_events.size(), 1);
+  const EvaluatorExecuteEvent& execute_event = listener.execute_events[0];
+  EXPECT_EQ(execute_event.sql, sql);
+  ZETASQL_EXPECT_OK(execute_event.status);
+  EXPECT_GE(execute_event.execute_time, absl::ZeroDuration());
+  EXPECT_THAT(execute_event.rows_scanned,
+              UnorderedElementsAre(Pair("LeftTable", 3),
+                                   Pair("RightTable", 2)));
+  // The join and the sort buffer rows.
+  EXPECT_GT(execute_event.peak_intermediate_bytes, 0);
+  EXPECT_GE(execute_event.intermediate_bytes_requested,
+            execute_event.peak_intermediate_bytes);
+  EXPECT_EQ(execute_event.num_regexps_compiled, 0);
+  EXPECT_EQ(execute_event.num_json_parses, 0);
+}
+
+TEST(EvaluatorListener, Expression) {
+  RecordingListener listener;
+  EvaluatorOptions evaluator_options;
+  evaluator_options.listener = &listener;
+  PreparedExpression expr(
+      "regexp_contains('abc', @pattern) and json_type(@json) = 'array'",
+      evaluator_options);
+  AnalyzerOptions options;
+  options.mutable_language()->EnableLanguageFeature(FEATURE_JSON_TYPE);
+  options.mutable_language()->EnableLanguageFeature(
+      FEATURE_JSON_VALUE_EXTRACTION_FUNCTIONS);
+  ZETASQL_ASSERT_OK(options.AddQueryParameter("pattern", types::StringType()));
+  ZETASQL_ASSERT_OK(options.AddQueryParameter("json", types::JsonType()));
+  ZETASQL_ASSERT_OK(expr.Prepare(options));
+  ASSERT_EQ(listener.prepare_events.size(), 1);
+
+  EXPECT_THAT(expr.Execute({}, {{"pattern", Value::String("b")},
+                                {"json", Value::UnvalidatedJsonString("[1]")}}),
+              IsOkAndHolds(Bool(true)));
+  ASSERT_EQ(listener.execute_events.size(), 1);
+  const EvaluatorExecuteEvent& event = listener.execute_events[0];
+  ZETASQL_EXPECT_OK(event.status);
+  EXPECT_THAT(event.rows_scanned, IsEmpty());
+  EXPECT_EQ(event.num_regexps_compiled, 1);
+  EXPECT_EQ(event.num_json_parses, 1);
+
+  // Errors are reported too.
+  EXPECT_THAT(expr.Execute({}, {{"pattern", Value::String("(")},
+                                {"json", Value::UnvalidatedJsonString("[1]")}}),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  ASSERT_EQ(listener.execute_events.size(), 2);
+  EXPECT_THAT(listener.execute_events[1].status,
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(EvaluatorListener, CountsJsonParsesInJsonFunctions) {
+  RecordingListener listener;
+  EvaluatorOptions evaluator_options;
+  evaluator_options.listener = &listener;
+  PreparedExpression expr(
+      "concat(json_value(parse_json(@json), '$.a'), "
+      "json_extract_scalar(@json, '$.a'))",
+      evaluator_options);
+  AnalyzerOptions options;
+  options.mutable_language()->EnableLanguageFeature(FEATURE_JSON_TYPE);
+  ZETASQL_ASSERT_OK(options.AddQueryParameter("json", types::StringType()));
+  ZETASQL_ASSERT_OK(expr.Prepare(options));
+
+  EXPECT_THAT(expr.Execute({}, {{"json", Value::String(R"({"a": "x"})")}}),
+              IsOkAndHolds(String("xx")));
+  ASSERT_EQ(listener.execute_events.size(), 1);
+  const EvaluatorExecuteEvent& event = listener.execute_events[0];
+  ZETASQL_EXPECT_OK(event.status);
+  // One parse for PARSE_JSON, none for JSON_VALUE on the parsed JSON, and one
+  // for JSON_EXTRACT_SCALAR on the STRING.
+  EXPECT_EQ(event.num_json_parses, 2);
+}
+
+TEST(EvaluatorListener, PrepareError) {
+  RecordingListener listener;
+  EvaluatorOptions evaluator_options;
+  evaluator_options.listener = &listener;
+  PreparedExpression expr("1 +", evaluator_options);
+  EXPECT_THAT(expr.Prepare(AnalyzerOptions()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  ASSERT_EQ(listener.prepare_events.size(), 1);
+  EXPECT_THAT(listener.prepare_events[0].status,
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(listener.prepare_events[0].algebrize_time, absl::ZeroDuration());
+  EXPECT_TRUE(listener.execute_events.empty());
+}
+
 }  // namespace
 
 class PreparedQueryTest : public ::testing::Test {
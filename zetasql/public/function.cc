@@ -78,6 +78,8 @@ absl::Status FunctionOptions::Deserialize(
   options->set_supports_clamped_between_modifier(
       proto.supports_clamped_between_modifier());
   options->set_uses_upper_case_sql_name(proto.uses_upper_case_sql_name());
+  options->set_propagates_null(proto.propagates_null());
+  options->set_allows_constant_folding(proto.allows_constant_folding());
 
   *result = std::move(options);
   return absl::OkStatus();
@@ -100,6 +102,8 @@ void FunctionOptions::Serialize(FunctionOptionsProto* proto) const {
   proto->set_supports_clamped_between_modifier(
       supports_clamped_between_modifier);
   proto->set_uses_upper_case_sql_name(uses_upper_case_sql_name);
+  proto->set_propagates_null(propagates_null);
+  proto->set_allows_constant_folding(allows_constant_folding);
 
   for (const LanguageFeature each : required_language_features) {
     proto->add_required_language_feature(each);
@@ -117,6 +121,25 @@ FunctionOptions& FunctionOptions::set_evaluator(
   return *this;
 }
 
+absl::Status AggregateFunctionEvaluator::Merge(
+    const AggregateFunctionEvaluator& other) {
+  return absl::UnimplementedError(
+      "This aggregate function evaluator does not support Merge");
+}
+
+absl::StatusOr<std::string> AggregateFunctionEvaluator::SerializeState()
+    const {
+  return absl::UnimplementedError(
+      "This aggregate function evaluator does not support SerializeState");
+}
+
+absl::Status AggregateFunctionEvaluator::MergeSerializedState(
+    absl::string_view state) {
+  return absl::UnimplementedError(
+      "This aggregate function evaluator does not support "
+      "MergeSerializedState");
+}
+
 bool FunctionOptions::check_all_required_features_are_enabled(
     const LanguageOptions::LanguageFeatureSet& enabled_features) const {
   for (const LanguageFeature& feature : required_language_features) {
@@ -589,6 +612,11 @@ FunctionEvaluatorFactory Function::GetFunctionEvaluatorFactory() const {
   return function_options_.function_evaluator_factory;
 }
 
+AggregateFunctionEvaluatorFactory
+Function::GetAggregateFunctionEvaluatorFactory() const {
+  return function_options_.aggregate_function_evaluator_factory;
+}
+
 absl::Status Function::CheckWindowSupportOptions() const {
   if (IsScalar() && SupportsOverClause()) {
     return MakeSqlError() << "Scalar functions cannot support OVER clause";
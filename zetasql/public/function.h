@@ -33,7 +33,9 @@
 #include "zetasql/public/types/type_deserializer.h"
 #include "zetasql/public/value.h"
 #include "absl/base/attributes.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/status.h"
@@ -158,6 +160,50 @@ using FunctionEvaluator = std::function<absl::StatusOr<Value>(
 using FunctionEvaluatorFactory =
     std::function<absl::StatusOr<FunctionEvaluator>(const FunctionSignature&)>;
 
+// Evaluates a user-defined aggregate function over the rows of one group (or
+// window) at a time, keeping only the function's own state rather than the
+// group's values. An evaluator is only ever used by one thread at a time.
+//
+// Rows are passed to Accumulate() in no particular order, unless the query
+// orders the aggregate's input. Engines that compute a group in pieces combine
+// the pieces with Merge() or MergeSerializedState() before calling
+// GetFinalResult(), so functions that do not implement them can only be
+// evaluated by engines that compute each group in a single evaluator, like the
+// reference implementation.
+class AggregateFunctionEvaluator {
+ public:
+  virtual ~AggregateFunctionEvaluator() = default;
+
+  // Resets the state to that of an empty group.
+  virtual absl::Status Reset() = 0;
+
+  // Adds a row to the group. <args> has one value per argument of the
+  // function's concrete signature.
+  virtual absl::Status Accumulate(absl::Span<const Value> args) = 0;
+
+  // Adds the rows accumulated by <other>, an evaluator created for the same
+  // function signature, to this group. Returns an UNIMPLEMENTED error by
+  // default.
+  virtual absl::Status Merge(const AggregateFunctionEvaluator& other);
+
+  // Returns the result of the function for the rows accumulated so far.
+  virtual absl::StatusOr<Value> GetFinalResult() = 0;
+
+  // Returns the state of the evaluator as bytes that MergeSerializedState() of
+  // an evaluator for the same function signature accepts, for engines that
+  // ship partial aggregates between processes. Both return an UNIMPLEMENTED
+  // error by default.
+  virtual absl::StatusOr<std::string> SerializeState() const;
+  virtual absl::Status MergeSerializedState(absl::string_view state);
+};
+
+// Takes a concrete function signature and returns a new aggregate function
+// evaluator, or an error if one cannot be constructed. Called once for every
+// group or window that the function is computed for.
+using AggregateFunctionEvaluatorFactory =
+    std::function<absl::StatusOr<std::unique_ptr<AggregateFunctionEvaluator>>(
+        const FunctionSignature&)>;
+
 // Options that apply to a function.
 // The setter methods here return a reference to *self so options can be
 // constructed inline, and chained if desired.
@@ -302,6 +348,13 @@ struct FunctionOptions {
     volatility = value;
     return *this;
   }
+  // See <allows_constant_folding>. Only takes effect together with an
+  // IMMUTABLE volatility, which is the default; leaving it false keeps the
+  // evaluator of a user-defined function from being called at Prepare() time.
+  FunctionOptions& set_allows_constant_folding(bool value) {
+    allows_constant_folding = value;
+    return *this;
+  }
   FunctionOptions& set_supports_order_by(bool value) {
     supports_order_by = value;
     return *this;
@@ -334,6 +387,10 @@ struct FunctionOptions {
     uses_upper_case_sql_name = value;
     return *this;
   }
+  FunctionOptions& set_propagates_null(bool value) {
+    propagates_null = value;
+    return *this;
+  }
 
   // Add a LanguageFeature that must be enabled for this function to be enabled.
   // This is used only on built-in functions, and determines whether they will
@@ -366,6 +423,20 @@ struct FunctionOptions {
   // function.
   FunctionEvaluatorFactory function_evaluator_factory = nullptr;
 
+  // Sets the factory used to create the AggregateFunctionEvaluators for an
+  // aggregate function. This method is used only for evaluating the function
+  // using the Evaluator interface or the reference implementation.
+  FunctionOptions& set_aggregate_function_evaluator_factory(
+      const AggregateFunctionEvaluatorFactory& evaluator_factory) {
+    aggregate_function_evaluator_factory = evaluator_factory;
+    return *this;
+  }
+
+  // If not nullptr, the callback is invoked to obtain evaluators for an
+  // aggregate function.
+  AggregateFunctionEvaluatorFactory aggregate_function_evaluator_factory =
+      nullptr;
+
   // If not nullptr, identifies additional constraints to check during function
   // resolution. For example, an argument must be a literal, it must be a simple
   // type, it cannot be an array, etc.
@@ -435,6 +506,13 @@ struct FunctionOptions {
   // ../analyzer/expr_resolver_helper.h.
   FunctionEnums::Volatility volatility = FunctionEnums::IMMUTABLE;
 
+  // Indicates that engines may evaluate a call of this IMMUTABLE function
+  // whose arguments are all constants once, ahead of execution (e.g., the
+  // reference implementation does so during Prepare()). This is opt-in
+  // because <volatility> defaults to IMMUTABLE, and existing functions may
+  // rely on their evaluator being called when the query runs.
+  bool allows_constant_folding = false;
+
   // Indicates whether this function supports ORDER BY in arguments (affects
   // aggregate functions only).
   bool supports_order_by = false;
@@ -478,6 +556,11 @@ struct FunctionOptions {
   // the upper-case version of <sql_name>.
   bool uses_upper_case_sql_name = true;
 
+  // Indicates that the function returns NULL whenever any of its arguments is
+  // NULL. Engines may then return NULL for such calls without invoking the
+  // function's evaluator.
+  bool propagates_null = false;
+
   // A set of LanguageFeatures that need to be enabled for the function to be
   // loaded in GetZetaSQLFunctions.
   std::set<LanguageFeature> required_language_features;
@@ -698,6 +781,11 @@ class Function {
   // Returns the factory set in <function_options_>.
   FunctionEvaluatorFactory GetFunctionEvaluatorFactory() const;
 
+  // Returns the aggregate function evaluator factory set in
+  // <function_options_>.
+  AggregateFunctionEvaluatorFactory GetAggregateFunctionEvaluatorFactory()
+      const;
+
   // Returns Status indicating whether or not the constraints for the OVER
   // clause are violated:
   // 1) Scalar function cannot support the OVER clause;
@@ -0,0 +1,313 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/cast_batch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/public/functions/convert_string.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "zetasql/public/numeric_value.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+// Parses a '-' sign, if any, followed by 1 to 18 decimal digits, which cannot
+// overflow an int64_t. Returns false for any other input.
+bool ParseShortDecimal(absl::string_view str, int64_t* out) {
+  const bool negative = !str.empty() && str[0] == '-';
+  if (negative) str.remove_prefix(1);
+  if (str.empty() || str.size() > 18) return false;
+  int64_t value = 0;
+  for (char c : str) {
+    const unsigned digit = c - '0';
+    if (digit > 9) return false;
+    value = value * 10 + digit;
+  }
+  *out = negative ? -value : value;
+  return true;
+}
+
+// Parses the forms of 'str' that are common in data and cheap to recognize.
+// Returns false for any other form, which must then be parsed by
+// StringToNumeric<T>.
+template <typename T>
+bool ParseCommonForm(absl::string_view str, T* out) {
+  return false;
+}
+
+template <>
+bool ParseCommonForm(absl::string_view str, int64_t* out) {
+  return ParseShortDecimal(str, out);
+}
+
+template <>
+bool ParseCommonForm(absl::string_view str, int32_t* out) {
+  int64_t value;
+  if (!ParseShortDecimal(str, &value) ||
+      value < std::numeric_limits<int32_t>::min() ||
+      value > std::numeric_limits<int32_t>::max()) {
+    return false;
+  }
+  *out = static_cast<int32_t>(value);
+  return true;
+}
+
+template <>
+bool ParseCommonForm(absl::string_view str, double* out) {
+  // A decimal with at most 15 digits is exact as an integer in a double, and
+  // so is its power of ten, so their quotient is correctly rounded just as
+  // the result of StringToNumeric.
+  static constexpr double kPowersOfTen[] = {1e0,  1e1,  1e2,  1e3,
+                                            1e4,  1e5,  1e6,  1e7,
+                                            1e8,  1e9,  1e10, 1e11,
+                                            1e12, 1e13, 1e14, 1e15};
+  const bool negative = !str.empty() && str[0] == '-';
+  if (negative) str.remove_prefix(1);
+  int64_t mantissa = 0;
+  int num_digits = 0;
+  int num_fractional_digits = -1;
+  for (char c : str) {
+    if (c == '.' && num_fractional_digits < 0 && num_digits > 0) {
+      num_fractional_digits = 0;
+      continue;
+    }
+    const unsigned digit = c - '0';
+    if (digit > 9 || ++num_digits > 15) return false;
+    mantissa = mantissa * 10 + digit;
+    if (num_fractional_digits >= 0) ++num_fractional_digits;
+  }
+  if (num_digits == 0 || num_fractional_digits == 0) return false;
+  const double value =
+      mantissa / kPowersOfTen[std::max(num_fractional_digits, 0)];
+  *out = negative ? -value : value;
+  return true;
+}
+
+// Returns the value of the two decimal digits at 'str', or -1 if they are not
+// both digits.
+int ParseTwoDigits(const char* str) {
+  const unsigned high = str[0] - '0';
+  const unsigned low = str[1] - '0';
+  if (high > 9 || low > 9) return -1;
+  return high * 10 + low;
+}
+
+int DaysInMonth(int year, int month) {
+  static constexpr int kDaysInMonth[] = {31, 28, 31, 30, 31, 30,
+                                         31, 31, 30, 31, 30, 31};
+  if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) {
+    return 29;
+  }
+  return kDaysInMonth[month - 1];
+}
+
+// Returns the number of days from 1970-01-01 to the given date of the
+// proleptic Gregorian calendar. 'year' must be positive.
+int32_t DaysSinceEpoch(int year, int month, int day) {
+  // Starts years in March, so that the leap day is the last day of a year.
+  if (month <= 2) --year;
+  const int era = year / 400;
+  const int year_of_era = year - era * 400;
+  const int day_of_year =
+      (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const int day_of_era = year_of_era * 365 + year_of_era / 4 -
+                         year_of_era / 100 + day_of_year;
+  // 719468 is the number of days from 0000-03-01 to 1970-01-01.
+  return era * 146097 + day_of_era - 719468;
+}
+
+// Parses a date in the canonical form YYYY-MM-DD at the start of 'str', with a
+// year in [1, 9999], into days since the epoch. Returns false for any other
+// input, including invalid dates.
+bool ParseCanonicalDatePrefix(absl::string_view str, int32_t* date) {
+  if (str.size() < 10 || str[4] != '-' || str[7] != '-') return false;
+  const int century = ParseTwoDigits(&str[0]);
+  const int year_of_century = ParseTwoDigits(&str[2]);
+  const int month = ParseTwoDigits(&str[5]);
+  const int day = ParseTwoDigits(&str[8]);
+  if (century < 0 || year_of_century < 0 || month < 1 || month > 12 ||
+      day < 1) {
+    return false;
+  }
+  const int year = century * 100 + year_of_century;
+  if (year == 0 || day > DaysInMonth(year, month)) return false;
+  *date = DaysSinceEpoch(year, month, day);
+  return true;
+}
+
+// Same as ParseCanonicalDatePrefix, but requires the entire string to be
+// consumed.
+bool ParseCanonicalDate(absl::string_view str, int32_t* date) {
+  return str.size() == 10 && ParseCanonicalDatePrefix(str, date);
+}
+
+// Parses a timestamp without time zone in the canonical form
+// YYYY-MM-DD[( |T|t)HH:MM:SS[.F]], where F has 1 to 6 digits, into the days
+// since the epoch and the microseconds since the start of that day. Returns
+// false for any other input, including invalid dates and times and leap
+// seconds.
+bool ParseCanonicalTimestamp(absl::string_view str, int32_t* date,
+                             int64_t* micros_of_day) {
+  if (!ParseCanonicalDatePrefix(str, date)) return false;
+  if (str.size() == 10) {
+    *micros_of_day = 0;
+    return true;
+  }
+  if (str.size() < 19 || (str[10] != ' ' && str[10] != 'T' && str[10] != 't') ||
+      str[13] != ':' || str[16] != ':') {
+    return false;
+  }
+  const int hour = ParseTwoDigits(&str[11]);
+  const int minute = ParseTwoDigits(&str[14]);
+  const int second = ParseTwoDigits(&str[17]);
+  if (hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 ||
+      second > 59) {
+    return false;
+  }
+  int64_t micros = 0;
+  if (str.size() > 19) {
+    const int num_digits = static_cast<int>(str.size()) - 20;
+    if (str[19] != '.' || num_digits < 1 || num_digits > 6) return false;
+    for (char c : str.substr(20)) {
+      const unsigned digit = c - '0';
+      if (digit > 9) return false;
+      micros = micros * 10 + digit;
+    }
+    for (int i = num_digits; i < 6; ++i) {
+      micros *= 10;
+    }
+  }
+  *micros_of_day = ((hour * 60 + minute) * 60 + second) * 1000000LL + micros;
+  return true;
+}
+
+// Casts 'str' with the specialized parsers. Returns false if 'str' is not in
+// the canonical form or if its time is not valid, in which case the caller
+// must use ConvertStringToTimestamp().
+bool CastCanonicalTimestamp(absl::string_view str,
+                            absl::TimeZone default_timezone, bool is_utc,
+                            int64_t* timestamp) {
+  int32_t date;
+  int64_t micros_of_day;
+  if (!ParseCanonicalTimestamp(str, &date, &micros_of_day)) return false;
+  constexpr int64_t kMicrosPerDay = 24LL * 60 * 60 * 1000000;
+  if (is_utc) {
+    // Every date with a year in [1, 9999] is in the range of TIMESTAMP in UTC.
+    *timestamp = date * kMicrosPerDay + micros_of_day;
+    return true;
+  }
+  const absl::CivilSecond civil_second =
+      absl::CivilSecond(absl::CivilDay(1970, 1, 1) + date) +
+      micros_of_day / 1000000;
+  const absl::Time time = default_timezone.At(civil_second).pre +
+                          absl::Microseconds(micros_of_day % 1000000);
+  if (!IsValidTime(time)) return false;
+  *timestamp = absl::ToUnixMicros(time);
+  return true;
+}
+
+}  // namespace
+
+template <typename T>
+absl::Status StringToNumericBatch(absl::Span<const absl::string_view> values,
+                                  bool safe, absl::Span<T> out,
+                                  absl::Span<bool> is_valid) {
+  ZETASQL_DCHECK_EQ(values.size(), out.size());
+  ZETASQL_DCHECK_EQ(values.size(), is_valid.size());
+  absl::Status error;
+  for (int i = 0; i < values.size(); ++i) {
+    if (!is_valid[i] || ParseCommonForm(values[i], &out[i]) ||
+        StringToNumeric(values[i], &out[i], safe ? nullptr : &error)) {
+      continue;
+    }
+    if (!safe) return error;
+    is_valid[i] = false;
+  }
+  return absl::OkStatus();
+}
+
+template absl::Status StringToNumericBatch<bool>(
+    absl::Span<const absl::string_view> values, bool safe,
+    absl::Span<bool> out, absl::Span<bool> is_valid);
+template absl::Status StringToNumericBatch<int32_t>(
+    absl::Span<const absl::string_view> values, bool safe,
+    absl::Span<int32_t> out, absl::Span<bool> is_valid);
+template absl::Status StringToNumericBatch<int64_t>(
+    absl::Span<const absl::string_view> values, bool safe,
+    absl::Span<int64_t> out, absl::Span<bool> is_valid);
+template absl::Status StringToNumericBatch<uint32_t>(
+    absl::Span<const absl::string_view> values, bool safe,
+    absl::Span<uint32_t> out, absl::Span<bool> is_valid);
+template absl::Status StringToNumericBatch<uint64_t>(
+    absl::Span<const absl::string_view> values, bool safe,
+    absl::Span<uint64_t> out, absl::Span<bool> is_valid);
+template absl::Status StringToNumericBatch<float>(
+    absl::Span<const absl::string_view> values, bool safe,
+    absl::Span<float> out, absl::Span<bool> is_valid);
+template absl::Status StringToNumericBatch<double>(
+    absl::Span<const absl::string_view> values, bool safe,
+    absl::Span<double> out, absl::Span<bool> is_valid);
+template absl::Status StringToNumericBatch<NumericValue>(
+    absl::Span<const absl::string_view> values, bool safe,
+    absl::Span<NumericValue> out, absl::Span<bool> is_valid);
+template absl::Status StringToNumericBatch<BigNumericValue>(
+    absl::Span<const absl::string_view> values, bool safe,
+    absl::Span<BigNumericValue> out, absl::Span<bool> is_valid);
+
+absl::Status StringToDateBatch(absl::Span<const absl::string_view> values,
+                               bool safe, absl::Span<int32_t> out,
+                               absl::Span<bool> is_valid) {
+  ZETASQL_DCHECK_EQ(values.size(), out.size());
+  ZETASQL_DCHECK_EQ(values.size(), is_valid.size());
+  for (int i = 0; i < values.size(); ++i) {
+    if (!is_valid[i] || ParseCanonicalDate(values[i], &out[i])) continue;
+    absl::Status status = ConvertStringToDate(values[i], &out[i]);
+    if (status.ok()) continue;
+    if (!safe) return status;
+    is_valid[i] = false;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status StringToTimestampBatch(absl::Span<const absl::string_view> values,
+                                    absl::TimeZone default_timezone, bool safe,
+                                    absl::Span<int64_t> out,
+                                    absl::Span<bool> is_valid) {
+  ZETASQL_DCHECK_EQ(values.size(), out.size());
+  ZETASQL_DCHECK_EQ(values.size(), is_valid.size());
+  const bool is_utc = default_timezone == absl::UTCTimeZone();
+  for (int i = 0; i < values.size(); ++i) {
+    if (!is_valid[i] || CastCanonicalTimestamp(values[i], default_timezone,
+                                               is_utc, &out[i])) {
+      continue;
+    }
+    absl::Status status = ConvertStringToTimestamp(
+        values[i], default_timezone, kMicroseconds, /*allow_tz_in_str=*/true,
+        &out[i]);
+    if (status.ok()) continue;
+    if (!safe) return status;
+    is_valid[i] = false;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,75 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// This file declares casts from STRING that convert a batch of values per
+// call, for converting whole columns (for example of a table read from a CSV
+// file) without going through CastValue() one Value at a time. They skip the
+// per-value type dispatch, Value construction and status allocation, and parse
+// the most common forms (plain decimal integers, and dates and timestamps in
+// canonical form without a time zone) with specialized parsers. Every other
+// form is handled by the scalar functions in convert_string.h and
+// date_time_util.h, so the results and errors are the same as CastValue()'s.
+//
+// All the functions take the following arguments:
+//   values:   The strings to cast.
+//   safe:     Whether to cast as SAFE_CAST does.
+//   out:      Receives the cast of values[i] in out[i].
+//   is_valid: On input, is_valid[i] is false if values[i] is NULL, in which
+//             case values[i] is ignored and out[i] is left unchanged.
+//
+// All the spans must have the same size. If a value cannot be cast, the
+// functions return the error for the first such value, unless 'safe' is true,
+// in which case they set is_valid[i] to false, as SAFE_CAST returns NULL, and
+// continue with the next value.
+
+#ifndef ZETASQL_PUBLIC_FUNCTIONS_CAST_BATCH_H_
+#define ZETASQL_PUBLIC_FUNCTIONS_CAST_BATCH_H_
+
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace functions {
+
+// Casts to T like StringToNumeric<T>. T must be one of the types supported by
+// StringToNumeric: bool, int32_t, int64_t, uint32_t, uint64_t, float, double,
+// NumericValue or BigNumericValue.
+template <typename T>
+absl::Status StringToNumericBatch(absl::Span<const absl::string_view> values,
+                                  bool safe, absl::Span<T> out,
+                                  absl::Span<bool> is_valid);
+
+// Casts to DATE like ConvertStringToDate, producing days since the epoch.
+absl::Status StringToDateBatch(absl::Span<const absl::string_view> values,
+                               bool safe, absl::Span<int32_t> out,
+                               absl::Span<bool> is_valid);
+
+// Casts to TIMESTAMP like ConvertStringToTimestamp with kMicroseconds scale,
+// producing microseconds since the epoch. Strings without a time zone are
+// interpreted in 'default_timezone'.
+absl::Status StringToTimestampBatch(absl::Span<const absl::string_view> values,
+                                    absl::TimeZone default_timezone, bool safe,
+                                    absl::Span<int64_t> out,
+                                    absl::Span<bool> is_valid);
+
+}  // namespace functions
+}  // namespace zetasql
+
+#endif  // ZETASQL_PUBLIC_FUNCTIONS_CAST_BATCH_H_
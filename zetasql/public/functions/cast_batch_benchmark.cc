@@ -0,0 +1,184 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures the throughput of casting columns of strings to INT64, DOUBLE, DATE
+// and TIMESTAMP with CastValue(), with the scalar conversion functions called
+// once per value, and with the batch casts. The argument of each benchmark
+// selects the target type, in that order.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/cast.h"
+#include "zetasql/public/functions/cast_batch.h"
+#include "zetasql/public/functions/convert_string.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "zetasql/public/language_options.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "benchmark/benchmark.h"
+#include "absl/random/random.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+constexpr int kBatchSize = 1024;
+
+enum TargetType { kInt64 = 0, kDouble = 1, kDate = 2, kTimestamp = 3 };
+
+// Returns kBatchSize strings in the form produced by CAST(x AS STRING) for the
+// given target type, as in a CSV file.
+std::vector<std::string> MakeStrings(int64_t target_type) {
+  absl::BitGen random;
+  std::vector<std::string> strings;
+  strings.reserve(kBatchSize);
+  for (int i = 0; i < kBatchSize; ++i) {
+    const int64_t micros = absl::Uniform<int64_t>(
+        random, 0, int64_t{50} * 365 * 24 * 60 * 60 * 1000000);
+    const absl::Time time = absl::UnixEpoch() + absl::Microseconds(micros);
+    switch (target_type) {
+      case kInt64:
+        strings.push_back(absl::StrFormat(
+            "%d", absl::Uniform<int64_t>(random, -10000000, 10000000)));
+        break;
+      case kDouble:
+        strings.push_back(absl::StrFormat(
+            "%.2f", absl::Uniform<double>(random, -100000, 100000)));
+        break;
+      case kDate:
+        strings.push_back(
+            absl::FormatTime("%Y-%m-%d", time, absl::UTCTimeZone()));
+        break;
+      case kTimestamp:
+        strings.push_back(
+            absl::FormatTime("%Y-%m-%d %H:%M:%E6S", time, absl::UTCTimeZone()));
+        break;
+    }
+  }
+  return strings;
+}
+
+const Type* ToType(int64_t target_type) {
+  switch (target_type) {
+    case kInt64:
+      return types::Int64Type();
+    case kDouble:
+      return types::DoubleType();
+    case kDate:
+      return types::DateType();
+    default:
+      return types::TimestampType();
+  }
+}
+
+void SetItemsProcessed(benchmark::State& state) {
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_CastValue(benchmark::State& state) {
+  std::vector<Value> values;
+  for (const std::string& str : MakeStrings(state.range(0))) {
+    values.push_back(Value::String(str));
+  }
+  const Type* to_type = ToType(state.range(0));
+  const LanguageOptions language_options;
+  for (auto _ : state) {
+    for (const Value& value : values) {
+      benchmark::DoNotOptimize(CastValue(value, absl::UTCTimeZone(),
+                                         language_options, to_type));
+    }
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK(BM_CastValue)->DenseRange(kInt64, kTimestamp);
+
+void BM_CastScalar(benchmark::State& state) {
+  const std::vector<std::string> strings = MakeStrings(state.range(0));
+  absl::Status error;
+  int64_t int64_out;
+  double double_out;
+  int32_t date_out;
+  for (auto _ : state) {
+    for (const std::string& str : strings) {
+      switch (state.range(0)) {
+        case kInt64:
+          benchmark::DoNotOptimize(StringToNumeric(str, &int64_out, &error));
+          break;
+        case kDouble:
+          benchmark::DoNotOptimize(StringToNumeric(str, &double_out, &error));
+          break;
+        case kDate:
+          benchmark::DoNotOptimize(ConvertStringToDate(str, &date_out));
+          break;
+        case kTimestamp:
+          benchmark::DoNotOptimize(ConvertStringToTimestamp(
+              str, absl::UTCTimeZone(), kMicroseconds,
+              /*allow_tz_in_str=*/true, &int64_out));
+          break;
+      }
+    }
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK(BM_CastScalar)->DenseRange(kInt64, kTimestamp);
+
+void BM_CastBatch(benchmark::State& state) {
+  const std::vector<std::string> strings = MakeStrings(state.range(0));
+  const std::vector<absl::string_view> views(strings.begin(), strings.end());
+  std::unique_ptr<bool[]> is_valid(new bool[kBatchSize]);
+  std::vector<int64_t> int64_out(kBatchSize);
+  std::vector<double> double_out(kBatchSize);
+  std::vector<int32_t> date_out(kBatchSize);
+  for (auto _ : state) {
+    std::fill(is_valid.get(), is_valid.get() + kBatchSize, true);
+    const absl::Span<bool> is_valid_span =
+        absl::MakeSpan(is_valid.get(), kBatchSize);
+    switch (state.range(0)) {
+      case kInt64:
+        benchmark::DoNotOptimize(StringToNumericBatch<int64_t>(
+            views, /*safe=*/false, absl::MakeSpan(int64_out), is_valid_span));
+        break;
+      case kDouble:
+        benchmark::DoNotOptimize(StringToNumericBatch<double>(
+            views, /*safe=*/false, absl::MakeSpan(double_out), is_valid_span));
+        break;
+      case kDate:
+        benchmark::DoNotOptimize(StringToDateBatch(
+            views, /*safe=*/false, absl::MakeSpan(date_out), is_valid_span));
+        break;
+      case kTimestamp:
+        benchmark::DoNotOptimize(StringToTimestampBatch(
+            views, absl::UTCTimeZone(), /*safe=*/false,
+            absl::MakeSpan(int64_out), is_valid_span));
+        break;
+    }
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK(BM_CastBatch)->DenseRange(kInt64, kTimestamp);
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
@@ -0,0 +1,204 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/public/functions/cast_batch.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/functions/convert_string.h"
+#include "zetasql/public/functions/date_time_util.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+// Casts 'values' with the batch function 'cast_batch' and one value at a time
+// with 'cast', and verifies that they agree on the results and errors, both
+// with and without SAFE_CAST semantics. Every other value is NULL in a second
+// pass.
+template <typename T>
+void VerifyBatchMatchesScalar(
+    const std::vector<absl::string_view>& values,
+    const std::function<absl::Status(absl::Span<const absl::string_view>, bool,
+                                     absl::Span<T>, absl::Span<bool>)>&
+        cast_batch,
+    const std::function<absl::Status(absl::string_view, T*)>& cast) {
+  for (bool with_nulls : {false, true}) {
+    // Not std::vector, which does not store bools in an array.
+    std::unique_ptr<T[]> out_array(new T[values.size()]);
+    std::unique_ptr<bool[]> is_valid_array(new bool[values.size()]);
+    const absl::Span<T> out = absl::MakeSpan(out_array.get(), values.size());
+    const absl::Span<bool> is_valid =
+        absl::MakeSpan(is_valid_array.get(), values.size());
+    for (int i = 0; i < values.size(); ++i) {
+      is_valid[i] = !with_nulls || i % 2 == 0;
+    }
+    ZETASQL_ASSERT_OK(cast_batch(values, /*safe=*/true, out, is_valid));
+
+    absl::Status first_error;
+    for (int i = 0; i < values.size(); ++i) {
+      SCOPED_TRACE(values[i]);
+      if (with_nulls && i % 2 != 0) {
+        EXPECT_FALSE(is_valid[i]);
+        continue;
+      }
+      T expected;
+      const absl::Status status = cast(values[i], &expected);
+      EXPECT_EQ(is_valid[i], status.ok());
+      if (status.ok()) {
+        EXPECT_EQ(out[i], expected);
+      } else if (first_error.ok()) {
+        first_error = status;
+      }
+    }
+
+    for (int i = 0; i < values.size(); ++i) {
+      is_valid[i] = !with_nulls || i % 2 == 0;
+    }
+    EXPECT_EQ(cast_batch(values, /*safe=*/false, out, is_valid), first_error);
+  }
+}
+
+template <typename T>
+void VerifyNumericBatch(const std::vector<absl::string_view>& values) {
+  VerifyBatchMatchesScalar<T>(
+      values, &StringToNumericBatch<T>,
+      [](absl::string_view value, T* out) {
+        absl::Status error;
+        StringToNumeric(value, out, &error);
+        return error;
+      });
+}
+
+TEST(CastBatchTest, StringToNumeric) {
+  const std::vector<absl::string_view> values = {
+      "0",
+      "-0",
+      "7",
+      "-123",
+      "007",
+      "2147483647",
+      "-2147483648",
+      "2147483648",
+      "999999999999999999",
+      "-999999999999999999",
+      "9223372036854775807",
+      "-9223372036854775808",
+      "9223372036854775808",
+      "18446744073709551616",
+      "",
+      "-",
+      "--1",
+      "+5",
+      " 12",
+      "12 ",
+      "0x1F",
+      "-0x1f",
+      "1.5",
+      "0.1",
+      "-1234.56",
+      "0.000000000000001",
+      "123456789012345",
+      "1234567890123456",
+      "12345678.9012345",
+      "12345678.90123456",
+      "5.",
+      ".5",
+      "1..5",
+      "1.5.",
+      "1e3",
+      "inf",
+      "abc",
+      "true",
+      "false",
+  };
+  VerifyNumericBatch<bool>(values);
+  VerifyNumericBatch<int32_t>(values);
+  VerifyNumericBatch<int64_t>(values);
+  VerifyNumericBatch<uint32_t>(values);
+  VerifyNumericBatch<uint64_t>(values);
+  VerifyNumericBatch<float>(values);
+  VerifyNumericBatch<double>(values);
+  VerifyNumericBatch<NumericValue>(values);
+  VerifyNumericBatch<BigNumericValue>(values);
+}
+
+TEST(CastBatchTest, StringToDate) {
+  VerifyBatchMatchesScalar<int32_t>(
+      {"1970-01-01", "1969-12-31", "2020-02-29", "2021-02-29", "2000-02-29",
+       "1900-02-29", "2100-02-28", "0001-01-01", "9999-12-31", "0000-12-31",
+       "10000-01-01", "2020-1-5", "2020-01-5", "2020-13-01", "2020-00-10",
+       "2020-04-31", "2020-04-00", "2020/04/01", "2020-04-01 ", " 2020-04-01",
+       "2020-04-01T00:00:00", "", "abcd-ef-gh"},
+      &StringToDateBatch, &ConvertStringToDate);
+}
+
+TEST(CastBatchTest, StringToTimestamp) {
+  const std::vector<absl::string_view> values = {
+      "1970-01-01",
+      "1970-01-01 00:00:00",
+      "1969-12-31 23:59:59.5",
+      "0001-01-01 00:00:00",
+      "9999-12-31 23:59:59.999999",
+      "2020-02-29T12:34:56.123",
+      "2020-02-29t12:34:56.000001",
+      "2021-03-14 02:30:00",
+      "2021-11-07 01:30:00",
+      "2020-06-01 12:00:00.1234567",
+      "2020-06-01 12:00:00.",
+      "2020-06-01 24:00:00",
+      "2020-06-01 23:60:00",
+      "2020-06-01 23:59:60",
+      "2020-06-01 1:02:03",
+      "2020-06-01 12:00:00+05:30",
+      "2020-06-01 12:00:00 UTC",
+      "2020-06-01 12:00:00 America/New_York",
+      "2020-06-01T12:00:00Z",
+      "2021-02-29 00:00:00",
+      "2020-06-01 12:00",
+      "",
+  };
+  for (absl::string_view timezone_name :
+       {"UTC", "America/Los_Angeles", "Asia/Kolkata", "Pacific/Kiritimati"}) {
+    SCOPED_TRACE(timezone_name);
+    absl::TimeZone timezone;
+    ZETASQL_ASSERT_OK(MakeTimeZone(timezone_name, &timezone));
+    VerifyBatchMatchesScalar<int64_t>(
+        values,
+        [timezone](absl::Span<const absl::string_view> values, bool safe,
+                   absl::Span<int64_t> out, absl::Span<bool> is_valid) {
+          return StringToTimestampBatch(values, timezone, safe, out, is_valid);
+        },
+        [timezone](absl::string_view value, int64_t* out) {
+          return ConvertStringToTimestamp(value, timezone, kMicroseconds,
+                                          /*allow_tz_in_str=*/true, out);
+        });
+  }
+}
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
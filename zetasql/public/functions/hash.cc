@@ -47,15 +47,32 @@ class OpenSSLHasher final : public Hasher {
   }
 
   std::string Hash(absl::string_view input) final {
-    init_f(&ctx_);
     memset(digest_, 0, sizeof(digest_));
-    ZETASQL_CHECK_EQ(update_f(&ctx_, input.data(), input.length()), 1);
-
-    ZETASQL_CHECK_EQ(finalize_f(digest_, &ctx_), 1);
+    HashInto(input, digest_);
     return std::string(reinterpret_cast<const char*>(digest_), sizeof(digest_));
   }
 
+  int digest_size() const final { return kDigestSize; }
+
+  void HashBatch(absl::Span<const absl::string_view> inputs,
+                 std::string* digests) final {
+    digests->resize(inputs.size() * kDigestSize);
+    uint8_t* out = reinterpret_cast<uint8_t*>(&(*digests)[0]);
+    for (const absl::string_view input : inputs) {
+      HashInto(input, out);
+      out += kDigestSize;
+    }
+  }
+
  private:
+  // Writes the hash of 'input' to 'out', which must have room for
+  // kDigestSize bytes.
+  void HashInto(absl::string_view input, uint8_t* out) {
+    init_f(&ctx_);
+    ZETASQL_CHECK_EQ(update_f(&ctx_, input.data(), input.length()), 1);
+    ZETASQL_CHECK_EQ(finalize_f(out, &ctx_), 1);
+  }
+
   // Note: Neither of these values are really state of the class, rather, they
   // are used as buffers to avoid having to allocate on every call to `Hash()`.
   CtxT ctx_;
@@ -109,9 +126,31 @@ std::unique_ptr<Hasher> Hasher::Create(Algorithm algorithm) {
   }
 }
 
+int Hasher::digest_size() const {
+  // Hash() is not const only because implementations may keep scratch
+  // buffers; hashing does not change the observable state of the hasher.
+  return static_cast<int>(const_cast<Hasher*>(this)->Hash("").size());
+}
+
+void Hasher::HashBatch(absl::Span<const absl::string_view> inputs,
+                       std::string* digests) {
+  digests->clear();
+  for (const absl::string_view input : inputs) {
+    digests->append(Hash(input));
+  }
+}
+
 int64_t FarmFingerprint(absl::string_view input) {
   return absl::bit_cast<int64_t>(farmhash::Fingerprint64(input));
 }
 
+void FarmFingerprintBatch(absl::Span<const absl::string_view> inputs,
+                          absl::Span<int64_t> fingerprints) {
+  ZETASQL_CHECK_EQ(inputs.size(), fingerprints.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    fingerprints[i] = FarmFingerprint(inputs[i]);
+  }
+}
+
 }  // namespace functions
 }  // namespace zetasql
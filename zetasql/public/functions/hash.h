@@ -26,6 +26,7 @@
 #include "absl/base/attributes.h"
 #include <cstdint>
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace zetasql {
 namespace functions {
@@ -48,12 +49,32 @@ class Hasher {
   // Returns the hash of the input bytes. Calling this method concurrently
   // on the same object is not thread-safe.
   ABSL_MUST_USE_RESULT virtual std::string Hash(absl::string_view input) = 0;
+
+  // Returns the size in bytes of the hashes computed by this object. The
+  // default implementation hashes an empty input, so it has the same
+  // thread-safety as Hash(); subclasses should override it.
+  virtual int digest_size() const;
+
+  // Hashes each of 'inputs' and stores the hashes back to back in '*digests',
+  // which is resized to inputs.size() * digest_size(); the hash of inputs[i]
+  // starts at offset i * digest_size(). Reusing 'digests' across calls avoids
+  // allocating a string per input. Same thread-safety as Hash().
+  //
+  // The default implementation calls Hash() for each input. Subclasses should
+  // override it to hash directly into '*digests'.
+  virtual void HashBatch(absl::Span<const absl::string_view> inputs,
+                         std::string* digests);
 };
 
 // Computes the fingerprint of the input bytes using the farmhash::Fingerprint64
 // function from the FarmHash library (https://github.com/google/farmhash).
 int64_t FarmFingerprint(absl::string_view input);
 
+// Computes FarmFingerprint() of each of 'inputs' into the corresponding
+// element of 'fingerprints', which must have the same size as 'inputs'.
+void FarmFingerprintBatch(absl::Span<const absl::string_view> inputs,
+                          absl::Span<int64_t> fingerprints);
+
 }  // namespace functions
 }  // namespace zetasql
 
@@ -0,0 +1,127 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Compares hashing one input per call with the batch APIs, for batches of
+// 1024 inputs of various sizes.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/functions/hash.h"
+#include "benchmark/benchmark.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+constexpr int kBatchSize = 1024;
+
+// Owns kBatchSize distinct inputs of 'input_size' bytes each.
+class Inputs {
+ public:
+  explicit Inputs(int64_t input_size) {
+    storage_.reserve(kBatchSize);
+    for (int i = 0; i < kBatchSize; ++i) {
+      std::string input(input_size, 'a');
+      for (int64_t j = 0; j < input_size; ++j) {
+        input[j] = static_cast<char>('a' + (i + j) % 26);
+      }
+      storage_.push_back(std::move(input));
+    }
+    views_.assign(storage_.begin(), storage_.end());
+  }
+
+  absl::Span<const absl::string_view> views() const { return views_; }
+
+  int64_t total_bytes() const {
+    return static_cast<int64_t>(kBatchSize) * storage_[0].size();
+  }
+
+ private:
+  std::vector<std::string> storage_;
+  std::vector<absl::string_view> views_;
+};
+
+void ApplyAlgorithmsAndSizes(benchmark::internal::Benchmark* b) {
+  for (int algorithm : {Hasher::kMd5, Hasher::kSha1, Hasher::kSha256,
+                        Hasher::kSha512}) {
+    for (int64_t size : {16, 256, 4096}) {
+      b->Args({algorithm, size});
+    }
+  }
+}
+
+void BM_HashPerRow(benchmark::State& state) {
+  const std::unique_ptr<Hasher> hasher =
+      Hasher::Create(static_cast<Hasher::Algorithm>(state.range(0)));
+  const Inputs inputs(state.range(1));
+  for (auto _ : state) {
+    for (absl::string_view input : inputs.views()) {
+      std::string digest = hasher->Hash(input);
+      benchmark::DoNotOptimize(digest);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  state.SetBytesProcessed(state.iterations() * inputs.total_bytes());
+}
+BENCHMARK(BM_HashPerRow)->Apply(ApplyAlgorithmsAndSizes);
+
+void BM_HashBatch(benchmark::State& state) {
+  const std::unique_ptr<Hasher> hasher =
+      Hasher::Create(static_cast<Hasher::Algorithm>(state.range(0)));
+  const Inputs inputs(state.range(1));
+  std::string digests;
+  for (auto _ : state) {
+    hasher->HashBatch(inputs.views(), &digests);
+    benchmark::DoNotOptimize(digests);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  state.SetBytesProcessed(state.iterations() * inputs.total_bytes());
+}
+BENCHMARK(BM_HashBatch)->Apply(ApplyAlgorithmsAndSizes);
+
+void BM_FarmFingerprintPerRow(benchmark::State& state) {
+  const Inputs inputs(state.range(0));
+  for (auto _ : state) {
+    for (absl::string_view input : inputs.views()) {
+      benchmark::DoNotOptimize(FarmFingerprint(input));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  state.SetBytesProcessed(state.iterations() * inputs.total_bytes());
+}
+BENCHMARK(BM_FarmFingerprintPerRow)->Arg(16)->Arg(256)->Arg(4096);
+
+void BM_FarmFingerprintBatch(benchmark::State& state) {
+  const Inputs inputs(state.range(0));
+  std::vector<int64_t> fingerprints(kBatchSize);
+  for (auto _ : state) {
+    FarmFingerprintBatch(inputs.views(), absl::MakeSpan(fingerprints));
+    benchmark::DoNotOptimize(fingerprints.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  state.SetBytesProcessed(state.iterations() * inputs.total_bytes());
+}
+BENCHMARK(BM_FarmFingerprintBatch)->Arg(16)->Arg(256)->Arg(4096);
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
@@ -16,6 +16,9 @@
 
 #include "zetasql/public/functions/hash.h"
 
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -24,7 +27,10 @@
 #include "zetasql/public/value.h"
 #include "zetasql/testing/test_function.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 
 namespace zetasql {
 namespace functions {
@@ -79,6 +85,54 @@ TEST(HashTest, BasicCorrectness) {
   }
 }
 
+TEST(HashTest, BatchMatchesSingleInput) {
+  const std::string long_input(1000, 'x');
+  const std::vector<absl::string_view> inputs = {"abc", "", "123456",
+                                                 long_input};
+  for (Hasher::Algorithm algorithm :
+       {Hasher::kMd5, Hasher::kSha1, Hasher::kSha256, Hasher::kSha512}) {
+    SCOPED_TRACE(absl::Substitute("Algorithm $0", algorithm));
+    const std::unique_ptr<Hasher> hasher = Hasher::Create(algorithm);
+    const int digest_size = hasher->digest_size();
+
+    std::string digests = "stale contents";
+    hasher->HashBatch(inputs, &digests);
+    ASSERT_EQ(inputs.size() * digest_size, digests.size());
+    for (int i = 0; i < inputs.size(); ++i) {
+      EXPECT_EQ(hasher->Hash(inputs[i]),
+                digests.substr(i * digest_size, digest_size));
+    }
+
+    hasher->HashBatch({}, &digests);
+    EXPECT_TRUE(digests.empty());
+  }
+}
+
+// A Hasher that only implements Hash(), to test the default implementations of
+// the other methods.
+class XorFoldingHasher : public Hasher {
+ public:
+  std::string Hash(absl::string_view input) override {
+    std::string hash(4, '\0');
+    for (int i = 0; i < input.size(); ++i) {
+      hash[i % 4] ^= input[i];
+    }
+    return hash;
+  }
+};
+
+TEST(HashTest, DefaultBatchImplementation) {
+  XorFoldingHasher hasher;
+  EXPECT_EQ(hasher.digest_size(), 4);
+
+  const std::vector<absl::string_view> inputs = {"abcdef", "", "x"};
+  std::string digests = "stale contents";
+  hasher.HashBatch(inputs, &digests);
+  EXPECT_EQ(digests,
+            absl::StrCat(hasher.Hash(inputs[0]), hasher.Hash(inputs[1]),
+                         hasher.Hash(inputs[2])));
+}
+
 TEST(HashTest, ComplianceTests) {
   std::unique_ptr<Hasher> md5 = Hasher::Create(Hasher::Algorithm::kMd5);
   std::unique_ptr<Hasher> sha1 = Hasher::Create(Hasher::Algorithm::kSha1);
@@ -143,6 +197,15 @@ TEST(FingerprintTest, ComplianceTests) {
   }
 }
 
+TEST(FingerprintTest, Batch) {
+  const std::vector<absl::string_view> inputs = {"abc", "", "123456"};
+  std::vector<int64_t> fingerprints(inputs.size());
+  FarmFingerprintBatch(inputs, absl::MakeSpan(fingerprints));
+  for (int i = 0; i < inputs.size(); ++i) {
+    EXPECT_EQ(FarmFingerprint(inputs[i]), fingerprints[i]);
+  }
+}
+
 }  // namespace
 }  // namespace functions
 }  // namespace zetasql
@@ -199,6 +199,13 @@ bool Utf8Trimmer::Initialize(absl::string_view to_trim, absl::Status* error) {
   }
   unicode_set_ = absl::make_unique<icu::UnicodeSet>();
   has_explicit_replacement_char_ = false;
+  ascii_only_ = IsAscii(to_trim);
+  memset(ascii_to_trim_, 0, sizeof(ascii_to_trim_));
+  if (ascii_only_) {
+    for (const char ch : to_trim) {
+      ascii_to_trim_[static_cast<uint8_t>(ch)] = true;
+    }
+  }
   int32_t offset = 0;
   while (offset < str_length32) {
     UChar32 character;
@@ -256,6 +263,19 @@ bool Utf8Trimmer::TrimLeft(absl::string_view str, absl::string_view* out,
   if (has_explicit_replacement_char_ && !IsWellFormedUTF8(str)) {
     return internal::UpdateError(error, kBadUtf8);
   }
+  if (ascii_only_) {
+    int32_t str_length32;
+    if (!CheckAndCastStrLength(str, &str_length32, error)) {
+      return false;
+    }
+    size_t prefix_length = 0;
+    while (prefix_length < str.length() &&
+           IsAsciiToTrim(str[prefix_length])) {
+      ++prefix_length;
+    }
+    *out = str.substr(prefix_length);
+    return true;
+  }
 
   return TrimLeftImpl(str, *unicode_set_, out, error);
 }
@@ -270,6 +290,18 @@ bool Utf8Trimmer::TrimRight(absl::string_view str, absl::string_view* out,
   if (has_explicit_replacement_char_ && !IsWellFormedUTF8(str)) {
     return internal::UpdateError(error, kBadUtf8);
   }
+  if (ascii_only_) {
+    int32_t str_length32;
+    if (!CheckAndCastStrLength(str, &str_length32, error)) {
+      return false;
+    }
+    size_t suffix_start = str.length();
+    while (suffix_start > 0 && IsAsciiToTrim(str[suffix_start - 1])) {
+      --suffix_start;
+    }
+    *out = str.substr(0, suffix_start);
+    return true;
+  }
 
   return TrimRightImpl(str, *unicode_set_, out, error);
 }
@@ -411,6 +443,13 @@ bool LengthUtf8(absl::string_view str, int64_t* out, absl::Status* error) {
   int utf8_length = 0;
   int32_t offset = 0;
   while (offset < str_length32) {
+    // Each ASCII character is a single byte.
+    const int32_t ascii_length =
+        static_cast<int32_t>(SpanAscii(str.substr(offset)));
+    offset += ascii_length;
+    utf8_length += ascii_length;
+    if (offset == str_length32) break;
+
     UChar32 character;
     U8_NEXT(str.data(), offset, str_length32, character);
     if (character < 0) {
@@ -570,6 +609,14 @@ static bool ForwardN(absl::string_view str, int32_t str_length32,
                      bool* hit_end, absl::Status* error) {
   int64_t i = 0;
   for (; i < num_code_points && *str_offset < str_length32; ++i) {
+    // Skip over ASCII characters, which are one byte each, without decoding.
+    const int32_t ascii_length = static_cast<int32_t>(SpanAscii(str.substr(
+        *str_offset, std::min<int64_t>(num_code_points - i,
+                                       str_length32 - *str_offset))));
+    *str_offset += ascii_length;
+    i += ascii_length;
+    if (i == num_code_points || *str_offset == str_length32) break;
+
     UChar32 character;
     U8_NEXT(str.data(), *str_offset, str_length32, character);
     if (character < 0) {
@@ -587,7 +634,12 @@ static bool ForwardN(absl::string_view str, int32_t str_length32,
 static bool BackN(absl::string_view str, int64_t num_code_points,
                   int32_t* str_offset, bool* hit_start, absl::Status* error) {
   int64_t i = 0;
-  for (; i<num_code_points&& * str_offset> 0; ++i) {
+  for (; i < num_code_points && *str_offset > 0; ++i) {
+    if ((static_cast<uint8_t>(str[*str_offset - 1]) & 0x80) == 0) {
+      // ASCII character.
+      --*str_offset;
+      continue;
+    }
     UChar32 character;
     U8_PREV(str.data(), 0, *str_offset, character);
 
@@ -986,6 +1038,10 @@ bool UpperUtf8(absl::string_view str, std::string* out, absl::Status* error) {
   if (!CheckAndCastStrLength(str, &str_length32, error)) {
     return false;
   }
+  if (IsAscii(str)) {
+    // The root locale maps ASCII letters to ASCII letters.
+    return UpperBytes(str, out, error);
+  }
   out->clear();
   out->reserve(str.length());
 
@@ -1010,6 +1066,10 @@ bool LowerUtf8(absl::string_view str, std::string* out, absl::Status* error) {
   if (!CheckAndCastStrLength(str, &str_length32, error)) {
     return false;
   }
+  if (IsAscii(str)) {
+    // The root locale maps ASCII letters to ASCII letters.
+    return LowerBytes(str, out, error);
+  }
   out->clear();
   out->reserve(str.length());
 
@@ -155,6 +155,11 @@ class Utf8Trimmer {
             absl::Status* error) const;
 
  private:
+  bool IsAsciiToTrim(char ch) const {
+    const uint8_t byte = static_cast<uint8_t>(ch);
+    return byte < 0x80 && ascii_to_trim_[byte];
+  }
+
   std::unique_ptr<icu::UnicodeSet> unicode_set_;
   // We use icu::UnicodeSet::spanUtf8, which automatically 'fixes' ill formed
   // spans with the replacement character before deciding to trim or not, which
@@ -164,6 +169,11 @@ class Utf8Trimmer {
   // ill-formed).  We do this conditionally, as it is more expensive, since
   // it requires two passes over the input.
   bool has_explicit_replacement_char_ = false;
+  // If all the characters to trim are ASCII, they are also recorded here and
+  // trimming scans bytes directly instead of going through 'unicode_set_'.
+  // Any non-ASCII byte ends the span, as it does for spanUTF8.
+  bool ascii_only_ = false;
+  bool ascii_to_trim_[128] = {};
 };
 
 // This class allows for a more efficient implementation of TRIM(), LTRIM()
@@ -0,0 +1,359 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Benchmarks for the UTF-8 string functions. Each function is measured on an
+// ASCII, a mixed (mostly ASCII with some accented letters) and a CJK corpus,
+// and compared against the equivalent loop over ICU code point iteration,
+// which is what these functions did before they gained ASCII fast paths.
+
+#include <cstdint>
+#include <string>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/public/functions/string.h"
+#include "benchmark/benchmark.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "unicode/bytestream.h"
+#include "unicode/casemap.h"
+#include "unicode/errorcode.h"
+#include "unicode/uniset.h"
+#include "unicode/utf8.h"
+
+namespace zetasql {
+namespace functions {
+namespace {
+
+enum Corpus { kAscii = 0, kMixed = 1, kCjk = 2 };
+
+// Returns a string of roughly 'size' bytes drawn from 'corpus'.
+std::string MakeCorpus(Corpus corpus, int64_t size) {
+  absl::string_view piece;
+  switch (corpus) {
+    case kAscii:
+      piece = "The quick brown fox jumps over the lazy dog. ";
+      break;
+    case kMixed:
+      piece = "Le cœur déçu mais l'âme plutôt naïve, Louÿs rêva. ";
+      break;
+    case kCjk:
+      piece = "敏捷的棕色狐狸跳过了懒狗。速い茶色の狐。";
+      break;
+  }
+  std::string out;
+  out.reserve(size + piece.size());
+  while (out.size() < size) {
+    out.append(piece.data(), piece.size());
+  }
+  return out;
+}
+
+// Moves 'offset' forward by up to 'num_code_points' characters of 'str' with
+// ICU code point iteration, and returns the new offset.
+int32_t IcuForwardN(absl::string_view str, int32_t offset,
+                    int64_t num_code_points) {
+  const int32_t str_length = static_cast<int32_t>(str.size());
+  for (int64_t i = 0; i < num_code_points && offset < str_length; ++i) {
+    UChar32 character;
+    U8_NEXT(str.data(), offset, str_length, character);
+    ZETASQL_CHECK_GE(character, 0);
+  }
+  return offset;
+}
+
+// Same as above, moving backward.
+int32_t IcuBackN(absl::string_view str, int32_t offset,
+                 int64_t num_code_points) {
+  for (int64_t i = 0; i < num_code_points && offset > 0; ++i) {
+    UChar32 character;
+    U8_PREV(str.data(), 0, offset, character);
+    ZETASQL_CHECK_GE(character, 0);
+  }
+  return offset;
+}
+
+void SetCorpusLabel(benchmark::State& state) {
+  switch (static_cast<Corpus>(state.range(0))) {
+    case kAscii:
+      state.SetLabel("ascii");
+      break;
+    case kMixed:
+      state.SetLabel("mixed");
+      break;
+    case kCjk:
+      state.SetLabel("cjk");
+      break;
+  }
+}
+
+void ApplyCorpora(benchmark::internal::Benchmark* b) {
+  for (int corpus : {kAscii, kMixed, kCjk}) {
+    for (int64_t size : {16, 1024, 64 * 1024}) {
+      b->Args({corpus, size});
+    }
+  }
+}
+
+void BM_LengthUtf8(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1));
+  absl::Status error;
+  for (auto _ : state) {
+    int64_t length;
+    ZETASQL_CHECK(LengthUtf8(str, &length, &error));
+    benchmark::DoNotOptimize(length);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_LengthUtf8)->Apply(ApplyCorpora);
+
+void BM_LengthUtf8_IcuBaseline(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1));
+  for (auto _ : state) {
+    int64_t length = 0;
+    int32_t offset = 0;
+    const int32_t str_length = static_cast<int32_t>(str.size());
+    while (offset < str_length) {
+      UChar32 character;
+      U8_NEXT(str.data(), offset, str_length, character);
+      ZETASQL_CHECK_GE(character, 0);
+      ++length;
+    }
+    benchmark::DoNotOptimize(length);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_LengthUtf8_IcuBaseline)->Apply(ApplyCorpora);
+
+void BM_UpperUtf8(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1));
+  absl::Status error;
+  std::string out;
+  for (auto _ : state) {
+    ZETASQL_CHECK(UpperUtf8(str, &out, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_UpperUtf8)->Apply(ApplyCorpora);
+
+void BM_UpperUtf8_IcuBaseline(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1));
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    icu::ErrorCode status;
+    icu::StringByteSink<std::string> icu_out(&out);
+    icu::CaseMap::utf8ToUpper("" /* root locale */, 0 /* default options */,
+                              str, icu_out, nullptr /* edits - unused */,
+                              status);
+    ZETASQL_CHECK(status.isSuccess());
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_UpperUtf8_IcuBaseline)->Apply(ApplyCorpora);
+
+void BM_LowerUtf8(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1));
+  absl::Status error;
+  std::string out;
+  for (auto _ : state) {
+    ZETASQL_CHECK(LowerUtf8(str, &out, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_LowerUtf8)->Apply(ApplyCorpora);
+
+void BM_LowerUtf8_IcuBaseline(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1));
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    icu::ErrorCode status;
+    icu::StringByteSink<std::string> icu_out(&out);
+    icu::CaseMap::utf8ToLower("" /* root locale */, 0 /* default options */,
+                              str, icu_out, nullptr /* edits - unused */,
+                              status);
+    ZETASQL_CHECK(status.isSuccess());
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_LowerUtf8_IcuBaseline)->Apply(ApplyCorpora);
+
+void BM_SubstrWithLengthUtf8(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1));
+  // Takes the middle half of the string, measured in bytes as an upper bound
+  // on the number of characters.
+  const int64_t pos = str.size() / 4;
+  const int64_t length = str.size() / 2;
+  absl::Status error;
+  for (auto _ : state) {
+    absl::string_view out;
+    ZETASQL_CHECK(SubstrWithLengthUtf8(str, pos, length, &out, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_SubstrWithLengthUtf8)->Apply(ApplyCorpora);
+
+void BM_SubstrWithLengthUtf8_IcuBaseline(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1));
+  const int64_t pos = str.size() / 4;
+  const int64_t length = str.size() / 2;
+  for (auto _ : state) {
+    const int32_t start_offset = IcuForwardN(str, 0, pos - 1);
+    const int32_t end_offset = IcuForwardN(str, start_offset, length);
+    absl::string_view out =
+        absl::string_view(str).substr(start_offset, end_offset - start_offset);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_SubstrWithLengthUtf8_IcuBaseline)->Apply(ApplyCorpora);
+
+void BM_SubstrWithNegativePosUtf8(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1));
+  const int64_t pos = -static_cast<int64_t>(str.size() / 2);
+  absl::Status error;
+  for (auto _ : state) {
+    absl::string_view out;
+    ZETASQL_CHECK(SubstrWithLengthUtf8(str, pos, /*length=*/8, &out, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_SubstrWithNegativePosUtf8)->Apply(ApplyCorpora);
+
+void BM_SubstrWithNegativePosUtf8_IcuBaseline(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1));
+  const int64_t pos = -static_cast<int64_t>(str.size() / 2);
+  const int64_t length = 8;
+  for (auto _ : state) {
+    // Walks back over the characters after the substring, then over the
+    // substring, and forward again if the start of the string came first.
+    int32_t end_offset = IcuBackN(str, str.size(), -(pos + length));
+    int32_t start_offset = end_offset;
+    int64_t remaining = length;
+    for (; remaining > 0 && start_offset > 0; --remaining) {
+      start_offset = IcuBackN(str, start_offset, 1);
+    }
+    end_offset = IcuForwardN(str, end_offset, remaining);
+    absl::string_view out =
+        absl::string_view(str).substr(start_offset, end_offset - start_offset);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_SubstrWithNegativePosUtf8_IcuBaseline)->Apply(ApplyCorpora);
+
+void BM_StrPosOccurrenceUtf8(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1)) + "\x01";
+  absl::Status error;
+  for (auto _ : state) {
+    int64_t out;
+    ZETASQL_CHECK(StrPosOccurrenceUtf8(str, "\x01", /*pos=*/1, /*occurrence=*/1,
+                               &out, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_StrPosOccurrenceUtf8)->Apply(ApplyCorpora);
+
+void BM_StrPosOccurrenceUtf8_IcuBaseline(benchmark::State& state) {
+  const std::string str =
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1)) + "\x01";
+  for (auto _ : state) {
+    // Finds the match, then counts the characters before it.
+    const int32_t match_offset = static_cast<int32_t>(str.find("\x01"));
+    int64_t out = 1;
+    for (int32_t offset = 0; offset < match_offset; ++out) {
+      offset = IcuForwardN(str, offset, 1);
+    }
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * str.size());
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_StrPosOccurrenceUtf8_IcuBaseline)->Apply(ApplyCorpora);
+
+void BM_TrimUtf8(benchmark::State& state) {
+  const std::string padding(64, ' ');
+  const std::string str =
+      padding +
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1)) +
+      padding;
+  Utf8Trimmer trimmer;
+  absl::Status error;
+  ZETASQL_CHECK(trimmer.Initialize(" \t", &error));
+  for (auto _ : state) {
+    absl::string_view out;
+    ZETASQL_CHECK(trimmer.Trim(str, &out, &error));
+    benchmark::DoNotOptimize(out);
+  }
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_TrimUtf8)->Apply(ApplyCorpora);
+
+void BM_TrimUtf8_IcuBaseline(benchmark::State& state) {
+  const std::string padding(64, ' ');
+  const std::string str =
+      padding +
+      MakeCorpus(static_cast<Corpus>(state.range(0)), state.range(1)) +
+      padding;
+  icu::UnicodeSet unicode_set;
+  unicode_set.add(' ');
+  unicode_set.add('\t');
+  unicode_set.freeze();
+  for (auto _ : state) {
+    const int32_t start = unicode_set.spanUTF8(
+        str.data(), static_cast<int32_t>(str.size()), USET_SPAN_CONTAINED);
+    const int32_t end = unicode_set.spanBackUTF8(
+        str.data() + start, static_cast<int32_t>(str.size()) - start,
+        USET_SPAN_CONTAINED);
+    absl::string_view out = absl::string_view(str).substr(start, end);
+    benchmark::DoNotOptimize(out);
+  }
+  SetCorpusLabel(state);
+}
+BENCHMARK(BM_TrimUtf8_IcuBaseline)->Apply(ApplyCorpora);
+
+}  // namespace
+}  // namespace functions
+}  // namespace zetasql
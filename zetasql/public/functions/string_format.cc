@@ -35,6 +35,7 @@
 #include "absl/strings/cord.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
@@ -271,38 +272,47 @@ absl::Status StringFormatEvaluator::Format(absl::Span<const Value> values,
     }
   }
 
-  absl::Cord out;
-  absl::Status status = FormatString(raw_parts_, format_parts_, &out, is_null);
+  // Most patterns produce outputs of similar length on every row, so reserving
+  // the length of the previous output avoids regrowing the string while the
+  // parts are appended.
+  output->reserve(output_size_hint_);
+  absl::Status status =
+      FormatString(raw_parts_, format_parts_, output, is_null);
   status_ = absl::OkStatus();
   if (status.ok() && !(*is_null)) {
-    *output = std::string(out);
+    output_size_hint_ = output->size();
+  } else {
+    output->clear();
   }
   return status;
 }
 
 absl::Status StringFormatEvaluator::FormatString(
     const std::vector<absl::string_view>& raw_parts,
-    const std::vector<FormatPart>& format_parts, absl::Cord* out,
+    const std::vector<FormatPart>& format_parts, std::string* out,
     bool* set_null) {
   ZETASQL_DCHECK_OK(status_);
   ZETASQL_DCHECK_GE(raw_parts.size(), format_parts.size());
+  const int64_t max_output_width =
+      absl::GetFlag(FLAGS_zetasql_format_max_output_width);
   for (int i = 0; i < format_parts.size(); ++i) {
-    if (out->size() > absl::GetFlag(FLAGS_zetasql_format_max_output_width)) {
+    if (out->size() > max_output_width) {
       status_.Update(zetasql_base::OutOfRangeErrorBuilder()
                      << "Output string too long while evaluating FORMAT; limit "
-                     << absl::GetFlag(FLAGS_zetasql_format_max_output_width));
+                     << max_output_width);
       return status_;
     }
-    out->Append(raw_parts[i]);
+    absl::StrAppend(out, raw_parts[i]);
     const FormatPart& part = format_parts[i];
     if (part.argument_index < 0) {
-      out->Append("%");
+      out->push_back('%');
       continue;
     }
 
     size_t num_args = 0;
     bool is_null = false;
-    std::vector<absl::FormatArg> args(3, absl::FormatArg(""));
+    absl::FormatArg args[3] = {absl::FormatArg(""), absl::FormatArg(""),
+                               absl::FormatArg("")};
 
     if (part.width_index != -1) {
       is_null = is_null || !part.set_width(this, part, &args[num_args++]);
@@ -321,8 +331,9 @@ absl::Status StringFormatEvaluator::FormatString(
       *set_null = true;
       return absl::OkStatus();
     }
-    if (!absl::FormatUntyped(
-            out, absl::UntypedFormatSpec(part.util_format_pattern), args)) {
+    if (!absl::FormatUntyped(out,
+                             absl::UntypedFormatSpec(part.util_format_pattern),
+                             absl::MakeConstSpan(args))) {
       status_.Update(zetasql_base::InternalErrorBuilder()
                      << "Failure in absl::StrFormat.");
       return status_;
@@ -330,12 +341,12 @@ absl::Status StringFormatEvaluator::FormatString(
   }
   if (raw_parts.size() > format_parts.size()) {
     ZETASQL_DCHECK_EQ(raw_parts.size(), format_parts.size() + 1);
-    out->Append(raw_parts.back());
+    absl::StrAppend(out, raw_parts.back());
   }
-  if (out->size() > absl::GetFlag(FLAGS_zetasql_format_max_output_width)) {
+  if (out->size() > max_output_width) {
     status_.Update(zetasql_base::OutOfRangeErrorBuilder()
                    << "Output string too long while evaluating FORMAT; limit "
-                   << absl::GetFlag(FLAGS_zetasql_format_max_output_width));
+                   << max_output_width);
   }
   *set_null = false;
   return status_;
@@ -1652,17 +1663,13 @@ AbslFormatConvert(const FormatGsqlNumeric<NumericType, GROUPING>& value,
 
 }  // namespace string_format_internal
 
-absl::Status StringFormatUtf8(absl::string_view format_string,
-                              absl::Span<const Value> values,
-                              ProductMode product_mode, std::string* output,
-                              bool* is_null) {
+absl::StatusOr<std::unique_ptr<CompiledStringFormat>>
+CompiledStringFormat::Create(absl::string_view format_string,
+                             std::vector<const Type*> types,
+                             ProductMode product_mode) {
   bool maybe_need_proto_factory = false;
-  std::vector<const Type*> types;
-  for (const Value& value : values) {
-    types.push_back(value.type());
-    const Type* t = value.type()->IsArray()
-                        ? value.type()->AsArray()->element_type()
-                        : value.type();
+  for (const Type* type : types) {
+    const Type* t = type->IsArray() ? type->AsArray()->element_type() : type;
 
     if (t->IsProto() || t->IsStruct()) {
       // A struct may contain a proto (transitively). It's probably cheaper
@@ -1672,15 +1679,32 @@ absl::Status StringFormatUtf8(absl::string_view format_string,
     }
   }
 
-  std::unique_ptr<google::protobuf::DynamicMessageFactory> factory;
+  // Private constructor, so absl::make_unique is not available.
+  std::unique_ptr<CompiledStringFormat> compiled(
+      new CompiledStringFormat(product_mode));
   if (maybe_need_proto_factory) {
-    factory = absl::make_unique<google::protobuf::DynamicMessageFactory>();
+    compiled->factory_ = absl::make_unique<google::protobuf::DynamicMessageFactory>();
   }
-  string_format_internal::StringFormatEvaluator evaluator(product_mode);
-  ZETASQL_RETURN_IF_ERROR(evaluator.SetTypes(std::move(types), factory.get()));
-  ZETASQL_RETURN_IF_ERROR(evaluator.SetPattern(format_string));
+  ZETASQL_RETURN_IF_ERROR(compiled->evaluator_.SetTypes(std::move(types),
+                                                compiled->factory_.get()));
+  ZETASQL_RETURN_IF_ERROR(compiled->evaluator_.SetPattern(format_string));
+  return compiled;
+}
 
-  return evaluator.Format(std::move(values), output, is_null);
+absl::Status StringFormatUtf8(absl::string_view format_string,
+                              absl::Span<const Value> values,
+                              ProductMode product_mode, std::string* output,
+                              bool* is_null) {
+  std::vector<const Type*> types;
+  types.reserve(values.size());
+  for (const Value& value : values) {
+    types.push_back(value.type());
+  }
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<CompiledStringFormat> compiled,
+      CompiledStringFormat::Create(format_string, std::move(types),
+                                   product_mode));
+  return compiled->Format(values, output, is_null);
 }
 
 absl::Status CheckStringFormatUtf8ArgumentTypes(absl::string_view format_string,
@@ -30,6 +30,7 @@
 #include "zetasql/public/value.h"
 #include <cstdint>
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
@@ -186,6 +187,10 @@ class StringFormatEvaluator {
   FormatGsqlNumeric<NumericValue, false> fmt_numeric_;
   FormatGsqlNumeric<BigNumericValue, false> fmt_bignumeric_;
 
+  // The length of the last successfully formatted output, reserved up front
+  // for the next one.
+  size_t output_size_hint_ = 0;
+
   // Status of function execution. It's initialized as absl::OkStatus() in
   // OnExecutionBegin. It's used for setting the error_reporter status.
   absl::Status status_;
@@ -196,7 +201,7 @@ class StringFormatEvaluator {
   // Bulk of the work.
   absl::Status FormatString(const std::vector<absl::string_view>& raw_parts,
                             const std::vector<FormatPart>& format_parts,
-                            absl::Cord* out, bool* set_null);
+                            std::string* out, bool* set_null);
 
   absl::Status TypeError(int64_t index, absl::string_view expected,
                          const Type* actual) const;
@@ -325,6 +330,36 @@ absl::Status CheckStringFormatUtf8ArgumentTypes(absl::string_view format_string,
                                                 std::vector<const Type*> types,
                                                 ProductMode product_mode);
 
+// A FORMAT pattern that is parsed and type checked once for a fixed list of
+// argument types, for formatting many rows with the same format string. Each
+// call to Format() only converts and appends the values. Not thread-safe.
+class CompiledStringFormat {
+ public:
+  // Returns an error if `format_string` is invalid or does not match `types`,
+  // with the same status StringFormatUtf8 would return.
+  static absl::StatusOr<std::unique_ptr<CompiledStringFormat>> Create(
+      absl::string_view format_string, std::vector<const Type*> types,
+      ProductMode product_mode);
+
+  CompiledStringFormat(const CompiledStringFormat&) = delete;
+  CompiledStringFormat& operator=(const CompiledStringFormat&) = delete;
+
+  // Same as StringFormatUtf8 with the format string passed to Create. The
+  // types of `values` must match the types passed to Create.
+  absl::Status Format(absl::Span<const Value> values, std::string* output,
+                      bool* is_null) {
+    return evaluator_.Format(values, output, is_null);
+  }
+
+ private:
+  explicit CompiledStringFormat(ProductMode product_mode)
+      : evaluator_(product_mode) {}
+
+  // Needed only when a type contains protos. Must outlive evaluator_.
+  std::unique_ptr<google::protobuf::DynamicMessageFactory> factory_;
+  string_format_internal::StringFormatEvaluator evaluator_;
+};
+
 }  // namespace functions
 }  // namespace zetasql
 
@@ -18,6 +18,8 @@
 
 #include <limits>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "zetasql/base/logging.h"
 #include "zetasql/base/testing/status_matchers.h"
@@ -163,5 +165,53 @@ TEST(StringFormatTest, TestBadJsonValue) {
   TestBadValue("%P", bad_json);
 }
 
+TEST(StringFormatTest, CompiledStringFormatMatchesStringFormatUtf8) {
+  const std::string pattern = "%s has %'d items at %.2f each (%t)%%";
+  const std::vector<const Type*> types = {
+      types::StringType(), types::Int64Type(), types::DoubleType(),
+      types::Int64ArrayType()};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<CompiledStringFormat> compiled,
+      CompiledStringFormat::Create(pattern, types,
+                                   ProductMode::PRODUCT_INTERNAL));
+
+  const std::vector<std::vector<Value>> rows = {
+      {Value::String("a much longer name than the others"), Value::Int64(1),
+       Value::Double(0.5), values::Int64Array({})},
+      {Value::String("b"), Value::Int64(1234567), Value::Double(-2),
+       values::Int64Array({1})},
+      {Value::String("c"), Value::NullInt64(), Value::Double(3),
+       Value::Null(types::Int64ArrayType())},
+      {Value::String(""), Value::Int64(-5), Value::Double(1e10),
+       values::Array(types::Int64ArrayType(), {Value::NullInt64()})},
+  };
+  std::string output = "leftover";
+  for (const std::vector<Value>& row : rows) {
+    std::string expected;
+    bool expected_is_null;
+    ZETASQL_ASSERT_OK(StringFormatUtf8(pattern, row, ProductMode::PRODUCT_INTERNAL,
+                               &expected, &expected_is_null));
+    bool is_null;
+    ZETASQL_ASSERT_OK(compiled->Format(row, &output, &is_null));
+    EXPECT_EQ(is_null, expected_is_null);
+    EXPECT_EQ(output, expected);
+  }
+
+  // Errors in the pattern are reported by Create, as by StringFormatUtf8.
+  EXPECT_THAT(CompiledStringFormat::Create("%d", {types::StringType()},
+                                           ProductMode::PRODUCT_INTERNAL),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  // Errors in the values are reported per row, without affecting later rows.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(compiled, CompiledStringFormat::Create(
+                                     "%t", {types::StringType()},
+                                     ProductMode::PRODUCT_INTERNAL));
+  bool is_null;
+  EXPECT_THAT(compiled->Format({Value::String("abc\xc1")}, &output, &is_null),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(output, testing::IsEmpty());
+  ZETASQL_ASSERT_OK(compiled->Format({Value::String("abc")}, &output, &is_null));
+  EXPECT_EQ(output, "abc");
+}
+
 }  // namespace functions
 }  // namespace zetasql
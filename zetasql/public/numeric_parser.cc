@@ -16,6 +16,7 @@
 
 #include "zetasql/public/numeric_parser.h"
 
+#include <array>
 #include <cstdint>
 
 #include "zetasql/common/multiprecision_int.h"
@@ -185,19 +186,61 @@ bool ParseNumber(absl::string_view int_part, absl::string_view fract_part,
   return true;
 }
 
+// Fast path of ParseNumber for inputs without exponent, with at most 19
+// integer digits and at most <scale> fractional digits, such as "1234.56",
+// which is the common form of numbers in CSV and JSON data. Such inputs need no
+// rounding, and both parts are parsed into native integers. Returns false if
+// the input is not of this form or is invalid; the caller then falls back to
+// the general path, which produces the error if any.
+template <uint32_t scale, int n>
+bool ParsePlainDecimal(absl::string_view int_part, absl::string_view fract_part,
+                       FixedUint<64, n>* output) {
+  static_assert(scale <= 38, "10^scale must fit in 128 bits");
+  RETURN_FALSE_IF(int_part.size() > 19 || fract_part.size() > scale ||
+                  (int_part.empty() && fract_part.empty()));
+  uint64_t int_value;
+  unsigned __int128 fract_value;
+  RETURN_FALSE_IF(!multiprecision_int_impl::ParseFromBase10UnsignedString(
+                      int_part, &int_value) ||
+                  !multiprecision_int_impl::ParseFromBase10UnsignedString(
+                      fract_part, &fract_value));
+  static constexpr std::array<unsigned __int128, 39> kPowersOf10 =
+      PowersAsc<unsigned __int128, 1, 10, 39>();
+  if constexpr (scale < 20) {
+    *output = FixedUint<64, n>(int_value);
+    RETURN_FALSE_IF(
+        output->MultiplyOverflow(static_cast<uint64_t>(kPowersOf10[scale])));
+  } else {
+    *output = FixedUint<64, n>(ExtendAndMultiply(
+        FixedUint<64, 1>(int_value), FixedUint<64, 2>(kPowersOf10[scale])));
+  }
+  RETURN_FALSE_IF(output->AddOverflow(FixedUint<64, n>(
+      fract_value * kPowersOf10[scale - fract_part.size()])));
+  return true;
+}
+
 #undef RETURN_FALSE_IF
 
 template <uint32_t word_count, uint32_t scale, bool strict_parsing>
 absl::Status ParseNumber(absl::string_view str,
                          FixedPointRepresentation<word_count>& parsed) {
   ENotationParts parts;
-  int64_t exp;
-  if (ABSL_PREDICT_TRUE(SplitENotationParts(str, &parts)) &&
-      ABSL_PREDICT_TRUE(ParseExponent(parts.exp_part, scale, &exp)) &&
-      ABSL_PREDICT_TRUE(ParseNumber(parts.int_part, parts.fract_part, exp,
-                                    strict_parsing, &parsed.output))) {
-    parsed.is_negative = parts.negative;
-    return absl::OkStatus();
+  if (ABSL_PREDICT_TRUE(SplitENotationParts(str, &parts))) {
+    if constexpr (scale <= 38) {
+      if (parts.exp_part.empty() &&
+          ParsePlainDecimal<scale>(parts.int_part, parts.fract_part,
+                                   &parsed.output)) {
+        parsed.is_negative = parts.negative;
+        return absl::OkStatus();
+      }
+    }
+    int64_t exp;
+    if (ABSL_PREDICT_TRUE(ParseExponent(parts.exp_part, scale, &exp)) &&
+        ABSL_PREDICT_TRUE(ParseNumber(parts.int_part, parts.fract_part, exp,
+                                      strict_parsing, &parsed.output))) {
+      parsed.is_negative = parts.negative;
+      return absl::OkStatus();
+    }
   }
   return ::zetasql_base::InvalidArgumentErrorBuilder()
          << "Failed to parse " << str << " . word_count: " << word_count
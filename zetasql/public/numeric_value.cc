@@ -38,6 +38,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/types/optional.h"
@@ -878,10 +879,36 @@ size_t NumericValue::HashCode() const {
 }
 
 void NumericValue::AppendToString(std::string* output) const {
-  if (as_packed_int() == 0) {
+  const __int128 packed = as_packed_int();
+  if (packed == 0) {
     output->push_back('0');
     return;
   }
+  const unsigned __int128 abs_packed = int128_abs(packed);
+  if (abs_packed <= std::numeric_limits<uint64_t>::max()) {
+    // Fast path for absolute values below ~1.8e10, which covers most amounts
+    // of money. Both parts are formatted with 64-bit arithmetic, and trailing
+    // zeros are never printed, so no digits need to be moved afterwards.
+    const uint64_t abs_value = static_cast<uint64_t>(abs_packed);
+    if (packed < 0) {
+      output->push_back('-');
+    }
+    absl::StrAppend(output, abs_value / kScalingFactor);
+    uint32_t fract = static_cast<uint32_t>(abs_value % kScalingFactor);
+    if (fract != 0) {
+      int num_digits = kMaxFractionalDigits;
+      for (; fract % 10 == 0; fract /= 10) {
+        --num_digits;
+      }
+      char buffer[kMaxFractionalDigits + 1];
+      buffer[0] = '.';
+      for (int i = num_digits; i > 0; --i, fract /= 10) {
+        buffer[i] = static_cast<char>('0' + fract % 10);
+      }
+      output->append(buffer, num_digits + 1);
+    }
+    return;
+  }
   size_t old_size = output->size();
   FixedInt<64, 2> value(as_packed_int());
   value.AppendToString(output);
@@ -1029,6 +1056,50 @@ absl::StatusOr<NumericValue> NumericValue::Multiply(NumericValue rh) const {
                          << rh.ToString();
 }
 
+absl::Status NumericValue::MultiplyBatch(absl::Span<const NumericValue> values,
+                                         NumericValue multiplier,
+                                         absl::Span<NumericValue> output) {
+  ZETASQL_DCHECK_EQ(values.size(), output.size());
+  const __int128 packed_multiplier = multiplier.as_packed_int();
+  if (packed_multiplier % kScalingFactor == 0) {
+    // Multiplying by an integer needs neither the 256-bit product nor the
+    // rescaling division. The range of NUMERIC is symmetric, so a single
+    // precomputed bound on the absolute value of the operand detects
+    // overflow.
+    const __int128 factor = packed_multiplier / kScalingFactor;
+    const unsigned __int128 abs_factor = int128_abs(factor);
+    const unsigned __int128 max_abs_operand =
+        abs_factor == 0 ? ~static_cast<unsigned __int128>(0)
+                        : static_cast<unsigned __int128>(
+                              MaxValue().as_packed_int()) /
+                              abs_factor;
+    for (size_t i = 0; i < values.size(); ++i) {
+      const __int128 value = values[i].as_packed_int();
+      if (ABSL_PREDICT_FALSE(int128_abs(value) > max_abs_operand)) {
+        return MakeEvalError() << "numeric overflow: " << values[i].ToString()
+                               << " * " << multiplier.ToString();
+      }
+      output[i] = NumericValue(value * factor);
+    }
+    return absl::OkStatus();
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    ZETASQL_ASSIGN_OR_RETURN(output[i], values[i].Multiply(multiplier));
+  }
+  return absl::OkStatus();
+}
+
+void NumericValue::CompareBatch(absl::Span<const NumericValue> values,
+                                NumericValue rh, absl::Span<int> output) {
+  ZETASQL_DCHECK_EQ(values.size(), output.size());
+  const __int128 packed_rh = rh.as_packed_int();
+  for (size_t i = 0; i < values.size(); ++i) {
+    const __int128 value = values[i].as_packed_int();
+    output[i] = static_cast<int>(value > packed_rh) -
+                static_cast<int>(value < packed_rh);
+  }
+}
+
 NumericValue NumericValue::Abs() const {
   // The result is expected to be within the valid range.
   return NumericValue(static_cast<__int128>(int128_abs(as_packed_int())));
@@ -2090,6 +2161,43 @@ absl::StatusOr<BigNumericValue> BigNumericValue::Multiply(
                          << rh.ToString();
 }
 
+absl::Status BigNumericValue::MultiplyBatch(
+    absl::Span<const BigNumericValue> values,
+    const BigNumericValue& multiplier, absl::Span<BigNumericValue> output) {
+  ZETASQL_DCHECK_EQ(values.size(), output.size());
+  if (!multiplier.HasFractionalPart()) {
+    absl::StatusOr<int64_t> factor = multiplier.To<int64_t>();
+    if (factor.ok()) {
+      // Multiplying by a 64-bit integer is a single-word multiplication with
+      // no rescaling.
+      for (size_t i = 0; i < values.size(); ++i) {
+        FixedInt<64, 4> result = values[i].value_;
+        if (ABSL_PREDICT_FALSE(result.MultiplyOverflow(*factor))) {
+          return MakeEvalError()
+                 << "BIGNUMERIC overflow: " << values[i].ToString() << " * "
+                 << multiplier.ToString();
+        }
+        output[i] = BigNumericValue(result);
+      }
+      return absl::OkStatus();
+    }
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    ZETASQL_ASSIGN_OR_RETURN(output[i], values[i].Multiply(multiplier));
+  }
+  return absl::OkStatus();
+}
+
+void BigNumericValue::CompareBatch(absl::Span<const BigNumericValue> values,
+                                   const BigNumericValue& rh,
+                                   absl::Span<int> output) {
+  ZETASQL_DCHECK_EQ(values.size(), output.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    output[i] = static_cast<int>(values[i].value_ > rh.value_) -
+                static_cast<int>(values[i].value_ < rh.value_);
+  }
+}
+
 absl::StatusOr<BigNumericValue> BigNumericValue::Divide(
     const BigNumericValue& rh) const {
   bool lh_negative = value_.is_negative();
@@ -0,0 +1,278 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures the throughput of NUMERIC and BIGNUMERIC sum, multiplication and
+// comparison, both per value and through the batch APIs, against INT64 and
+// DOUBLE baselines over the same batches of kBatchSize values. Also measures
+// parsing and formatting of typical amounts of money and of values with the
+// maximum number of digits.
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/numeric_value.h"
+#include "benchmark/benchmark.h"
+#include "absl/random/random.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+
+namespace zetasql {
+namespace {
+
+constexpr int kBatchSize = 1024;
+
+// Returns kBatchSize amounts in cents, as they appear in financial data.
+std::vector<int64_t> MakeCents() {
+  absl::BitGen random;
+  std::vector<int64_t> cents(kBatchSize);
+  for (int64_t& value : cents) {
+    value = absl::Uniform<int64_t>(random, -10000000, 10000000);
+  }
+  return cents;
+}
+
+// Returns the values of MakeCents() as T.
+template <typename T>
+std::vector<T> MakeValues();
+
+template <>
+std::vector<NumericValue> MakeValues<NumericValue>() {
+  std::vector<NumericValue> values;
+  values.reserve(kBatchSize);
+  for (int64_t cents : MakeCents()) {
+    values.push_back(NumericValue::FromScaledValue(cents * 10000000));
+  }
+  return values;
+}
+
+template <>
+std::vector<BigNumericValue> MakeValues<BigNumericValue>() {
+  std::vector<BigNumericValue> values;
+  values.reserve(kBatchSize);
+  for (NumericValue value : MakeValues<NumericValue>()) {
+    values.push_back(BigNumericValue(value));
+  }
+  return values;
+}
+
+template <>
+std::vector<int64_t> MakeValues<int64_t>() {
+  return MakeCents();
+}
+
+template <>
+std::vector<double> MakeValues<double>() {
+  std::vector<double> values;
+  values.reserve(kBatchSize);
+  for (int64_t cents : MakeCents()) {
+    values.push_back(cents / 100.0);
+  }
+  return values;
+}
+
+void SetItemsProcessed(benchmark::State& state) {
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+template <typename T>
+void BM_SumPrimitive(benchmark::State& state) {
+  const std::vector<T> values = MakeValues<T>();
+  for (auto _ : state) {
+    T sum = 0;
+    for (T value : values) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_SumPrimitive, int64_t);
+BENCHMARK_TEMPLATE(BM_SumPrimitive, double);
+
+template <typename T>
+void BM_SumPerValue(benchmark::State& state) {
+  const std::vector<T> values = MakeValues<T>();
+  for (auto _ : state) {
+    typename T::SumAggregator aggregator;
+    for (const T& value : values) {
+      aggregator.Add(value);
+    }
+    benchmark::DoNotOptimize(aggregator.GetSum());
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_SumPerValue, NumericValue);
+BENCHMARK_TEMPLATE(BM_SumPerValue, BigNumericValue);
+
+template <typename T>
+void BM_SumBatch(benchmark::State& state) {
+  const std::vector<T> values = MakeValues<T>();
+  for (auto _ : state) {
+    typename T::SumAggregator aggregator;
+    aggregator.AddBatch(values);
+    benchmark::DoNotOptimize(aggregator.GetSum());
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_SumBatch, NumericValue);
+BENCHMARK_TEMPLATE(BM_SumBatch, BigNumericValue);
+
+template <typename T>
+void BM_MultiplyPrimitive(benchmark::State& state) {
+  const std::vector<T> values = MakeValues<T>();
+  std::vector<T> products(kBatchSize);
+  for (auto _ : state) {
+    for (int i = 0; i < kBatchSize; ++i) {
+      products[i] = values[i] * 3;
+    }
+    benchmark::DoNotOptimize(products.data());
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_MultiplyPrimitive, int64_t);
+BENCHMARK_TEMPLATE(BM_MultiplyPrimitive, double);
+
+// Argument 0 multiplies by an integer, argument 1 by a fraction.
+template <typename T>
+T Multiplier(int64_t kind) {
+  return kind == 0 ? T(3) : T::FromString("1.075").value();
+}
+
+template <typename T>
+void BM_MultiplyPerValue(benchmark::State& state) {
+  const std::vector<T> values = MakeValues<T>();
+  const T multiplier = Multiplier<T>(state.range(0));
+  std::vector<T> products(kBatchSize);
+  for (auto _ : state) {
+    for (int i = 0; i < kBatchSize; ++i) {
+      products[i] = values[i].Multiply(multiplier).value();
+    }
+    benchmark::DoNotOptimize(products.data());
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_MultiplyPerValue, NumericValue)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_MultiplyPerValue, BigNumericValue)->Arg(0)->Arg(1);
+
+template <typename T>
+void BM_MultiplyBatch(benchmark::State& state) {
+  const std::vector<T> values = MakeValues<T>();
+  const T multiplier = Multiplier<T>(state.range(0));
+  std::vector<T> products(kBatchSize);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        T::MultiplyBatch(values, multiplier, absl::MakeSpan(products)));
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_MultiplyBatch, NumericValue)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_MultiplyBatch, BigNumericValue)->Arg(0)->Arg(1);
+
+template <typename T>
+void BM_ComparePerValue(benchmark::State& state) {
+  const std::vector<T> values = MakeValues<T>();
+  const T rh = values[kBatchSize / 2];
+  std::vector<int> results(kBatchSize);
+  for (auto _ : state) {
+    for (int i = 0; i < kBatchSize; ++i) {
+      results[i] = values[i] < rh ? -1 : (values[i] == rh ? 0 : 1);
+    }
+    benchmark::DoNotOptimize(results.data());
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_ComparePerValue, int64_t);
+BENCHMARK_TEMPLATE(BM_ComparePerValue, double);
+BENCHMARK_TEMPLATE(BM_ComparePerValue, NumericValue);
+BENCHMARK_TEMPLATE(BM_ComparePerValue, BigNumericValue);
+
+template <typename T>
+void BM_CompareBatch(benchmark::State& state) {
+  const std::vector<T> values = MakeValues<T>();
+  const T rh = values[kBatchSize / 2];
+  std::vector<int> results(kBatchSize);
+  for (auto _ : state) {
+    T::CompareBatch(values, rh, absl::MakeSpan(results));
+    benchmark::DoNotOptimize(results.data());
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_CompareBatch, NumericValue);
+BENCHMARK_TEMPLATE(BM_CompareBatch, BigNumericValue);
+
+// Argument 0 selects amounts of money such as "-1234.56", argument 1 values
+// with all the integer and fractional digits of T.
+template <typename T>
+std::vector<std::string> MakeStrings(int64_t kind) {
+  std::vector<std::string> strings;
+  strings.reserve(kBatchSize);
+  if (kind == 0) {
+    for (const T& value : MakeValues<T>()) {
+      strings.push_back(value.ToString());
+    }
+    return strings;
+  }
+  absl::BitGen random;
+  for (int i = 0; i < kBatchSize; ++i) {
+    std::string str = absl::Uniform<int>(random, 0, 2) == 0 ? "-" : "";
+    for (int digit = 0; digit < T::kMaxIntegerDigits - 1; ++digit) {
+      absl::StrAppend(&str, absl::Uniform<int>(random, digit == 0, 10));
+    }
+    str.push_back('.');
+    for (int digit = 0; digit < T::kMaxFractionalDigits; ++digit) {
+      absl::StrAppend(&str, absl::Uniform<int>(random, 1, 10));
+    }
+    strings.push_back(std::move(str));
+  }
+  return strings;
+}
+
+template <typename T>
+void BM_FromString(benchmark::State& state) {
+  const std::vector<std::string> strings = MakeStrings<T>(state.range(0));
+  for (auto _ : state) {
+    for (const std::string& str : strings) {
+      benchmark::DoNotOptimize(T::FromString(str));
+    }
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_FromString, NumericValue)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_FromString, BigNumericValue)->Arg(0)->Arg(1);
+
+template <typename T>
+void BM_ToString(benchmark::State& state) {
+  std::vector<T> values;
+  for (const std::string& str : MakeStrings<T>(state.range(0))) {
+    values.push_back(T::FromString(str).value());
+  }
+  std::string output;
+  for (auto _ : state) {
+    for (const T& value : values) {
+      output.clear();
+      value.AppendToString(&output);
+      benchmark::DoNotOptimize(output);
+    }
+  }
+  SetItemsProcessed(state);
+}
+BENCHMARK_TEMPLATE(BM_ToString, NumericValue)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ToString, BigNumericValue)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace zetasql
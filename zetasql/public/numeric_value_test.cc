@@ -39,6 +39,7 @@
 #include "absl/hash/hash_testing.h"
 #include "absl/numeric/int128.h"
 #include "absl/random/random.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/match.h"
@@ -48,6 +49,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "zetasql/base/bits.h"
 #include "zetasql/base/endian.h"
@@ -486,6 +488,35 @@ TEST_F(NumericValueTest, FromString) {
   }
 }
 
+// Verifies that the fast path for plain decimals such as "1234.5" produces
+// the same results as the general path, which is forced by an exponent, and
+// that ToString() round trips.
+template <typename T>
+void VerifyPlainDecimalParsing(const T& value) {
+  const std::string str = value.ToString();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(T parsed, T::FromStringStrict(str));
+  EXPECT_EQ(value, parsed) << str;
+  EXPECT_THAT(T::FromStringStrict(absl::StrCat(str, "e0")),
+              IsOkAndHolds(value))
+      << str;
+  // Also exercise inputs with trailing fractional zeros and surrounding
+  // whitespace.
+  const std::string padded = absl::StrCat(
+      " ", str, absl::StrContains(str, '.') ? "00 " : ".00 ");
+  EXPECT_THAT(T::FromString(padded), IsOkAndHolds(value)) << padded;
+}
+
+TEST_F(NumericValueTest, FromStringPlainDecimal) {
+  for (__int128 packed : kNumericValidPackedValues) {
+    VerifyPlainDecimalParsing(NumericValue::FromPackedInt(packed).value());
+  }
+  for (int i = 0; i < 10000; ++i) {
+    VerifyPlainDecimalParsing(MakeRandomNumeric());
+    VerifyPlainDecimalParsing(NumericValue::FromScaledValue(
+        absl::Uniform<int64_t>(random_, kint64min, kint64max)));
+  }
+}
+
 // A lite version of Status that allows instantiation with constexpr.
 struct Error : absl::string_view {
   constexpr explicit Error(absl::string_view message_prefix)
@@ -3296,6 +3327,87 @@ TEST(NumericSumAggregatorTest, Avg) {
   }
 }
 
+// Verifies that the batch operations produce the same results as applying
+// the scalar operations element by element.
+template <typename T>
+void VerifyBatchOpsMatchScalarOps(const std::vector<T>& values,
+                                  const std::vector<T>& operands) {
+  typename T::SumAggregator expected_sum;
+  for (const T& value : values) {
+    expected_sum.Add(value);
+  }
+  typename T::SumAggregator batch_sum;
+  const size_t half = values.size() / 2;
+  batch_sum.AddBatch(absl::MakeConstSpan(values).subspan(0, half));
+  batch_sum.AddBatch(absl::MakeConstSpan(values).subspan(half));
+  EXPECT_TRUE(batch_sum == expected_sum);
+  EXPECT_EQ(batch_sum.GetSum().status(), expected_sum.GetSum().status());
+
+  std::vector<int> comparisons(values.size());
+  std::vector<T> products(values.size());
+  for (const T& operand : operands) {
+    T::CompareBatch(values, operand, absl::MakeSpan(comparisons));
+    for (size_t i = 0; i < values.size(); ++i) {
+      EXPECT_EQ(comparisons[i],
+                values[i] < operand ? -1 : (values[i] == operand ? 0 : 1));
+    }
+
+    std::vector<T> expected_products;
+    absl::Status expected_status;
+    for (const T& value : values) {
+      absl::StatusOr<T> product = value.Multiply(operand);
+      if (!product.ok()) {
+        expected_status = product.status();
+        break;
+      }
+      expected_products.push_back(*product);
+    }
+    absl::Status status =
+        T::MultiplyBatch(values, operand, absl::MakeSpan(products));
+    EXPECT_EQ(status, expected_status) << operand;
+    if (status.ok()) {
+      EXPECT_EQ(products, expected_products) << operand;
+    }
+  }
+}
+
+TEST_F(NumericValueTest, BatchOps) {
+  std::vector<NumericValue> values;
+  for (__int128 packed : kNumericValidPackedValues) {
+    values.push_back(NumericValue::FromPackedInt(packed).value());
+  }
+  std::vector<NumericValue> small_values;
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(MakeRandomNumeric());
+    small_values.push_back(NumericValue::FromScaledValue(
+        absl::Uniform<int64_t>(random_, -1000000000000, 1000000000000)));
+  }
+  const std::vector<NumericValue> operands = {
+      NumericValue(0),
+      NumericValue(1),
+      NumericValue(-1),
+      NumericValue(3),
+      NumericValue(-1000),
+      NumericValue(kint64max),
+      NumericValue::FromString("0.5").value(),
+      NumericValue::FromString("-2.000000001").value(),
+      NumericValue::MaxValue(),
+      NumericValue::MinValue(),
+      MakeRandomNumeric()};
+  VerifyBatchOpsMatchScalarOps(values, operands);
+  VerifyBatchOpsMatchScalarOps(small_values, operands);
+  VerifyBatchOpsMatchScalarOps(std::vector<NumericValue>(), operands);
+
+  // The high word of the batch sum must absorb many carries.
+  std::vector<NumericValue> max_values(1000, NumericValue::MaxValue());
+  NumericValue::SumAggregator sum;
+  sum.AddBatch(max_values);
+  for (int i = 0; i < 1000; ++i) {
+    sum.Add(NumericValue::MinValue());
+  }
+  EXPECT_THAT(sum.GetSum(), IsOkAndHolds(NumericValue(0)));
+}
+
 static constexpr NumericValueWrapper kNumericUnaryAggregatorTestInputs[] = {
     1,
     0,
@@ -5452,6 +5564,16 @@ TEST_F(BigNumericValueTest, FromString) {
   }
 }
 
+TEST_F(BigNumericValueTest, FromStringPlainDecimal) {
+  VerifyPlainDecimalParsing(BigNumericValue::MaxValue());
+  VerifyPlainDecimalParsing(BigNumericValue::MinValue());
+  for (int i = 0; i < 10000; ++i) {
+    VerifyPlainDecimalParsing(MakeRandomBigNumeric());
+    VerifyPlainDecimalParsing(BigNumericValue::FromScaledValue(
+        absl::Uniform<int64_t>(random_, kint64min, kint64max)));
+  }
+}
+
 TEST_F(BigNumericValueTest, FromStringStrict) {
   for (BigNumericStringTestData data : kSortedBigNumericValueStringPairs) {
     ZETASQL_ASSERT_OK_AND_ASSIGN(BigNumericValue actual,
@@ -6399,6 +6521,30 @@ TEST(BigNumericSumAggregatorTest, Avg) {
   }
 }
 
+TEST_F(BigNumericValueTest, BatchOps) {
+  std::vector<BigNumericValue> values = {BigNumericValue::MaxValue(),
+                                         BigNumericValue::MinValue()};
+  std::vector<BigNumericValue> small_values;
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(MakeRandomBigNumeric());
+    small_values.push_back(BigNumericValue::FromScaledValue(
+        absl::Uniform<int64_t>(random_, kint64min, kint64max)));
+  }
+  const std::vector<BigNumericValue> operands = {
+      BigNumericValue(0),
+      BigNumericValue(1),
+      BigNumericValue(-1),
+      BigNumericValue(7),
+      BigNumericValue(kint64max),
+      BigNumericValue(kint64min),
+      BigNumericValue::FromString("1e30").value(),
+      BigNumericValue::FromString("0.25").value(),
+      BigNumericValue::MaxValue(),
+      MakeRandomBigNumeric()};
+  VerifyBatchOpsMatchScalarOps(values, operands);
+  VerifyBatchOpsMatchScalarOps(small_values, operands);
+}
+
 template <int kNumInputs>
 void TestBigNumericSumAggregatorSubtract(
     const BigNumericSumAggregatorTestData (&test_data)[kNumInputs]) {
@@ -33,6 +33,8 @@
 #include "zetasql/public/types/annotation.h"
 #include "zetasql/public/types/type_deserializer.h"
 #include "zetasql/base/case.h"
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
@@ -1329,10 +1331,21 @@ void SimpleTable::SetContents(const std::vector<std::vector<Value>>& rows) {
       columns.push_back(GetColumn(column_idx));
       column_values.push_back(column_major_contents_[column_idx]);
     }
+    // Honor filters on the primary key columns, so that statements that pin
+    // the key (e.g., DELETE ... WHERE key = @key) only get the matching rows
+    // back. The iterator still scans every row to apply the filters.
+    absl::flat_hash_set<int> filter_column_idxs;
+    if (primary_key_.has_value()) {
+      for (int i = 0; i < column_idxs.size(); ++i) {
+        if (absl::c_linear_search(*primary_key_, column_idxs[i])) {
+          filter_column_idxs.insert(i);
+        }
+      }
+    }
     std::unique_ptr<EvaluatorTableIterator> iter(
         new SimpleEvaluatorTableIterator(
             columns, column_values, num_rows_,
-            /*end_status=*/absl::OkStatus(), /*filter_column_idxs=*/{},
+            /*end_status=*/absl::OkStatus(), filter_column_idxs,
             /*cancel_cb=*/[]() {},
             /*set_deadline_cb=*/[](absl::Time t) {}, zetasql_base::Clock::RealClock()));
     return iter;
@@ -585,7 +585,9 @@ class SimpleTable : public Table {
   // Convenience method that calls SetEvaluatorTableIteratorFactory to
   // correspond to a list of rows. More specifically, sets the table contents
   // to a copy of 'rows' and sets up a callback to return those values when
-  // CreateEvaluatorTableIterator() is called.
+  // CreateEvaluatorTableIterator() is called. The returned iterators honor
+  // column filters on the primary key columns by not returning rows that fail
+  // them; they still visit every row, since there is no index on the key.
   // CAVEAT: This is not preserved by serialization/deserialization.  It is only
   // relevant to users of the evaluator API defined in public/evaluator.h.
   void SetContents(const std::vector<std::vector<Value>>& rows);
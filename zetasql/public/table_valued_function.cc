@@ -158,6 +158,15 @@ std::string TableValuedFunction::GetTVFSignatureErrorMessage(
   }
 }
 
+absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+TableValuedFunction::CreateEvaluator(
+    std::vector<TvfEvaluatorArg> input_arguments,
+    const std::vector<TVFSchemaColumn>& output_columns,
+    const FunctionSignature* function_call_signature) const {
+  return absl::UnimplementedError(absl::StrCat(
+      "Table-valued function ", FullName(), " does not support evaluation"));
+}
+
 absl::Status TableValuedFunction::Serialize(
     FileDescriptorSetMap* file_descriptor_set_map,
     TableValuedFunctionProto* proto) const {
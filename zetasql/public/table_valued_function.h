@@ -31,6 +31,7 @@
 #include "zetasql/common/errors.h"
 #include "zetasql/public/catalog.h"
 #include "zetasql/public/deprecation_warning.pb.h"
+#include "zetasql/public/evaluator_table_iterator.h"
 #include "zetasql/public/function.pb.h"
 #include "zetasql/public/function_signature.h"
 #include "zetasql/public/input_argument_type.h"
@@ -56,6 +57,7 @@ class TVFInputArgumentType;
 class TVFRelationColumnProto;
 class TVFRelationProto;
 class TVFSignature;
+struct TVFSchemaColumn;
 class TableValuedFunctionProto;
 class TableValuedFunctionOptionsProto;
 
@@ -310,6 +312,42 @@ class TableValuedFunction {
     return tvf_options_;
   }
 
+  // An argument to CreateEvaluator(). Scalar arguments are passed in <value>.
+  // Relation arguments are passed in <relation>, an iterator with one column
+  // per column of the argument's schema in the concrete signature.
+  struct TvfEvaluatorArg {
+    Value value;
+    std::unique_ptr<EvaluatorTableIterator> relation;
+  };
+
+  // Returns an iterator over the output of a call to this TVF with
+  // <input_arguments>, which match the arguments of the call's concrete
+  // TVFSignature 1:1. <function_call_signature> is the signature that matched
+  // the call if the analyzer recorded one (see ResolvedTVFScan), and nullptr
+  // otherwise. This is used only by the Evaluator interface and the reference
+  // implementation (see zetasql/public/evaluator.h).
+  //
+  // <output_columns> are the columns of the call's output schema that the
+  // query reads, and the returned iterator must produce exactly those
+  // columns, in that order. Rows should be produced as the iterator advances
+  // rather than computed up front, and input relations should be read the same
+  // way, so that the TVF streams. As for tables, the engine may pass column
+  // filters to the iterator with SetColumnFilterMap(), keyed by position in
+  // <output_columns>. Honoring them is optional.
+  //
+  // Subclasses that override this must also override HasEvaluator().
+  // Returns UNIMPLEMENTED by default.
+  virtual absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>>
+  CreateEvaluator(std::vector<TvfEvaluatorArg> input_arguments,
+                  const std::vector<TVFSchemaColumn>& output_columns,
+                  const FunctionSignature* function_call_signature) const;
+
+  // Returns true if this TVF implements CreateEvaluator(). The reference
+  // implementation rejects calls to TVFs without an evaluator when the query
+  // is prepared, as it does for scalar and aggregate UDFs without evaluators,
+  // rather than failing when the query runs. Returns false by default.
+  virtual bool HasEvaluator() const { return false; }
+
  protected:
   // Returns user facing text (to be used in error messages) for the
   // specified table function <signature>. For example:
@@ -213,6 +213,11 @@ const std::string& GetBytesValue(const ValueContent& value) {
   return GetStringValue(value);
 }
 
+// Unlike GetStringValue(), does not materialize string slices.
+absl::string_view GetStringView(const ValueContent& value) {
+  return value.GetAs<internal::StringRef*>()->view();
+}
+
 std::string GetJsonString(const ValueContent& value) {
   return value.GetAs<internal::JSONRef*>()->ToString();
 }
@@ -464,7 +469,7 @@ absl::HashState SimpleType::HashValueContent(const ValueContent& value,
     }
     case TYPE_STRING:
     case TYPE_BYTES:
-      return absl::HashState::combine(std::move(state), GetStringValue(value));
+      return absl::HashState::combine(std::move(state), GetStringView(value));
     case TYPE_DATE:
       return absl::HashState::combine(std::move(state), GetDateValue(value));
     case TYPE_TIMESTAMP:
@@ -527,7 +532,7 @@ bool SimpleType::ValueContentEquals(
       return options.float_margin.Equal(x.GetAs<double>(), y.GetAs<double>());
     case TYPE_STRING:
     case TYPE_BYTES:
-      return ReferencedValueEquals<internal::StringRef>(x, y);
+      return GetStringView(x) == GetStringView(y);
     case TYPE_DATE:
       return ContentEquals<DateValueContentType>(x, y);
     case TYPE_TIMESTAMP:
@@ -591,7 +596,7 @@ bool SimpleType::ValueContentLess(const ValueContent& x, const ValueContent& y,
       return ContentLess<double>(x, y);
     case TYPE_STRING:
     case TYPE_BYTES:
-      return ReferencedValueLess<internal::StringRef>(x, y);
+      return GetStringView(x) < GetStringView(y);
     case TYPE_DATE:
       return ContentLess<DateValueContentType>(x, y);
     case TYPE_TIMESTAMP:
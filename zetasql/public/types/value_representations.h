@@ -26,7 +26,9 @@
 #include "zetasql/public/interval_value.h"
 #include "zetasql/public/json_value.h"
 #include "zetasql/public/numeric_value.h"
+#include "absl/base/call_once.h"
 #include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
 #include "zetasql/base/simple_reference_counted.h"
@@ -139,23 +141,91 @@ class IntervalRef : public zetasql_base::SimpleReferenceCounted {
 
 // -------------------------------------------------------
 // StringRef is ref count wrapper around string.
+//
+// A StringRef either owns its string or is a slice of another StringRef (the
+// parent), whose buffer it shares instead of copying. Slices keep a reference
+// on their parent. value() of a slice materializes a copy of the slice the
+// first time it is called, so callers that only need the characters should
+// use view() instead.
 // -------------------------------------------------------
 class StringRef : public zetasql_base::SimpleReferenceCounted {
  public:
-  StringRef() {}
-  explicit StringRef(std::string value) : value_(std::move(value)) {}
+  // Slices shorter than this are copied; a short copy is as cheap as the
+  // slice bookkeeping and does not pin the parent.
+  static constexpr size_t kMinSliceSize = 16;
+  // Slices of parents longer than this are copied if they cover less than
+  // 1/kMaxPinnedRatio of the parent, so that a small slice does not keep a
+  // large buffer alive.
+  static constexpr size_t kMinPinnedParentSize = 1024;
+  static constexpr size_t kMaxPinnedRatio = 8;
+
+  StringRef() : view_(value_) {}
+  explicit StringRef(std::string value)
+      : value_(std::move(value)), view_(value_) {}
 
   StringRef(const StringRef&) = delete;
   StringRef& operator=(const StringRef&) = delete;
 
-  const std::string& value() const { return value_; }
+  // Returns a new StringRef, owned by the caller, holding 'slice', which must
+  // point into parent->view(). Shares the buffer of 'parent' unless the
+  // heuristics above decide that a copy is preferable.
+  static StringRef* MakeSlice(const StringRef* parent,
+                              absl::string_view slice) {
+    ZETASQL_DCHECK(slice.empty() || (slice.data() >= parent->view().data() &&
+                             slice.data() + slice.size() <=
+                                 parent->view().data() + parent->view().size()))
+        << "slice does not point into its parent";
+    // Always reference the string that owns the buffer, so chains of slices
+    // do not pin intermediate StringRefs.
+    const StringRef* root =
+        parent->parent_ != nullptr ? parent->parent_ : parent;
+    const size_t root_size = root->view().size();
+    if (slice.size() < kMinSliceSize ||
+        (root_size > kMinPinnedParentSize &&
+         slice.size() < root_size / kMaxPinnedRatio)) {
+      return new StringRef(std::string(slice));
+    }
+    return new StringRef(root, slice);
+  }
+
+  // Returns the characters of this string without copying them.
+  absl::string_view view() const { return view_; }
+
+  const std::string& value() const {
+    if (parent_ != nullptr) {
+      absl::call_once(materialize_once_,
+                      [this] { value_.assign(view_.data(), view_.size()); });
+    }
+    return value_;
+  }
+
+  bool is_slice() const { return parent_ != nullptr; }
 
+  // A slice reports the whole buffer of its parent, which it keeps alive for
+  // as long as it lives. A buffer shared by several values is counted by each.
   uint64_t physical_byte_size() const {
-    return sizeof(StringRef) + value_.size() * sizeof(char);
+    const size_t buffer_size =
+        parent_ != nullptr ? parent_->view().size() : view_.size();
+    return sizeof(StringRef) + buffer_size * sizeof(char);
+  }
+
+ protected:
+  ~StringRef() override {
+    if (parent_ != nullptr) parent_->Unref();
   }
 
  private:
-  const std::string value_;
+  StringRef(const StringRef* parent, absl::string_view slice)
+      : view_(slice), parent_(parent) {
+    parent_->Ref();
+  }
+
+  // The owned string, or the materialized copy of a slice.
+  mutable std::string value_;
+  absl::string_view view_;
+  // Reffed. Non-null iff this is a slice.
+  const StringRef* parent_ = nullptr;
+  mutable absl::once_flag materialize_once_;
 };
 
 // -------------------------------------------------------
@@ -404,7 +404,7 @@ absl::Cord Value::ToCord() const {
   switch (metadata_.type_kind()) {
     case TYPE_STRING:
     case TYPE_BYTES:
-      return absl::Cord(string_ptr_->value());
+      return absl::Cord(string_ptr_->view());
     case TYPE_PROTO:
       return proto_ptr_->value();
     default:
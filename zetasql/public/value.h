@@ -146,6 +146,10 @@ class Value {
   double double_value() const;         // REQUIRES: double type
   const std::string& string_value() const;  // REQUIRES: string type
   const std::string& bytes_value() const;   // REQUIRES: bytes type
+  // Returns the characters of a string or bytes value. Unlike string_value()
+  // and bytes_value(), this does not copy values created with SliceOf(). The
+  // view is valid for as long as this Value or a copy of it is alive.
+  absl::string_view string_or_bytes_view() const;  // REQUIRES: string or bytes
   int32_t date_value() const;               // REQUIRES: date type
   int32_t enum_value() const;               // REQUIRES: enum type
   const std::string& enum_name() const;  // REQUIRES: enum type
@@ -374,6 +378,13 @@ class Value {
   static Value Bytes(const absl::Cord& v);
   // str may contain '\0' in the middle, without getting truncated.
   template <size_t N> static Value Bytes(const char (&str)[N]);
+  // Creates a value of the same type as 'parent' holding 'slice', which must
+  // point into parent.string_or_bytes_view(). The result shares the buffer of
+  // 'parent' instead of copying it, unless 'slice' is short or only a small
+  // part of a large parent, which it would otherwise keep alive. A shared
+  // slice's physical_byte_size() includes the whole buffer of 'parent'.
+  // REQUIRES: 'parent' is a non-null string or bytes value.
+  static Value SliceOf(const Value& parent, absl::string_view slice);
   // Create a date value. 'v' is the number of days since unix epoch 1970-1-1
   static Value Date(int32_t v);
   // Creates a timestamp value from absl::Time at nanoseconds precision.
@@ -712,6 +723,9 @@ class Value {
   Value(TypeKind type_kind, int64_t value);
   // REQUIRES: type_kind is string or bytes
   Value(TypeKind type_kind, std::string value);
+  // REQUIRES: type_kind is string or bytes. Takes ownership of the reference
+  // on 'string_ref'.
+  Value(TypeKind type_kind, internal::StringRef* string_ref);
 
   // Constructs a timestamp value.
   explicit Value(absl::Time t);
@@ -183,6 +183,12 @@ inline Value::Value(TypeKind type_kind, std::string value)
         type_kind == TYPE_BYTES);
 }
 
+inline Value::Value(TypeKind type_kind, internal::StringRef* string_ref)
+    : metadata_(type_kind), string_ptr_(string_ref) {
+  ZETASQL_CHECK(type_kind == TYPE_STRING ||
+        type_kind == TYPE_BYTES);
+}
+
 inline Value::Value(const NumericValue& numeric)
     : metadata_(TypeKind::TYPE_NUMERIC),
       numeric_ptr_(new internal::NumericRef(numeric)) {}
@@ -290,6 +296,15 @@ inline Value Value::Bytes(const char (&str)[N]) {
   return Value::Bytes(std::string(str, N - 1));
 }
 
+inline Value Value::SliceOf(const Value& parent, absl::string_view slice) {
+  ZETASQL_CHECK(parent.metadata_.type_kind() == TYPE_STRING ||
+        parent.metadata_.type_kind() == TYPE_BYTES)
+      << "Not a string or bytes value";
+  ZETASQL_CHECK(!parent.metadata_.is_null()) << "Null value";
+  return Value(parent.metadata_.type_kind(),
+               internal::StringRef::MakeSlice(parent.string_ptr_, slice));
+}
+
 inline Value Value::Date(int32_t v) { return Value(TYPE_DATE, v); }
 inline Value Value::Timestamp(absl::Time t) { return Value(t); }
 inline Value Value::Time(TimeValue time) {
@@ -445,6 +460,14 @@ inline const std::string& Value::bytes_value() const {
   return string_ptr_->value();
 }
 
+inline absl::string_view Value::string_or_bytes_view() const {
+  ZETASQL_CHECK(metadata_.type_kind() == TYPE_STRING ||
+        metadata_.type_kind() == TYPE_BYTES)
+      << "Not a string or bytes value";
+  ZETASQL_CHECK(!metadata_.is_null()) << "Null value";
+  return string_ptr_->view();
+}
+
 inline int32_t Value::date_value() const {
   ZETASQL_CHECK_EQ(TYPE_DATE, metadata_.type_kind()) << "Not a date value";
   ZETASQL_CHECK(!metadata_.is_null()) << "Null value";
@@ -429,6 +429,64 @@ TEST_F(ValueTest, CopyAssignMove) {
   EXPECT_FALSE(obj.is_valid());
 }
 
+// Returns true if 'inner' points into the characters of 'outer'.
+static bool SharesBuffer(const Value& inner, const Value& outer) {
+  const absl::string_view inner_view = inner.string_or_bytes_view();
+  const absl::string_view outer_view = outer.string_or_bytes_view();
+  return inner_view.data() >= outer_view.data() &&
+         inner_view.data() < outer_view.data() + outer_view.size();
+}
+
+TEST_F(ValueTest, SliceOf) {
+  std::string text;
+  for (int i = 0; i < 10; ++i) absl::StrAppend(&text, "0123456789");
+  Value parent = Value::String(text);
+
+  Value slice =
+      Value::SliceOf(parent, parent.string_or_bytes_view().substr(10, 40));
+  EXPECT_TRUE(SharesBuffer(slice, parent));
+  EXPECT_EQ("STRING", slice.type()->DebugString());
+  EXPECT_EQ(text.substr(10, 40), slice.string_or_bytes_view());
+  EXPECT_EQ(text.substr(10, 40), slice.string_value());
+  EXPECT_EQ(Value::String(text.substr(10, 40)), slice);
+  EXPECT_EQ(Value::String(text.substr(10, 40)).HashCode(), slice.HashCode());
+  EXPECT_TRUE(Value::String(text.substr(10, 39)).LessThan(slice));
+
+  // Slices of slices share the original buffer, which outlives its Value.
+  Value nested =
+      Value::SliceOf(slice, slice.string_or_bytes_view().substr(5, 20));
+  parent = Value();
+  slice = Value();
+  EXPECT_EQ(text.substr(15, 20), nested.string_value());
+  EXPECT_EQ(text.substr(15, 20), nested.string_or_bytes_view());
+
+  // Short slices are copied.
+  Value bytes = Value::Bytes(text);
+  Value short_slice =
+      Value::SliceOf(bytes, bytes.string_or_bytes_view().substr(0, 3));
+  EXPECT_FALSE(SharesBuffer(short_slice, bytes));
+  EXPECT_EQ(Value::Bytes("012"), short_slice);
+  EXPECT_EQ(Value::Bytes(""),
+            Value::SliceOf(bytes, bytes.string_or_bytes_view().substr(0, 0)));
+
+  // Slices that would pin a much larger buffer are copied.
+  Value large = Value::String(std::string(100000, 'x'));
+  Value small_slice =
+      Value::SliceOf(large, large.string_or_bytes_view().substr(10, 100));
+  EXPECT_FALSE(SharesBuffer(small_slice, large));
+  Value large_slice =
+      Value::SliceOf(large, large.string_or_bytes_view().substr(10, 50000));
+  EXPECT_TRUE(SharesBuffer(large_slice, large));
+  // A shared slice accounts for the whole buffer that it keeps alive.
+  EXPECT_GT(large_slice.physical_byte_size(), 100000);
+  EXPECT_LT(small_slice.physical_byte_size(), 1000);
+  EXPECT_EQ(std::string(50000, 'x'), large_slice.string_value());
+
+  EXPECT_DEATH(Value::SliceOf(Value::NullString(), ""), "Null value");
+  EXPECT_DEATH(Value::SliceOf(Value::Int64(1), ""),
+               "Not a string or bytes value");
+}
+
 TEST_F(ValueTest, StringDebugString) {
   // Strings and bytes get escaped as printable zetasql literals.
   EXPECT_EQ("\"abc\"", Value::String("abc").DebugString());
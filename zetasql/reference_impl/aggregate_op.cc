@@ -25,6 +25,7 @@
 
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
+#include "zetasql/reference_impl/collation_key_cache.h"
 #include "zetasql/reference_impl/common.h"
 #include "zetasql/reference_impl/evaluation.h"
 #include "zetasql/reference_impl/function.h"
@@ -450,6 +451,8 @@ class DistinctAccumulator : public IntermediateAggregateAccumulator {
     if (collator_ == nullptr) {
       value_to_insert = value;
     } else {
+      // Not cached: 'distinct_values_' already keeps the key of every
+      // distinct input, and a per-group cache would hold a second copy.
       absl::StatusOr<Value> collated_distinct_key =
           GetValueSortKey(value, *(collator_));
       if (!collated_distinct_key.ok()) {
@@ -780,7 +783,7 @@ class WithGroupRowsAccumulator : public IntermediateAggregateAccumulator {
     // the other hand the same params are passed to all aggregates. Reference:
     // https://github.com/google/zetasql/blob/master/zetasql/reference_impl/aggregate_op.cc?l=1089&rcl=327634640
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> input_iter,
-                     group_rows_subquery_->CreateIterator(
+                     group_rows_subquery_->CreateProfiledIterator(
                          params_, /*num_extra_slots=*/0, context_));
     absl::Status status;
     while (true) {
@@ -1393,7 +1396,7 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
     EvaluationContext* context) const {
   ZETASQL_ASSIGN_OR_RETURN(
       std::unique_ptr<TupleIterator> input_iter,
-      input()->CreateIterator(params, /*num_extra_slots=*/0, context));
+      input()->CreateProfiledIterator(params, /*num_extra_slots=*/0, context));
 
   // The key is owned by the <group_map_keys_memory> defined below.
   absl::flat_hash_map<TupleDataPtr, std::unique_ptr<GroupValue>> group_map;
@@ -1419,9 +1422,28 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
         GetCollatorFromResolvedCollationValue(collation_slot.value()));
     collators.push_back(std::move(collator));
   }
+  // Grouping keys are collated through their sort keys, which are cached so
+  // that repeated values are only passed to ICU once.
+  std::vector<std::unique_ptr<CollationKeyCache>> collation_key_caches;
+  for (const std::unique_ptr<const ZetaSqlCollator>& collator : collators) {
+    if (collator == nullptr) {
+      collation_key_caches.push_back(nullptr);
+    } else {
+      collation_key_caches.push_back(absl::make_unique<CollationKeyCache>(
+          collator.get(), context->memory_accountant()));
+    }
+  }
 
   absl::Status status;
+  // The whole input is consumed before the first row is returned, so check
+  // for cancellation here too.
+  int64_t num_inputs = 0;
   while (true) {
+    if (num_inputs++ %
+            absl::GetFlag(FLAGS_zetasql_call_verify_not_aborted_rows_period) ==
+        0) {
+      ZETASQL_RETURN_IF_ERROR(context->VerifyNotAborted());
+    }
     const TupleData* next_input = input_iter->Next();
     if (next_input == nullptr) {
       ZETASQL_RETURN_IF_ERROR(input_iter->Status());
@@ -1448,11 +1470,12 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
 
       Value* collated_slot_value =
           collated_key_data->mutable_slot(i)->mutable_value();
-      if (collators[i] == nullptr) {
+      if (collation_key_caches[i] == nullptr) {
         *collated_slot_value = slot->value();
       } else {
-        ZETASQL_ASSIGN_OR_RETURN(*collated_slot_value,
-                         GetValueSortKey(slot->value(), *(collators[i])));
+        ZETASQL_ASSIGN_OR_RETURN(
+            *collated_slot_value,
+            collation_key_caches[i]->GetSortKeyValue(slot->value()));
       }
     }
 
@@ -1509,6 +1532,10 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AggregateOp::CreateIterator(
       break;
     }
   }
+  if (OperatorProfiler* profiler = context->operator_profiler();
+      profiler != nullptr) {
+    profiler->RecordCounter(this, "hash_table_keys", group_map.size());
+  }
 
   // Build the tuples that the iterator should return.
   auto tuples = absl::make_unique<TupleDataDeque>(context->memory_accountant());
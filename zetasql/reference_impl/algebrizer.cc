@@ -16,7 +16,10 @@
 
 #include "zetasql/reference_impl/algebrizer.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <stack>
 #include <string>
@@ -319,24 +322,49 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeFunctionCall(
 
   // User-defined functions.
   if (!function_call->function()->IsZetaSQLBuiltin()) {
-    auto callback = function_call->function()->GetFunctionEvaluatorFactory();
+    const Function* function = function_call->function();
+    auto callback = function->GetFunctionEvaluatorFactory();
     if (callback == nullptr) {
       return ::zetasql_base::InvalidArgumentErrorBuilder()
              << "User-defined function " << name << " has no evaluator. "
              << "Use FunctionOptions to supply one.";
     }
-    auto status_or_evaluator = callback(function_call->signature());
-    ZETASQL_RETURN_IF_ERROR(status_or_evaluator.status());
-    auto evaluator = status_or_evaluator.value();
+    ZETASQL_ASSIGN_OR_RETURN(FunctionEvaluator evaluator,
+                     callback(function_call->signature()));
     if (evaluator == nullptr) {
       return ::zetasql_base::InternalErrorBuilder()
              << "NULL evaluator returned for user-defined function " << name;
     }
+    auto udf = absl::make_unique<UserDefinedScalarFunction>(
+        evaluator, function_call->type(), name,
+        function->function_options().propagates_null);
+
+    // A deterministic function of constants that opted in is evaluated once,
+    // here. Errors are left to be raised when the query runs so that SAFE
+    // error mode and the query's own error handling still apply to them.
+    const FunctionOptions& options = function->function_options();
+    if (options.allows_constant_folding &&
+        options.volatility == FunctionEnums::IMMUTABLE &&
+        std::all_of(arguments.begin(), arguments.end(),
+                    [](const std::unique_ptr<ValueExpr>& argument) {
+                      return argument->IsConstant();
+                    })) {
+      std::vector<Value> argument_values;
+      argument_values.reserve(arguments.size());
+      for (const std::unique_ptr<ValueExpr>& argument : arguments) {
+        argument_values.push_back(
+            static_cast<const ConstExpr*>(argument.get())->value());
+      }
+      Value result;
+      absl::Status status;
+      if (udf->Eval(argument_values, /*context=*/nullptr, &result, &status)) {
+        return ConstExpr::Create(result);
+      }
+    }
+
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> function_call,
                      ScalarFunctionCallExpr::Create(
-                         absl::make_unique<UserDefinedScalarFunction>(
-                             evaluator, function_call->type(), name),
-                         std::move(arguments), error_mode));
+                         std::move(udf), std::move(arguments), error_mode));
     return function_call;
   }
 
@@ -747,14 +775,23 @@ Algebrizer::AlgebrizeAggregateFnWithAlgebrizedArguments(
   }
 
   const Type* type = aggregate_function->type();
-  if (!aggregate_function->function()->IsZetaSQLBuiltin()) {
+  const bool is_user_defined =
+      !aggregate_function->function()->IsZetaSQLBuiltin();
+  if (is_user_defined &&
+      aggregate_function->function()->GetAggregateFunctionEvaluatorFactory() ==
+          nullptr) {
     return ::zetasql_base::InvalidArgumentErrorBuilder()
-        << "User-defined aggregate functions are unsupported: " << name;
+           << "User-defined aggregate function " << name
+           << " has no evaluator. Use FunctionOptions to supply one.";
   }
 
   FunctionKind kind;
   int num_input_fields;
-  if (name == "$count_star") {
+  if (is_user_defined) {
+    // User-defined aggregate functions are fed all of their arguments.
+    ZETASQL_RET_CHECK(!anonymization_options.has_value()) << name;
+    num_input_fields = static_cast<int>(arguments.size());
+  } else if (name == "$count_star") {
     kind = FunctionKind::kCount;
     num_input_fields = 0;
   } else {
@@ -833,30 +870,64 @@ Algebrizer::AlgebrizeAggregateFnWithAlgebrizedArguments(
     }
   }
 
-  std::unique_ptr<BuiltinAggregateFunction> function;
-  switch (kind) {
-    case FunctionKind::kCorr:
-    case FunctionKind::kCovarPop:
-    case FunctionKind::kCovarSamp:
-      function = absl::make_unique<BinaryStatFunction>(kind, type, input_type);
-      break;
-    default:
-      ZETASQL_RET_CHECK(aggregate_function->function()->IsZetaSQLBuiltin());
-      function = absl::make_unique<BuiltinAggregateFunction>(
-          kind, type, num_input_fields, input_type,
-          IgnoresNullArguments(aggregate_function));
-      break;
+  std::unique_ptr<AggregateFunctionBody> function;
+  if (is_user_defined) {
+    auto user_defined_function =
+        absl::make_unique<UserDefinedAggregateFunction>(
+            aggregate_function->function()
+                ->GetAggregateFunctionEvaluatorFactory(),
+            aggregate_function->signature(), type, num_input_fields,
+            input_type, IgnoresNullArguments(aggregate_function), name);
+    // Create an evaluator up front so that a failing factory is reported when
+    // the query is prepared rather than when it first runs.
+    ZETASQL_RETURN_IF_ERROR(user_defined_function->CreateEvaluator().status());
+    function = std::move(user_defined_function);
+  } else {
+    switch (kind) {
+      case FunctionKind::kCorr:
+      case FunctionKind::kCovarPop:
+      case FunctionKind::kCovarSamp:
+        function =
+            absl::make_unique<BinaryStatFunction>(kind, type, input_type);
+        break;
+      case FunctionKind::kApproxQuantiles:
+        function = absl::make_unique<ApproxQuantilesFunction>(
+            type, input_type, IgnoresNullArguments(aggregate_function));
+        break;
+      case FunctionKind::kApproxTopCount:
+      case FunctionKind::kApproxTopSum:
+        function = absl::make_unique<ApproxTopFunction>(
+            kind, type, num_input_fields, input_type,
+            IgnoresNullArguments(aggregate_function));
+        break;
+      case FunctionKind::kApproxCountDistinct:
+      case FunctionKind::kHllCountInit:
+      case FunctionKind::kHllCountMerge:
+      case FunctionKind::kHllCountMergePartial:
+        function = absl::make_unique<HllCountFunction>(kind, type, input_type);
+        break;
+      default:
+        ZETASQL_RET_CHECK(aggregate_function->function()->IsZetaSQLBuiltin());
+        function = absl::make_unique<BuiltinAggregateFunction>(
+            kind, type, num_input_fields, input_type,
+            IgnoresNullArguments(aggregate_function));
+        break;
+    }
   }
 
+  // APPROX_COUNT_DISTINCT does not need a DistinctAccumulator; duplicates do
+  // not change the state of the underlying sketch.
   const AggregateArg::Distinctness distinctness =
-      (aggregate_function->distinct() ||
-       (kind == FunctionKind::kApproxCountDistinct))
-          ? AggregateArg::kDistinct
-          : AggregateArg::kAll;
+      aggregate_function->distinct() ? AggregateArg::kDistinct
+                                     : AggregateArg::kAll;
 
+  // Sketch-based functions apply the collation when hashing their input.
   if (!aggregate_function->collation_list().empty() &&
-      distinctness != AggregateArg::kDistinct && kind != FunctionKind::kMin &&
-      kind != FunctionKind::kMax) {
+      distinctness != AggregateArg::kDistinct &&
+      (is_user_defined ||
+       (kind != FunctionKind::kMin && kind != FunctionKind::kMax &&
+        kind != FunctionKind::kApproxCountDistinct &&
+        kind != FunctionKind::kHllCountInit))) {
     return ::zetasql_base::InvalidArgumentErrorBuilder()
            << "Collation is not supported for aggregate function " << name
            << " without DISTINCT";
@@ -1324,13 +1395,17 @@ Algebrizer::AlgebrizeStandaloneExpression(const ResolvedExpr* expr) {
   // subqueries to array expressions.  WITH subqueries cannot be correlated so
   // we can attach them all in one batch at the top of the query, and that will
   // ensure we run each of them exactly once.
-  if (!with_subquery_let_assignments_.empty()) {
-    ZETASQL_ASSIGN_OR_RETURN(value_expr,
-                     LetExpr::Create(std::move(with_subquery_let_assignments_),
-                                     std::move(value_expr)));
+  if (!with_subquery_let_assignments_.empty() ||
+      !with_subquery_cpp_let_assignments_.empty()) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        value_expr,
+        LetExpr::Create(std::move(with_subquery_let_assignments_),
+                        std::move(with_subquery_cpp_let_assignments_),
+                        std::move(value_expr)));
   }
   // Sanity check - WITH map should be cleared as WITH clauses go out of scope.
   ZETASQL_RET_CHECK(with_map_.empty());
+  ZETASQL_RET_CHECK(shared_with_map_.empty());
 
   return WrapWithRootExpr(std::move(value_expr));
 }
@@ -1643,6 +1718,7 @@ Algebrizer::FilterConjunctInfo::Create(const ResolvedExpr* conjunct) {
   const ResolvedFunctionCall* function_call =
       conjunct->GetAs<ResolvedFunctionCall>();
   const Function* function = function_call->function();
+  info->has_collation = !function_call->collation_list().empty();
 
   info->arguments.reserve(function_call->argument_list_size());
   for (int i = 0; i < function_call->argument_list_size(); ++i) {
@@ -1775,10 +1851,101 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeTableScan(
       }
     }
 
-    return EvaluatorTableScanOp::Create(
-        table_scan->table(), table_scan->alias(), column_idx_list, column_names,
-        variables, std::move(and_filters), std::move(system_time_expr));
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<EvaluatorTableScanOp> scan_op,
+        EvaluatorTableScanOp::Create(
+            table_scan->table(), table_scan->alias(), column_idx_list,
+            column_names, variables, std::move(and_filters),
+            std::move(system_time_expr)));
+    if (auto it = row_count_hints_.find(table_scan);
+        it != row_count_hints_.end()) {
+      scan_op->set_row_count_hint(it->second);
+    }
+    return scan_op;
+  }
+}
+
+absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeTvfScan(
+    const ResolvedTVFScan* tvf_scan,
+    std::vector<FilterConjunctInfo*>* active_conjuncts) {
+  if (!tvf_scan->tvf()->HasEvaluator()) {
+    return ::zetasql_base::InvalidArgumentErrorBuilder()
+           << "Table-valued function " << tvf_scan->tvf()->FullName()
+           << " has no evaluator. Override "
+           << "TableValuedFunction::CreateEvaluator() to supply one.";
+  }
+  const TVFSignature& signature = *tvf_scan->signature();
+  ZETASQL_RET_CHECK_EQ(tvf_scan->argument_list_size(),
+               signature.input_arguments().size());
+
+  std::vector<TvfOp::TvfArg> arguments;
+  arguments.reserve(tvf_scan->argument_list_size());
+  for (int i = 0; i < tvf_scan->argument_list_size(); ++i) {
+    const ResolvedFunctionArgument* argument = tvf_scan->argument_list(i);
+    TvfOp::TvfArg& arg = arguments.emplace_back();
+    if (argument->expr() != nullptr) {
+      ZETASQL_ASSIGN_OR_RETURN(arg.value, AlgebrizeExpression(argument->expr()));
+    } else if (argument->scan() != nullptr) {
+      ZETASQL_RET_CHECK(signature.argument(i).is_relation());
+      ZETASQL_ASSIGN_OR_RETURN(arg.relation, AlgebrizeScan(argument->scan()));
+      arg.relation_columns = signature.argument(i).relation().columns();
+      ZETASQL_RET_CHECK_EQ(arg.relation_columns.size(),
+                   argument->argument_column_list_size());
+      for (const ResolvedColumn& column : argument->argument_column_list()) {
+        arg.relation_variables.push_back(
+            column_to_variable_->GetVariableNameFromColumn(column));
+      }
+    } else {
+      return zetasql_base::UnimplementedErrorBuilder()
+             << "Table-valued function " << tvf_scan->tvf()->FullName()
+             << " has an argument that is not a scalar or a relation, which "
+                "is not supported by the reference implementation";
+    }
+  }
+
+  const ResolvedColumnList& column_list = tvf_scan->column_list();
+  const std::vector<int>& column_idx_list = tvf_scan->column_index_list();
+  ZETASQL_RET_CHECK_EQ(column_list.size(), column_idx_list.size());
+
+  std::vector<TVFSchemaColumn> output_columns;
+  output_columns.reserve(column_list.size());
+  std::vector<VariableId> variables;
+  variables.reserve(column_list.size());
+  TableScanColumnInfoMap column_info_map;
+  column_info_map.reserve(column_list.size());
+  for (int i = 0; i < column_list.size(); ++i) {
+    const ResolvedColumn& column = column_list[i];
+    output_columns.push_back(
+        signature.result_schema().column(column_idx_list[i]));
+    const VariableId variable =
+        column_to_variable_->GetVariableNameFromColumn(column);
+    variables.push_back(variable);
+    ZETASQL_RET_CHECK(
+        column_info_map.emplace(column, std::make_pair(variable, i)).second);
   }
+
+  std::vector<std::unique_ptr<ColumnFilterArg>> and_filters;
+  if (algebrizer_options_.push_down_filters) {
+    // Iterate over 'active_conjuncts' in reverse order because it's a stack.
+    for (auto i = active_conjuncts->rbegin(); i != active_conjuncts->rend();
+         ++i) {
+      ZETASQL_RETURN_IF_ERROR(TryAlgebrizeFilterConjunctAsColumnFilterArgs(
+          column_info_map, **i, &and_filters));
+      // As for table scans, the TVF's iterator is free to ignore the filters,
+      // so the conjunct stays in a filter above it.
+    }
+  }
+
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<TvfOp> tvf_op,
+      TvfOp::Create(tvf_scan->tvf(), std::move(arguments),
+                    std::move(output_columns), std::move(variables),
+                    std::move(and_filters),
+                    tvf_scan->function_call_signature()));
+  if (auto it = row_count_hints_.find(tvf_scan); it != row_count_hints_.end()) {
+    tvf_op->set_row_count_hint(it->second);
+  }
+  return tvf_op;
 }
 
 // Returns true if any element of 'a' is in 'b'.
@@ -1795,6 +1962,10 @@ absl::Status Algebrizer::TryAlgebrizeFilterConjunctAsColumnFilterArgs(
     const FilterConjunctInfo& conjunct_info,
     std::vector<std::unique_ptr<ColumnFilterArg>>* and_filters) {
   if (!conjunct_info.is_non_volatile) return absl::OkStatus();
+  // ColumnFilters compare values without collation, so they would drop rows
+  // that only match under the collation (e.g., 'A' for key = 'a' with
+  // und:ci).
+  if (conjunct_info.has_collation) return absl::OkStatus();
 
   absl::flat_hash_set<ResolvedColumn> table_columns;
   table_columns.reserve(column_info_map.size());
@@ -2034,6 +2205,25 @@ class FindWithEntryReferenceCountVisitor : public ResolvedASTVisitor {
     return absl::OkStatus();
   }
 
+  // A subquery expression is evaluated once per row of its enclosing scan, so
+  // a WITH entry referenced once inside of it is counted as referenced more
+  // than once. This keeps the entry from being inlined and evaluated again for
+  // each row, which is both slow and wrong if the entry is non-deterministic.
+  absl::Status VisitResolvedSubqueryExpr(
+      const ResolvedSubqueryExpr* expr) override {
+    ZETASQL_RETURN_IF_ERROR(expr->ChildrenAccept(this));
+    return expr->ChildrenAccept(this);
+  }
+
+  // Likewise, the recursive term of a recursive scan is evaluated once per
+  // iteration.
+  absl::Status VisitResolvedRecursiveScan(
+      const ResolvedRecursiveScan* scan) override {
+    ZETASQL_RETURN_IF_ERROR(scan->non_recursive_term()->Accept(this));
+    ZETASQL_RETURN_IF_ERROR(scan->recursive_term()->Accept(this));
+    return scan->recursive_term()->Accept(this);
+  }
+
   absl::Status VisitResolvedWithRefScan(
       const ResolvedWithRefScan* scan) override {
     auto it = reference_count_.find(scan->with_query_name());
@@ -2055,6 +2245,8 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeWithScan(
   // reference those subqueries.
   // Save the old with_map_ with names that are visible in the outer scope.
   const absl::flat_hash_map<std::string, ExprArg*> old_with_map = with_map_;
+  const absl::flat_hash_map<std::string, VariableId> old_shared_with_map =
+      shared_with_map_;
 
   // Compute how many times each WITH entry is referenced. Entries referenced
   // exactly once can be inlined, while entries not referenced at all can be
@@ -2086,6 +2278,26 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeWithScan(
     }
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<RelationalOp> subquery,
                      AlgebrizeScan(with_entry->with_subquery()));
+    if (algebrizer_options_.share_with_entry_scans) {
+      // The references read the subquery through a shared buffer, which
+      // evaluates it lazily and only once.
+      std::vector<VariableId> subquery_variables;
+      for (const ResolvedColumn& column :
+           with_entry->with_subquery()->column_list()) {
+        ZETASQL_ASSIGN_OR_RETURN(
+            VariableId variable,
+            column_to_variable_->LookupVariableNameForColumn(column));
+        subquery_variables.push_back(variable);
+      }
+      const VariableId buffer_variable =
+          variable_gen_->GetNewVariableName(with_entry->with_query_name());
+      with_subquery_cpp_let_assignments_.push_back(
+          SharedScanOp::MakeCppValueArgForBuffer(
+              with_entry->with_query_name(), buffer_variable,
+              std::move(subquery), std::move(subquery_variables)));
+      shared_with_map_[with_entry->with_query_name()] = buffer_variable;
+      continue;
+    }
     ZETASQL_ASSIGN_OR_RETURN(
         std::unique_ptr<ArrayNestExpr> nested_subquery,
         NestRelationInStruct(with_entry->with_subquery()->column_list(),
@@ -2102,6 +2314,7 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeWithScan(
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<RelationalOp> nested_query,
                    AlgebrizeScan(scan->query()));
   with_map_ = old_with_map;  // Restore original state.
+  shared_with_map_ = old_shared_with_map;
   return nested_query;
 }
 
@@ -2151,6 +2364,18 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeWithRefScan(
     return compute_op;
   }
 
+  if (auto shared_it = shared_with_map_.find(query_name);
+      shared_it != shared_with_map_.end()) {
+    std::vector<VariableId> variables;
+    variables.reserve(scan->column_list_size());
+    for (const ResolvedColumn& column : scan->column_list()) {
+      variables.push_back(
+          column_to_variable_->GetVariableNameFromColumn(column));
+    }
+    return SharedScanOp::Create(query_name, shared_it->second,
+                                std::move(variables));
+  }
+
   // We are referencing a pre-computed array value storing the entire table.
   const auto it = with_map_.find(query_name);
   ZETASQL_RET_CHECK(it != with_map_.end())
@@ -2245,6 +2470,26 @@ Algebrizer::AlgebrizeLimitOffsetScan(const ResolvedLimitOffsetScan* scan) {
     return AlgebrizeOrderByScan(input_scan, std::move(limit),
                                 std::move(offset));
   } else {
+    if (algebrizer_options_.push_down_row_count_hints &&
+        scan->limit()->node_kind() == RESOLVED_LITERAL &&
+        (scan->offset() == nullptr ||
+         scan->offset()->node_kind() == RESOLVED_LITERAL)) {
+      const Value& limit_value =
+          scan->limit()->GetAs<ResolvedLiteral>()->value();
+      const Value offset_value =
+          scan->offset() == nullptr
+              ? Value::Int64(0)
+              : scan->offset()->GetAs<ResolvedLiteral>()->value();
+      // Invalid values are reported by LimitOp, so only hint for valid ones.
+      if (limit_value.type()->IsInt64() && !limit_value.is_null() &&
+          limit_value.int64_value() >= 0 && offset_value.type()->IsInt64() &&
+          !offset_value.is_null() && offset_value.int64_value() >= 0 &&
+          limit_value.int64_value() <= std::numeric_limits<int64_t>::max() -
+                                           offset_value.int64_value()) {
+        AddRowCountHints(scan->input_scan(), limit_value.int64_value() +
+                                                 offset_value.int64_value());
+      }
+    }
     ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<RelationalOp> input,
                      AlgebrizeScan(scan->input_scan()));
     return LimitOp::Create(std::move(limit), std::move(offset),
@@ -2252,6 +2497,43 @@ Algebrizer::AlgebrizeLimitOffsetScan(const ResolvedLimitOffsetScan* scan) {
   }
 }
 
+void Algebrizer::AddRowCountHints(const ResolvedScan* scan, int64_t max_rows) {
+  switch (scan->node_kind()) {
+    case RESOLVED_TABLE_SCAN:
+    case RESOLVED_TVFSCAN:
+      row_count_hints_[scan] = max_rows;
+      break;
+    case RESOLVED_PROJECT_SCAN:
+      AddRowCountHints(scan->GetAs<ResolvedProjectScan>()->input_scan(),
+                       max_rows);
+      break;
+    case RESOLVED_SET_OPERATION_SCAN: {
+      const ResolvedSetOperationScan* set_scan =
+          scan->GetAs<ResolvedSetOperationScan>();
+      if (set_scan->op_type() == ResolvedSetOperationScan::UNION_ALL) {
+        for (const auto& item : set_scan->input_item_list()) {
+          AddRowCountHints(item->scan(), max_rows);
+        }
+      }
+      break;
+    }
+    case RESOLVED_JOIN_SCAN: {
+      // Every left row produces at least one output row of a left outer join,
+      // and JoinOp reads the left input as it goes. The right input is read in
+      // full.
+      const ResolvedJoinScan* join_scan = scan->GetAs<ResolvedJoinScan>();
+      if (join_scan->join_type() == ResolvedJoinScan::LEFT) {
+        AddRowCountHints(join_scan->left_scan(), max_rows);
+      }
+      break;
+    }
+    default:
+      // Other scans, e.g. filters, may read any number of input rows per row
+      // they produce.
+      break;
+  }
+}
+
 absl::Status Algebrizer::AddFilterConjunctsTo(
     const ResolvedExpr* expr,
     std::vector<std::unique_ptr<FilterConjunctInfo>>* conjunct_infos) {
@@ -3457,7 +3739,12 @@ Algebrizer::AlgebrizeAnalyticFunctionCall(
                                        analytic_function_call->window_frame()));
   }
 
-  if (!analytic_function_call->function()->IsZetaSQLBuiltin()) {
+  // User-defined aggregate functions that support window framing are computed
+  // like built-in ones, over each window. Other non-built-in analytic functions
+  // have no evaluator.
+  if (!analytic_function_call->function()->IsZetaSQLBuiltin() &&
+      (analytic_function_call->function()->mode() != Function::AGGREGATE ||
+       !analytic_function_call->function()->SupportsWindowFraming())) {
     return ::zetasql_base::InvalidArgumentErrorBuilder()
            << "Non-ZetaSQL built-in functions are unsupported: "
            << analytic_function_call->function()->Name();
@@ -4221,6 +4508,12 @@ absl::StatusOr<std::unique_ptr<RelationalOp>> Algebrizer::AlgebrizeScan(
                                           active_conjuncts));
       break;
     }
+    case RESOLVED_TVFSCAN: {
+      ZETASQL_ASSIGN_OR_RETURN(
+          rel_op,
+          AlgebrizeTvfScan(scan->GetAs<ResolvedTVFScan>(), active_conjuncts));
+      break;
+    }
     case RESOLVED_JOIN_SCAN: {
       ZETASQL_ASSIGN_OR_RETURN(
           rel_op,
@@ -4440,13 +4733,16 @@ Algebrizer::AlgebrizeRootScanAsValueExpr(
   // subqueries to array expressions.  WITH subqueries cannot be correlated
   // so we can attach them all in one batch at the top of the query, and that
   // will ensure we run each of them exactly once.
-  if (!with_subquery_let_assignments_.empty()) {
-    ZETASQL_ASSIGN_OR_RETURN(value,
-                     LetExpr::Create(std::move(with_subquery_let_assignments_),
-                                     std::move(value)));
+  if (!with_subquery_let_assignments_.empty() ||
+      !with_subquery_cpp_let_assignments_.empty()) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        value, LetExpr::Create(std::move(with_subquery_let_assignments_),
+                               std::move(with_subquery_cpp_let_assignments_),
+                               std::move(value)));
   }
   // Sanity check - WITH map should be cleared as WITH clauses go out of scope.
   ZETASQL_RET_CHECK(with_map_.empty());
+  ZETASQL_RET_CHECK(shared_with_map_.empty());
 
   return WrapWithRootExpr(std::move(value));
 }
@@ -4497,13 +4793,17 @@ Algebrizer::AlgebrizeQueryStatementAsRelation(
   // subqueries to array expressions.  WITH subqueries cannot be correlated
   // so we can attach them all in one batch at the top of the query, and that
   // will ensure we run each of them exactly once.
-  if (!with_subquery_let_assignments_.empty()) {
-    ZETASQL_ASSIGN_OR_RETURN(relation,
-                     LetOp::Create(std::move(with_subquery_let_assignments_),
-                                   /*cpp_assign=*/{}, std::move(relation)));
+  if (!with_subquery_let_assignments_.empty() ||
+      !with_subquery_cpp_let_assignments_.empty()) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        relation,
+        LetOp::Create(std::move(with_subquery_let_assignments_),
+                      std::move(with_subquery_cpp_let_assignments_),
+                      std::move(relation)));
   }
   // Sanity check - WITH map should be cleared as WITH clauses go out of scope.
   ZETASQL_RET_CHECK(with_map_.empty());
+  ZETASQL_RET_CHECK(shared_with_map_.empty());
 
   ZETASQL_ASSIGN_OR_RETURN(relation,
                    RootOp::Create(std::move(relation), GetRootData()));
@@ -4597,6 +4897,20 @@ absl::StatusOr<std::unique_ptr<ValueExpr>> Algebrizer::AlgebrizeDMLStatement(
       break;
   }
 
+  // WITH entries referenced from subquery expressions in the statement are
+  // materialized (or shared) through these assignments, so they must be live
+  // while the DML ValueExpr runs.
+  if (!with_subquery_let_assignments_.empty() ||
+      !with_subquery_cpp_let_assignments_.empty()) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        value_expr,
+        LetExpr::Create(std::move(with_subquery_let_assignments_),
+                        std::move(with_subquery_cpp_let_assignments_),
+                        std::move(value_expr)));
+  }
+  ZETASQL_RET_CHECK(with_subquery_let_assignments_.empty());
+  ZETASQL_RET_CHECK(with_subquery_cpp_let_assignments_.empty());
+
   return WrapWithRootExpr(std::move(value_expr));
 }
 
@@ -4619,7 +4933,10 @@ absl::Status Algebrizer::AlgebrizeDescendantsOfDMLStatement(
 
       resolved_table_scan_or_null = stmt->table_scan();
       if (resolved_table_scan_or_null != nullptr) {
+        // Push the WHERE clause into the table scan so that the table only
+        // returns the rows that may be deleted.
         ZETASQL_RETURN_IF_ERROR(PopulateResolvedScanMap(resolved_table_scan_or_null,
+                                                stmt->where_expr(),
                                                 resolved_scan_map));
       }
 
@@ -4646,8 +4963,12 @@ absl::Status Algebrizer::AlgebrizeDescendantsOfDMLStatement(
 
       resolved_table_scan_or_null = stmt->table_scan();
       if (resolved_table_scan_or_null != nullptr) {
-        ZETASQL_RETURN_IF_ERROR(PopulateResolvedScanMap(resolved_table_scan_or_null,
-                                                resolved_scan_map));
+        // Without a FROM clause, the WHERE clause only references the target
+        // table, so we can push it into the table scan.
+        ZETASQL_RETURN_IF_ERROR(PopulateResolvedScanMap(
+            resolved_table_scan_or_null,
+            stmt->from_scan() == nullptr ? stmt->where_expr() : nullptr,
+            resolved_scan_map));
       }
 
       if (stmt->from_scan() != nullptr) {
@@ -4868,6 +5189,27 @@ absl::Status Algebrizer::PopulateResolvedScanMap(
   return absl::OkStatus();
 }
 
+absl::Status Algebrizer::PopulateResolvedScanMap(
+    const ResolvedScan* resolved_scan, const ResolvedExpr* filter_expr,
+    ResolvedScanMap* resolved_scan_map) {
+  std::vector<std::unique_ptr<FilterConjunctInfo>> conjunct_infos;
+  if (filter_expr != nullptr && algebrizer_options_.push_down_dml_filters) {
+    ZETASQL_RETURN_IF_ERROR(AddFilterConjunctsTo(filter_expr, &conjunct_infos));
+  }
+  // Push the conjuncts onto 'active_conjuncts' in reverse order (because it's a
+  // stack).
+  std::vector<FilterConjunctInfo*> active_conjuncts;
+  for (auto i = conjunct_infos.rbegin(); i != conjunct_infos.rend(); ++i) {
+    active_conjuncts.push_back(i->get());
+  }
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<RelationalOp> relational_op,
+                   AlgebrizeScan(resolved_scan, &active_conjuncts));
+  const auto ret =
+      resolved_scan_map->emplace(resolved_scan, std::move(relational_op));
+  ZETASQL_RET_CHECK(ret.second);
+  return absl::OkStatus();
+}
+
 absl::Status Algebrizer::PopulateResolvedExprMap(
     const ResolvedExpr* resolved_expr, ResolvedExprMap* resolved_expr_map) {
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ValueExpr> value_expr,
@@ -79,6 +79,14 @@ struct AlgebrizerOptions {
   // EvaluatorTableIterator does not have to honor the filter.
   bool push_down_filters = false;
 
+  // If true (and 'push_down_filters' is true), the WHERE clause of a DELETE or
+  // an UPDATE without a FROM clause is also pushed down into the scan of the
+  // target table, so that the table can skip rows that cannot be modified. This
+  // is only valid when the statement is evaluated with
+  // EvaluationOptions::return_all_rows_for_dml set to false, because otherwise
+  // the output must contain the unmodified rows.
+  bool push_down_dml_filters = false;
+
   // True to inline references to WITH entries which are referenced at most
   // once. This causes rows in a WITH entry referenced only once to be evaluated
   // only when necessary to determine the primary query result, while also
@@ -88,6 +96,20 @@ struct AlgebrizerOptions {
   // evaluated up front, and the result stored in an in-memory array, which will
   // then be dereferenced when the WITH entry is referenced.
   bool inline_with_entries = false;
+
+  // True to evaluate WITH entries which are not inlined lazily, through a
+  // SharedScanOp per reference. The references share a single evaluation of
+  // the entry, which buffers only the rows that some reference has read.
+  //
+  // If false, such WITH entries are evaluated up front into an in-memory
+  // array, as described above.
+  bool share_with_entry_scans = false;
+
+  // If true, a LIMIT and OFFSET with literal values is passed as a row count
+  // hint to the EvaluatorTableIterators of the table and TVF scans that every
+  // row of the LIMIT's input comes from, through projections, UNION ALLs and
+  // the left input of left outer joins.
+  bool push_down_row_count_hints = false;
 };
 
 struct AnonymizationOptions {
@@ -301,6 +323,10 @@ class Algebrizer {
     // FunctionEnums::VOLATILE).
     bool is_non_volatile = false;
 
+    // True if 'conjunct' is a ResolvedFunctionCall that compares its arguments
+    // under a collation (i.e., it has a non-empty collation_list).
+    bool has_collation = false;
+
     // All the columns referenced by 'conjunct'.
     absl::flat_hash_set<ResolvedColumn> referenced_columns;
 
@@ -423,6 +449,19 @@ class Algebrizer {
       const ResolvedTableScan* table_scan,
       std::vector<FilterConjunctInfo*>* active_conjuncts);
 
+  // Algebrizes a call to a TableValuedFunction that implements
+  // TableValuedFunction::CreateEvaluator(). Conjuncts on the output columns
+  // are passed to the TVF's iterator like those of a table scan.
+  absl::StatusOr<std::unique_ptr<RelationalOp>> AlgebrizeTvfScan(
+      const ResolvedTVFScan* tvf_scan,
+      std::vector<FilterConjunctInfo*>* active_conjuncts);
+
+  // Records 'max_rows' as the row count hint of the table and TVF scans under
+  // 'scan' that each yield at least one row of 'scan' per row they produce, so
+  // that reading 'max_rows' rows of 'scan' reads at most as many of theirs
+  // (see 'push_down_row_count_hints').
+  void AddRowCountHints(const ResolvedScan* scan, int64_t max_rows);
+
   // Maps a ResolvedColumn from a table scan to its corresponding Variable and
   // index in the scan (not the Table).
   using TableScanColumnInfoMap =
@@ -578,6 +617,15 @@ class Algebrizer {
   absl::Status PopulateResolvedScanMap(const ResolvedScan* resolved_scan,
                                        ResolvedScanMap* resolved_scan_map);
 
+  // Same as above, but algebrizes 'resolved_scan' with the conjuncts of
+  // 'filter_expr' (which may be NULL) as active conjuncts so that they can be
+  // pushed down into the scan if 'algebrizer_options_.push_down_dml_filters' is
+  // true. Used for the target table scan of DELETE and UPDATE, whose WHERE
+  // clause is still evaluated on every returned row.
+  absl::Status PopulateResolvedScanMap(const ResolvedScan* resolved_scan,
+                                       const ResolvedExpr* filter_expr,
+                                       ResolvedScanMap* resolved_scan_map);
+
   // Adds the entry corresponding to 'resolved_expr' to 'resolved_expr_map'
   // (whose key is 'resolved_expr' and whose value is the algebrized
   // expression). Note that the map does not own the ResolvedExpr nodes.
@@ -917,6 +965,14 @@ class Algebrizer {
   // the query.
   std::vector<std::unique_ptr<ExprArg>> with_subquery_let_assignments_;
 
+  // The WITH subqueries that are read through SharedScanOps, if
+  // 'share_with_entry_scans' is true. Maps the name of each subquery in scope
+  // to the variable of its buffer.
+  absl::flat_hash_map<std::string, VariableId> shared_with_map_;
+
+  // The C++ LetOp/LetExpr assignments of the buffers of 'shared_with_map_'.
+  std::vector<std::unique_ptr<CppValueArg>> with_subquery_cpp_let_assignments_;
+
   // WITH entries whose definitions are to be inlined where they are referenced.
   // Only WITH entries referenced exactly once are included in this map.
   // Key = name, value = ResolvedScan of WITH entry subquery.
@@ -924,6 +980,10 @@ class Algebrizer {
   // Entries are removed from the map as AlgebrizeWithRefScan() consumes them.
   absl::flat_hash_map<std::string, const ResolvedScan*> inlined_with_entries_;
 
+  // The row count hints of the table and TVF scans that have one, keyed by the
+  // scan. Populated by AddRowCountHints().
+  absl::flat_hash_map<const ResolvedScan*, int64_t> row_count_hints_;
+
   // Owns all the ProtoFieldRegistries created by the algebrizer.
   std::vector<std::unique_ptr<ProtoFieldRegistry>> proto_field_registries_;
 
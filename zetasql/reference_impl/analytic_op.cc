@@ -2309,7 +2309,7 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> AnalyticOp::CreateIterator(
     EvaluationContext* context) const {
   ZETASQL_ASSIGN_OR_RETURN(
       std::unique_ptr<TupleIterator> iter,
-      input()->CreateIterator(
+      input()->CreateProfiledIterator(
           {params}, analytic_args().size() + num_extra_slots, context));
 
   std::vector<int> slots_for_partition_keys;
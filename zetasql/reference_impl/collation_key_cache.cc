@@ -0,0 +1,112 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/collation_key_cache.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "zetasql/base/ret_check.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+
+CollationKeyCache::CollationKeyCache(const ZetaSqlCollator* collator,
+                                     MemoryAccountant* accountant,
+                                     int64_t max_bytes)
+    : collator_(collator),
+      accountant_(accountant),
+      is_binary_(collator->IsBinaryComparison()),
+      max_bytes_(max_bytes) {}
+
+CollationKeyCache::~CollationKeyCache() {
+  if (accountant_ != nullptr) accountant_->ReturnBytes(num_bytes_);
+}
+
+absl::StatusOr<absl::string_view> CollationKeyCache::GetSortKey(
+    absl::string_view str) {
+  if (is_binary_) return str;
+
+  auto it = index_.find(str);
+  if (it != index_.end()) {
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return absl::string_view(it->second->sort_key);
+  }
+
+  absl::Cord sort_key;
+  ZETASQL_RETURN_IF_ERROR(collator_->GetSortKeyUtf8(str, &sort_key));
+  ++num_computed_keys_;
+  const int64_t entry_bytes = str.size() + sort_key.size();
+  if (accountant_ != nullptr) {
+    // Keep the most recently used entry, whose key may still be referenced by
+    // the caller (see Compare()).
+    absl::Status status;
+    while (!accountant_->RequestBytes(entry_bytes, &status)) {
+      if (entries_.size() <= 1) return status;
+      EvictLast();
+    }
+  }
+  entries_.push_front(Entry{std::string(str), std::string(sort_key)});
+  const Entry& entry = entries_.front();
+  index_.emplace(entry.str, entries_.begin());
+  num_bytes_ += entry_bytes;
+  Evict();
+  return absl::string_view(entry.sort_key);
+}
+
+absl::StatusOr<int> CollationKeyCache::Compare(absl::string_view s1,
+                                               absl::string_view s2) {
+  ZETASQL_ASSIGN_OR_RETURN(absl::string_view key1, GetSortKey(s1));
+  ZETASQL_ASSIGN_OR_RETURN(absl::string_view key2, GetSortKey(s2));
+  return key1.compare(key2);
+}
+
+absl::StatusOr<Value> CollationKeyCache::GetSortKeyValue(const Value& value) {
+  ZETASQL_RET_CHECK(value.type()->IsString())
+      << "Cannot get sort key for value in non-String type: "
+      << value.type()->DebugString();
+  if (value.is_null()) {
+    return Value::NullBytes();
+  }
+  ZETASQL_ASSIGN_OR_RETURN(absl::string_view sort_key,
+                   GetSortKey(value.string_or_bytes_view()));
+  return Value::Bytes(sort_key);
+}
+
+void CollationKeyCache::Evict() {
+  while (num_bytes_ > max_bytes_ && entries_.size() > 2) {
+    EvictLast();
+  }
+}
+
+void CollationKeyCache::EvictLast() {
+  const Entry& entry = entries_.back();
+  const int64_t entry_bytes = entry.str.size() + entry.sort_key.size();
+  num_bytes_ -= entry_bytes;
+  if (accountant_ != nullptr) accountant_->ReturnBytes(entry_bytes);
+  index_.erase(entry.str);
+  entries_.pop_back();
+}
+
+}  // namespace zetasql
@@ -0,0 +1,107 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef ZETASQL_REFERENCE_IMPL_COLLATION_KEY_CACHE_H_
+#define ZETASQL_REFERENCE_IMPL_COLLATION_KEY_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <string>
+
+#include "zetasql/public/collator.h"
+#include "zetasql/public/value.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace zetasql {
+
+class MemoryAccountant;
+
+// Computes the collation sort keys of strings, and remembers the keys of the
+// most recently used strings so that repeated values go through ICU only once.
+//
+// Sort keys compare with memcmp() in the same order as the collator compares
+// the strings, so operators that compare or group collated strings many times
+// can work on the keys. If the collator uses binary comparison, the sort key
+// of a string is the string itself and ICU is not called at all.
+//
+// The cached strings and sort keys are charged to a MemoryAccountant. When
+// the accountant runs out of memory the cache shrinks instead, and GetSortKey()
+// only fails if not even a single new entry fits.
+//
+// This class is not thread-safe.
+class CollationKeyCache {
+ public:
+  // Default bound on the total size of the cached strings and sort keys.
+  static constexpr int64_t kDefaultMaxBytes = int64_t{8} << 20;
+
+  // 'collator' and 'accountant' must outlive this object. 'accountant' may be
+  // null, in which case the cache is only bounded by 'max_bytes'.
+  CollationKeyCache(const ZetaSqlCollator* collator,
+                    MemoryAccountant* accountant,
+                    int64_t max_bytes = kDefaultMaxBytes);
+
+  CollationKeyCache(const CollationKeyCache&) = delete;
+  CollationKeyCache& operator=(const CollationKeyCache&) = delete;
+
+  ~CollationKeyCache();
+
+  // Returns the sort key of 'str'. The returned view remains valid until the
+  // second next call to GetSortKey(), so that two keys can be compared.
+  absl::StatusOr<absl::string_view> GetSortKey(absl::string_view str);
+
+  // Compares 's1' and 's2' under the collation. Returns a negative number, 0
+  // or a positive number if 's1' is less than, equal to or greater than 's2'.
+  absl::StatusOr<int> Compare(absl::string_view s1, absl::string_view s2);
+
+  // Returns the sort key of the STRING 'value' as a BYTES value, or NULL BYTES
+  // if 'value' is NULL.
+  absl::StatusOr<Value> GetSortKeyValue(const Value& value);
+
+  // Returns the number of sort keys computed by the collator, i.e. the number
+  // of cache misses.
+  int64_t num_computed_keys() const { return num_computed_keys_; }
+
+ private:
+  struct Entry {
+    std::string str;
+    std::string sort_key;
+  };
+
+  // Evicts least recently used entries until the cache fits in 'max_bytes_',
+  // always keeping the two most recently used ones.
+  void Evict();
+
+  // Evicts the least recently used entry and returns its bytes to
+  // 'accountant_'. The cache must not be empty.
+  void EvictLast();
+
+  const ZetaSqlCollator* collator_;
+  MemoryAccountant* accountant_;
+  const bool is_binary_;
+  const int64_t max_bytes_;
+  int64_t num_bytes_ = 0;
+  int64_t num_computed_keys_ = 0;
+  // Most recently used entries first.
+  std::list<Entry> entries_;
+  // Keys point into the 'str' of the corresponding entry.
+  absl::flat_hash_map<absl::string_view, std::list<Entry>::iterator> index_;
+};
+
+}  // namespace zetasql
+
+#endif  // ZETASQL_REFERENCE_IMPL_COLLATION_KEY_CACHE_H_
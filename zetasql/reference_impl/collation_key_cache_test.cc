@@ -0,0 +1,152 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "zetasql/reference_impl/collation_key_cache.h"
+
+#include <memory>
+#include <string>
+
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/public/collator.h"
+#include "zetasql/public/value.h"
+#include "zetasql/reference_impl/tuple.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+
+namespace zetasql {
+namespace {
+
+using ::testing::Gt;
+using ::testing::Lt;
+using ::zetasql_base::testing::IsOkAndHolds;
+
+std::unique_ptr<const ZetaSqlCollator> MakeCollator(absl::string_view name) {
+  return MakeSqlCollator(name).value();
+}
+
+TEST(CollationKeyCacheTest, CompareMatchesCollator) {
+  std::unique_ptr<const ZetaSqlCollator> collator = MakeCollator("en_US:ci");
+  CollationKeyCache cache(collator.get(), /*accountant=*/nullptr);
+  const std::string strings[] = {"a", "A", "b", "B", "ä", "", "aa", "Z"};
+  for (absl::string_view s1 : strings) {
+    for (absl::string_view s2 : strings) {
+      absl::Status status;
+      const int64_t expected = collator->CompareUtf8(s1, s2, &status);
+      ZETASQL_ASSERT_OK(status);
+      ZETASQL_ASSERT_OK_AND_ASSIGN(const int result, cache.Compare(s1, s2));
+      EXPECT_EQ(expected, (result > 0) - (result < 0))
+          << "'" << s1 << "' vs '" << s2 << "'";
+    }
+  }
+}
+
+TEST(CollationKeyCacheTest, RepeatedValuesAreComputedOnce) {
+  std::unique_ptr<const ZetaSqlCollator> collator = MakeCollator("en_US");
+  CollationKeyCache cache(collator.get(), /*accountant=*/nullptr);
+  for (int i = 0; i < 100; ++i) {
+    ZETASQL_ASSERT_OK(cache.Compare("apple", "Banana").status());
+  }
+  EXPECT_EQ(cache.num_computed_keys(), 2);
+
+  absl::Cord expected;
+  ZETASQL_ASSERT_OK(collator->GetSortKeyUtf8("apple", &expected));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(absl::string_view key,
+                       cache.GetSortKey("apple"));
+  EXPECT_EQ(std::string(expected), key);
+  EXPECT_EQ(cache.num_computed_keys(), 2);
+}
+
+TEST(CollationKeyCacheTest, EvictsLeastRecentlyUsed) {
+  std::unique_ptr<const ZetaSqlCollator> collator = MakeCollator("en_US");
+  // Small enough that only a few entries fit.
+  CollationKeyCache cache(collator.get(), /*accountant=*/nullptr,
+                          /*max_bytes=*/64);
+  for (int i = 0; i < 100; ++i) {
+    ZETASQL_ASSERT_OK(cache.GetSortKey(absl::StrCat("value", i)).status());
+  }
+  EXPECT_EQ(cache.num_computed_keys(), 100);
+  ZETASQL_ASSERT_OK(cache.GetSortKey("value0").status());
+  EXPECT_EQ(cache.num_computed_keys(), 101);
+
+  // The two most recently used keys are always kept, even when they do not
+  // fit in the cache.
+  const std::string long_string(1000, 'x');
+  EXPECT_THAT(cache.Compare(long_string, "y" + long_string),
+              IsOkAndHolds(Lt(0)));
+}
+
+TEST(CollationKeyCacheTest, ChargesMemoryAccountant) {
+  std::unique_ptr<const ZetaSqlCollator> collator = MakeCollator("en_US");
+  MemoryAccountant accountant(/*total_num_bytes=*/1000);
+  {
+    CollationKeyCache cache(collator.get(), &accountant);
+    ZETASQL_ASSERT_OK(cache.GetSortKey("apple").status());
+    EXPECT_LT(accountant.remaining_bytes(), 1000);
+  }
+  EXPECT_EQ(accountant.remaining_bytes(), 1000);
+}
+
+TEST(CollationKeyCacheTest, ShrinksWhenOutOfMemory) {
+  std::unique_ptr<const ZetaSqlCollator> collator = MakeCollator("en_US");
+  const std::string long_string(100, 'x');
+  MemoryAccountant accountant(/*total_num_bytes=*/1000);
+  {
+    CollationKeyCache cache(collator.get(), &accountant);
+    // Far more than the accountant allows in total; older entries are evicted
+    // instead of failing.
+    for (int i = 0; i < 100; ++i) {
+      ZETASQL_ASSERT_OK(
+          cache.GetSortKey(absl::StrCat(long_string, i)).status());
+    }
+    EXPECT_GE(accountant.remaining_bytes(), 0);
+
+    // A single entry that does not fit is an error.
+    const absl::StatusOr<absl::string_view> too_large =
+        cache.GetSortKey(std::string(2000, 'x'));
+    EXPECT_EQ(too_large.status().code(), absl::StatusCode::kResourceExhausted);
+  }
+  EXPECT_EQ(accountant.remaining_bytes(), 1000);
+}
+
+TEST(CollationKeyCacheTest, BinaryCollationSkipsIcu) {
+  std::unique_ptr<const ZetaSqlCollator> collator = MakeCollator("binary");
+  ASSERT_TRUE(collator->IsBinaryComparison());
+  CollationKeyCache cache(collator.get(), /*accountant=*/nullptr);
+  EXPECT_THAT(cache.Compare("B", "a"), IsOkAndHolds(Lt(0)));
+  EXPECT_THAT(cache.Compare("b", "a"), IsOkAndHolds(Gt(0)));
+  EXPECT_THAT(cache.Compare("\xff", "a"), IsOkAndHolds(Gt(0)));
+  EXPECT_EQ(cache.num_computed_keys(), 0);
+}
+
+TEST(CollationKeyCacheTest, GetSortKeyValue) {
+  std::unique_ptr<const ZetaSqlCollator> collator = MakeCollator("en_US:ci");
+  CollationKeyCache cache(collator.get(), /*accountant=*/nullptr);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(Value lower,
+                       cache.GetSortKeyValue(Value::String("a")));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(Value upper,
+                       cache.GetSortKeyValue(Value::String("A")));
+  EXPECT_TRUE(lower.type()->IsBytes());
+  EXPECT_EQ(lower, upper);
+  EXPECT_THAT(cache.GetSortKeyValue(Value::NullString()),
+              IsOkAndHolds(Value::NullBytes()));
+  EXPECT_FALSE(cache.GetSortKeyValue(Value::Int64(1)).ok());
+}
+
+}  // namespace
+}  // namespace zetasql
@@ -17,9 +17,12 @@
 #ifndef ZETASQL_REFERENCE_IMPL_EVALUATION_H_
 #define ZETASQL_REFERENCE_IMPL_EVALUATION_H_
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -31,7 +34,9 @@
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include <cstdint>
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
 #include "absl/flags/declare.h"
+#include "absl/memory/memory.h"
 #include "absl/random/random.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
@@ -95,6 +100,15 @@ struct EvaluationOptions {
   // limit results in an error.
   int64_t max_intermediate_byte_size = 128 * 1024 * 1024;
 
+  // Size parameters of the bounded-memory sketches used to evaluate
+  // APPROX_QUANTILES (the KLL compactor size 'k') and APPROX_TOP_COUNT and
+  // APPROX_TOP_SUM (the number of tracked keys). Larger values use more memory
+  // and give more accurate results. Inputs with at most this many rows (resp.
+  // distinct keys) are evaluated exactly. Both are raised to the requested
+  // number of quantiles or top entries when that is larger.
+  int64_t approx_quantiles_sketch_k = 1000;
+  int64_t approx_top_sketch_capacity = 1000;
+
   // If true, the results of DML statements will include all rows in the
   // modified table; otherwise, only modified rows (i.e. those matching the
   // WHERE clause) are included. For DELETE, 'modified rows' means the rows to
@@ -106,6 +120,72 @@ struct EvaluationOptions {
 };
 
 class ProtoFieldReader;
+class RelationalOp;
+
+// Execution statistics of a RelationalOp collected by an OperatorProfiler. The
+// times and the peak memory include those of the inputs of the operator, which
+// run within its calls.
+struct OperatorStats {
+  // The number of iterators created by the operator.
+  int64_t num_iterators = 0;
+  // The number of calls to Next() on those iterators, and the number of tuples
+  // they returned.
+  int64_t num_next_calls = 0;
+  int64_t num_rows = 0;
+  // Time spent creating the iterators and in their calls to Next().
+  absl::Duration wall_time;
+  absl::Duration cpu_time;
+  // The largest number of bytes allocated from the MemoryAccountant at once
+  // while the operator was running.
+  int64_t peak_memory_bytes = 0;
+  // Operator-specific counters by name, such as the number of entries of a hash
+  // table. Each holds the largest value recorded.
+  std::map<std::string, int64_t> counters;
+  // The number of calls to the operator in progress. Only the outermost one is
+  // timed, so that operators that run within themselves are not counted twice.
+  int num_active_calls = 0;
+};
+
+// Collects OperatorStats for the relational operators evaluated with an
+// EvaluationContext that has profiling enabled.
+class OperatorProfiler {
+ public:
+  OperatorProfiler() {}
+  OperatorProfiler(const OperatorProfiler&) = delete;
+  OperatorProfiler& operator=(const OperatorProfiler&) = delete;
+
+  // Returns the statistics of 'op', creating them if needed. The returned
+  // pointer remains valid for the lifetime of this object.
+  OperatorStats* GetMutableStats(const RelationalOp* op) { return &stats_[op]; }
+
+  // Returns the statistics of 'op', or NULL if 'op' has not been evaluated.
+  const OperatorStats* GetStats(const RelationalOp* op) const {
+    const auto it = stats_.find(op);
+    return it == stats_.end() ? nullptr : &it->second;
+  }
+
+  // Records 'value' for the counter 'name' of 'op' if it is larger than the
+  // current value.
+  void RecordCounter(const RelationalOp* op, const std::string& name,
+                     int64_t value) {
+    int64_t& counter = GetMutableStats(op)->counters[name];
+    counter = std::max(counter, value);
+  }
+
+ private:
+  absl::node_hash_map<const RelationalOp*, OperatorStats> stats_;
+};
+
+// Counts work done by an evaluation, for reporting to an EvaluatorListener.
+struct EvaluationCounters {
+  // The number of rows read from each EvaluatorTable, by table name.
+  std::map<std::string, int64_t> rows_scanned;
+  // The number of regular expressions compiled while evaluating, excluding
+  // constant patterns compiled once when the function is created.
+  int64_t num_regexps_compiled = 0;
+  // The number of JSON strings parsed while evaluating.
+  int64_t num_json_parses = 0;
+};
 
 // Base class for C++ values which can be associated with a variable.
 class CppValueBase {
@@ -129,6 +209,24 @@ class EvaluationContext {
 
   MemoryAccountant* memory_accountant() { return &memory_accountant_; }
 
+  // Makes the relational operators record their OperatorStats in
+  // operator_profiler(). Must be called before evaluation starts.
+  void EnableOperatorProfiling() {
+    operator_profiler_ = absl::make_unique<OperatorProfiler>();
+  }
+
+  // Returns NULL unless EnableOperatorProfiling() has been called.
+  OperatorProfiler* operator_profiler() { return operator_profiler_.get(); }
+
+  // Makes the evaluation count its work in counters(). Must be called before
+  // evaluation starts.
+  void EnableCounters() {
+    counters_ = absl::make_unique<EvaluationCounters>();
+  }
+
+  // Returns NULL unless EnableCounters() has been called.
+  EvaluationCounters* counters() { return counters_.get(); }
+
   // Returns the contents of table 'table_name' or Value::Invalid().
   Value GetTableAsArray(const std::string& table_name) {
     const auto it = tables_.find(table_name);
@@ -272,6 +370,12 @@ class EvaluationContext {
     return ret;
   }
 
+  // Marks the current statement as cancelled without invoking the
+  // cancellation callbacks. Unlike the rest of this class, this may be called
+  // from any thread while the statement is being evaluated; the evaluation
+  // stops the next time an iterator calls VerifyNotAborted().
+  void RequestCancellation() { cancelled_ = true; }
+
   // Reset the deadline to infinity, uncancel the statement, and clear the
   // cancellation callbacks.
   void ClearDeadlineAndCancellationState() {
@@ -372,6 +476,8 @@ class EvaluationContext {
 
   const EvaluationOptions options_;
   MemoryAccountant memory_accountant_;
+  std::unique_ptr<OperatorProfiler> operator_profiler_;
+  std::unique_ptr<EvaluationCounters> counters_;
   // Tables added by AddTableAsArray().
   std::map<std::string, Value> tables_;
 
@@ -381,7 +487,7 @@ class EvaluationContext {
   LanguageOptions language_options_;
   // Default is no deadline.
   absl::Time statement_eval_deadline_ = absl::InfiniteFuture();
-  bool cancelled_ = false;
+  std::atomic<bool> cancelled_{false};
   std::vector<CancelCallback> cancel_cbs_;
 
   // Used to obtain the current timestamp.
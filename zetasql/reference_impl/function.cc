@@ -46,8 +46,11 @@
 #include "google/protobuf/message.h"
 #include "google/protobuf/reflection.h"
 #include "zetasql/common/errors.h"
+#include "zetasql/common/frequent_items_sketch.h"
+#include "zetasql/common/hll_sketch.h"
 #include "zetasql/common/initialize_required_fields.h"
 #include "zetasql/common/internal_value.h"
+#include "zetasql/common/kll_sketch.h"
 #include "zetasql/public/cast.h"
 #include "zetasql/public/civil_time.h"
 #include "zetasql/public/collator.h"
@@ -99,11 +102,14 @@
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "algorithms/algorithm.h"
 #include "algorithms/bounded-mean.h"
 #include "algorithms/bounded-standard-deviation.h"
 #include "algorithms/bounded-sum.h"
 #include "algorithms/bounded-variance.h"
+#include "farmhash.h"
+#include "zetasql/base/endian.h"
 #include "zetasql/base/map_util.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/exactfloat.h"
@@ -251,6 +257,20 @@ bool InvokeString(FunctionType function, Value* result, absl::Status* status,
   return true;
 }
 
+// Like InvokeString() and InvokeBytes(), for functions that return a part of
+// their first argument 'parent'. The result shares the buffer of 'parent'
+// where Value::SliceOf() deems it worthwhile.
+template <typename FunctionType, class... Args>
+bool InvokeSlice(FunctionType function, Value* result, absl::Status* status,
+                 const Value& parent, Args... args) {
+  absl::string_view out;
+  if (!function(parent.string_or_bytes_view(), args..., &out, status)) {
+    return false;
+  }
+  *result = Value::SliceOf(parent, out);
+  return true;
+}
+
 template <typename FunctionType, class... Args>
 bool InvokeStringWithCollation(FunctionType function, Value* result,
                                absl::Status* status,
@@ -471,6 +491,14 @@ FunctionMap::FunctionMap() {
     RegisterFunction(FunctionKind::kAnd, "$and", "And");
     RegisterFunction(FunctionKind::kAndAgg, kPrivate, "AndAgg");
     RegisterFunction(FunctionKind::kAnyValue, "any_value", "AnyValue");
+    RegisterFunction(FunctionKind::kApproxCountDistinct,
+                     "approx_count_distinct", "ApproxCountDistinct");
+    RegisterFunction(FunctionKind::kApproxQuantiles, "approx_quantiles",
+                     "ApproxQuantiles");
+    RegisterFunction(FunctionKind::kApproxTopCount, "approx_top_count",
+                     "ApproxTopCount");
+    RegisterFunction(FunctionKind::kApproxTopSum, "approx_top_sum",
+                     "ApproxTopSum");
     RegisterFunction(FunctionKind::kArrayAgg, "array_agg", "ArrayAgg");
     RegisterFunction(FunctionKind::kArrayConcat, "array_concat", "ArrayConcat");
     RegisterFunction(FunctionKind::kArrayConcatAgg, "array_concat_agg",
@@ -858,6 +886,14 @@ FunctionMap::FunctionMap() {
     RegisterFunction(FunctionKind::kFarmFingerprint, "farm_fingerprint",
                      "FarmFingerprint");
     RegisterFunction(FunctionKind::kError, "error", "Error");
+    RegisterFunction(FunctionKind::kHllCountInit, "hll_count.init",
+                     "HllCount.Init");
+    RegisterFunction(FunctionKind::kHllCountMerge, "hll_count.merge",
+                     "HllCount.Merge");
+    RegisterFunction(FunctionKind::kHllCountMergePartial,
+                     "hll_count.merge_partial", "HllCount.MergePartial");
+    RegisterFunction(FunctionKind::kHllCountExtract, "hll_count.extract",
+                     "HllCount.Extract");
     RegisterFunction(FunctionKind::kArrayIncludes, "array_includes",
                      "ArrayIncludes");
     RegisterFunction(FunctionKind::kArrayIncludesAny, "array_includes_any",
@@ -963,7 +999,7 @@ static absl::StatusOr<Value> Extract(absl::Span<const Value> x,
   absl::Status status;
   absl::string_view out;
   bool is_null;
-  if (!regexp.Extract(/*str=*/ValueTraits<type>::FromValue(x[0]),
+  if (!regexp.Extract(/*str=*/x[0].string_or_bytes_view(),
                       ValueTraits<type>::RegExpUnit(), position,
                       occurrence_index, &out, &is_null, &status)) {
     return status;
@@ -971,7 +1007,7 @@ static absl::StatusOr<Value> Extract(absl::Span<const Value> x,
   if (is_null) {
     return ValueTraits<type>::NullValue();
   } else {
-    return ValueTraits<type>::ToValue(out);
+    return Value::SliceOf(x[0], out);
   }
 }
 
@@ -1037,14 +1073,14 @@ static absl::StatusOr<Value> ExtractAll(absl::Span<const Value> x,
   absl::Status status;
   std::vector<Value> values;
   functions::RegExp::ExtractAllIterator iter =
-      regexp.CreateExtractAllIterator(ValueTraits<type>::FromValue(x[0]));
+      regexp.CreateExtractAllIterator(x[0].string_or_bytes_view());
 
   while (true) {
     absl::string_view out;
     if (!iter.Next(&out, &status)) {
       break;
     }
-    values.push_back(ValueTraits<type>::ToValue(out));
+    values.push_back(Value::SliceOf(x[0], out));
   }
   if (!status.ok()) {
     return status;
@@ -1336,10 +1372,13 @@ absl::Status ConcatError(int64_t max_output_size, zetasql_base::SourceLocation s
 
 absl::StatusOr<JSONValueConstRef> GetJSONValueConstRef(
     const Value& json, const JSONParsingOptions& json_parsing_options,
-    JSONValue& json_storage) {
+    EvaluationContext* context, JSONValue& json_storage) {
   if (json.is_validated_json()) {
     return json.json_value();
   }
+  if (EvaluationCounters* counters = context->counters(); counters != nullptr) {
+    ++counters->num_json_parses;
+  }
   ZETASQL_ASSIGN_OR_RETURN(json_storage,
                    JSONValue::ParseJSONString(json.json_value_unparsed(),
                                               json_parsing_options));
@@ -1723,8 +1762,12 @@ BuiltinScalarFunction::CreateValidatedRaw(
     case FunctionKind::kCodePointsToString:
     case FunctionKind::kCodePointsToBytes:
       return new CodePointsToFunction(kind, output_type);
-    case FunctionKind::kFormat:
-      return new FormatFunction(output_type);
+    case FunctionKind::kFormat: {
+      ZETASQL_ASSIGN_OR_RETURN(
+          auto fct, CreateFormatFunction(language_options.product_mode(),
+                                         output_type, arguments));
+      return fct.release();
+    }
     case FunctionKind::kRegexpContains:
     case FunctionKind::kRegexpMatch:
     case FunctionKind::kRegexpExtract:
@@ -1897,6 +1940,8 @@ BuiltinScalarFunction::CreateValidatedRaw(
       return BuiltinFunctionRegistry::GetScalarFunction(kind, output_type);
     case FunctionKind::kError:
       return new ErrorFunction(output_type);
+    case FunctionKind::kHllCountExtract:
+      return new HllCountExtractFunction();
     default:
       ZETASQL_RET_CHECK_FAIL() << BuiltinFunctionCatalog::GetDebugNameByKind(kind)
                        << " is not a scalar function";
@@ -2020,6 +2065,35 @@ BuiltinScalarFunction::CreateRegexpFunction(
                                            output_type);
 }
 
+absl::StatusOr<std::unique_ptr<BuiltinScalarFunction>>
+BuiltinScalarFunction::CreateFormatFunction(
+    ProductMode product_mode, const Type* output_type,
+    const std::vector<std::unique_ptr<ValueExpr>>& arguments) {
+  if (arguments.empty() || !arguments[0]->IsConstant()) {
+    return absl::make_unique<FormatFunction>(output_type);
+  }
+  const ConstExpr* format = static_cast<const ConstExpr*>(arguments[0].get());
+  if (format->value().is_null() || !format->value().type()->IsString()) {
+    return absl::make_unique<FormatFunction>(output_type);
+  }
+  std::vector<const Type*> arg_types;
+  arg_types.reserve(arguments.size() - 1);
+  for (int i = 1; i < arguments.size(); ++i) {
+    arg_types.push_back(arguments[i]->output_type());
+  }
+  // As for regexps, errors are left to be reported at runtime so that SAFE
+  // function variants work correctly and queries that produce no rows do not
+  // fail.
+  auto const_format = functions::CompiledStringFormat::Create(
+      format->value().string_value(), arg_types, product_mode);
+  if (!const_format.ok()) {
+    return absl::make_unique<FormatFunction>(output_type);
+  }
+  return absl::make_unique<FormatFunction>(
+      std::move(const_format).value(), format->value().string_value(),
+      std::move(arg_types), product_mode, output_type);
+}
+
 bool BuiltinScalarFunction::HasNulls(absl::Span<const Value> args) {
   for (const auto& value : args) {
     if (value.is_null()) return true;
@@ -2154,6 +2228,39 @@ absl::StatusOr<Value> CodePointsToFunction::Eval(
   }
 }
 
+FormatFunction::FormatFunction(
+    std::unique_ptr<functions::CompiledStringFormat> const_format,
+    absl::string_view format_string, std::vector<const Type*> arg_types,
+    ProductMode product_mode, const Type* output_type)
+    : SimpleBuiltinScalarFunction(FunctionKind::kFormat, output_type),
+      has_const_format_(true),
+      const_format_string_(format_string),
+      arg_types_(std::move(arg_types)),
+      product_mode_(product_mode) {
+  idle_const_formats_.push_back(std::move(const_format));
+}
+
+absl::StatusOr<std::unique_ptr<functions::CompiledStringFormat>>
+FormatFunction::AcquireConstFormat() const {
+  {
+    absl::MutexLock lock(&mu_);
+    if (!idle_const_formats_.empty()) {
+      std::unique_ptr<functions::CompiledStringFormat> compiled =
+          std::move(idle_const_formats_.back());
+      idle_const_formats_.pop_back();
+      return compiled;
+    }
+  }
+  return functions::CompiledStringFormat::Create(const_format_string_,
+                                                 arg_types_, product_mode_);
+}
+
+void FormatFunction::ReleaseConstFormat(
+    std::unique_ptr<functions::CompiledStringFormat> compiled) const {
+  absl::MutexLock lock(&mu_);
+  idle_const_formats_.push_back(std::move(compiled));
+}
+
 absl::StatusOr<Value> FormatFunction::Eval(absl::Span<const Value> args,
                                            EvaluationContext* context) const {
   ZETASQL_DCHECK_GE(args.size(), 1);
@@ -2164,10 +2271,20 @@ absl::StatusOr<Value> FormatFunction::Eval(absl::Span<const Value> args,
   bool is_null;
   absl::Span<const Value> values(args);
   values.remove_prefix(1);
-  ZETASQL_RETURN_IF_ERROR(functions::StringFormatUtf8(
-      args[0].string_value(), values,
-      context->GetLanguageOptions().product_mode(), &output,
-      &is_null));
+  const ProductMode product_mode = context->GetLanguageOptions().product_mode();
+  if (has_const_format_ && product_mode == product_mode_) {
+    ZETASQL_DCHECK_EQ(args[0].string_value(), const_format_string_);
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<functions::CompiledStringFormat> compiled,
+        AcquireConstFormat());
+    const absl::Status status = compiled->Format(values, &output, &is_null);
+    ReleaseConstFormat(std::move(compiled));
+    ZETASQL_RETURN_IF_ERROR(status);
+  } else {
+    ZETASQL_RETURN_IF_ERROR(functions::StringFormatUtf8(args[0].string_value(),
+                                                values, product_mode, &output,
+                                                &is_null));
+  }
   Value value;
   if (is_null) {
     value = Value::NullString();
@@ -2180,7 +2297,7 @@ absl::StatusOr<Value> FormatFunction::Eval(absl::Span<const Value> args,
         }
       }
     }
-    value = Value::String(output);
+    value = Value::String(std::move(output));
   }
   if (value.physical_byte_size() > context->options().max_value_byte_size) {
     return zetasql_base::OutOfRangeErrorBuilder()
@@ -3366,6 +3483,12 @@ class BuiltinAggregateAccumulator : public AggregateAccumulator {
 
   MemoryAccountant* accountant() { return context_->memory_accountant(); }
 
+  // For MIN (sign < 0) and MAX (sign > 0) of strings with a collation:
+  // replaces the result with 'value' if it is the first input or comes before
+  // (MIN) or after (MAX) the result under collator_list_[0]. Only the sort key
+  // of the result is kept, so each input computes a single sort key.
+  absl::Status UpdateCollatedMinOrMax(const Value& value, int sign);
+
   const BuiltinAggregateFunction* function_;
   const Type* input_type_;
   const std::vector<Value> args_;
@@ -3400,6 +3523,7 @@ class BuiltinAggregateAccumulator : public AggregateAccumulator {
   BigNumericValue::VarianceAggregator
       bignumeric_variance_aggregator_;           // Var, Stddev
   std::string out_string_ = "";                  // Max, Min, StringAgg
+  std::string out_sort_key_;                     // Max, Min with collation
   std::string delimiter_ = ",";                  // StringAgg
   // OrAgg, AndAgg, LogicalOr, LogicalAnd.
   bool has_null_ = false;
@@ -3570,6 +3694,7 @@ absl::Status BuiltinAggregateAccumulator::Reset() {
     case FCT(FunctionKind::kMax, TYPE_STRING):
     case FCT(FunctionKind::kMax, TYPE_BYTES):
       out_string_.clear();
+      out_sort_key_.clear();
       break;
     case FCT(FunctionKind::kMax, TYPE_ARRAY):
       min_max_out_array_ = Value::Invalid();
@@ -3609,6 +3734,7 @@ absl::Status BuiltinAggregateAccumulator::Reset() {
     case FCT(FunctionKind::kMin, TYPE_STRING):
     case FCT(FunctionKind::kMin, TYPE_BYTES):
       out_string_.clear();
+      out_sort_key_.clear();
       break;
     case FCT(FunctionKind::kMin, TYPE_ARRAY):
       min_max_out_array_ = Value::Invalid();
@@ -3726,6 +3852,26 @@ absl::Status BuiltinAggregateAccumulator::Reset() {
   return absl::OkStatus();
 }
 
+absl::Status BuiltinAggregateAccumulator::UpdateCollatedMinOrMax(
+    const Value& value, int sign) {
+  const ZetaSqlCollator& collator = *collator_list_[0];
+  if (collator.IsBinaryComparison()) {
+    if (count_ <= 1 ||
+        sign * value.string_or_bytes_view().compare(out_string_) > 0) {
+      out_string_ = value.string_value();
+    }
+    return absl::OkStatus();
+  }
+  absl::Cord sort_key;
+  ZETASQL_RETURN_IF_ERROR(
+      collator.GetSortKeyUtf8(value.string_or_bytes_view(), &sort_key));
+  if (count_ <= 1 || sign * sort_key.Compare(out_sort_key_) > 0) {
+    out_string_ = value.string_value();
+    out_sort_key_ = std::string(sort_key);
+  }
+  return absl::OkStatus();
+}
+
 bool BuiltinAggregateAccumulator::Accumulate(const Value& value,
                                              bool* stop_accumulation,
                                              absl::Status* status) {
@@ -3977,22 +4123,16 @@ bool BuiltinAggregateAccumulator::Accumulate(const Value& value,
       break;
     }
     case FCT(FunctionKind::kMax, TYPE_STRING): {
-      bytes_to_return = out_string_.size();
-      if (count_ <= 1) {
+      bytes_to_return = out_string_.size() + out_sort_key_.size();
+      if (!collator_list_.empty()) {
+        *status = UpdateCollatedMinOrMax(value, /*sign=*/1);
+        if (!status->ok()) return false;
+      } else if (count_ <= 1) {
         out_string_ = value.string_value();
-      } else if (collator_list_.empty()) {
-        out_string_ = std::max(out_string_, value.string_value());
       } else {
-        int64_t result = collator_list_[0]->CompareUtf8(value.string_value(),
-                                                        out_string_, status);
-        if (!status->ok()) {
-          return false;
-        }
-        if (result > 0) {
-          out_string_ = value.string_value();
-        }
+        out_string_ = std::max(out_string_, value.string_value());
       }
-      additional_bytes_to_request = out_string_.size();
+      additional_bytes_to_request = out_string_.size() + out_sort_key_.size();
       break;
     }
     case FCT(FunctionKind::kMax, TYPE_BYTES): {
@@ -4065,22 +4205,16 @@ bool BuiltinAggregateAccumulator::Accumulate(const Value& value,
       break;
     }
     case FCT(FunctionKind::kMin, TYPE_STRING): {
-      bytes_to_return = out_string_.size();
-      if (count_ <= 1) {
+      bytes_to_return = out_string_.size() + out_sort_key_.size();
+      if (!collator_list_.empty()) {
+        *status = UpdateCollatedMinOrMax(value, /*sign=*/-1);
+        if (!status->ok()) return false;
+      } else if (count_ <= 1) {
         out_string_ = value.string_value();
-      } else if (collator_list_.empty()) {
-        out_string_ = std::min(out_string_, value.string_value());
       } else {
-        int64_t result = collator_list_[0]->CompareUtf8(value.string_value(),
-                                                        out_string_, status);
-        if (!status->ok()) {
-          return false;
-        }
-        if (result < 0) {
-          out_string_ = value.string_value();
-        }
+        out_string_ = std::min(out_string_, value.string_value());
       }
-      additional_bytes_to_request = out_string_.size();
+      additional_bytes_to_request = out_string_.size() + out_sort_key_.size();
       break;
     }
     case FCT(FunctionKind::kMin, TYPE_BYTES): {
@@ -4965,9 +5099,537 @@ BinaryStatFunction::CreateAccumulator(absl::Span<const Value> args,
   return BinaryStatAccumulator::Create(this, input_type(), context);
 }
 
+namespace {
+
+// Returns the 64-bit hash of 'value' that is fed to an HllSketch. Sketches
+// returned by HLL_COUNT.INIT can be stored and merged by later queries, so the
+// hashes of the types it accepts must be stable across processes. The other
+// types are only reachable through APPROX_COUNT_DISTINCT, whose sketch never
+// leaves the query, and use Value::HashCode() which is consistent with the
+// equality used by COUNT(DISTINCT).
+absl::StatusOr<uint64_t> HllHash(const Value& value,
+                                 const ZetaSqlCollator* collator) {
+  switch (value.type_kind()) {
+    case TYPE_INT64:
+    case TYPE_UINT64: {
+      char buffer[sizeof(uint64_t)];
+      zetasql_base::LittleEndian::Store64(
+          buffer, value.type_kind() == TYPE_INT64
+                      ? static_cast<uint64_t>(value.int64_value())
+                      : value.uint64_value());
+      return farmhash::Fingerprint64(buffer, sizeof(buffer));
+    }
+    case TYPE_NUMERIC:
+      return farmhash::Fingerprint64(
+          value.numeric_value().SerializeAsProtoBytes());
+    case TYPE_BIGNUMERIC:
+      return farmhash::Fingerprint64(
+          value.bignumeric_value().SerializeAsProtoBytes());
+    case TYPE_STRING: {
+      if (collator == nullptr || collator->IsBinaryComparison()) {
+        return farmhash::Fingerprint64(value.string_value());
+      }
+      absl::Cord sort_key;
+      ZETASQL_RETURN_IF_ERROR(
+          collator->GetSortKeyUtf8(value.string_value(), &sort_key));
+      return farmhash::Fingerprint64(std::string(sort_key));
+    }
+    case TYPE_BYTES:
+      return farmhash::Fingerprint64(value.bytes_value());
+    default:
+      return static_cast<uint64_t>(value.HashCode());
+  }
+}
+
+// Accumulator implementation for HllCountFunction.
+class HllCountAccumulator : public AggregateAccumulator {
+ public:
+  static absl::StatusOr<std::unique_ptr<HllCountAccumulator>> Create(
+      const HllCountFunction* function, absl::Span<const Value> args,
+      CollatorList collator_list, EvaluationContext* context) {
+    int precision = HllSketch::kDefaultPrecision;
+    if (function->kind() == FunctionKind::kHllCountInit && !args.empty()) {
+      ZETASQL_RET_CHECK_EQ(args.size(), 1);
+      if (args[0].is_null()) {
+        return ::zetasql_base::OutOfRangeErrorBuilder()
+               << "Precision of HLL_COUNT.INIT must not be NULL";
+      }
+      precision = args[0].int64_value();
+      if (precision < HllSketch::kMinPrecision ||
+          precision > HllSketch::kMaxPrecision) {
+        return ::zetasql_base::OutOfRangeErrorBuilder()
+               << "Precision of HLL_COUNT.INIT must be between "
+               << HllSketch::kMinPrecision << " and "
+               << HllSketch::kMaxPrecision << ", but was " << precision;
+      }
+    }
+    ZETASQL_RET_CHECK_LE(collator_list.size(), 1);
+    auto accumulator = absl::WrapUnique(new HllCountAccumulator(
+        function, precision,
+        collator_list.empty() ? nullptr : std::move(collator_list[0]),
+        context));
+    ZETASQL_RETURN_IF_ERROR(accumulator->Reset());
+    return accumulator;
+  }
+
+  HllCountAccumulator(const HllCountAccumulator&) = delete;
+  HllCountAccumulator& operator=(const HllCountAccumulator&) = delete;
+
+  ~HllCountAccumulator() override {
+    context_->memory_accountant()->ReturnBytes(requested_bytes_);
+  }
+
+  absl::Status Reset() final {
+    sketch_.reset();
+    return UpdateRequestedBytes();
+  }
+
+  bool Accumulate(const Value& value, bool* stop_accumulation,
+                  absl::Status* status) override {
+    *stop_accumulation = false;
+    if (value.is_null()) return true;
+    *status = AccumulateInternal(value);
+    if (status->ok()) *status = UpdateRequestedBytes();
+    return status->ok();
+  }
+
+  absl::StatusOr<Value> GetFinalResult(bool inputs_in_defined_order) override {
+    switch (function_->kind()) {
+      case FunctionKind::kApproxCountDistinct:
+      case FunctionKind::kHllCountMerge:
+        return Value::Int64(sketch_.has_value() ? sketch_->Estimate() : 0);
+      case FunctionKind::kHllCountInit:
+      case FunctionKind::kHllCountMergePartial:
+        return sketch_.has_value() ? Value::Bytes(sketch_->Serialize())
+                                   : Value::NullBytes();
+      default:
+        ZETASQL_RET_CHECK_FAIL() << "Unexpected function kind: "
+                         << function_->debug_name();
+    }
+  }
+
+ private:
+  HllCountAccumulator(const HllCountFunction* function, int precision,
+                      std::unique_ptr<const ZetaSqlCollator> collator,
+                      EvaluationContext* context)
+      : function_(function),
+        precision_(precision),
+        collator_(std::move(collator)),
+        context_(context) {}
+
+  absl::Status AccumulateInternal(const Value& value) {
+    switch (function_->kind()) {
+      case FunctionKind::kApproxCountDistinct:
+      case FunctionKind::kHllCountInit: {
+        if (!sketch_.has_value()) {
+          const uint8_t value_tag = static_cast<uint8_t>(value.type_kind());
+          ZETASQL_ASSIGN_OR_RETURN(sketch_,
+                           HllSketch::Create(precision_, value_tag));
+        }
+        ZETASQL_ASSIGN_OR_RETURN(const uint64_t hash,
+                         HllHash(value, collator_.get()));
+        sketch_->AddHash(hash);
+        return absl::OkStatus();
+      }
+      case FunctionKind::kHllCountMerge:
+      case FunctionKind::kHllCountMergePartial: {
+        absl::StatusOr<HllSketch> sketch =
+            HllSketch::Deserialize(value.bytes_value());
+        absl::Status merge_status = sketch.status();
+        if (merge_status.ok()) {
+          if (sketch_.has_value()) {
+            merge_status = sketch_->Merge(*sketch);
+          } else {
+            sketch_ = std::move(sketch).value();
+          }
+        }
+        if (!merge_status.ok()) {
+          return ::zetasql_base::OutOfRangeErrorBuilder()
+                 << "Invalid or incompatible sketch in "
+                 << (function_->kind() == FunctionKind::kHllCountMerge
+                         ? "HLL_COUNT.MERGE"
+                         : "HLL_COUNT.MERGE_PARTIAL");
+        }
+        return absl::OkStatus();
+      }
+      default:
+        ZETASQL_RET_CHECK_FAIL() << "Unexpected function kind: "
+                         << function_->debug_name();
+    }
+  }
+
+  // Brings the bytes requested from the memory accountant in line with the
+  // current size of the sketch.
+  absl::Status UpdateRequestedBytes() {
+    const int64_t bytes =
+        sizeof(*this) + (sketch_.has_value() ? sketch_->MemoryUsage() : 0);
+    if (bytes > requested_bytes_) {
+      absl::Status status;
+      if (!context_->memory_accountant()->RequestBytes(
+              bytes - requested_bytes_, &status)) {
+        return status;
+      }
+    } else {
+      context_->memory_accountant()->ReturnBytes(requested_bytes_ - bytes);
+    }
+    requested_bytes_ = bytes;
+    return absl::OkStatus();
+  }
+
+  const HllCountFunction* function_;
+  const int precision_;
+  const std::unique_ptr<const ZetaSqlCollator> collator_;
+  EvaluationContext* context_;
+
+  int64_t requested_bytes_ = 0;
+  absl::optional<HllSketch> sketch_;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<AggregateAccumulator>>
+HllCountFunction::CreateAccumulator(absl::Span<const Value> args,
+                                    CollatorList collator_list,
+                                    EvaluationContext* context) const {
+  return HllCountAccumulator::Create(this, args, std::move(collator_list),
+                                     context);
+}
+
+namespace {
+
+// The largest number of quantiles or top entries that APPROX_QUANTILES,
+// APPROX_TOP_COUNT and APPROX_TOP_SUM can return.
+constexpr int64_t kMaxApproxAggregateNumber = 100000;
+
+// Validates the non-aggregate 'number' argument of APPROX_QUANTILES,
+// APPROX_TOP_COUNT or APPROX_TOP_SUM, which is the only element of 'args'.
+absl::StatusOr<int64_t> GetApproxAggregateNumber(
+    absl::Span<const Value> args, absl::string_view function_name) {
+  ZETASQL_RET_CHECK_EQ(args.size(), 1);
+  ZETASQL_RET_CHECK(args[0].type()->IsInt64());
+  if (args[0].is_null()) {
+    return ::zetasql_base::OutOfRangeErrorBuilder()
+           << "The second argument to " << function_name
+           << " function must not be NULL";
+  }
+  const int64_t number = args[0].int64_value();
+  if (number <= 0) {
+    return ::zetasql_base::OutOfRangeErrorBuilder()
+           << "The second argument to " << function_name
+           << " function must be positive";
+  }
+  if (number > kMaxApproxAggregateNumber) {
+    return ::zetasql_base::OutOfRangeErrorBuilder()
+           << "The second argument to " << function_name
+           << " function cannot be greater than " << kMaxApproxAggregateNumber;
+  }
+  return number;
+}
+
+// Brings the bytes requested from 'accountant' from '*requested_bytes' to
+// 'bytes'.
+absl::Status UpdateRequestedBytes(int64_t bytes, int64_t* requested_bytes,
+                                  MemoryAccountant* accountant) {
+  if (bytes > *requested_bytes) {
+    absl::Status status;
+    if (!accountant->RequestBytes(bytes - *requested_bytes, &status)) {
+      return status;
+    }
+  } else {
+    accountant->ReturnBytes(*requested_bytes - bytes);
+  }
+  *requested_bytes = bytes;
+  return absl::OkStatus();
+}
+
+struct ValueLess {
+  bool operator()(const Value& a, const Value& b) const {
+    return a.LessThan(b);
+  }
+};
+
+// Accumulator implementation for ApproxQuantilesFunction.
+class ApproxQuantilesAccumulator : public AggregateAccumulator {
+ public:
+  static absl::StatusOr<std::unique_ptr<ApproxQuantilesAccumulator>> Create(
+      const ApproxQuantilesFunction* function, absl::Span<const Value> args,
+      EvaluationContext* context) {
+    ZETASQL_ASSIGN_OR_RETURN(const int64_t number,
+                     GetApproxAggregateNumber(args, "APPROX_QUANTILES"));
+    auto accumulator = absl::WrapUnique(
+        new ApproxQuantilesAccumulator(function, number, context));
+    ZETASQL_RETURN_IF_ERROR(accumulator->Reset());
+    return accumulator;
+  }
+
+  ApproxQuantilesAccumulator(const ApproxQuantilesAccumulator&) = delete;
+  ApproxQuantilesAccumulator& operator=(const ApproxQuantilesAccumulator&) =
+      delete;
+
+  ~ApproxQuantilesAccumulator() override {
+    context_->memory_accountant()->ReturnBytes(requested_bytes_);
+  }
+
+  absl::Status Reset() final {
+    sketch_ = Sketch(SketchK());
+    retained_bytes_ = 0;
+    return UpdateRequestedBytes(sizeof(*this), &requested_bytes_,
+                                context_->memory_accountant());
+  }
+
+  bool Accumulate(const Value& value, bool* stop_accumulation,
+                  absl::Status* status) override {
+    *stop_accumulation = false;
+    const int64_t num_retained = sketch_.num_retained();
+    retained_bytes_ += value.physical_byte_size();
+    sketch_.Add(value);
+    if (sketch_.num_retained() <= num_retained) {
+      // The sketch compacted some of its items.
+      retained_bytes_ = 0;
+      sketch_.ForEachRetained([this](const Value& item) {
+        retained_bytes_ += item.physical_byte_size();
+      });
+    }
+    *status = UpdateRequestedBytes(sizeof(*this) + retained_bytes_,
+                                   &requested_bytes_,
+                                   context_->memory_accountant());
+    return status->ok();
+  }
+
+  absl::StatusOr<Value> GetFinalResult(bool inputs_in_defined_order) override {
+    if (sketch_.empty()) {
+      return Value::Null(function_->output_type());
+    }
+    return Value::Array(function_->output_type()->AsArray(),
+                        sketch_.Quantiles(number_));
+  }
+
+ private:
+  using Sketch = KllSketch<Value, ValueLess>;
+
+  ApproxQuantilesAccumulator(const ApproxQuantilesFunction* function,
+                             int64_t number, EvaluationContext* context)
+      : function_(function), number_(number), context_(context) {}
+
+  int SketchK() const {
+    return static_cast<int>(std::min<int64_t>(
+        std::max(context_->options().approx_quantiles_sketch_k, number_),
+        std::numeric_limits<int>::max()));
+  }
+
+  const ApproxQuantilesFunction* function_;
+  const int64_t number_;
+  EvaluationContext* context_;
+
+  int64_t requested_bytes_ = 0;
+  // The sum of the physical sizes of the values retained by 'sketch_'.
+  int64_t retained_bytes_ = 0;
+  Sketch sketch_;
+};
+
+// Weight operations for APPROX_TOP_SUM, where the weights are INT64, UINT64,
+// DOUBLE, NUMERIC or BIGNUMERIC Values. NULL weights are ignored, so the sum
+// is NULL only if all the weights of a key are NULL.
+struct ApproxTopSumWeightOps {
+  absl::Status Add(const Value& weight, Value* sum) const {
+    if (weight.is_null()) return absl::OkStatus();
+    if (sum->is_null()) {
+      *sum = weight;
+      return absl::OkStatus();
+    }
+    switch (weight.type_kind()) {
+      case TYPE_INT64:
+        return AddAs<int64_t>(weight, sum);
+      case TYPE_UINT64:
+        return AddAs<uint64_t>(weight, sum);
+      case TYPE_DOUBLE:
+        return AddAs<double>(weight, sum);
+      case TYPE_NUMERIC:
+        return AddAs<NumericValue>(weight, sum);
+      case TYPE_BIGNUMERIC:
+        return AddAs<BigNumericValue>(weight, sum);
+      default:
+        ZETASQL_RET_CHECK_FAIL() << "Unsupported APPROX_TOP_SUM weight type: "
+                         << weight.type()->DebugString();
+    }
+  }
+
+  bool Less(const Value& a, const Value& b) const { return a.LessThan(b); }
+
+ private:
+  template <typename T>
+  static absl::Status AddAs(const Value& weight, Value* sum) {
+    T out;
+    absl::Status status;
+    if (!functions::Add<T>(sum->Get<T>(), weight.Get<T>(), &out, &status)) {
+      return status;
+    }
+    *sum = Value::Make<T>(out);
+    return absl::OkStatus();
+  }
+};
+
+// Returns true if 'weight' is an invalid APPROX_TOP_SUM weight.
+bool IsNegativeOrNanWeight(const Value& weight) {
+  if (weight.is_null()) return false;
+  switch (weight.type_kind()) {
+    case TYPE_INT64:
+      return weight.int64_value() < 0;
+    case TYPE_DOUBLE:
+      return weight.double_value() < 0 || std::isnan(weight.double_value());
+    case TYPE_NUMERIC:
+      return weight.numeric_value().Sign() < 0;
+    case TYPE_BIGNUMERIC:
+      return weight.bignumeric_value().Sign() < 0;
+    default:
+      return false;
+  }
+}
+
+// Accumulator implementation for ApproxTopFunction.
+class ApproxTopAccumulator : public AggregateAccumulator {
+ public:
+  static absl::StatusOr<std::unique_ptr<ApproxTopAccumulator>> Create(
+      const ApproxTopFunction* function, absl::Span<const Value> args,
+      EvaluationContext* context) {
+    const bool is_sum = function->kind() == FunctionKind::kApproxTopSum;
+    ZETASQL_ASSIGN_OR_RETURN(
+        const int64_t number,
+        GetApproxAggregateNumber(
+            args, is_sum ? "APPROX_TOP_SUM" : "APPROX_TOP_COUNT"));
+    auto accumulator =
+        absl::WrapUnique(new ApproxTopAccumulator(function, number, context));
+    ZETASQL_RETURN_IF_ERROR(accumulator->Reset());
+    return accumulator;
+  }
+
+  ApproxTopAccumulator(const ApproxTopAccumulator&) = delete;
+  ApproxTopAccumulator& operator=(const ApproxTopAccumulator&) = delete;
+
+  ~ApproxTopAccumulator() override {
+    context_->memory_accountant()->ReturnBytes(requested_bytes_);
+  }
+
+  absl::Status Reset() final {
+    const int64_t capacity =
+        std::max(context_->options().approx_top_sketch_capacity, number_);
+    sketch_ = Sketch(capacity);
+    retained_bytes_ = 0;
+    return UpdateRequestedBytes(sizeof(*this), &requested_bytes_,
+                                context_->memory_accountant());
+  }
+
+  bool Accumulate(const Value& value, bool* stop_accumulation,
+                  absl::Status* status) override {
+    *stop_accumulation = false;
+    const Value* key = &value;
+    Value weight = Value::Int64(1);
+    if (function_->kind() == FunctionKind::kApproxTopSum) {
+      // The input is a STRUCT<value, weight>.
+      key = &value.field(0);
+      weight = value.field(1);
+      if (IsNegativeOrNanWeight(weight)) {
+        *status = ::zetasql_base::OutOfRangeErrorBuilder()
+                  << "APPROX_TOP_SUM does not support negative or NaN weights "
+                     "in the second argument; got "
+                  << weight.DebugString();
+        return false;
+      }
+    }
+
+    const int64_t num_retained = sketch_.num_retained();
+    *status = sketch_.Add(*key, weight);
+    if (!status->ok()) return false;
+    if (sketch_.num_retained() > num_retained) {
+      retained_bytes_ +=
+          key->physical_byte_size() + weight.physical_byte_size();
+    } else if (sketch_.num_retained() < num_retained) {
+      // The sketch evicted some of its keys.
+      retained_bytes_ = 0;
+      sketch_.ForEachRetained([this](const Value& key, const Value& weight) {
+        retained_bytes_ +=
+            key.physical_byte_size() + weight.physical_byte_size();
+      });
+    }
+    *status = UpdateRequestedBytes(sizeof(*this) + retained_bytes_,
+                                   &requested_bytes_,
+                                   context_->memory_accountant());
+    return status->ok();
+  }
+
+  absl::StatusOr<Value> GetFinalResult(bool inputs_in_defined_order) override {
+    if (sketch_.empty()) {
+      return Value::Null(function_->output_type());
+    }
+    const ArrayType* array_type = function_->output_type()->AsArray();
+    const StructType* struct_type = array_type->element_type()->AsStruct();
+    ZETASQL_RET_CHECK_EQ(struct_type->num_fields(), 2);
+    std::vector<Value> elements;
+    for (auto& [key, weight] : sketch_.Top(number_)) {
+      elements.push_back(Value::Struct(struct_type, {key, weight}));
+    }
+    return Value::Array(array_type, elements);
+  }
+
+ private:
+  using Sketch = FrequentItemsSketch<Value, Value, absl::Hash<Value>,
+                                     std::equal_to<Value>,
+                                     ApproxTopSumWeightOps>;
+
+  ApproxTopAccumulator(const ApproxTopFunction* function, int64_t number,
+                       EvaluationContext* context)
+      : function_(function),
+        number_(number),
+        context_(context),
+        sketch_(/*capacity=*/1) {}
+
+  const ApproxTopFunction* function_;
+  const int64_t number_;
+  EvaluationContext* context_;
+
+  int64_t requested_bytes_ = 0;
+  // The sum of the physical sizes of the keys and weights in 'sketch_'.
+  int64_t retained_bytes_ = 0;
+  // APPROX_TOP_COUNT uses INT64 weights of 1.
+  Sketch sketch_;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<AggregateAccumulator>>
+ApproxQuantilesFunction::CreateAccumulator(absl::Span<const Value> args,
+                                           CollatorList collator_list,
+                                           EvaluationContext* context) const {
+  ZETASQL_RET_CHECK(collator_list.empty());
+  return ApproxQuantilesAccumulator::Create(this, args, context);
+}
+
+absl::StatusOr<std::unique_ptr<AggregateAccumulator>>
+ApproxTopFunction::CreateAccumulator(absl::Span<const Value> args,
+                                     CollatorList collator_list,
+                                     EvaluationContext* context) const {
+  ZETASQL_RET_CHECK(collator_list.empty());
+  return ApproxTopAccumulator::Create(this, args, context);
+}
+
+absl::StatusOr<Value> HllCountExtractFunction::Eval(
+    absl::Span<const Value> args, EvaluationContext* context) const {
+  ZETASQL_RET_CHECK_EQ(1, args.size());
+  if (args[0].is_null()) {
+    return Value::Int64(0);
+  }
+  absl::StatusOr<HllSketch> sketch =
+      HllSketch::Deserialize(args[0].bytes_value());
+  if (!sketch.ok()) {
+    return ::zetasql_base::OutOfRangeErrorBuilder()
+           << "Invalid sketch in HLL_COUNT.EXTRACT";
+  }
+  return Value::Int64(sketch->Estimate());
+}
+
 namespace {
 absl::StatusOr<Value> LikeImpl(const Value& lhs, const Value& rhs,
-                               const RE2* regexp) {
+                               const RE2* regexp, EvaluationContext* context) {
   if (lhs.is_null() || rhs.is_null()) {
     return Value::Null(types::BoolType());
   }
@@ -4985,6 +5647,10 @@ absl::StatusOr<Value> LikeImpl(const Value& lhs, const Value& rhs,
     std::unique_ptr<RE2> regexp;
     ZETASQL_RETURN_IF_ERROR(
         functions::CreateLikeRegexp(pattern, lhs.type_kind(), &regexp));
+    if (EvaluationCounters* counters = context->counters();
+        counters != nullptr) {
+      ++counters->num_regexps_compiled;
+    }
     return Value::Bool(RE2::FullMatch(text, *regexp));
   }
 }
@@ -5002,7 +5668,7 @@ bool IsFalse(const Value& value) {
 absl::StatusOr<Value> LikeFunction::Eval(absl::Span<const Value> args,
                                          EvaluationContext* context) const {
   ZETASQL_CHECK_EQ(2, args.size());
-  return LikeImpl(args[0], args[1], regexp_.get());
+  return LikeImpl(args[0], args[1], regexp_.get(), context);
 }
 
 absl::StatusOr<Value> LikeAnyFunction::Eval(absl::Span<const Value> args,
@@ -5017,8 +5683,9 @@ absl::StatusOr<Value> LikeAnyFunction::Eval(absl::Span<const Value> args,
   Value result = Value::Bool(false);
 
   for (int i = 1; i < args.size(); ++i) {
-    ZETASQL_ASSIGN_OR_RETURN(Value local_result,
-                     LikeImpl(args[0], args[i], regexp_[i - 1].get()));
+    ZETASQL_ASSIGN_OR_RETURN(
+        Value local_result,
+        LikeImpl(args[0], args[i], regexp_[i - 1].get(), context));
     if (!IsTrue(result) && !IsFalse(local_result)) {
       result = local_result;
     }
@@ -5038,8 +5705,9 @@ absl::StatusOr<Value> LikeAllFunction::Eval(absl::Span<const Value> args,
   Value result = Value::Bool(true);
 
   for (int i = 1; i < args.size(); ++i) {
-    ZETASQL_ASSIGN_OR_RETURN(Value local_result,
-                     LikeImpl(args[0], args[i], regexp_[i - 1].get()));
+    ZETASQL_ASSIGN_OR_RETURN(
+        Value local_result,
+        LikeImpl(args[0], args[i], regexp_[i - 1].get(), context));
     if (!IsFalse(result) && !IsTrue(local_result)) {
       result = local_result;
     }
@@ -5634,72 +6302,55 @@ bool StringFunction::Eval(absl::Span<const Value> args,
       return InvokeString<std::string>(
           &functions::CodePointToString, result, status, args[0].int64_value());
     case FCT_TYPE_ARITY(FunctionKind::kSubstr, TYPE_STRING, 2):
-      return InvokeString<absl::string_view>(&functions::SubstrUtf8, result,
-                                             status, args[0].string_value(),
-                                             args[1].int64_value());
+      return InvokeSlice(&functions::SubstrUtf8, result, status, args[0],
+                         args[1].int64_value());
     case FCT_TYPE_ARITY(FunctionKind::kSubstr, TYPE_STRING, 3):
-      return InvokeString<absl::string_view>(
-          &functions::SubstrWithLengthUtf8, result, status,
-          args[0].string_value(), args[1].int64_value(), args[2].int64_value());
+      return InvokeSlice(&functions::SubstrWithLengthUtf8, result, status,
+                         args[0], args[1].int64_value(), args[2].int64_value());
     case FCT_TYPE_ARITY(FunctionKind::kSubstr, TYPE_BYTES, 2):
-      return InvokeBytes<absl::string_view>(&functions::SubstrBytes, result,
-                                            status, args[0].bytes_value(),
-                                            args[1].int64_value());
+      return InvokeSlice(&functions::SubstrBytes, result, status, args[0],
+                         args[1].int64_value());
     case FCT_TYPE_ARITY(FunctionKind::kSubstr, TYPE_BYTES, 3):
-      return InvokeBytes<absl::string_view>(
-          &functions::SubstrWithLengthBytes, result, status,
-          args[0].bytes_value(), args[1].int64_value(), args[2].int64_value());
+      return InvokeSlice(&functions::SubstrWithLengthBytes, result, status,
+                         args[0], args[1].int64_value(), args[2].int64_value());
     case FCT_TYPE_ARITY(FunctionKind::kTrim, TYPE_STRING, 1):
-      return InvokeString<absl::string_view>(&functions::TrimSpacesUtf8, result,
-                                             status, args[0].string_value());
+      return InvokeSlice(&functions::TrimSpacesUtf8, result, status, args[0]);
     case FCT_TYPE_ARITY(FunctionKind::kTrim, TYPE_STRING, 2):
-      return InvokeString<absl::string_view>(&functions::TrimUtf8, result,
-                                             status, args[0].string_value(),
-                                             args[1].string_value());
+      return InvokeSlice(&functions::TrimUtf8, result, status, args[0],
+                         args[1].string_value());
     case FCT_TYPE_ARITY(FunctionKind::kTrim, TYPE_BYTES, 2):
-      return InvokeBytes<absl::string_view>(&functions::TrimBytes, result,
-                                            status, args[0].bytes_value(),
-                                            args[1].bytes_value());
+      return InvokeSlice(&functions::TrimBytes, result, status, args[0],
+                         args[1].bytes_value());
     case FCT_TYPE_ARITY(FunctionKind::kLtrim, TYPE_STRING, 1):
-      return InvokeString<absl::string_view>(&functions::LeftTrimSpacesUtf8,
-                                             result, status,
-                                             args[0].string_value());
+      return InvokeSlice(&functions::LeftTrimSpacesUtf8, result, status,
+                         args[0]);
     case FCT_TYPE_ARITY(FunctionKind::kLtrim, TYPE_STRING, 2):
-      return InvokeString<absl::string_view>(&functions::LeftTrimUtf8, result,
-                                             status, args[0].string_value(),
-                                             args[1].string_value());
+      return InvokeSlice(&functions::LeftTrimUtf8, result, status, args[0],
+                         args[1].string_value());
     case FCT_TYPE_ARITY(FunctionKind::kLtrim, TYPE_BYTES, 2):
-      return InvokeBytes<absl::string_view>(&functions::LeftTrimBytes, result,
-                                            status, args[0].bytes_value(),
-                                            args[1].bytes_value());
+      return InvokeSlice(&functions::LeftTrimBytes, result, status, args[0],
+                         args[1].bytes_value());
     case FCT_TYPE_ARITY(FunctionKind::kRtrim, TYPE_STRING, 1):
-      return InvokeString<absl::string_view>(&functions::RightTrimSpacesUtf8,
-                                             result, status,
-                                             args[0].string_value());
+      return InvokeSlice(&functions::RightTrimSpacesUtf8, result, status,
+                         args[0]);
     case FCT_TYPE_ARITY(FunctionKind::kRtrim, TYPE_STRING, 2):
-      return InvokeString<absl::string_view>(&functions::RightTrimUtf8, result,
-                                             status, args[0].string_value(),
-                                             args[1].string_value());
+      return InvokeSlice(&functions::RightTrimUtf8, result, status, args[0],
+                         args[1].string_value());
     case FCT_TYPE_ARITY(FunctionKind::kRtrim, TYPE_BYTES, 2):
-      return InvokeBytes<absl::string_view>(&functions::RightTrimBytes, result,
-                                            status, args[0].bytes_value(),
-                                            args[1].bytes_value());
+      return InvokeSlice(&functions::RightTrimBytes, result, status, args[0],
+                         args[1].bytes_value());
     case FCT_TYPE_ARITY(FunctionKind::kLeft, TYPE_STRING, 2):
-      return InvokeString<absl::string_view>(&functions::LeftUtf8, result,
-                                             status, args[0].string_value(),
-                                             args[1].int64_value());
+      return InvokeSlice(&functions::LeftUtf8, result, status, args[0],
+                         args[1].int64_value());
     case FCT_TYPE_ARITY(FunctionKind::kLeft, TYPE_BYTES, 2):
-      return InvokeBytes<absl::string_view>(&functions::LeftBytes, result,
-                                            status, args[0].bytes_value(),
-                                            args[1].int64_value());
+      return InvokeSlice(&functions::LeftBytes, result, status, args[0],
+                         args[1].int64_value());
     case FCT_TYPE_ARITY(FunctionKind::kRight, TYPE_STRING, 2):
-      return InvokeString<absl::string_view>(&functions::RightUtf8, result,
-                                             status, args[0].string_value(),
-                                             args[1].int64_value());
+      return InvokeSlice(&functions::RightUtf8, result, status, args[0],
+                         args[1].int64_value());
     case FCT_TYPE_ARITY(FunctionKind::kRight, TYPE_BYTES, 2):
-      return InvokeBytes<absl::string_view>(&functions::RightBytes, result,
-                                            status, args[0].bytes_value(),
-                                            args[1].int64_value());
+      return InvokeSlice(&functions::RightBytes, result, status, args[0],
+                         args[1].int64_value());
     case FCT_TYPE_ARITY(FunctionKind::kReplace, TYPE_BYTES, 3):
       return InvokeBytes<std::string>(
           &functions::ReplaceBytes, result, status, args[0].bytes_value(),
@@ -5848,6 +6499,10 @@ absl::StatusOr<Value> RegexpFunction::Eval(absl::Span<const Value> args,
   if (regexp == nullptr) {
     ZETASQL_ASSIGN_OR_RETURN(runtime_regexp, CreateRegexp(args[1]));
     regexp = runtime_regexp.get();
+    if (EvaluationCounters* counters = context->counters();
+        counters != nullptr) {
+      ++counters->num_regexps_compiled;
+    }
   }
   switch (FCT(kind(), args[0].type_kind())) {
     case FCT(FunctionKind::kRegexpContains, TYPE_STRING): {
@@ -5895,27 +6550,29 @@ absl::StatusOr<Value> SplitFunction::Eval(absl::Span<const Value> args,
                                           EvaluationContext* context) const {
   if (HasNulls(args)) return Value::Null(output_type());
   absl::Status status;
-  std::vector<std::string> parts;
+  std::vector<absl::string_view> parts;
   std::vector<Value> values;
   if (args[0].type()->kind() == TYPE_STRING) {
     const std::string& delimiter =
         (args.size() == 1) ? "," : args[1].string_value();
-    if (!functions::SplitUtf8(args[0].string_value(), delimiter, &parts,
-                              &status)) {
+    if (!functions::SplitUtf8(args[0].string_or_bytes_view(), delimiter,
+                              &parts, &status)) {
       return status;
     }
-    for (const std::string& s : parts) {
-      values.push_back(Value::String(s));
+    values.reserve(parts.size());
+    for (absl::string_view s : parts) {
+      values.push_back(Value::SliceOf(args[0], s));
     }
     return Value::Array(types::StringArrayType(), values);
   } else {
     absl::Status status;
-    if (!functions::SplitBytes(args[0].bytes_value(), args[1].bytes_value(),
-                               &parts, &status)) {
+    if (!functions::SplitBytes(args[0].string_or_bytes_view(),
+                               args[1].bytes_value(), &parts, &status)) {
       return status;
     }
-    for (const std::string& s : parts) {
-      values.push_back(Value::Bytes(s));
+    values.reserve(parts.size());
+    for (absl::string_view s : parts) {
+      values.push_back(Value::SliceOf(args[0], s));
     }
     return Value::Array(types::BytesArrayType(), values);
   }
@@ -6764,7 +7421,7 @@ absl::StatusOr<Value> StringConversionFunction::Eval(
                   .strict_number_parsing =
                       language_options.LanguageFeatureEnabled(
                           FEATURE_JSON_STRICT_NUMBER_PARSING)},
-              json_storage));
+              context, json_storage));
       ZETASQL_ASSIGN_OR_RETURN(result_string,
                        functions::ConvertJsonToString(json_value_const_ref));
     } break;
@@ -7464,13 +8121,28 @@ absl::StatusOr<Value> CollationKeyFunction::Eval(
     return Value::NullBytes();
   }
 
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<const ZetaSqlCollator> collator,
-                   MakeSqlCollator(args[1].string_value()));
+  ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<const ZetaSqlCollator> collator,
+                   GetCollator(args[1].string_value()));
+  if (collator->IsBinaryComparison()) {
+    // The sort key of a binary collation is the string itself.
+    return Value::Bytes(args[0].string_or_bytes_view());
+  }
   absl::Cord cord;
-  ZETASQL_RETURN_IF_ERROR(collator->GetSortKeyUtf8(args[0].string_value(), &cord));
+  ZETASQL_RETURN_IF_ERROR(
+      collator->GetSortKeyUtf8(args[0].string_or_bytes_view(), &cord));
   return Value::Bytes(cord.Flatten());
 }
 
+absl::StatusOr<std::shared_ptr<const ZetaSqlCollator>>
+CollationKeyFunction::GetCollator(absl::string_view collation_name) const {
+  absl::MutexLock lock(&mu_);
+  if (collator_ == nullptr || collation_name_ != collation_name) {
+    ZETASQL_ASSIGN_OR_RETURN(collator_, MakeSqlCollator(collation_name));
+    collation_name_ = std::string(collation_name);
+  }
+  return collator_;
+}
+
 absl::StatusOr<Value> CollateFunction::Eval(
     absl::Span<const Value> args, EvaluationContext* context) const {
   ZETASQL_RET_CHECK_EQ(args.size(), 2);
@@ -7506,6 +8178,10 @@ std::string UserDefinedScalarFunction::debug_name() const {
 bool UserDefinedScalarFunction::Eval(absl::Span<const Value> args,
                                      EvaluationContext* context, Value* result,
                                      absl::Status* status) const {
+  if (propagates_null_ && BuiltinScalarFunction::HasNulls(args)) {
+    *result = Value::Null(output_type());
+    return true;
+  }
   auto status_or_result = evaluator_(args);
   if (!status_or_result.ok()) {
     *status = status_or_result.status();
@@ -7525,6 +8201,82 @@ bool UserDefinedScalarFunction::Eval(absl::Span<const Value> args,
   return true;
 }
 
+namespace {
+
+// Accumulator implementation for UserDefinedAggregateFunction.
+class UserDefinedAggregateAccumulator : public AggregateAccumulator {
+ public:
+  UserDefinedAggregateAccumulator(
+      const UserDefinedAggregateFunction* function,
+      std::unique_ptr<AggregateFunctionEvaluator> evaluator)
+      : function_(function), evaluator_(std::move(evaluator)) {}
+
+  UserDefinedAggregateAccumulator(const UserDefinedAggregateAccumulator&) =
+      delete;
+  UserDefinedAggregateAccumulator& operator=(
+      const UserDefinedAggregateAccumulator&) = delete;
+
+  absl::Status Reset() final { return evaluator_->Reset(); }
+
+  bool Accumulate(const Value& value, bool* stop_accumulation,
+                  absl::Status* status) final {
+    *stop_accumulation = false;
+    // Functions of several arguments are fed a struct with one field per
+    // argument.
+    *status = function_->num_input_fields() == 1
+                  ? evaluator_->Accumulate(absl::MakeConstSpan(&value, 1))
+                  : evaluator_->Accumulate(value.fields());
+    return status->ok();
+  }
+
+  absl::StatusOr<Value> GetFinalResult(bool inputs_in_defined_order) final {
+    ZETASQL_ASSIGN_OR_RETURN(Value result, evaluator_->GetFinalResult());
+    if (!result.is_valid() ||
+        !function_->output_type()->Equals(result.type())) {
+      return ::zetasql_base::InternalErrorBuilder()
+             << "User-defined aggregate function " << function_->debug_name()
+             << " returned a bad result: " << result.DebugString(true) << "\n"
+             << "Expected value of type: "
+             << function_->output_type()->DebugString();
+    }
+    return result;
+  }
+
+ private:
+  const UserDefinedAggregateFunction* function_;
+  const std::unique_ptr<AggregateFunctionEvaluator> evaluator_;
+};
+
+}  // namespace
+
+std::string UserDefinedAggregateFunction::debug_name() const {
+  return absl::StrCat("UDA[", function_name_, "]");
+}
+
+absl::StatusOr<std::unique_ptr<AggregateFunctionEvaluator>>
+UserDefinedAggregateFunction::CreateEvaluator() const {
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<AggregateFunctionEvaluator> evaluator,
+                   evaluator_factory_(signature_));
+  if (evaluator == nullptr) {
+    return ::zetasql_base::InternalErrorBuilder()
+           << "NULL evaluator returned for user-defined aggregate function "
+           << function_name_;
+  }
+  return evaluator;
+}
+
+absl::StatusOr<std::unique_ptr<AggregateAccumulator>>
+UserDefinedAggregateFunction::CreateAccumulator(
+    absl::Span<const Value> args, CollatorList collator_list,
+    EvaluationContext* context) const {
+  ZETASQL_RET_CHECK(args.empty()) << debug_name();
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<AggregateFunctionEvaluator> evaluator,
+                   CreateEvaluator());
+  ZETASQL_RETURN_IF_ERROR(evaluator->Reset());
+  return absl::make_unique<UserDefinedAggregateAccumulator>(
+      this, std::move(evaluator));
+}
+
 std::string BuiltinAnalyticFunction::debug_name() const {
   return BuiltinFunctionCatalog::GetDebugNameByKind(kind_);
 }
@@ -8343,7 +9095,8 @@ absl::StatusOr<Value> TypeFunction::Eval(absl::Span<const Value> args,
           FEATURE_JSON_STRICT_NUMBER_PARSING)};
   ZETASQL_ASSIGN_OR_RETURN(
       JSONValueConstRef json_value_const_ref,
-      GetJSONValueConstRef(args[0], json_parsing_options, json_storage));
+      GetJSONValueConstRef(args[0], json_parsing_options, context,
+                           json_storage));
   ZETASQL_ASSIGN_OR_RETURN(const std::string output,
                    functions::GetJsonType(json_value_const_ref));
   return Value::String(output);
@@ -8367,7 +9120,8 @@ absl::StatusOr<Value> ConvertJsonFunction::Eval(
       ZETASQL_RET_CHECK_EQ(args.size(), 1);
       ZETASQL_ASSIGN_OR_RETURN(
           JSONValueConstRef json_value_const_ref,
-          GetJSONValueConstRef(args[0], json_parsing_options, json_storage));
+          GetJSONValueConstRef(args[0], json_parsing_options, context,
+                               json_storage));
       ZETASQL_ASSIGN_OR_RETURN(const int64_t output,
                        functions::ConvertJsonToInt64(json_value_const_ref));
       return Value::Int64(output);
@@ -8389,7 +9143,8 @@ absl::StatusOr<Value> ConvertJsonFunction::Eval(
           (wide_number_mode == functions::WideNumberMode::kExact);
       ZETASQL_ASSIGN_OR_RETURN(
           JSONValueConstRef json_value_const_ref,
-          GetJSONValueConstRef(args[0], json_parsing_options, json_storage));
+          GetJSONValueConstRef(args[0], json_parsing_options, context,
+                               json_storage));
       ZETASQL_ASSIGN_OR_RETURN(
           const double output,
           functions::ConvertJsonToDouble(json_value_const_ref, wide_number_mode,
@@ -8400,7 +9155,8 @@ absl::StatusOr<Value> ConvertJsonFunction::Eval(
       ZETASQL_RET_CHECK_EQ(args.size(), 1);
       ZETASQL_ASSIGN_OR_RETURN(
           JSONValueConstRef json_value_const_ref,
-          GetJSONValueConstRef(args[0], json_parsing_options, json_storage));
+          GetJSONValueConstRef(args[0], json_parsing_options, context,
+                               json_storage));
       ZETASQL_ASSIGN_OR_RETURN(const bool output,
                        functions::ConvertJsonToBool(json_value_const_ref));
       return Value::Bool(output);
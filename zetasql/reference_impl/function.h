@@ -30,6 +30,7 @@
 #include "google/protobuf/descriptor.h"
 #include "zetasql/public/function.h"
 #include "zetasql/public/functions/regexp.h"
+#include "zetasql/public/functions/string_format.h"
 #include "zetasql/public/language_options.h"
 #include "zetasql/public/proto/type_annotation.pb.h"
 #include "zetasql/public/type.h"
@@ -80,6 +81,8 @@ enum class FunctionKind {
   kAndAgg,  // private function that ANDs all input values incl. NULLs
   kAnyValue,
   kApproxCountDistinct,
+  kApproxQuantiles,
+  kApproxTopCount,
   kApproxTopSum,
   kArrayAgg,
   kArrayConcatAgg,
@@ -92,6 +95,10 @@ enum class FunctionKind {
   kCorr,
   kCovarPop,
   kCovarSamp,
+  kHllCountInit,
+  kHllCountMerge,
+  kHllCountMergePartial,
+  kHllCountExtract,
   kLogicalAnd,
   kLogicalOr,
   kMax,
@@ -477,6 +484,13 @@ class BuiltinScalarFunction : public ScalarFunctionBody {
       FunctionKind kind, const Type* output_type,
       const std::vector<std::unique_ptr<ValueExpr>>& arguments);
 
+  // Creates a FORMAT function, compiling the format string once if it is a
+  // constant.
+  static absl::StatusOr<std::unique_ptr<BuiltinScalarFunction>>
+  CreateFormatFunction(
+      ProductMode product_mode, const Type* output_type,
+      const std::vector<std::unique_ptr<ValueExpr>>& arguments);
+
   FunctionKind kind_;
 };
 
@@ -542,14 +556,74 @@ class BinaryStatFunction : public BuiltinAggregateFunction {
       EvaluationContext* context) const override;
 };
 
+// Implements APPROX_COUNT_DISTINCT and the HLL_COUNT.INIT, HLL_COUNT.MERGE and
+// HLL_COUNT.MERGE_PARTIAL aggregate functions on top of HllSketch, so that
+// the memory used per group is bounded by the sketch size rather than by the
+// number of distinct values.
+class HllCountFunction : public BuiltinAggregateFunction {
+ public:
+  HllCountFunction(FunctionKind kind, const Type* output_type,
+                   const Type* input_type)
+      : BuiltinAggregateFunction(kind, output_type, /*num_input_fields=*/1,
+                                 input_type, /*ignores_null=*/true) {}
+
+  HllCountFunction(const HllCountFunction&) = delete;
+  HllCountFunction& operator=(const HllCountFunction&) = delete;
+
+  absl::StatusOr<std::unique_ptr<AggregateAccumulator>> CreateAccumulator(
+      absl::Span<const Value> args, CollatorList collator_list,
+      EvaluationContext* context) const override;
+};
+
+// Implements APPROX_QUANTILES on top of a KllSketch, so that the memory used
+// per group is bounded by the sketch size rather than by the number of rows.
+class ApproxQuantilesFunction : public BuiltinAggregateFunction {
+ public:
+  ApproxQuantilesFunction(const Type* output_type, const Type* input_type,
+                          bool ignores_null)
+      : BuiltinAggregateFunction(FunctionKind::kApproxQuantiles, output_type,
+                                 /*num_input_fields=*/1, input_type,
+                                 ignores_null) {}
+
+  ApproxQuantilesFunction(const ApproxQuantilesFunction&) = delete;
+  ApproxQuantilesFunction& operator=(const ApproxQuantilesFunction&) = delete;
+
+  absl::StatusOr<std::unique_ptr<AggregateAccumulator>> CreateAccumulator(
+      absl::Span<const Value> args, CollatorList collator_list,
+      EvaluationContext* context) const override;
+};
+
+// Implements APPROX_TOP_COUNT and APPROX_TOP_SUM on top of a
+// FrequentItemsSketch, so that the memory used per group is bounded by the
+// sketch size rather than by the number of distinct values.
+class ApproxTopFunction : public BuiltinAggregateFunction {
+ public:
+  ApproxTopFunction(FunctionKind kind, const Type* output_type,
+                    int num_input_fields, const Type* input_type,
+                    bool ignores_null)
+      : BuiltinAggregateFunction(kind, output_type, num_input_fields,
+                                 input_type, ignores_null) {}
+
+  ApproxTopFunction(const ApproxTopFunction&) = delete;
+  ApproxTopFunction& operator=(const ApproxTopFunction&) = delete;
+
+  absl::StatusOr<std::unique_ptr<AggregateAccumulator>> CreateAccumulator(
+      absl::Span<const Value> args, CollatorList collator_list,
+      EvaluationContext* context) const override;
+};
+
+// If <propagates_null> is true, calls with a NULL argument return NULL without
+// invoking <evaluator>.
 class UserDefinedScalarFunction : public ScalarFunctionBody {
  public:
   UserDefinedScalarFunction(const FunctionEvaluator& evaluator,
                             const Type* output_type,
-                            const std::string& function_name)
+                            const std::string& function_name,
+                            bool propagates_null = false)
       : ScalarFunctionBody(output_type),
         evaluator_(evaluator),
-        function_name_(function_name) {}
+        function_name_(function_name),
+        propagates_null_(propagates_null) {}
   std::string debug_name() const override;
   bool Eval(absl::Span<const Value> args, EvaluationContext* context,
             Value* result, absl::Status* status) const override;
@@ -557,6 +631,44 @@ class UserDefinedScalarFunction : public ScalarFunctionBody {
  private:
   FunctionEvaluator evaluator_;
   const std::string function_name_;
+  const bool propagates_null_;
+};
+
+// An aggregate function whose groups are computed by the
+// AggregateFunctionEvaluators that <evaluator_factory> creates for
+// <signature>. The function is fed one field per argument of <signature>.
+class UserDefinedAggregateFunction : public AggregateFunctionBody {
+ public:
+  UserDefinedAggregateFunction(
+      const AggregateFunctionEvaluatorFactory& evaluator_factory,
+      const FunctionSignature& signature, const Type* output_type,
+      int num_input_fields, const Type* input_type, bool ignores_null,
+      const std::string& function_name)
+      : AggregateFunctionBody(output_type, num_input_fields, input_type,
+                              ignores_null),
+        evaluator_factory_(evaluator_factory),
+        signature_(signature),
+        function_name_(function_name) {}
+
+  UserDefinedAggregateFunction(const UserDefinedAggregateFunction&) = delete;
+  UserDefinedAggregateFunction& operator=(const UserDefinedAggregateFunction&) =
+      delete;
+
+  std::string debug_name() const override;
+
+  // Returns a new evaluator from <evaluator_factory_>, or an error if the
+  // factory fails or returns nullptr.
+  absl::StatusOr<std::unique_ptr<AggregateFunctionEvaluator>> CreateEvaluator()
+      const;
+
+  absl::StatusOr<std::unique_ptr<AggregateAccumulator>> CreateAccumulator(
+      absl::Span<const Value> args, CollatorList collator_list,
+      EvaluationContext* context) const override;
+
+ private:
+  const AggregateFunctionEvaluatorFactory evaluator_factory_;
+  const FunctionSignature signature_;
+  const std::string function_name_;
 };
 
 // Abstract built-in (non-aggregate) analytic function.
@@ -858,8 +970,33 @@ class FormatFunction : public SimpleBuiltinScalarFunction {
  public:
   explicit FormatFunction(const Type* output_type)
       : SimpleBuiltinScalarFunction(FunctionKind::kFormat, output_type) {}
+  // Formats every row with 'const_format', which was compiled from the
+  // constant 'format_string' for 'arg_types' in 'product_mode'.
+  FormatFunction(std::unique_ptr<functions::CompiledStringFormat> const_format,
+                 absl::string_view format_string,
+                 std::vector<const Type*> arg_types, ProductMode product_mode,
+                 const Type* output_type);
   absl::StatusOr<Value> Eval(absl::Span<const Value> args,
                              EvaluationContext* context) const override;
+
+ private:
+  // Returns an idle compiled format for the constant format string, compiling
+  // another one if all of them are in use by concurrent evaluations.
+  absl::StatusOr<std::unique_ptr<functions::CompiledStringFormat>>
+  AcquireConstFormat() const;
+  // Makes 'compiled' available to the next call to AcquireConstFormat.
+  void ReleaseConstFormat(
+      std::unique_ptr<functions::CompiledStringFormat> compiled) const;
+
+  // False if the format string is not a constant.
+  const bool has_const_format_ = false;
+  const std::string const_format_string_;
+  const std::vector<const Type*> arg_types_;
+  const ProductMode product_mode_ = PRODUCT_INTERNAL;
+
+  mutable absl::Mutex mu_;
+  mutable std::vector<std::unique_ptr<functions::CompiledStringFormat>>
+      idle_const_formats_ ABSL_GUARDED_BY(mu_);
 };
 
 class GenerateArrayFunction : public SimpleBuiltinScalarFunction {
@@ -1242,6 +1379,18 @@ class CollationKeyFunction : public SimpleBuiltinScalarFunction {
   using SimpleBuiltinScalarFunction::SimpleBuiltinScalarFunction;
   absl::StatusOr<Value> Eval(absl::Span<const Value> args,
                              EvaluationContext* context) const override;
+
+ private:
+  // Returns the collator for 'collation_name', reusing the one from the
+  // previous call if the name is the same, which is the common case of a
+  // constant collation name.
+  absl::StatusOr<std::shared_ptr<const ZetaSqlCollator>> GetCollator(
+      absl::string_view collation_name) const;
+
+  mutable absl::Mutex mu_;
+  mutable std::string collation_name_ ABSL_GUARDED_BY(mu_);
+  mutable std::shared_ptr<const ZetaSqlCollator> collator_
+      ABSL_GUARDED_BY(mu_);
 };
 
 class CollateFunction : public SimpleBuiltinScalarFunction {
@@ -1259,6 +1408,16 @@ class RandFunction : public SimpleBuiltinScalarFunction {
                              EvaluationContext* context) const override;
 };
 
+// Implements HLL_COUNT.EXTRACT(BYTES) -> INT64.
+class HllCountExtractFunction : public SimpleBuiltinScalarFunction {
+ public:
+  HllCountExtractFunction()
+      : SimpleBuiltinScalarFunction(FunctionKind::kHllCountExtract,
+                                    types::Int64Type()) {}
+  absl::StatusOr<Value> Eval(absl::Span<const Value> args,
+                             EvaluationContext* context) const override;
+};
+
 class ErrorFunction : public SimpleBuiltinScalarFunction {
  public:
   explicit ErrorFunction(const Type* output_type)
@@ -71,9 +71,7 @@ absl::StatusOr<Value> HashFunction::Eval(absl::Span<const Value> args,
     return Value::Null(output_type());
   }
 
-  const absl::string_view input = args[0].type_kind() == TYPE_BYTES
-                                      ? args[0].bytes_value()
-                                      : args[0].string_value();
+  const absl::string_view input = args[0].string_or_bytes_view();
 
   return Value::Bytes(hasher_->Hash(input));
 }
@@ -85,9 +83,7 @@ absl::StatusOr<Value> FarmFingerprintFunction::Eval(
     return Value::Null(output_type());
   }
 
-  const absl::string_view input = args[0].type_kind() == TYPE_BYTES
-                                      ? args[0].bytes_value()
-                                      : args[0].string_value();
+  const absl::string_view input = args[0].string_or_bytes_view();
 
   return Value::Int64(functions::FarmFingerprint(input));
 }
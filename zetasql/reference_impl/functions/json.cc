@@ -25,8 +25,10 @@
 #include "zetasql/public/json_value.h"
 #include "zetasql/public/type.pb.h"
 #include "zetasql/public/types/type_factory.h"
+#include "zetasql/reference_impl/evaluation.h"
 #include "zetasql/reference_impl/function.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "zetasql/base/ret_check.h"
 
 namespace zetasql {
@@ -49,6 +51,22 @@ void MaybeSetNonDeterministicContext(const Value& arg,
   }
 }
 
+// Records one JSON parse in the counters of <context>, if any.
+void CountJsonParse(EvaluationContext* context) {
+  if (EvaluationCounters* counters = context->counters(); counters != nullptr) {
+    ++counters->num_json_parses;
+  }
+}
+
+// Parses <json> like JSONValue::ParseJSONString, counting the parse in
+// <context>.
+absl::StatusOr<JSONValue> ParseJson(absl::string_view json,
+                                    JSONParsingOptions parsing_options,
+                                    EvaluationContext* context) {
+  CountJsonParse(context);
+  return JSONValue::ParseJSONString(json, parsing_options);
+}
+
 // Implementation of:
 // JSON_EXTRACT/JSON_QUERY(string, string) -> string
 // JSON_EXTRACT/JSON_QUERY(json, string) -> json
@@ -134,15 +152,16 @@ absl::StatusOr<Value> JsonExtractString(
 // JSON_EXTRACT and JSON_EXTRACT_SCALAR.
 absl::StatusOr<Value> JsonExtractJson(
     const functions::JsonPathEvaluator& evaluator, const Value& json,
-    const Type* output_type, bool scalar, JSONParsingOptions parsing_options) {
+    const Type* output_type, bool scalar, JSONParsingOptions parsing_options,
+    EvaluationContext* context) {
   if (scalar) {
     absl::optional<std::string> output_string_or;
     if (json.is_validated_json()) {
       output_string_or = evaluator.ExtractScalar(json.json_value());
     } else {
-      ZETASQL_ASSIGN_OR_RETURN(JSONValue input_json,
-                       JSONValue::ParseJSONString(json.json_value_unparsed(),
-                                                  parsing_options));
+      ZETASQL_ASSIGN_OR_RETURN(
+          JSONValue input_json,
+          ParseJson(json.json_value_unparsed(), parsing_options, context));
       output_string_or = evaluator.ExtractScalar(input_json.GetConstRef());
     }
     if (output_string_or.has_value()) {
@@ -154,9 +173,8 @@ absl::StatusOr<Value> JsonExtractJson(
     if (json.is_validated_json()) {
       output_json_or = evaluator.Extract(json.json_value());
     } else {
-      ZETASQL_ASSIGN_OR_RETURN(input_json,
-                       JSONValue::ParseJSONString(json.json_value_unparsed(),
-                                                  parsing_options));
+      ZETASQL_ASSIGN_OR_RETURN(input_json, ParseJson(json.json_value_unparsed(),
+                                             parsing_options, context));
       output_json_or = evaluator.Extract(input_json.GetConstRef());
     }
     if (output_json_or.has_value()) {
@@ -180,14 +198,14 @@ absl::StatusOr<Value> JsonSubscriptFunction::Eval(
     const auto& language_options = context->GetLanguageOptions();
     ZETASQL_ASSIGN_OR_RETURN(
         input_json,
-        JSONValue::ParseJSONString(
-            args[0].json_value_unparsed(),
-            JSONParsingOptions{
-                .legacy_mode = language_options.LanguageFeatureEnabled(
-                    FEATURE_JSON_LEGACY_PARSE),
-                .strict_number_parsing =
-                    language_options.LanguageFeatureEnabled(
-                        FEATURE_JSON_STRICT_NUMBER_PARSING)}));
+        ParseJson(args[0].json_value_unparsed(),
+                  JSONParsingOptions{
+                      .legacy_mode = language_options.LanguageFeatureEnabled(
+                          FEATURE_JSON_LEGACY_PARSE),
+                      .strict_number_parsing =
+                          language_options.LanguageFeatureEnabled(
+                              FEATURE_JSON_STRICT_NUMBER_PARSING)},
+                  context));
     json_value_const_ref = input_json.GetConstRef();
   }
   ZETASQL_RET_CHECK(json_value_const_ref.has_value());
@@ -233,6 +251,8 @@ absl::StatusOr<Value> JsonFunction::Eval(absl::Span<const Value> args,
   bool scalar = kind() == FunctionKind::kJsonValue ||
                 kind() == FunctionKind::kJsonExtractScalar;
   if (args[0].type_kind() == TYPE_STRING) {
+    // The evaluator parses the JSON text while extracting from it.
+    CountJsonParse(context);
     return JsonExtractString(*evaluator, args[0].string_value(),
                              scalar);
   } else {
@@ -243,7 +263,8 @@ absl::StatusOr<Value> JsonFunction::Eval(absl::Span<const Value> args,
             .legacy_mode = language_options.LanguageFeatureEnabled(
                 FEATURE_JSON_LEGACY_PARSE),
             .strict_number_parsing = language_options.LanguageFeatureEnabled(
-                FEATURE_JSON_STRICT_NUMBER_PARSING)});
+                FEATURE_JSON_STRICT_NUMBER_PARSING)},
+        context);
   }
 }
 
@@ -289,14 +310,14 @@ absl::StatusOr<Value> JsonExtractArrayString(
 // JSON_EXTRACT_STRING_ARRAY.
 absl::StatusOr<Value> JsonExtractStringArrayJson(
     const functions::JsonPathEvaluator& evaluator, const Value& json,
-    JSONParsingOptions parsing_options) {
+    JSONParsingOptions parsing_options, EvaluationContext* context) {
   absl::optional<std::vector<absl::optional<std::string>>> output;
   if (json.is_validated_json()) {
     output = evaluator.ExtractStringArray(json.json_value());
   } else {
-    ZETASQL_ASSIGN_OR_RETURN(JSONValue input_json,
-                     JSONValue::ParseJSONString(json.json_value_unparsed(),
-                                                parsing_options));
+    ZETASQL_ASSIGN_OR_RETURN(
+        JSONValue input_json,
+        ParseJson(json.json_value_unparsed(), parsing_options, context));
     output = evaluator.ExtractStringArray(input_json.GetConstRef());
   }
   if (output.has_value()) {
@@ -319,15 +340,14 @@ absl::StatusOr<Value> JsonExtractStringArrayJson(
 // JSON_EXTRACT_ARRAY.
 absl::StatusOr<Value> JsonExtractArrayJson(
     const functions::JsonPathEvaluator& evaluator, const Value& json,
-    JSONParsingOptions parsing_options) {
+    JSONParsingOptions parsing_options, EvaluationContext* context) {
   absl::optional<std::vector<JSONValueConstRef>> output;
   JSONValue input_json;
   if (json.is_validated_json()) {
     output = evaluator.ExtractArray(json.json_value());
   } else {
-    ZETASQL_ASSIGN_OR_RETURN(input_json,
-                     JSONValue::ParseJSONString(json.json_value_unparsed(),
-                                                parsing_options));
+    ZETASQL_ASSIGN_OR_RETURN(input_json, ParseJson(json.json_value_unparsed(),
+                                           parsing_options, context));
     output = evaluator.ExtractArray(input_json.GetConstRef());
   }
   if (output.has_value()) {
@@ -366,6 +386,8 @@ absl::StatusOr<Value> JsonArrayFunction::Eval(
   bool scalar = kind() == FunctionKind::kJsonValueArray ||
                 kind() == FunctionKind::kJsonExtractStringArray;
   if (args[0].type_kind() == TYPE_STRING) {
+    // The evaluator parses the JSON text while extracting from it.
+    CountJsonParse(context);
     return scalar ? JsonExtractStringArrayString(*evaluator,
                                                  args[0].string_value())
                   : JsonExtractArrayString(*evaluator, args[0].string_value());
@@ -378,8 +400,9 @@ absl::StatusOr<Value> JsonArrayFunction::Eval(
             FEATURE_JSON_STRICT_NUMBER_PARSING)};
 
     return scalar ? JsonExtractStringArrayJson(*evaluator, args[0],
-                                               parsing_options)
-                  : JsonExtractArrayJson(*evaluator, args[0], parsing_options);
+                                               parsing_options, context)
+                  : JsonExtractArrayJson(*evaluator, args[0], parsing_options,
+                                         context);
   }
 }
 
@@ -436,7 +459,7 @@ absl::StatusOr<Value> ParseJsonFunction::Eval(
       .legacy_mode = context->GetLanguageOptions().LanguageFeatureEnabled(
           FEATURE_JSON_LEGACY_PARSE),
       .strict_number_parsing = (args[1].string_value() == "exact")};
-  auto result = JSONValue::ParseJSONString(args[0].string_value(), options);
+  auto result = ParseJson(args[0].string_value(), options, context);
   if (!result.ok()) {
     return MakeEvalError() << "Invalid input to PARSE_JSON: "
                            << result.status().message();
@@ -51,6 +51,7 @@
 #include "google/protobuf/descriptor.h"
 #include "zetasql/public/catalog.h"
 #include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/table_valued_function.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
 #include "zetasql/reference_impl/common.h"
@@ -63,6 +64,7 @@
 #include "zetasql/resolved_ast/resolved_column.h"
 #include "zetasql/resolved_ast/resolved_node.h"
 #include <cstdint>
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/hash/hash.h"
 #include "absl/memory/memory.h"
@@ -195,8 +197,17 @@ class CppValueArg : public AlgebraArg {
   CppValueArg(const CppValueArg&) = delete;
   CppValueArg& operator=(const CppValueArg&) = delete;
 
+  // Sets the schemas of the 'params' that are passed to CreateValue().
+  virtual absl::Status SetSchemasForEvaluation(
+      absl::Span<const TupleSchema* const> params_schemas) {
+    return absl::OkStatus();
+  }
+
   // Creates a C++ value to represent the variable passed to the constructor.
+  // 'params' are those of the operator that assigns the variable, and outlive
+  // the value.
   virtual std::unique_ptr<CppValueBase> CreateValue(
+      absl::Span<const TupleData* const> params,
       EvaluationContext* context) const = 0;
 
   std::string DebugInternal(const std::string& indent,
@@ -1212,6 +1223,15 @@ class RelationalOp : public AlgebraNode {
       absl::Span<const TupleData* const> params, int num_extra_slots,
       EvaluationContext* context) const = 0;
 
+  // Calls CreateIterator(). If 'context' has an OperatorProfiler, records the
+  // OperatorStats of this operator and wraps the iterator to record those of
+  // its calls to Next(). Operators must create the iterators of their inputs
+  // with this method rather than CreateIterator(), so that every operator of
+  // a profiled query is measured.
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateProfiledIterator(
+      absl::Span<const TupleData* const> params, int num_extra_slots,
+      EvaluationContext* context) const;
+
   // Returns a copy of the output schema of the TupleIterator corresponding to
   // this operator.
   virtual std::unique_ptr<TupleSchema> CreateOutputSchema() const = 0;
@@ -1276,6 +1296,10 @@ class EvaluatorTableScanOp final : public RelationalOp {
   static absl::StatusOr<std::unique_ptr<ColumnFilter>> IntersectColumnFilters(
       const std::vector<std::unique_ptr<ColumnFilter>>& filters);
 
+  // Sets the hint passed to EvaluatorTableIterator::SetRowCountHint() for each
+  // scan of the table.
+  void set_row_count_hint(int64_t max_rows) { row_count_hint_ = max_rows; }
+
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
@@ -1308,6 +1332,125 @@ class EvaluatorTableScanOp final : public RelationalOp {
   const std::vector<VariableId> variables_;
   std::vector<std::unique_ptr<ColumnFilterArg>> and_filters_;
   std::unique_ptr<ValueExpr> read_time_;
+  absl::optional<int64_t> row_count_hint_;
+};
+
+// Produces a relation from a call to a TableValuedFunction, by iterating over
+// the EvaluatorTableIterator that TableValuedFunction::CreateEvaluator()
+// returns. Input relations are passed to the TVF as iterators over the
+// input RelationalOps, so rows stream through the TVF as it reads them.
+class TvfOp final : public RelationalOp {
+ public:
+  // An argument of the TVF call. Scalar arguments have a <value>. Relation
+  // arguments have a <relation>, whose <relation_variables> are passed to the
+  // TVF as the corresponding <relation_columns>.
+  struct TvfArg {
+    std::unique_ptr<ValueExpr> value;
+    std::unique_ptr<RelationalOp> relation;
+    std::vector<TVFSchemaColumn> relation_columns;
+    std::vector<VariableId> relation_variables;
+  };
+
+  TvfOp(const TvfOp&) = delete;
+  TvfOp& operator=(const TvfOp&) = delete;
+
+  // 'output_columns' are the columns of the TVF call's output that are read,
+  // and 'variables' are the corresponding variables of the output tuples.
+  // 'and_filters' are column filters on 'output_columns' that are passed on
+  // to the TVF's iterator. 'function_call_signature' may be null.
+  static absl::StatusOr<std::unique_ptr<TvfOp>> Create(
+      const TableValuedFunction* tvf, std::vector<TvfArg> arguments,
+      std::vector<TVFSchemaColumn> output_columns,
+      std::vector<VariableId> variables,
+      std::vector<std::unique_ptr<ColumnFilterArg>> and_filters,
+      std::shared_ptr<FunctionSignature> function_call_signature);
+
+  // Sets the hint passed to EvaluatorTableIterator::SetRowCountHint() for the
+  // iterator of each call to the TVF.
+  void set_row_count_hint(int64_t max_rows) { row_count_hint_ = max_rows; }
+
+  absl::Status SetSchemasForEvaluation(
+      absl::Span<const TupleSchema* const> params_schemas) override;
+
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+      absl::Span<const TupleData* const> params, int num_extra_slots,
+      EvaluationContext* context) const override;
+
+  // Returns the TupleSchema corresponding to the 'variables' passed to the
+  // constructor.
+  std::unique_ptr<TupleSchema> CreateOutputSchema() const override;
+
+  std::string IteratorDebugString() const override;
+
+  std::string DebugInternal(const std::string& indent,
+                            bool verbose) const override;
+
+ private:
+  TvfOp(const TableValuedFunction* tvf, std::vector<TvfArg> arguments,
+        std::vector<TVFSchemaColumn> output_columns,
+        std::vector<VariableId> variables,
+        std::vector<std::unique_ptr<ColumnFilterArg>> and_filters,
+        std::shared_ptr<FunctionSignature> function_call_signature);
+
+  const TableValuedFunction* tvf_;
+  std::vector<TvfArg> arguments_;
+  const std::vector<TVFSchemaColumn> output_columns_;
+  const std::vector<VariableId> variables_;
+  std::vector<std::unique_ptr<ColumnFilterArg>> and_filters_;
+  const std::shared_ptr<FunctionSignature> function_call_signature_;
+  absl::optional<int64_t> row_count_hint_;
+};
+
+// Reads a relation that is shared by several readers, such as a WITH entry
+// that is referenced more than once. The relation is evaluated at most once:
+// its rows are pulled as the reader furthest ahead needs them, and buffered for
+// the other readers. Rows that no reader asks for are never evaluated.
+//
+// Every SharedScanOp should be used in conjunction with a LetOp or LetExpr
+// which assigns the <buffer> variable from the CppValueArg returned by
+// MakeCppValueArgForBuffer().
+class SharedScanOp final : public RelationalOp {
+ public:
+  SharedScanOp(const SharedScanOp&) = delete;
+  SharedScanOp& operator=(const SharedScanOp&) = delete;
+
+  static std::string GetIteratorDebugString(absl::string_view name);
+
+  // <variables> correspond 1:1 to the <input_variables> of the buffer.
+  static absl::StatusOr<std::unique_ptr<SharedScanOp>> Create(
+      const std::string& name, VariableId buffer,
+      std::vector<VariableId> variables);
+
+  // Returns a factory for the buffer of the rows of <input>, which consist of
+  // the values of its <input_variables>. <name> is used for debugging.
+  static std::unique_ptr<CppValueArg> MakeCppValueArgForBuffer(
+      const std::string& name, VariableId buffer,
+      std::unique_ptr<RelationalOp> input,
+      std::vector<VariableId> input_variables);
+
+  absl::Status SetSchemasForEvaluation(
+      absl::Span<const TupleSchema* const> params_schemas) override;
+
+  absl::StatusOr<std::unique_ptr<TupleIterator>> CreateIterator(
+      absl::Span<const TupleData* const> params, int num_extra_slots,
+      EvaluationContext* context) const override;
+
+  // Returns the TupleSchema corresponding to the 'variables' passed to the
+  // constructor.
+  std::unique_ptr<TupleSchema> CreateOutputSchema() const override;
+
+  std::string IteratorDebugString() const override;
+
+  std::string DebugInternal(const std::string& indent,
+                            bool verbose) const override;
+
+ private:
+  SharedScanOp(const std::string& name, VariableId buffer,
+               std::vector<VariableId> variables);
+
+  const std::string name_;
+  const VariableId buffer_;
+  const std::vector<VariableId> variables_;
 };
 
 // Evaluates some expressions and makes them available to 'body'. Each
@@ -1351,6 +1494,7 @@ class LetOp final : public RelationalOp {
   absl::Span<ExprArg* const> mutable_assign();
 
   absl::Span<const CppValueArg* const> cpp_assign() const;
+  absl::Span<CppValueArg* const> mutable_cpp_assign();
 
   const RelationalOp* body() const;
   RelationalOp* mutable_body();
@@ -3066,6 +3210,13 @@ class LetExpr final : public ValueExpr {
       std::vector<std::unique_ptr<ExprArg>> assign,
       std::unique_ptr<ValueExpr> body);
 
+  // Same as above, and also assigns the C++ values of 'cpp_assign' while
+  // 'body' is evaluated.
+  static absl::StatusOr<std::unique_ptr<LetExpr>> Create(
+      std::vector<std::unique_ptr<ExprArg>> assign,
+      std::vector<std::unique_ptr<CppValueArg>> cpp_assign,
+      std::unique_ptr<ValueExpr> body);
+
   absl::Status SetSchemasForEvaluation(
       absl::Span<const TupleSchema* const> params_schemas) override;
 
@@ -3077,14 +3228,18 @@ class LetExpr final : public ValueExpr {
                             bool verbose) const override;
 
  private:
-  enum ArgKind { kAssign, kBody };
+  enum ArgKind { kAssign, kCppAssign, kBody };
 
   LetExpr(std::vector<std::unique_ptr<ExprArg>> assign,
+          std::vector<std::unique_ptr<CppValueArg>> cpp_assign,
           std::unique_ptr<ValueExpr> body);
 
   absl::Span<const ExprArg* const> assign() const;
   absl::Span<ExprArg* const> mutable_assign();
 
+  absl::Span<const CppValueArg* const> cpp_assign() const;
+  absl::Span<CppValueArg* const> mutable_cpp_assign();
+
   const ValueExpr* body() const;
   ValueExpr* mutable_body();
 };
@@ -3358,7 +3513,7 @@ class DMLValueExpr : public ValueExpr {
   absl::Status EvalReturningClause(
       const zetasql::ResolvedReturningClause* returning,
       absl::Span<const TupleData* const> params, EvaluationContext* context,
-      TupleData* tuple_data, const Value& action_value,
+      const TupleData* tuple_data, const Value& action_value,
       std::vector<std::vector<Value>>& dml_returning_rows) const;
 
   std::string DebugDMLCommon(const std::string& indent, bool verbose) const;
@@ -3885,9 +4040,13 @@ class DMLInsertValueExpr final : public DMLValueExpr {
       std::vector<std::vector<Value>>& dml_returning_rows) const;
 
   // Populates 'original_rows' with the rows in the table before insertion. Each
-  // Value has type 'table_array_type_->element_type()'.
+  // Value has type 'table_array_type_->element_type()'. If 'primary_keys' is
+  // non-NULL, only the rows whose primary keys are in 'primary_keys' are
+  // populated, and the rest of the table is streamed without being copied.
   absl::Status PopulateRowsInOriginalTable(
-      absl::Span<const TupleData* const> params, EvaluationContext* context,
+      absl::Span<const TupleData* const> params,
+      const absl::flat_hash_set<Value, ValueHasher>* primary_keys,
+      EvaluationContext* context,
       std::vector<std::vector<Value>>* original_rows) const;
 
   // Adds the rows in 'rows_to_insert' to 'row_map' and returns the number of
@@ -17,6 +17,8 @@
 // This file contains implementations for relational operators that don't
 // warrant their own files.
 
+#include <time.h>
+
 #include <algorithm>
 #include <cstdint>
 #include <map>
@@ -52,6 +54,8 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "zetasql/base/source_location.h"
@@ -96,8 +100,8 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> RelationalOp::Eval(
       DeepCopyTupleDatas(params);
   PassThroughTupleIterator::IteratorFactory iterator_factory =
       [this, params_copies, num_extra_slots, context]() {
-        return CreateIterator(StripSharedPtrs(params_copies), num_extra_slots,
-                              context);
+        return CreateProfiledIterator(StripSharedPtrs(params_copies),
+                                      num_extra_slots, context);
       };
   const std::unique_ptr<const TupleSchema> schema = CreateOutputSchema();
   PassThroughTupleIterator::DebugStringFactory debug_string_factory = [this]() {
@@ -109,6 +113,117 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> RelationalOp::Eval(
   return iter;
 }
 
+namespace {
+
+// Returns the CPU time consumed so far by the calling thread.
+absl::Duration ThreadCpuTime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return absl::DurationFromTimespec(ts);
+}
+
+// While in scope, measures a call to a RelationalOp (creating an iterator or
+// calling Next() on one) and then adds its time and peak memory to the
+// OperatorStats of the operator.
+class ProfiledCall {
+ public:
+  ProfiledCall(OperatorStats* stats, MemoryAccountant* accountant)
+      : stats_(stats),
+        accountant_(accountant),
+        outer_peak_bytes_(accountant->ResetPeakBytes()) {
+    if (stats_->num_active_calls++ == 0) {
+      start_wall_time_ = absl::Now();
+      start_cpu_time_ = ThreadCpuTime();
+    }
+  }
+
+  ProfiledCall(const ProfiledCall&) = delete;
+  ProfiledCall& operator=(const ProfiledCall&) = delete;
+
+  ~ProfiledCall() {
+    if (--stats_->num_active_calls == 0) {
+      stats_->cpu_time += ThreadCpuTime() - start_cpu_time_;
+      stats_->wall_time += absl::Now() - start_wall_time_;
+    }
+    stats_->peak_memory_bytes =
+        std::max(stats_->peak_memory_bytes, accountant_->peak_bytes());
+    accountant_->RestorePeakBytes(outer_peak_bytes_);
+  }
+
+ private:
+  OperatorStats* stats_;
+  MemoryAccountant* accountant_;
+  // The peak of the enclosing calls before this one, restored afterwards.
+  const int64_t outer_peak_bytes_;
+  absl::Time start_wall_time_;
+  absl::Duration start_cpu_time_;
+};
+
+// Wraps the iterator of a profiled RelationalOp and records its calls to
+// Next() in the OperatorStats of the operator.
+class ProfilingTupleIterator : public TupleIterator {
+ public:
+  ProfilingTupleIterator(std::unique_ptr<TupleIterator> iter,
+                         OperatorStats* stats, MemoryAccountant* accountant)
+      : iter_(std::move(iter)), stats_(stats), accountant_(accountant) {}
+
+  ProfilingTupleIterator(const ProfilingTupleIterator&) = delete;
+  ProfilingTupleIterator& operator=(const ProfilingTupleIterator&) = delete;
+
+  const TupleSchema& Schema() const override { return iter_->Schema(); }
+
+  TupleData* Next() override {
+    ++stats_->num_next_calls;
+    TupleData* data;
+    {
+      ProfiledCall call(stats_, accountant_);
+      data = iter_->Next();
+    }
+    if (data != nullptr) ++stats_->num_rows;
+    return data;
+  }
+
+  absl::Status Status() const override { return iter_->Status(); }
+
+  bool PreservesOrder() const override { return iter_->PreservesOrder(); }
+
+  absl::Status DisableReordering() override {
+    return iter_->DisableReordering();
+  }
+
+  std::string DebugString() const override {
+    return absl::StrCat("ProfilingTupleIterator(", iter_->DebugString(), ")");
+  }
+
+ private:
+  const std::unique_ptr<TupleIterator> iter_;
+  OperatorStats* stats_;
+  MemoryAccountant* accountant_;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<TupleIterator>>
+RelationalOp::CreateProfiledIterator(absl::Span<const TupleData* const> params,
+                                     int num_extra_slots,
+                                     EvaluationContext* context) const {
+  OperatorProfiler* profiler = context->operator_profiler();
+  if (profiler == nullptr) {
+    return CreateIterator(params, num_extra_slots, context);
+  }
+  OperatorStats* stats = profiler->GetMutableStats(this);
+  ++stats->num_iterators;
+  std::unique_ptr<TupleIterator> iter;
+  {
+    ProfiledCall call(stats, context->memory_accountant());
+    ZETASQL_ASSIGN_OR_RETURN(iter,
+                     CreateIterator(params, num_extra_slots, context));
+  }
+  iter = absl::make_unique<ProfilingTupleIterator>(
+      std::move(iter), stats, context->memory_accountant());
+  return iter;
+}
+
 absl::StatusOr<std::unique_ptr<TupleIterator>> RelationalOp::MaybeReorder(
     std::unique_ptr<TupleIterator> iter, EvaluationContext* context) const {
   if (context->options().scramble_undefined_orderings) {
@@ -447,6 +562,9 @@ class EvaluatorTableTupleIterator : public TupleIterator {
         context_(context),
         evaluator_table_iter_(std::move(evaluator_table_iter)),
         current_(schema_->num_variables() + num_extra_slots) {
+    if (context_->counters() != nullptr) {
+      num_rows_scanned_ = &context_->counters()->rows_scanned[name_];
+    }
     context_->RegisterCancelCallback(
         [this] { return evaluator_table_iter_->Cancel(); });
   }
@@ -479,6 +597,7 @@ class EvaluatorTableTupleIterator : public TupleIterator {
     for (int i = 0; i < schema_->num_variables(); ++i) {
       current_.mutable_slot(i)->SetValue(evaluator_table_iter_->GetValue(i));
     }
+    if (num_rows_scanned_ != nullptr) ++*num_rows_scanned_;
     return &current_;
   }
 
@@ -492,6 +611,8 @@ class EvaluatorTableTupleIterator : public TupleIterator {
   const std::string name_;
   const std::unique_ptr<TupleSchema> schema_;
   EvaluationContext* context_;
+  // Counts the rows returned if the context has counters enabled.
+  int64_t* num_rows_scanned_ = nullptr;
   bool called_next_ = false;
   std::unique_ptr<EvaluatorTableIterator> evaluator_table_iter_;
   TupleData current_;
@@ -524,6 +645,9 @@ EvaluatorTableScanOp::CreateIterator(absl::Span<const TupleData* const> params,
   if (read_time.has_value()) {
     ZETASQL_RETURN_IF_ERROR(evaluator_table_iter->SetReadTime(read_time.value()));
   }
+  if (row_count_hint_.has_value()) {
+    evaluator_table_iter->SetRowCountHint(row_count_hint_.value());
+  }
 
   absl::flat_hash_map<int, std::vector<std::unique_ptr<ColumnFilter>>>
       filter_list_map;
@@ -583,7 +707,11 @@ std::string EvaluatorTableScanOp::DebugInternal(const std::string& indent,
       filter_strings.empty() ? "" : indent_input,
       absl::StrJoin(filter_strings, indent_input), indent_input,
       "table: ", table_->Name(),
-      alias_.empty() ? "" : absl::StrCat(indent_input, "alias: ", alias_), ")");
+      alias_.empty() ? "" : absl::StrCat(indent_input, "alias: ", alias_),
+      row_count_hint_.has_value()
+          ? absl::StrCat(indent_input, "row_count_hint: ", *row_count_hint_)
+          : "",
+      ")");
 }
 
 EvaluatorTableScanOp::EvaluatorTableScanOp(
@@ -601,6 +729,452 @@ EvaluatorTableScanOp::EvaluatorTableScanOp(
       and_filters_(std::move(and_filters)),
       read_time_(std::move(read_time)) {}
 
+// -------------------------------------------------------
+// TvfOp
+// -------------------------------------------------------
+
+absl::StatusOr<std::unique_ptr<TvfOp>> TvfOp::Create(
+    const TableValuedFunction* tvf, std::vector<TvfArg> arguments,
+    std::vector<TVFSchemaColumn> output_columns,
+    std::vector<VariableId> variables,
+    std::vector<std::unique_ptr<ColumnFilterArg>> and_filters,
+    std::shared_ptr<FunctionSignature> function_call_signature) {
+  ZETASQL_RET_CHECK(tvf != nullptr);
+  ZETASQL_RET_CHECK_EQ(output_columns.size(), variables.size());
+  for (const TvfArg& arg : arguments) {
+    ZETASQL_RET_CHECK_EQ(arg.value != nullptr, arg.relation == nullptr);
+    ZETASQL_RET_CHECK_EQ(arg.relation_columns.size(), arg.relation_variables.size());
+  }
+  return absl::WrapUnique(new TvfOp(
+      tvf, std::move(arguments), std::move(output_columns),
+      std::move(variables), std::move(and_filters),
+      std::move(function_call_signature)));
+}
+
+absl::Status TvfOp::SetSchemasForEvaluation(
+    absl::Span<const TupleSchema* const> params_schemas) {
+  for (TvfArg& arg : arguments_) {
+    if (arg.value != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(arg.value->SetSchemasForEvaluation(params_schemas));
+    } else {
+      ZETASQL_RETURN_IF_ERROR(arg.relation->SetSchemasForEvaluation(params_schemas));
+    }
+  }
+  for (std::unique_ptr<ColumnFilterArg>& filter : and_filters_) {
+    ZETASQL_RETURN_IF_ERROR(filter->SetSchemasForEvaluation(params_schemas));
+  }
+  return absl::OkStatus();
+}
+
+namespace {
+// Presents the tuples of an input relation of a TVF as an
+// EvaluatorTableIterator over the given slots of the tuples.
+class TvfInputRelationIterator : public EvaluatorTableIterator {
+ public:
+  TvfInputRelationIterator(absl::Span<const TVFSchemaColumn> columns,
+                           std::vector<int> slot_idxs,
+                           std::unique_ptr<TupleIterator> iter)
+      : columns_(columns),
+        slot_idxs_(std::move(slot_idxs)),
+        iter_(std::move(iter)) {}
+
+  TvfInputRelationIterator(const TvfInputRelationIterator&) = delete;
+  TvfInputRelationIterator& operator=(const TvfInputRelationIterator&) =
+      delete;
+
+  int NumColumns() const override { return static_cast<int>(columns_.size()); }
+  std::string GetColumnName(int i) const override { return columns_[i].name; }
+  const Type* GetColumnType(int i) const override { return columns_[i].type; }
+
+  bool NextRow() override {
+    current_ = iter_->Next();
+    if (current_ == nullptr) {
+      status_ = iter_->Status();
+      return false;
+    }
+    return true;
+  }
+
+  const Value& GetValue(int i) const override {
+    return current_->slot(slot_idxs_[i]).value();
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  // The input is cancelled along with the rest of the statement, through the
+  // EvaluationContext.
+  absl::Status Cancel() override { return absl::OkStatus(); }
+
+ private:
+  const absl::Span<const TVFSchemaColumn> columns_;
+  const std::vector<int> slot_idxs_;
+  std::unique_ptr<TupleIterator> iter_;
+  const TupleData* current_ = nullptr;
+  absl::Status status_;
+};
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<TupleIterator>> TvfOp::CreateIterator(
+    absl::Span<const TupleData* const> params, int num_extra_slots,
+    EvaluationContext* context) const {
+  std::vector<TableValuedFunction::TvfEvaluatorArg> input_arguments;
+  input_arguments.reserve(arguments_.size());
+  for (const TvfArg& arg : arguments_) {
+    TableValuedFunction::TvfEvaluatorArg& input_argument =
+        input_arguments.emplace_back();
+    if (arg.value != nullptr) {
+      std::shared_ptr<TupleSlot::SharedProtoState> shared_state;
+      VirtualTupleSlot slot(&input_argument.value, &shared_state);
+      absl::Status status;
+      if (!arg.value->Eval(params, context, &slot, &status)) {
+        return status;
+      }
+      continue;
+    }
+    // The input relation is read as the TVF reads its iterator.
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
+                     arg.relation->CreateProfiledIterator(
+                         params, /*num_extra_slots=*/0, context));
+    std::vector<int> slot_idxs;
+    slot_idxs.reserve(arg.relation_variables.size());
+    for (const VariableId& variable : arg.relation_variables) {
+      absl::optional<int> slot_idx =
+          iter->Schema().FindIndexForVariable(variable);
+      ZETASQL_RET_CHECK(slot_idx.has_value()) << variable;
+      slot_idxs.push_back(slot_idx.value());
+    }
+    input_argument.relation = absl::make_unique<TvfInputRelationIterator>(
+        arg.relation_columns, std::move(slot_idxs), std::move(iter));
+  }
+
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<EvaluatorTableIterator> evaluator_table_iter,
+      tvf_->CreateEvaluator(std::move(input_arguments), output_columns_,
+                            function_call_signature_.get()));
+  ZETASQL_RET_CHECK(evaluator_table_iter != nullptr) << tvf_->FullName();
+  if (row_count_hint_.has_value()) {
+    evaluator_table_iter->SetRowCountHint(row_count_hint_.value());
+  }
+
+  absl::flat_hash_map<int, std::vector<std::unique_ptr<ColumnFilter>>>
+      filter_list_map;
+  for (const std::unique_ptr<ColumnFilterArg>& arg : and_filters_) {
+    ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<ColumnFilter> filter,
+                     arg->Eval(params, context));
+    filter_list_map[arg->column_idx()].push_back(std::move(filter));
+  }
+  absl::flat_hash_map<int, std::unique_ptr<ColumnFilter>> filter_map;
+  for (const auto& entry : filter_list_map) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        std::unique_ptr<ColumnFilter> filter,
+        EvaluatorTableScanOp::IntersectColumnFilters(entry.second));
+    ZETASQL_RET_CHECK(filter_map.emplace(entry.first, std::move(filter)).second);
+  }
+  ZETASQL_RETURN_IF_ERROR(
+      evaluator_table_iter->SetColumnFilterMap(std::move(filter_map)));
+
+  std::unique_ptr<TupleIterator> tuple_iter =
+      absl::make_unique<EvaluatorTableTupleIterator>(
+          tvf_->FullName(), CreateOutputSchema(), num_extra_slots, context,
+          std::move(evaluator_table_iter));
+  return MaybeReorder(std::move(tuple_iter), context);
+}
+
+std::unique_ptr<TupleSchema> TvfOp::CreateOutputSchema() const {
+  return absl::make_unique<TupleSchema>(variables_);
+}
+
+std::string TvfOp::IteratorDebugString() const {
+  return EvaluatorTableScanOp::GetIteratorDebugString(tvf_->FullName());
+}
+
+std::string TvfOp::DebugInternal(const std::string& indent,
+                                 bool verbose) const {
+  const std::string indent_input = absl::StrCat(indent, kIndentFork);
+  const std::string indent_child = absl::StrCat(indent, kIndentSpace);
+
+  std::vector<std::string> column_strings;
+  column_strings.reserve(output_columns_.size());
+  for (int i = 0; i < output_columns_.size(); ++i) {
+    column_strings.push_back(absl::StrCat(variables_[i].ToString(), " := ",
+                                          output_columns_[i].name));
+  }
+
+  std::vector<std::string> argument_strings;
+  argument_strings.reserve(arguments_.size());
+  for (const TvfArg& arg : arguments_) {
+    argument_strings.push_back(
+        arg.value != nullptr
+            ? arg.value->DebugInternal(indent_child, verbose)
+            : arg.relation->DebugInternal(indent_child, verbose));
+  }
+
+  std::vector<std::string> filter_strings;
+  filter_strings.reserve(and_filters_.size());
+  for (const std::unique_ptr<ColumnFilterArg>& filter : and_filters_) {
+    filter_strings.push_back(filter->DebugInternal(indent_input, verbose));
+  }
+
+  return absl::StrCat(
+      "TvfOp(", column_strings.empty() ? "" : indent_input,
+      absl::StrJoin(column_strings, indent_input),
+      argument_strings.empty() ? "" : indent_input,
+      absl::StrJoin(argument_strings, indent_input),
+      filter_strings.empty() ? "" : indent_input,
+      absl::StrJoin(filter_strings, indent_input), indent_input,
+      "tvf: ", tvf_->FullName(),
+      row_count_hint_.has_value()
+          ? absl::StrCat(indent_input, "row_count_hint: ", *row_count_hint_)
+          : "",
+      ")");
+}
+
+TvfOp::TvfOp(const TableValuedFunction* tvf, std::vector<TvfArg> arguments,
+             std::vector<TVFSchemaColumn> output_columns,
+             std::vector<VariableId> variables,
+             std::vector<std::unique_ptr<ColumnFilterArg>> and_filters,
+             std::shared_ptr<FunctionSignature> function_call_signature)
+    : tvf_(tvf),
+      arguments_(std::move(arguments)),
+      output_columns_(std::move(output_columns)),
+      variables_(std::move(variables)),
+      and_filters_(std::move(and_filters)),
+      function_call_signature_(std::move(function_call_signature)) {}
+
+// -------------------------------------------------------
+// SharedScanOp
+// -------------------------------------------------------
+
+namespace {
+// The rows of a shared relation that have been read so far, and the iterator
+// that produces the rest of them. Only the values of the shared variables are
+// kept, and their memory is charged to the EvaluationContext.
+class SharedScanBuffer {
+ public:
+  SharedScanBuffer(const RelationalOp* input,
+                   absl::Span<const VariableId> input_variables,
+                   absl::Span<const TupleData* const> params,
+                   EvaluationContext* context)
+      : input_(input),
+        input_variables_(input_variables),
+        params_(params.begin(), params.end()),
+        context_(context),
+        rows_(context->memory_accountant()) {}
+
+  SharedScanBuffer(const SharedScanBuffer&) = delete;
+  SharedScanBuffer& operator=(const SharedScanBuffer&) = delete;
+
+  // Returns the row at 'index', reading the input up to it if necessary.
+  // Returns nullptr if the input has no such row, or on error, in which case
+  // 'status' is populated.
+  const TupleData* GetRow(int64_t index, absl::Status* status) {
+    while (index >= row_ptrs_.size()) {
+      if (!status_.ok()) {
+        *status = status_;
+        return nullptr;
+      }
+      if (done_) return nullptr;
+      status_ = ReadRow();
+    }
+    return row_ptrs_[index];
+  }
+
+ private:
+  // Appends the next row of the input to the buffer, or sets 'done_' if there
+  // are no more rows.
+  absl::Status ReadRow() {
+    if (iter_ == nullptr) {
+      ZETASQL_ASSIGN_OR_RETURN(iter_, input_->CreateProfiledIterator(
+                                  params_, /*num_extra_slots=*/0, context_));
+      slot_idxs_.reserve(input_variables_.size());
+      for (const VariableId& variable : input_variables_) {
+        absl::optional<int> slot_idx =
+            iter_->Schema().FindIndexForVariable(variable);
+        ZETASQL_RET_CHECK(slot_idx.has_value()) << variable;
+        slot_idxs_.push_back(slot_idx.value());
+      }
+    }
+
+    const TupleData* data = iter_->Next();
+    if (data == nullptr) {
+      ZETASQL_RETURN_IF_ERROR(iter_->Status());
+      done_ = true;
+      // Release whatever the input holds on to.
+      iter_.reset();
+      return absl::OkStatus();
+    }
+
+    auto row = absl::make_unique<TupleData>(slot_idxs_.size());
+    for (int i = 0; i < slot_idxs_.size(); ++i) {
+      row->mutable_slot(i)->CopyFromSlot(data->slot(slot_idxs_[i]));
+    }
+    const TupleData* row_ptr = row.get();
+    absl::Status status;
+    if (!rows_.PushBack(std::move(row), &status)) {
+      return status;
+    }
+    row_ptrs_.push_back(row_ptr);
+    return absl::OkStatus();
+  }
+
+  const RelationalOp* input_;
+  const absl::Span<const VariableId> input_variables_;
+  const std::vector<const TupleData*> params_;
+  EvaluationContext* context_;
+  std::unique_ptr<TupleIterator> iter_;
+  // The slot in the tuples of 'iter_' of each of 'input_variables_'.
+  std::vector<int> slot_idxs_;
+  TupleDataDeque rows_;
+  // The rows in 'rows_', for random access.
+  std::vector<const TupleData*> row_ptrs_;
+  bool done_ = false;
+  absl::Status status_;
+};
+
+// CppValueArg implementation representing a variable associated with a
+// SharedScanBuffer. Owns the input of the buffer.
+class SharedScanBufferArg : public CppValueArg {
+ public:
+  SharedScanBufferArg(const std::string& name, VariableId buffer,
+                      std::unique_ptr<RelationalOp> input,
+                      std::vector<VariableId> input_variables)
+      : CppValueArg(buffer, absl::StrCat("SharedScanBuffer: ", name)),
+        input_(std::move(input)),
+        input_variables_(std::move(input_variables)) {}
+
+  absl::Status SetSchemasForEvaluation(
+      absl::Span<const TupleSchema* const> params_schemas) override {
+    return input_->SetSchemasForEvaluation(params_schemas);
+  }
+
+  std::unique_ptr<CppValueBase> CreateValue(
+      absl::Span<const TupleData* const> params,
+      EvaluationContext* context) const override {
+    return absl::make_unique<CppValue<SharedScanBuffer>>(
+        input_.get(), absl::MakeConstSpan(input_variables_), params, context);
+  }
+
+  std::string DebugInternal(const std::string& indent,
+                            bool verbose) const override {
+    const std::string indent_child =
+        absl::StrCat(indent, AlgebraNode::kIndentSpace);
+    return absl::StrCat("$", variable().ToString(), " := SharedScanBuffer(",
+                        indent, AlgebraNode::kIndentFork, "input: ",
+                        input_->DebugInternal(indent_child, verbose), ")");
+  }
+
+ private:
+  const std::unique_ptr<RelationalOp> input_;
+  const std::vector<VariableId> input_variables_;
+};
+
+class SharedScanTupleIterator : public TupleIterator {
+ public:
+  SharedScanTupleIterator(const std::string& name,
+                          std::unique_ptr<TupleSchema> schema,
+                          int num_extra_slots, SharedScanBuffer* buffer)
+      : name_(name),
+        schema_(std::move(schema)),
+        buffer_(buffer),
+        current_(schema_->num_variables() + num_extra_slots) {}
+
+  SharedScanTupleIterator(const SharedScanTupleIterator&) = delete;
+  SharedScanTupleIterator& operator=(const SharedScanTupleIterator&) = delete;
+
+  const TupleSchema& Schema() const override { return *schema_; }
+
+  TupleData* Next() override {
+    const TupleData* row = buffer_->GetRow(next_row_, &status_);
+    if (row == nullptr) return nullptr;
+    ++next_row_;
+    for (int i = 0; i < schema_->num_variables(); ++i) {
+      current_.mutable_slot(i)->CopyFromSlot(row->slot(i));
+    }
+    return &current_;
+  }
+
+  absl::Status Status() const override { return status_; }
+
+  std::string DebugString() const override {
+    return SharedScanOp::GetIteratorDebugString(name_);
+  }
+
+ private:
+  const std::string name_;
+  const std::unique_ptr<TupleSchema> schema_;
+  SharedScanBuffer* buffer_;
+  int64_t next_row_ = 0;
+  TupleData current_;
+  absl::Status status_;
+};
+}  // namespace
+
+std::string SharedScanOp::GetIteratorDebugString(absl::string_view name) {
+  return absl::StrCat("SharedScanTupleIterator(", name, ")");
+}
+
+absl::StatusOr<std::unique_ptr<SharedScanOp>> SharedScanOp::Create(
+    const std::string& name, VariableId buffer,
+    std::vector<VariableId> variables) {
+  return absl::WrapUnique(new SharedScanOp(name, buffer, std::move(variables)));
+}
+
+std::unique_ptr<CppValueArg> SharedScanOp::MakeCppValueArgForBuffer(
+    const std::string& name, VariableId buffer,
+    std::unique_ptr<RelationalOp> input,
+    std::vector<VariableId> input_variables) {
+  return absl::make_unique<SharedScanBufferArg>(
+      name, buffer, std::move(input), std::move(input_variables));
+}
+
+absl::Status SharedScanOp::SetSchemasForEvaluation(
+    absl::Span<const TupleSchema* const> params_schemas) {
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::unique_ptr<TupleIterator>> SharedScanOp::CreateIterator(
+    absl::Span<const TupleData* const> params, int num_extra_slots,
+    EvaluationContext* context) const {
+  SharedScanBuffer* buffer =
+      CppValue<SharedScanBuffer>::Get(context->GetCppValue(buffer_));
+  if (buffer == nullptr) {
+    // This error means an outer tree node failed to assign the buffer.
+    return zetasql_base::InternalErrorBuilder()
+           << "SharedScanOp unable to look up buffer " << buffer_;
+  }
+  std::unique_ptr<TupleIterator> iter =
+      absl::make_unique<SharedScanTupleIterator>(name_, CreateOutputSchema(),
+                                                 num_extra_slots, buffer);
+  return MaybeReorder(std::move(iter), context);
+}
+
+std::unique_ptr<TupleSchema> SharedScanOp::CreateOutputSchema() const {
+  return absl::make_unique<TupleSchema>(variables_);
+}
+
+std::string SharedScanOp::IteratorDebugString() const {
+  return GetIteratorDebugString(name_);
+}
+
+std::string SharedScanOp::DebugInternal(const std::string& indent,
+                                        bool verbose) const {
+  const std::string indent_input = absl::StrCat(indent, kIndentFork);
+  std::vector<std::string> column_strings;
+  column_strings.reserve(variables_.size());
+  for (int i = 0; i < variables_.size(); ++i) {
+    column_strings.push_back(
+        absl::StrCat("$", variables_[i].ToString(), " := ", name_, "#", i));
+  }
+  return absl::StrCat(
+      "SharedScanOp(", column_strings.empty() ? "" : indent_input,
+      absl::StrJoin(column_strings, indent_input), indent_input, "buffer: $",
+      buffer_.ToString(), ")");
+}
+
+SharedScanOp::SharedScanOp(const std::string& name, VariableId buffer,
+                           std::vector<VariableId> variables)
+    : name_(name), buffer_(buffer), variables_(std::move(variables)) {}
+
 // -------------------------------------------------------
 // LetOp
 // -------------------------------------------------------
@@ -640,6 +1214,10 @@ absl::Status LetOp::SetSchemasForEvaluation(
     new_schemas.push_back(std::move(new_schema));
   }
 
+  for (CppValueArg* arg : mutable_cpp_assign()) {
+    ZETASQL_RETURN_IF_ERROR(arg->SetSchemasForEvaluation(schema_ptrs));
+  }
+
   return mutable_body()->SetSchemasForEvaluation(schema_ptrs);
 }
 
@@ -747,17 +1325,19 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> LetOp::CreateIterator(
     }
   }
 
+  std::vector<std::shared_ptr<const TupleData>> all_params_copies =
+      DeepCopyTupleDatas(all_params);
+
   auto cpp_values = absl::make_unique<CppValueHolder>(context);
   for (const CppValueArg* a : cpp_assign()) {
-    ZETASQL_RETURN_IF_ERROR(
-        cpp_values->AddVariable(a->variable(), a->CreateValue(context)));
+    ZETASQL_RETURN_IF_ERROR(cpp_values->AddVariable(
+        a->variable(),
+        a->CreateValue(StripSharedPtrs(all_params_copies), context)));
   }
-
-  std::vector<std::shared_ptr<const TupleData>> all_params_copies =
-      DeepCopyTupleDatas(all_params);
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
-                   body()->CreateIterator(StripSharedPtrs(all_params_copies),
-                                          num_extra_slots, context));
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<TupleIterator> iter,
+      body()->CreateProfiledIterator(StripSharedPtrs(all_params_copies),
+                                     num_extra_slots, context));
   iter = absl::make_unique<LetOpTupleIterator>(
       std::move(new_params), all_params_copies, std::move(iter),
       std::move(cpp_values));
@@ -800,6 +1380,10 @@ absl::Span<const CppValueArg* const> LetOp::cpp_assign() const {
   return GetArgs<CppValueArg>(kCppAssign);
 }
 
+absl::Span<CppValueArg* const> LetOp::mutable_cpp_assign() {
+  return GetMutableArgs<CppValueArg>(kCppAssign);
+}
+
 const RelationalOp* LetOp::body() const {
   return GetArg(kBody)->node()->AsRelationalOp();
 }
@@ -1048,7 +1632,7 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
 
   ZETASQL_ASSIGN_OR_RETURN(
       std::unique_ptr<TupleIterator> input_iter,
-      input()->CreateIterator(params, /*num_extra_slots=*/0, context));
+      input()->CreateProfiledIterator(params, /*num_extra_slots=*/0, context));
 
   std::vector<int> slots_for_keys;
   slots_for_keys.reserve(keys().size());
@@ -1061,9 +1645,16 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
     slots_for_values.push_back(keys().size() + i);
   }
 
+  // Collated keys are compared by sort keys, which are computed once per row
+  // and stored after the extra slots, where they are charged to the memory
+  // accountant along with the rest of the row.
+  const int first_sort_key_slot =
+      keys().size() + values().size() + num_extra_slots;
   ZETASQL_ASSIGN_OR_RETURN(
       std::unique_ptr<TupleComparator> comparator,
-      TupleComparator::Create(keys(), slots_for_keys, params, context));
+      TupleComparator::CreateWithSortKeys(keys(), slots_for_keys,
+                                          first_sort_key_slot, params,
+                                          context));
 
   // If 'limit_offset' is set, 'top_n_outputs' contains the top
   // 'limit_offset.limit + limit_offset.offset' rows. Otherwise, 'outputs'
@@ -1073,7 +1664,15 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
   auto outputs =
       absl::make_unique<TupleDataDeque>(context->memory_accountant());
   absl::Status status;
+  // The whole input is consumed before the first row is returned, so check
+  // for cancellation here too.
+  int64_t num_inputs = 0;
   while (true) {
+    if (num_inputs++ %
+            absl::GetFlag(FLAGS_zetasql_call_verify_not_aborted_rows_period) ==
+        0) {
+      ZETASQL_RETURN_IF_ERROR(context->VerifyNotAborted());
+    }
     const TupleData* next_input = input_iter->Next();
     if (next_input == nullptr) {
       ZETASQL_RETURN_IF_ERROR(input_iter->Status());
@@ -1084,7 +1683,7 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
         ConcatSpans(params, {next_input});
 
     auto next_output = absl::make_unique<TupleData>(
-        keys().size() + values().size() + num_extra_slots);
+        first_sort_key_slot + comparator->num_sort_key_slots());
     for (int i = 0; i < keys().size(); ++i) {
       TupleSlot* slot = next_output->mutable_slot(i);
       if (!keys()[i]->value_expr()->EvalSimple(params_and_input_tuple, context,
@@ -1092,6 +1691,9 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SortOp::CreateIterator(
         return status;
       }
     }
+    if (!comparator->ComputeSortKeys(next_output.get(), &status)) {
+      return status;
+    }
     for (int i = 0; i < values().size(); ++i) {
       TupleSlot* slot = next_output->mutable_slot(keys().size() + i);
       if (!values()[i]->value_expr()->EvalSimple(params_and_input_tuple,
@@ -1376,7 +1978,8 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> ComputeOp::CreateIterator(
     EvaluationContext* context) const {
   ZETASQL_ASSIGN_OR_RETURN(
       std::unique_ptr<TupleIterator> iter,
-      input()->CreateIterator(params, num_extra_slots + map().size(), context));
+      input()->CreateProfiledIterator(params, num_extra_slots + map().size(),
+                                      context));
   iter = absl::make_unique<ComputeTupleIterator>(params, map(), std::move(iter),
                                                  CreateOutputSchema(), context);
   return MaybeReorder(std::move(iter), context);
@@ -1509,8 +2112,9 @@ class FilterTupleIterator : public TupleIterator {
 absl::StatusOr<std::unique_ptr<TupleIterator>> FilterOp::CreateIterator(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
-                   input()->CreateIterator(params, num_extra_slots, context));
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<TupleIterator> iter,
+      input()->CreateProfiledIterator(params, num_extra_slots, context));
   iter = absl::make_unique<FilterTupleIterator>(params, predicate(),
                                                 std::move(iter), context);
   return MaybeReorder(std::move(iter), context);
@@ -1695,8 +2299,9 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> LimitOp::CreateIterator(
            << "Limit requires non-negative count and offset";
   }
 
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
-                   input()->CreateIterator(params, num_extra_slots, context));
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<TupleIterator> iter,
+      input()->CreateProfiledIterator(params, num_extra_slots, context));
   const bool underlying_iter_preserves_order = iter->PreservesOrder();
 
   iter = absl::make_unique<LimitTupleIterator>(count.int64_value(),
@@ -2110,8 +2715,9 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> SampleScanOp::CreateIterator(
     // The input iterator needs to allocate an extra tuple slot for weight.
     num_extra_slots++;
   }
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
-                   input()->CreateIterator(params, num_extra_slots, context));
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<TupleIterator> iter,
+      input()->CreateProfiledIterator(params, num_extra_slots, context));
   const bool underlying_iter_preserves_order = iter->PreservesOrder();
 
   if (method_ == Method::kReservoirRows) {
@@ -2624,6 +3230,9 @@ class UncorrelatedHashedRightInput : public RightInputForJoin {
 
   bool IsCorrelated() const override { return false; }
 
+  // Returns the number of distinct keys in the hash table.
+  int64_t num_keys() const { return right_tuple_map_->size(); }
+
   const TupleSchema& Schema() const override { return *schema_; }
 
   absl::Status ResetForLeftInput(const Tuple* left_input) override {
@@ -2796,8 +3405,9 @@ absl::Status ExtractFromRelationalOp(
     const RelationalOp* op, absl::Span<const TupleData* const> params,
     EvaluationContext* context, TupleDataDeque* tuples,
     std::unique_ptr<TupleIterator>* iter_for_debug_string) {
-  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
-                   op->CreateIterator(params, /*num_extra_slots=*/0, context));
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<TupleIterator> iter,
+      op->CreateProfiledIterator(params, /*num_extra_slots=*/0, context));
   tuples->Clear();
   absl::Status status;
   while (true) {
@@ -3409,13 +4019,21 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> JoinOp::CreateIterator(
             right_input()->CreateOutputSchema(), std::move(tuples),
             std::move(iter_for_right_debug_string));
       } else {
+        const int64_t num_right_tuples = tuples->GetSize();
         ZETASQL_ASSIGN_OR_RETURN(
-            right_hand_side,
+            std::unique_ptr<UncorrelatedHashedRightInput> hashed_right_input,
             UncorrelatedHashedRightInput::Create(
                 params, hash_join_equality_left_exprs(),
                 hash_join_equality_right_exprs(),
                 right_input()->CreateOutputSchema(), std::move(tuples),
                 std::move(iter_for_right_debug_string), context));
+        if (OperatorProfiler* profiler = context->operator_profiler();
+            profiler != nullptr) {
+          profiler->RecordCounter(this, "hash_table_rows", num_right_tuples);
+          profiler->RecordCounter(this, "hash_table_keys",
+                                  hashed_right_input->num_keys());
+        }
+        right_hand_side = std::move(hashed_right_input);
       }
       break;
     }
@@ -3429,7 +4047,8 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> JoinOp::CreateIterator(
 
   ZETASQL_ASSIGN_OR_RETURN(
       std::unique_ptr<TupleIterator> left_iter,
-      left_input()->CreateIterator(params, /*num_extra_slots=*/0, context));
+      left_input()->CreateProfiledIterator(params, /*num_extra_slots=*/0,
+                                           context));
 
   std::unique_ptr<TupleIterator> iter = absl::make_unique<JoinTupleIterator>(
       join_kind_, params, remaining_join_expr(), std::move(left_iter),
@@ -3910,6 +4529,7 @@ class DistinctRowSetValueArg : public CppValueArg {
       : CppValueArg(var_id, "DistinctRowSet") {}
 
   std::unique_ptr<CppValueBase> CreateValue(
+      absl::Span<const TupleData* const> params,
       EvaluationContext* context) const override {
     return absl::make_unique<CppValue<DistinctRowSet>>(
         context->memory_accountant());
@@ -4016,7 +4636,7 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> DistinctOp::CreateIterator(
     EvaluationContext* context) const {
   ZETASQL_ASSIGN_OR_RETURN(
       std::unique_ptr<TupleIterator> input_iterator,
-      input()->CreateIterator(params, /*num_extra_slots=*/0, context));
+      input()->CreateProfiledIterator(params, /*num_extra_slots=*/0, context));
 
   DistinctRowSet* row_set =
       CppValue<DistinctRowSet>::Get(context->GetCppValue(row_set_id()));
@@ -4208,7 +4828,7 @@ absl::StatusOr<std::unique_ptr<TupleIterator>> UnionAllOp::CreateIterator(
   for (int i = 0; i < num_rel(); ++i) {
     ZETASQL_ASSIGN_OR_RETURN(
         std::unique_ptr<TupleIterator> iter,
-        rel(i)->CreateIterator(params, /*num_extra_slots=*/0, context));
+        rel(i)->CreateProfiledIterator(params, /*num_extra_slots=*/0, context));
     iters.push_back(std::move(iter));
   }
 
@@ -4545,9 +5165,9 @@ class LoopTupleIterator : public TupleIterator {
   //  - An error status if an error occurred.
   absl::StatusOr<TupleData*> BeginNextIteration() {
     // Create a new iterator for the body
-    ZETASQL_ASSIGN_OR_RETURN(iter_,
-                     op_->body()->CreateIterator(params_and_loop_variables_,
-                                                 num_extra_slots_, context_));
+    ZETASQL_ASSIGN_OR_RETURN(
+        iter_, op_->body()->CreateProfiledIterator(params_and_loop_variables_,
+                                                   num_extra_slots_, context_));
 
     // Fetch the first TupleData of the next iteration
     TupleData* data = iter_->Next();
@@ -4613,7 +5233,7 @@ absl::Status RootOp::SetSchemasForEvaluation(
 absl::StatusOr<std::unique_ptr<TupleIterator>> RootOp::CreateIterator(
     absl::Span<const TupleData* const> params, int num_extra_slots,
     EvaluationContext* context) const {
-  return input()->CreateIterator(params, num_extra_slots, context);
+  return input()->CreateProfiledIterator(params, num_extra_slots, context);
 }
 
 std::unique_ptr<TupleSchema> RootOp::CreateOutputSchema() const {
@@ -892,6 +892,7 @@ class TestCppValueArg : public CppValueArg {
         value_(value) {}
 
   std::unique_ptr<CppValueBase> CreateValue(
+      absl::Span<const TupleData* const> params,
       EvaluationContext* context) const override {
     EXPECT_NE(context, nullptr);
     return absl::make_unique<CppValue<std::string>>(value_);
@@ -3768,6 +3769,86 @@ DistinctOp(
                           IsTupleSlotWith(Int64(20), IsNull()), _));
 }
 
+TEST_F(CreateIteratorTest, SharedScanOp) {
+  VariableId a("a"), b("b"), x("x"), y("y"), z("z"), buffer("buffer");
+
+  std::vector<TupleData> test_values = CreateTestTupleDatas(
+      {{Int64(1), Int64(10)}, {Int64(2), Int64(20)}, {Int64(3), Int64(30)}});
+  auto input = absl::WrapUnique(new TestRelationalOp({a, b}, test_values,
+                                                     /*preserves_order=*/true));
+  std::unique_ptr<CppValueArg> buffer_arg =
+      SharedScanOp::MakeCppValueArgForBuffer("t", buffer, std::move(input),
+                                             {a, b});
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedScanOp> scan1,
+                       SharedScanOp::Create("t", buffer, {x, y}));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedScanOp> scan2,
+                       SharedScanOp::Create("t", buffer, {z, y}));
+  EXPECT_EQ(absl::StripAsciiWhitespace(R"(
+SharedScanOp(
++-$x := t#0
++-$y := t#1
++-buffer: $buffer)
+)"),
+            scan1->DebugString());
+  EXPECT_EQ("SharedScanTupleIterator(t)", scan1->IteratorDebugString());
+  EXPECT_EQ("<z,y>", scan2->CreateOutputSchema()->DebugString());
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK(buffer_arg->SetSchemasForEvaluation(EmptyParamsSchemas()));
+  ASSERT_TRUE(context.SetCppValueIfNotPresent(
+      buffer, buffer_arg->CreateValue(EmptyParams(), &context)));
+  ZETASQL_ASSERT_OK(scan1->SetSchemasForEvaluation(EmptyParamsSchemas()));
+  ZETASQL_ASSERT_OK(scan2->SetSchemasForEvaluation(EmptyParamsSchemas()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter1,
+      scan1->CreateIterator(EmptyParams(), /*num_extra_slots=*/1, &context));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TupleIterator> iter2,
+      scan2->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context));
+  EXPECT_EQ(iter1->DebugString(), "SharedScanTupleIterator(t)");
+
+  // The second reader gets ahead of the first one, and then the first one
+  // reads the rows that the second one buffered.
+  const TupleData* data = iter2->Next();
+  ASSERT_NE(data, nullptr);
+  EXPECT_THAT(data->slots(), ElementsAre(IsTupleSlotWith(Int64(1), IsNull()),
+                                         IsTupleSlotWith(Int64(10), IsNull())));
+  data = iter2->Next();
+  ASSERT_NE(data, nullptr);
+  EXPECT_THAT(data->slots(), ElementsAre(IsTupleSlotWith(Int64(2), IsNull()),
+                                         IsTupleSlotWith(Int64(20), IsNull())));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<TupleData> data1,
+                       ReadFromTupleIterator(iter1.get()));
+  ASSERT_EQ(data1.size(), 3);
+  for (int i = 0; i < data1.size(); ++i) {
+    EXPECT_THAT(data1[i].slots(),
+                ElementsAre(IsTupleSlotWith(Int64(i + 1), IsNull()),
+                            IsTupleSlotWith(Int64(10 * (i + 1)), IsNull()), _));
+  }
+
+  data = iter2->Next();
+  ASSERT_NE(data, nullptr);
+  EXPECT_THAT(data->slots(), ElementsAre(IsTupleSlotWith(Int64(3), IsNull()),
+                                         IsTupleSlotWith(Int64(30), IsNull())));
+  EXPECT_EQ(iter2->Next(), nullptr);
+  ZETASQL_EXPECT_OK(iter2->Status());
+
+  context.ClearCppValue(buffer);
+}
+
+TEST_F(CreateIteratorTest, SharedScanOpWithoutBuffer) {
+  VariableId x("x"), buffer("buffer");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedScanOp> scan,
+                       SharedScanOp::Create("t", buffer, {x}));
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK(scan->SetSchemasForEvaluation(EmptyParamsSchemas()));
+  EXPECT_THAT(
+      scan->CreateIterator(EmptyParams(), /*num_extra_slots=*/0, &context),
+      StatusIs(absl::StatusCode::kInternal, HasSubstr("buffer")));
+}
+
 TEST_F(CreateIteratorTest, ComputeOp) {
   VariableId a("a"), b("b"), param("param"), minus("minus"), plus("plus");
   std::vector<TupleData> test_values =
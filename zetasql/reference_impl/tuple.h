@@ -21,6 +21,7 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <iterator>
 #include <map>
@@ -624,7 +625,9 @@ class MemoryAccountant {
   // Constructs a MemoryAccountant that can allocate at most 'total_num_bytes'
   // at once.
   explicit MemoryAccountant(int64_t total_num_bytes)
-      : total_num_bytes_(total_num_bytes), remaining_bytes_(total_num_bytes) {}
+      : total_num_bytes_(total_num_bytes),
+        remaining_bytes_(total_num_bytes),
+        min_remaining_bytes_(total_num_bytes) {}
 
   MemoryAccountant(const MemoryAccountant&) = delete;
   MemoryAccountant& operator=(const MemoryAccountant&) = delete;
@@ -643,6 +646,8 @@ class MemoryAccountant {
       return false;
     }
     remaining_bytes_ -= num_bytes;
+    min_remaining_bytes_ = std::min(min_remaining_bytes_, remaining_bytes_);
+    total_requested_bytes_ += num_bytes;
     return true;
   }
 
@@ -655,9 +660,36 @@ class MemoryAccountant {
 
   int64_t remaining_bytes() const { return remaining_bytes_; }
 
+  // Returns the sum of the successful requests since the construction of this
+  // object. All of them have been returned once the evaluation has finished.
+  int64_t total_requested_bytes() const { return total_requested_bytes_; }
+
+  // Returns the largest number of bytes that were allocated at once since the
+  // construction of this object or the last call to ResetPeakBytes().
+  int64_t peak_bytes() const { return total_num_bytes_ - min_remaining_bytes_; }
+
+  // Resets peak_bytes() to the number of bytes currently allocated and returns
+  // its previous value. Used to measure the peak over a part of the evaluation;
+  // RestorePeakBytes() with the returned value then restores the overall peak.
+  int64_t ResetPeakBytes() {
+    const int64_t peak = peak_bytes();
+    min_remaining_bytes_ = remaining_bytes_;
+    return peak;
+  }
+
+  // Raises peak_bytes() to 'peak_bytes' if it is lower.
+  void RestorePeakBytes(int64_t peak_bytes) {
+    min_remaining_bytes_ =
+        std::min(min_remaining_bytes_, total_num_bytes_ - peak_bytes);
+  }
+
  private:
   const int64_t total_num_bytes_;
   int64_t remaining_bytes_;
+  // The smallest value of 'remaining_bytes_' since the construction or the
+  // last call to ResetPeakBytes().
+  int64_t min_remaining_bytes_;
+  int64_t total_requested_bytes_ = 0;
 };
 
 // Holds a deque of TupleDatas whose memory usage is tracked by a
@@ -1032,6 +1064,8 @@ class TupleIterator {
   //   the order of tuples (x1, y1), (x2, y2) where x1 = x2, but not tuples
   //   where x1 != x2.
   // - LetOpTupleIterator (used by LetOp), which just wraps another iterator.
+  // - ProfilingTupleIterator (used by RelationalOp::CreateProfiledIterator()),
+  //   which also just wraps another iterator.
   // - TestTupleIterator, which is a test-only class.
   virtual bool PreservesOrder() const { return true; }
 
@@ -32,8 +32,10 @@
 #include "zetasql/reference_impl/operator.h"
 #include "zetasql/reference_impl/tuple.h"
 #include <cstdint>
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
 #include "zetasql/base/source_location.h"
 #include "zetasql/base/ret_check.h"
@@ -97,7 +99,60 @@ absl::StatusOr<std::unique_ptr<TupleComparator>> TupleComparator::Create(
       std::make_shared<Collators>(Collators());
   ZETASQL_RETURN_IF_ERROR(
       GetZetaSqlCollators(keys, params, context, collators.get()));
-  return absl::WrapUnique(new TupleComparator(keys, slots_for_keys, collators));
+  return absl::WrapUnique(new TupleComparator(
+      keys, slots_for_keys, collators, /*slots_for_sort_keys=*/{}));
+}
+
+absl::StatusOr<std::unique_ptr<TupleComparator>>
+TupleComparator::CreateWithSortKeys(absl::Span<const KeyArg* const> keys,
+                                    absl::Span<const int> slots_for_keys,
+                                    int first_sort_key_slot,
+                                    absl::Span<const TupleData* const> params,
+                                    EvaluationContext* context) {
+  std::shared_ptr<Collators> collators =
+      std::make_shared<Collators>(Collators());
+  ZETASQL_RETURN_IF_ERROR(
+      GetZetaSqlCollators(keys, params, context, collators.get()));
+  // Binary collations compare the strings themselves, so they need no sort
+  // key.
+  std::vector<int> slots_for_sort_keys;
+  slots_for_sort_keys.reserve(collators->size());
+  int next_sort_key_slot = first_sort_key_slot;
+  for (const std::unique_ptr<const ZetaSqlCollator>& collator : *collators) {
+    if (collator != nullptr && !collator->IsBinaryComparison()) {
+      slots_for_sort_keys.push_back(next_sort_key_slot++);
+    } else {
+      slots_for_sort_keys.push_back(-1);
+    }
+  }
+  return absl::WrapUnique(new TupleComparator(
+      keys, slots_for_keys, collators, std::move(slots_for_sort_keys)));
+}
+
+bool TupleComparator::ComputeSortKeys(TupleData* tuple,
+                                      absl::Status* status) const {
+  for (int i = 0; i < slots_for_sort_keys_.size(); ++i) {
+    const int sort_key_slot = slots_for_sort_keys_[i];
+    if (sort_key_slot < 0) continue;
+
+    const Value& value = tuple->slot(slots_for_keys_[i]).value();
+    if (!value.type()->IsString()) {
+      *status = zetasql_base::InternalErrorBuilder()
+                << "Cannot get sort key for value in non-String type: "
+                << value.type()->DebugString();
+      return false;
+    }
+    if (value.is_null()) {
+      tuple->mutable_slot(sort_key_slot)->SetValue(Value::NullBytes());
+      continue;
+    }
+    absl::Cord sort_key;
+    *status = (*collators_)[i]->GetSortKeyUtf8(value.string_value(), &sort_key);
+    if (!status->ok()) return false;
+    tuple->mutable_slot(sort_key_slot)
+        ->SetValue(Value::Bytes(std::string(sort_key)));
+  }
+  return true;
 }
 
 bool TupleComparator::operator()(const TupleData& t1,
@@ -130,10 +185,17 @@ bool TupleComparator::operator()(const TupleData& t1,
     if (collator != nullptr) {
       ZETASQL_DCHECK(v1.type()->IsString());
       ZETASQL_DCHECK(v2.type()->IsString());
-      absl::Status status;
-      int64_t result =
-          collator->CompareUtf8(v1.string_value(), v2.string_value(), &status);
-      ZETASQL_DCHECK_OK(status);
+      int64_t result;
+      if (!slots_for_sort_keys_.empty() && slots_for_sort_keys_[i] >= 0) {
+        const int sort_key_slot = slots_for_sort_keys_[i];
+        result = t1.slot(sort_key_slot).value().bytes_value().compare(
+            t2.slot(sort_key_slot).value().bytes_value());
+      } else {
+        absl::Status status;
+        result = collator->CompareUtf8(v1.string_value(), v2.string_value(),
+                                       &status);
+        ZETASQL_DCHECK_OK(status);
+      }
       if (result != 0) {  // v1 != v2
         if (key->is_descending()) {
           return result > 0;  // v1 > v2
@@ -17,6 +17,7 @@
 #ifndef ZETASQL_REFERENCE_IMPL_TUPLE_COMPARATOR_H_
 #define ZETASQL_REFERENCE_IMPL_TUPLE_COMPARATOR_H_
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -43,6 +44,24 @@ class TupleComparator {
       absl::Span<const int> slots_for_keys,
       absl::Span<const TupleData* const> params, EvaluationContext* context);
 
+  // Like Create(), but the returned comparator compares the keys that use a
+  // non-binary collation by their collation sort keys, which is much cheaper
+  // than comparing the strings with the collator. ComputeSortKeys() must be
+  // called on every tuple before it is compared, and stores the sort keys in
+  // the 'num_sort_key_slots()' slots starting at 'first_sort_key_slot'.
+  static absl::StatusOr<std::unique_ptr<TupleComparator>> CreateWithSortKeys(
+      absl::Span<const KeyArg* const> keys,
+      absl::Span<const int> slots_for_keys, int first_sort_key_slot,
+      absl::Span<const TupleData* const> params, EvaluationContext* context);
+
+  // Returns the number of slots that ComputeSortKeys() fills in. Always 0 for
+  // comparators returned by Create().
+  int num_sort_key_slots() const { return num_sort_key_slots_; }
+
+  // Stores the sort keys of the collated keys of 'tuple' in its sort key slots.
+  // Returns false and sets 'status' if a sort key cannot be computed.
+  bool ComputeSortKeys(TupleData* tuple, absl::Status* status) const;
+
   // Returns true if t1 is less than t2.
   bool operator()(const TupleData& t1, const TupleData& t2) const;
 
@@ -72,10 +91,16 @@ class TupleComparator {
 
   TupleComparator(absl::Span<const KeyArg* const> keys,
                   absl::Span<const int> slots_for_keys,
-                  std::shared_ptr<const Collators> collators)
+                  std::shared_ptr<const Collators> collators,
+                  std::vector<int> slots_for_sort_keys)
       : keys_(keys.begin(), keys.end()),
         slots_for_keys_(slots_for_keys.begin(), slots_for_keys.end()),
-        collators_(collators) {}
+        collators_(collators),
+        slots_for_sort_keys_(std::move(slots_for_sort_keys)),
+        num_sort_key_slots_(
+            std::count_if(slots_for_sort_keys_.begin(),
+                          slots_for_sort_keys_.end(),
+                          [](int slot_idx) { return slot_idx >= 0; })) {}
 
   const std::vector<const KeyArg*> keys_;
   const std::vector<int> slots_for_keys_;
@@ -85,6 +110,11 @@ class TupleComparator {
   // compared based on their UTF-8 encoding.
   // We use std::shared_ptr<const ...> to allow the comparator to be copied.
   const std::shared_ptr<const Collators> collators_;
+  // If not empty, corresponds 1-1 with keys_. 'slots_for_sort_keys_[i]' is
+  // the index of the sort key of 'keys_[i]' in a TupleData passed to
+  // operator(), or -1 if 'keys_[i]' is compared without a sort key.
+  const std::vector<int> slots_for_sort_keys_;
+  const int num_sort_key_slots_;
 };
 
 }  // namespace zetasql
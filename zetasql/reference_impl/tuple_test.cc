@@ -508,6 +508,41 @@ TEST(TupleDataOrderedQueue, DestructorTest) {
   EXPECT_EQ(accountant.remaining_bytes(), 1000);
 }
 
+TEST(TupleComparator, ComparesCollatedKeysBySortKeys) {
+  VariableId k1("k1"), k2("k2");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ValueExpr> key,
+                       DerefExpr::Create(k1, StringType()));
+  KeyArg key_arg(k2, std::move(key), KeyArg::kAscending);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ValueExpr> collation,
+                       ConstExpr::Create(String("en_US:ci")));
+  key_arg.set_collation(std::move(collation));
+
+  EvaluationContext context((EvaluationOptions()));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TupleComparator> comparator,
+                       TupleComparator::CreateWithSortKeys(
+                           {&key_arg}, /*slots_for_keys=*/{0},
+                           /*first_sort_key_slot=*/1, /*params=*/{}, &context));
+  ASSERT_EQ(comparator->num_sort_key_slots(), 1);
+
+  std::vector<TupleData> tuples;
+  for (const Value& value :
+       {String("b"), String("A"), String("a"), NullString()}) {
+    tuples.push_back(CreateTupleDataFromValues({value, Value()}));
+    absl::Status status;
+    ASSERT_TRUE(comparator->ComputeSortKeys(&tuples.back(), &status))
+        << status;
+  }
+  EXPECT_TRUE(tuples[3].slot(1).value().is_null());
+  EXPECT_FALSE(tuples[1].slot(1).value().is_null());
+
+  // NULL < "A" == "a" < "b".
+  EXPECT_TRUE((*comparator)(tuples[3], tuples[1]));
+  EXPECT_TRUE((*comparator)(tuples[1], tuples[0]));
+  EXPECT_FALSE((*comparator)(tuples[0], tuples[2]));
+  EXPECT_FALSE((*comparator)(tuples[1], tuples[2]));
+  EXPECT_FALSE((*comparator)(tuples[2], tuples[1]));
+}
+
 TEST(ValueHashSet, BasicTest) {
   MemoryAccountant accountant(/*total_num_bytes=*/1000);
   ValueHashSet set(&accountant);
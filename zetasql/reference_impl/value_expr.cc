@@ -330,7 +330,7 @@ bool ArrayNestExpr::Eval(absl::Span<const TupleData* const> params,
                          EvaluationContext* context, VirtualTupleSlot* result,
                          absl::Status* status) const {
   auto status_or_iter =
-      input()->CreateIterator(params, /*num_extra_slots=*/0, context);
+      input()->CreateProfiledIterator(params, /*num_extra_slots=*/0, context);
   if (!status_or_iter.ok()) {
     *status = status_or_iter.status();
     return false;
@@ -839,7 +839,7 @@ bool SingleValueExpr::Eval(absl::Span<const TupleData* const> params,
                            EvaluationContext* context, VirtualTupleSlot* result,
                            absl::Status* status) const {
   auto status_or_iter =
-      input()->CreateIterator(params, /*num_extra_slots=*/0, context);
+      input()->CreateProfiledIterator(params, /*num_extra_slots=*/0, context);
   if (!status_or_iter.ok()) {
     *status = status_or_iter.status();
     return false;
@@ -919,7 +919,7 @@ bool ExistsExpr::Eval(absl::Span<const TupleData* const> params,
                       EvaluationContext* context, VirtualTupleSlot* result,
                       absl::Status* status) const {
   auto status_or_iter =
-      input()->CreateIterator(params, /*num_extra_slots=*/0, context);
+      input()->CreateProfiledIterator(params, /*num_extra_slots=*/0, context);
   if (!status_or_iter.ok()) {
     *status = status_or_iter.status();
     return false;
@@ -1260,7 +1260,15 @@ ValueExpr* IfExpr::mutable_false_value() {
 absl::StatusOr<std::unique_ptr<LetExpr>> LetExpr::Create(
     std::vector<std::unique_ptr<ExprArg>> assign,
     std::unique_ptr<ValueExpr> body) {
-  return absl::WrapUnique(new LetExpr(std::move(assign), std::move(body)));
+  return Create(std::move(assign), /*cpp_assign=*/{}, std::move(body));
+}
+
+absl::StatusOr<std::unique_ptr<LetExpr>> LetExpr::Create(
+    std::vector<std::unique_ptr<ExprArg>> assign,
+    std::vector<std::unique_ptr<CppValueArg>> cpp_assign,
+    std::unique_ptr<ValueExpr> body) {
+  return absl::WrapUnique(
+      new LetExpr(std::move(assign), std::move(cpp_assign), std::move(body)));
 }
 
 absl::Status LetExpr::SetSchemasForEvaluation(
@@ -1285,6 +1293,10 @@ absl::Status LetExpr::SetSchemasForEvaluation(
     new_schemas.push_back(std::move(new_schema));
   }
 
+  for (CppValueArg* arg : mutable_cpp_assign()) {
+    ZETASQL_RETURN_IF_ERROR(arg->SetSchemasForEvaluation(schema_ptrs));
+  }
+
   return mutable_body()->SetSchemasForEvaluation(schema_ptrs);
 }
 
@@ -1315,20 +1327,42 @@ bool LetExpr::Eval(absl::Span<const TupleData* const> params,
       return false;
     }
   }
+
+  // The C++ values only live while 'body' is evaluated.
+  std::vector<VariableId> cpp_variables;
+  cpp_variables.reserve(cpp_assign().size());
+  auto cleanup = absl::MakeCleanup([context, &cpp_variables] {
+    for (const VariableId& variable : cpp_variables) {
+      context->ClearCppValue(variable);
+    }
+  });
+  for (const CppValueArg* arg : cpp_assign()) {
+    if (!context->SetCppValueIfNotPresent(
+            arg->variable(), arg->CreateValue(data_ptrs, context))) {
+      *status = zetasql_base::InternalErrorBuilder()
+                << "Variable " << arg->variable()
+                << " already holds a C++ value";
+      return false;
+    }
+    cpp_variables.push_back(arg->variable());
+  }
   return body()->Eval(data_ptrs, context, result, status);
 }
 
 std::string LetExpr::DebugInternal(const std::string& indent,
                                    bool verbose) const {
-  return absl::StrCat(
-      "LetExpr(", ArgDebugString({"assign", "body"}, {kN, k1}, indent, verbose),
-      ")");
+  return absl::StrCat("LetExpr(",
+                      ArgDebugString({"assign", "cpp_assign", "body"},
+                                     {kN, kNOpt, k1}, indent, verbose),
+                      ")");
 }
 
 LetExpr::LetExpr(std::vector<std::unique_ptr<ExprArg>> assign,
+                 std::vector<std::unique_ptr<CppValueArg>> cpp_assign,
                  std::unique_ptr<ValueExpr> body)
     : ValueExpr(body->output_type()) {
   SetArgs<ExprArg>(kAssign, std::move(assign));
+  SetArgs<CppValueArg>(kCppAssign, std::move(cpp_assign));
   SetArg(kBody, absl::make_unique<ExprArg>(std::move(body)));
 }
 
@@ -1340,6 +1374,14 @@ absl::Span<ExprArg* const> LetExpr::mutable_assign() {
   return GetMutableArgs<ExprArg>(kAssign);
 }
 
+absl::Span<const CppValueArg* const> LetExpr::cpp_assign() const {
+  return GetArgs<CppValueArg>(kCppAssign);
+}
+
+absl::Span<CppValueArg* const> LetExpr::mutable_cpp_assign() {
+  return GetMutableArgs<CppValueArg>(kCppAssign);
+}
+
 const ValueExpr* LetExpr::body() const {
   return GetArg(kBody)->node()->AsValueExpr();
 }
@@ -2004,7 +2046,7 @@ absl::StatusOr<Value> DMLValueExpr::GetDMLOutputValue(
 absl::Status DMLValueExpr::EvalReturningClause(
     const zetasql::ResolvedReturningClause* returning,
     absl::Span<const TupleData* const> params, EvaluationContext* context,
-    TupleData* tuple_data, const Value& action_value,
+    const TupleData* tuple_data, const Value& action_value,
     std::vector<std::vector<Value>>& dml_returning_rows) const {
   std::vector<const TupleData*> input_params =
       ConcatSpans(params, {tuple_data});
@@ -2026,6 +2068,40 @@ absl::Status DMLValueExpr::EvalReturningClause(
   return absl::OkStatus();
 }
 
+// Returns an iterator over the result of evaluating 'op' on 'params'.
+static absl::StatusOr<std::unique_ptr<TupleIterator>> CreateDMLInputIterator(
+    const RelationalOp& op, absl::Span<const TupleData* const> params,
+    EvaluationContext* context) {
+  ZETASQL_ASSIGN_OR_RETURN(
+      std::unique_ptr<TupleIterator> iter,
+      op.CreateProfiledIterator(params, /*num_extra_slots=*/0, context));
+  // We disable reordering when iterating over relations when processing DML
+  // statements for backwards compatibility with the text-based reference
+  // implementation compliance tests. As another advantage, this effectively
+  // disables scrambling for simple statements, which makes the tests easier to
+  // understand.
+  ZETASQL_RETURN_IF_ERROR(iter->DisableReordering());
+  return iter;
+}
+
+// Evaluates 'op' on 'params' and calls 'fn' on each output tuple as it is
+// produced. Unlike EvalRelationalOp(), this does not materialize the relation,
+// which matters for the scan of the target table.
+static absl::Status ForEachTupleOfRelationalOp(
+    const RelationalOp& op, absl::Span<const TupleData* const> params,
+    EvaluationContext* context,
+    const std::function<absl::Status(const Tuple&)>& fn) {
+  ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
+                   CreateDMLInputIterator(op, params, context));
+  while (true) {
+    const TupleData* data = iter->Next();
+    if (data == nullptr) {
+      return iter->Status();
+    }
+    ZETASQL_RETURN_IF_ERROR(fn(Tuple(&iter->Schema(), data)));
+  }
+}
+
 // Evaluates 'op' on 'params', then populates 'schema' and 'datas' with the
 // corresponding TupleSchema and TupleDatas.
 static absl::Status EvalRelationalOp(
@@ -2033,14 +2109,8 @@ static absl::Status EvalRelationalOp(
     EvaluationContext* context, std::unique_ptr<TupleSchema>* schema,
     std::vector<std::unique_ptr<TupleData>>* datas) {
   ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<TupleIterator> iter,
-                   op.CreateIterator(params, /*num_extra_slots=*/0, context));
+                   CreateDMLInputIterator(op, params, context));
   *schema = absl::make_unique<TupleSchema>(iter->Schema().variables());
-  // We disable reordering when iterating over relations when processing DML
-  // statements for backwards compatibility with the text-based reference
-  // implementation compliance tests. As another advantage, this effectively
-  // disables scrambling for simple statements, which makes the tests easier to
-  // understand.
-  ZETASQL_RETURN_IF_ERROR(iter->DisableReordering());
   while (true) {
     const TupleData* data = iter->Next();
     if (data == nullptr) {
@@ -2117,41 +2187,38 @@ absl::StatusOr<Value> DMLDeleteValueExpr::Eval(
   ZETASQL_ASSIGN_OR_RETURN(const RelationalOp* relational_op,
                    LookupResolvedScan(stmt()->table_scan()));
 
-  std::unique_ptr<TupleSchema> tuple_schema;
-  std::vector<std::unique_ptr<TupleData>> tuple_datas;
-  ZETASQL_RETURN_IF_ERROR(EvalRelationalOp(*relational_op, params, context,
-                                   &tuple_schema, &tuple_datas));
-  for (const std::unique_ptr<TupleData>& tuple_data : tuple_datas) {
-    // It is expensive to call this for every row, but this code is only used
-    // for compliance testing, so it's ok.
-    ZETASQL_RETURN_IF_ERROR(context->VerifyNotAborted());
-
-    const Tuple tuple(tuple_schema.get(), tuple_data.get());
-    ZETASQL_ASSIGN_OR_RETURN(std::vector<Value> tuple_as_values,
-                     GetScannedTupleAsColumnValues(*column_list_, tuple));
-
-    // The WHERE clause can reference column values and statement parameters.
-    ZETASQL_ASSIGN_OR_RETURN(
-        const Value where_value,
-        EvalExpr(*where_expr, ConcatSpans(params, {tuple.data}), context));
-    const bool deleted = (where_value == Bool(true));
-    if (deleted) {
-      ++num_rows_deleted;
-      if (!context->options().return_all_rows_for_dml) {
-        dml_output_rows.push_back(tuple_as_values);
-      }
-      if (stmt()->returning() != nullptr) {
-        ZETASQL_RETURN_IF_ERROR(EvalReturningClause(
-            stmt()->returning(), params, context, tuple_data.get(),
-            Value::StringValue("DELETE"), dml_returning_rows));
-      }
-    } else {
-      // In all_rows mode,the output contains the remaining rows.
-      if (context->options().return_all_rows_for_dml) {
-        dml_output_rows.push_back(tuple_as_values);
-      }
-    }
-  }
+  // The table scan is streamed so that only the rows in the output are copied.
+  // If the algebrizer pushed the WHERE clause down into the scan, the table
+  // may also skip rows that cannot be deleted.
+  ZETASQL_RETURN_IF_ERROR(ForEachTupleOfRelationalOp(
+      *relational_op, params, context,
+      [&](const Tuple& tuple) -> absl::Status {
+        // It is expensive to call this for every row, but this code is only
+        // used for compliance testing, so it's ok.
+        ZETASQL_RETURN_IF_ERROR(context->VerifyNotAborted());
+
+        // The WHERE clause can reference column values and statement
+        // parameters.
+        ZETASQL_ASSIGN_OR_RETURN(
+            const Value where_value,
+            EvalExpr(*where_expr, ConcatSpans(params, {tuple.data}), context));
+        const bool deleted = (where_value == Bool(true));
+        // In all_rows mode, the output contains the remaining rows.
+        if (deleted != context->options().return_all_rows_for_dml) {
+          ZETASQL_ASSIGN_OR_RETURN(std::vector<Value> tuple_as_values,
+                           GetScannedTupleAsColumnValues(*column_list_, tuple));
+          dml_output_rows.push_back(std::move(tuple_as_values));
+        }
+        if (deleted) {
+          ++num_rows_deleted;
+          if (stmt()->returning() != nullptr) {
+            ZETASQL_RETURN_IF_ERROR(EvalReturningClause(
+                stmt()->returning(), params, context, tuple.data,
+                Value::StringValue("DELETE"), dml_returning_rows));
+          }
+        }
+        return absl::OkStatus();
+      }));
 
   ZETASQL_RETURN_IF_ERROR(VerifyNumRowsModified(stmt()->assert_rows_modified(), params,
                                         num_rows_deleted, context));
@@ -2282,53 +2349,56 @@ absl::StatusOr<Value> DMLUpdateValueExpr::Eval(
   ZETASQL_ASSIGN_OR_RETURN(const RelationalOp* relational_op,
                    LookupResolvedScan(stmt()->table_scan()));
 
-  std::unique_ptr<TupleSchema> tuple_schema;
-  std::vector<std::unique_ptr<TupleData>> tuples;
-  ZETASQL_RETURN_IF_ERROR(EvalRelationalOp(*relational_op, params, context,
-                                   &tuple_schema, &tuples));
-  for (const std::unique_ptr<TupleData>& tuple_data : tuples) {
-    // It is expensive to call this for every row, but this code is only used
-    // for compliance testing, so it's ok.
-    ZETASQL_RETURN_IF_ERROR(context->VerifyNotAborted());
-
-    const Tuple tuple(tuple_schema.get(), tuple_data.get());
-    std::vector<const TupleData*> joined_tuple_datas;
-    ZETASQL_RETURN_IF_ERROR(GetJoinedTupleDatas(params, tuple_data.get(),
-                                        from_tuples.get(), where_expr, context,
-                                        &joined_tuple_datas));
-    if (joined_tuple_datas.empty()) {
-      ZETASQL_ASSIGN_OR_RETURN(const std::vector<Value> dml_output_row,
-                       GetScannedTupleAsColumnValues(*column_list_, tuple));
-      if (context->options().return_all_rows_for_dml) {
-        dml_output_rows.push_back(dml_output_row);
-      }
-      continue;
-    }
+  // The table scan is streamed so that only the rows in the output are copied.
+  // Without a FROM clause, the algebrizer may also have pushed the WHERE clause
+  // down into the scan so that the table skips rows that cannot be updated.
+  ZETASQL_RETURN_IF_ERROR(ForEachTupleOfRelationalOp(
+      *relational_op, params, context,
+      [&](const Tuple& tuple) -> absl::Status {
+        // It is expensive to call this for every row, but this code is only
+        // used for compliance testing, so it's ok.
+        ZETASQL_RETURN_IF_ERROR(context->VerifyNotAborted());
+
+        std::vector<const TupleData*> joined_tuple_datas;
+        ZETASQL_RETURN_IF_ERROR(GetJoinedTupleDatas(params, tuple.data,
+                                            from_tuples.get(), where_expr,
+                                            context, &joined_tuple_datas));
+        if (joined_tuple_datas.empty()) {
+          if (context->options().return_all_rows_for_dml) {
+            ZETASQL_ASSIGN_OR_RETURN(std::vector<Value> dml_output_row,
+                             GetScannedTupleAsColumnValues(*column_list_,
+                                                           tuple));
+            dml_output_rows.push_back(std::move(dml_output_row));
+          }
+          return absl::OkStatus();
+        }
 
-    ++num_rows_modified;
+        ++num_rows_modified;
 
-    UpdateMap update_map;
-    for (const std::unique_ptr<const ResolvedUpdateItem>& update_item :
-         stmt()->update_item_list()) {
-      ResolvedColumn update_column, update_target_column;
-      std::vector<UpdatePathComponent> prefix_components;
-      ZETASQL_RETURN_IF_ERROR(AddToUpdateMap(
-          update_item.get(), joined_tuple_datas, context, &update_column,
-          &update_target_column, &prefix_components, &update_map));
-    }
+        UpdateMap update_map;
+        for (const std::unique_ptr<const ResolvedUpdateItem>& update_item :
+             stmt()->update_item_list()) {
+          ResolvedColumn update_column, update_target_column;
+          std::vector<UpdatePathComponent> prefix_components;
+          ZETASQL_RETURN_IF_ERROR(AddToUpdateMap(
+              update_item.get(), joined_tuple_datas, context, &update_column,
+              &update_target_column, &prefix_components, &update_map));
+        }
 
-    ZETASQL_ASSIGN_OR_RETURN(std::vector<Value> dml_output_row,
-                     GetDMLOutputRow(tuple, update_map, context));
+        ZETASQL_ASSIGN_OR_RETURN(std::vector<Value> dml_output_row,
+                         GetDMLOutputRow(tuple, update_map, context));
 
-    if (stmt()->returning() != nullptr) {
-      TupleData updated_tuple_data = CreateTupleDataFromValues(dml_output_row);
-      ZETASQL_RETURN_IF_ERROR(EvalReturningClause(
-          stmt()->returning(), params, context, &updated_tuple_data,
-          Value::StringValue("UPDATE"), dml_returning_rows));
-    }
+        if (stmt()->returning() != nullptr) {
+          const TupleData updated_tuple_data =
+              CreateTupleDataFromValues(dml_output_row);
+          ZETASQL_RETURN_IF_ERROR(EvalReturningClause(
+              stmt()->returning(), params, context, &updated_tuple_data,
+              Value::StringValue("UPDATE"), dml_returning_rows));
+        }
 
-    dml_output_rows.push_back(dml_output_row);
-  }
+        dml_output_rows.push_back(std::move(dml_output_row));
+        return absl::OkStatus();
+      }));
 
   // Verify that there are no duplicate primary keys in the modified table.
   absl::string_view duplicate_primary_key_error_prefix =
@@ -3280,17 +3350,36 @@ absl::StatusOr<Value> DMLInsertValueExpr::Eval(
                                           dml_returning_rows));
   }
 
+  // When we are only returning new rows, the only old rows that matter are the
+  // ones whose primary keys collide with a new row, so we only store those
+  // into `row_map`. Without a primary key, no old row can collide (and only
+  // OR_ERROR is allowed, see below), so we do not scan the table at all.
   std::vector<std::vector<Value>> original_rows;
-  ZETASQL_RETURN_IF_ERROR(PopulateRowsInOriginalTable(params, context, &original_rows));
+  if (context->options().return_all_rows_for_dml) {
+    ZETASQL_RETURN_IF_ERROR(PopulateRowsInOriginalTable(
+        params, /*primary_keys=*/nullptr, context, &original_rows));
+  } else {
+    ZETASQL_ASSIGN_OR_RETURN(
+        const absl::optional<std::vector<int>> primary_key_indexes,
+        GetPrimaryKeyColumnIndexes(context));
+    if (primary_key_indexes.has_value()) {
+      absl::flat_hash_set<Value, ValueHasher> inserted_primary_keys;
+      for (const std::vector<Value>& row_to_insert : rows_to_insert) {
+        RowNumberAndValues row_number_and_values;
+        row_number_and_values.values = row_to_insert;
+        ZETASQL_ASSIGN_OR_RETURN(
+            Value primary_key,
+            GetPrimaryKeyOrRowNumber(row_number_and_values, context));
+        inserted_primary_keys.insert(std::move(primary_key));
+      }
+      ZETASQL_RETURN_IF_ERROR(PopulateRowsInOriginalTable(
+          params, &inserted_primary_keys, context, &original_rows));
+    }
+  }
 
   absl::string_view duplicate_primary_key_error_prefix =
       "Found two rows with primary key";
 
-  // We currently store all old rows into `row_map` even in the case where we
-  // are only returning new rows. This is because we have to do the error
-  // checking that we do not cause a primary key collision. A future
-  // optimization might do this checking without materializing the entire
-  // updated PrimaryKeyRowMap in this case.
   PrimaryKeyRowMap row_map;
   bool has_primary_key;
   // Duplicate primary keys in the original table can only result from a problem
@@ -3489,28 +3578,33 @@ absl::Status DMLInsertValueExpr::PopulateReturningRows(
 }
 
 absl::Status DMLInsertValueExpr::PopulateRowsInOriginalTable(
-    absl::Span<const TupleData* const> params, EvaluationContext* context,
+    absl::Span<const TupleData* const> params,
+    const absl::flat_hash_set<Value, ValueHasher>* primary_keys,
+    EvaluationContext* context,
     std::vector<std::vector<Value>>* original_rows) const {
   ZETASQL_ASSIGN_OR_RETURN(const RelationalOp* relational_op,
                    LookupResolvedScan(stmt()->table_scan()));
 
-  std::unique_ptr<TupleSchema> tuple_schema;
-  std::vector<std::unique_ptr<TupleData>> tuples;
-  ZETASQL_RETURN_IF_ERROR(EvalRelationalOp(*relational_op, params, context,
-                                   &tuple_schema, &tuples));
-
-  for (const std::unique_ptr<TupleData>& tuple : tuples) {
-    // It is expensive to call this for every row, but this code is only used
-    // for compliance testing, so it's ok.
-    ZETASQL_RETURN_IF_ERROR(context->VerifyNotAborted());
-    ZETASQL_ASSIGN_OR_RETURN(
-        const std::vector<Value> column_values,
-        GetScannedTupleAsColumnValues(*column_list_,
-                                      Tuple(tuple_schema.get(), tuple.get())));
-    original_rows->push_back(column_values);
-  }
-
-  return absl::OkStatus();
+  return ForEachTupleOfRelationalOp(
+      *relational_op, params, context,
+      [&](const Tuple& tuple) -> absl::Status {
+        // It is expensive to call this for every row, but this code is only
+        // used for compliance testing, so it's ok.
+        ZETASQL_RETURN_IF_ERROR(context->VerifyNotAborted());
+        ZETASQL_ASSIGN_OR_RETURN(std::vector<Value> column_values,
+                         GetScannedTupleAsColumnValues(*column_list_, tuple));
+        if (primary_keys != nullptr) {
+          RowNumberAndValues row_number_and_values;
+          row_number_and_values.values = std::move(column_values);
+          ZETASQL_ASSIGN_OR_RETURN(
+              const Value primary_key,
+              GetPrimaryKeyOrRowNumber(row_number_and_values, context));
+          if (!primary_keys->contains(primary_key)) return absl::OkStatus();
+          column_values = std::move(row_number_and_values.values);
+        }
+        original_rows->push_back(std::move(column_values));
+        return absl::OkStatus();
+      });
 }
 
 absl::StatusOr<int64_t> DMLInsertValueExpr::InsertRows(
@@ -25,6 +25,7 @@
 #include "zetasql/public/type.h"
 #include "zetasql/public/types/proto_type.h"
 #include "zetasql/public/value.h"
+#include "zetasql/tools/execute_query/execute_query_tool.h"
 #include "zetasql/tools/execute_query/simple_proto_evaluator_table_iterator.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
@@ -39,34 +40,35 @@
 namespace zetasql {
 namespace {
 
-// Represents a binary proto file as a value table with 1 row.
+// Represents binary proto files as a value table with 1 row per file. Each
+// file is only read when the scan reaches it.
 class BinaryProtoEvaluatorTableIterator
     : public SimpleProtoEvaluatorTableIterator {
  public:
-  BinaryProtoEvaluatorTableIterator(absl::string_view path,
+  BinaryProtoEvaluatorTableIterator(std::vector<std::string> paths,
                                     const ProtoType* proto_type,
                                     absl::Span<const int> columns)
-      : SimpleProtoEvaluatorTableIterator(proto_type), path_(path) {
+      : SimpleProtoEvaluatorTableIterator(proto_type),
+        paths_(std::move(paths)) {
     ZETASQL_CHECK_EQ(columns.size(), 1);
     ZETASQL_CHECK_EQ(columns[0], 0);
   }
 
   bool NextRow() override {
-    if (done_) {
+    if (!status_.ok() || next_path_ >= paths_.size()) {
       return false;
     }
-    done_ = true;
 
     std::string data;
-    status_ = internal::GetContents(path_, &data);
+    status_ = internal::GetContents(paths_[next_path_++], &data);
     if (!status_.ok()) return false;
     current_value_ = Value::Proto(proto_type_, absl::Cord(data));
     return true;
   }
 
  private:
-  const std::string path_;
-  bool done_ = false;
+  const std::vector<std::string> paths_;
+  int next_path_ = 0;
 };
 
 }  // namespace
@@ -74,19 +76,26 @@ class BinaryProtoEvaluatorTableIterator
 absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromBinaryProtoFile(
     absl::string_view table_name, absl::string_view path,
     const ProtoType* column_proto_type) {
+  return MakeTableFromBinaryProtoFiles(table_name, {std::string(path)},
+                                       column_proto_type);
+}
+
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromBinaryProtoFiles(
+    absl::string_view table_name, absl::Span<const std::string> paths,
+    const ProtoType* column_proto_type) {
   std::unique_ptr<SimpleTable> table;
   std::vector<SimpleTable::NameAndType> columns = {
       {SimpleProtoEvaluatorTableIterator::kValueColumnName, column_proto_type}};
 
   table = absl::make_unique<SimpleTable>(table_name, columns);
   table->set_is_value_table(true);
-  // Make a copy, because we cannot trust the lifetime of `path`.
-  std::string string_path = std::string(path);
+  // Make a copy, because we cannot trust the lifetime of `paths`.
+  std::vector<std::string> string_paths(paths.begin(), paths.end());
   table->SetEvaluatorTableIteratorFactory(
-      [string_path, column_proto_type](absl::Span<const int> columns)
+      [string_paths, column_proto_type](absl::Span<const int> columns)
           -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
         return absl::make_unique<BinaryProtoEvaluatorTableIterator>(
-            string_path, column_proto_type, columns);
+            string_paths, column_proto_type, columns);
       });
   return table;
 }
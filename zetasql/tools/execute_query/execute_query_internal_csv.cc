@@ -21,26 +21,41 @@
 // names. For an example of how to use this tool with a custom proto db, see
 // :execute_query_test. Note that not all protos are in the global proto db.
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "zetasql/public/simple_catalog.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
+#include "zetasql/tools/execute_query/execute_query_tool.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "riegeli/bytes/fd_reader.h"
 #include "riegeli/csv/csv_reader.h"
+#include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
 
 namespace zetasql {
 
-absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromCsvFile(
-    absl::string_view table_name, absl::string_view path) {
+namespace {
+
+// The contents of one CSV file.
+struct CsvShard {
+  std::vector<std::string> header;
+  std::vector<std::vector<Value>> rows;
+};
+
+absl::Status ReadCsvShard(absl::string_view path, CsvShard* shard) {
   riegeli::CsvReader csv_reader(riegeli::FdReader(path, O_RDONLY));
 
   std::vector<std::string> record;
@@ -49,28 +64,93 @@ absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromCsvFile(
     return zetasql_base::UnknownErrorBuilder()
            << "CSV file " << path << " does not contain a header row";
   }
-  std::vector<SimpleTable::NameAndType> columns;
-  columns.reserve(record.size());
-  for (const std::string& column_name : record) {
-    columns.emplace_back(column_name, types::StringType());
-  }
+  shard->header = record;
 
-  std::vector<std::vector<Value>> contents;
   while (csv_reader.ReadRecord(record)) {
-    if (record.size() != columns.size()) {
+    if (record.size() != shard->header.size()) {
       return zetasql_base::UnknownErrorBuilder()
              << "CSV file " << path << " has a header row with "
-             << columns.size() << " columns, but row "
+             << shard->header.size() << " columns, but row "
              << csv_reader.last_record_index() << " has " << record.size()
              << " fields";
     }
-    std::vector<Value>& row = contents.emplace_back();
+    std::vector<Value>& row = shard->rows.emplace_back();
     row.reserve(record.size());
     for (const std::string& field : record) {
       row.push_back(Value::String(field));
     }
   }
   if (!csv_reader.Close()) return csv_reader.status();
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromCsvFile(
+    absl::string_view table_name, absl::string_view path) {
+  return MakeTableFromCsvFiles(table_name, {std::string(path)},
+                               /*num_threads=*/1,
+                               /*shard_loaded_cb=*/nullptr);
+}
+
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromCsvFiles(
+    absl::string_view table_name, absl::Span<const std::string> paths,
+    int num_threads, const ShardLoadedCallback& shard_loaded_cb) {
+  ZETASQL_RET_CHECK(!paths.empty());
+  std::vector<CsvShard> shards(paths.size());
+  std::vector<absl::Status> statuses(paths.size());
+
+  // Each thread repeatedly claims the next shard that nobody is loading.
+  std::atomic<int> next_shard{0};
+  std::atomic<int> num_shards_loaded{0};
+  absl::Mutex callback_mutex;
+  auto load_shards = [&]() {
+    for (int i = next_shard++; i < paths.size(); i = next_shard++) {
+      statuses[i] = ReadCsvShard(paths[i], &shards[i]);
+      const int num_loaded = ++num_shards_loaded;
+      if (shard_loaded_cb != nullptr) {
+        absl::MutexLock lock(&callback_mutex);
+        shard_loaded_cb(paths[i], num_loaded, paths.size());
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  const int num_extra_threads =
+      std::min<int>(std::max(num_threads, 1), paths.size()) - 1;
+  for (int i = 0; i < num_extra_threads; ++i) {
+    threads.emplace_back(load_shards);
+  }
+  load_shards();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const absl::Status& status : statuses) {
+    ZETASQL_RETURN_IF_ERROR(status);
+  }
+
+  // The shards form a single table, in the order of 'paths'.
+  const std::vector<std::string>& header = shards[0].header;
+  size_t num_rows = 0;
+  for (int i = 0; i < shards.size(); ++i) {
+    if (shards[i].header != header) {
+      return zetasql_base::UnknownErrorBuilder()
+             << "CSV file " << paths[i]
+             << " has a different header row than CSV file " << paths[0];
+    }
+    num_rows += shards[i].rows.size();
+  }
+  std::vector<SimpleTable::NameAndType> columns;
+  columns.reserve(header.size());
+  for (const std::string& column_name : header) {
+    columns.emplace_back(column_name, types::StringType());
+  }
+  std::vector<std::vector<Value>> contents;
+  contents.reserve(num_rows);
+  for (CsvShard& shard : shards) {
+    std::move(shard.rows.begin(), shard.rows.end(),
+              std::back_inserter(contents));
+    shard.rows.clear();
+  }
 
   auto table = absl::make_unique<SimpleTable>(table_name, columns);
   table->SetContents(contents);
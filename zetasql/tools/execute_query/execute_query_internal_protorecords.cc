@@ -0,0 +1,227 @@
+//
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/logging.h"
+#include "zetasql/public/evaluator_table_iterator.h"
+#include "zetasql/public/simple_catalog.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/types/proto_type.h"
+#include "zetasql/public/value.h"
+#include "zetasql/tools/execute_query/execute_query_tool.h"
+#include "zetasql/tools/execute_query/simple_proto_evaluator_table_iterator.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status_macros.h"
+
+namespace zetasql {
+namespace {
+
+// A read-only memory mapping of a whole file. The file is unmapped when the
+// last reference to the mapping goes away, which may be after the table and
+// its iterators are gone because the Values of the rows reference the mapped
+// bytes.
+class MappedFile {
+ public:
+  static absl::StatusOr<std::shared_ptr<const MappedFile>> Open(
+      const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return ErrnoError("Unable to open", path);
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+      absl::Status error = ErrnoError("Unable to stat", path);
+      close(fd);
+      return error;
+    }
+    if (!S_ISREG(status.st_mode)) {
+      close(fd);
+      return absl::FailedPreconditionError(
+          absl::StrCat("File is not regular: ", path));
+    }
+    const size_t size = status.st_size;
+    void* data = nullptr;
+    if (size > 0) {
+      data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        absl::Status error = ErrnoError("Unable to map", path);
+        close(fd);
+        return error;
+      }
+      // Records are read front to back, so let the kernel read ahead and drop
+      // the pages behind us. This is what lets files larger than RAM work.
+      madvise(data, size, MADV_SEQUENTIAL);
+    }
+    // The mapping stays valid after the file descriptor is closed.
+    close(fd);
+    return std::shared_ptr<const MappedFile>(new MappedFile(data, size));
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+  }
+
+  absl::string_view contents() const {
+    return absl::string_view(static_cast<const char*>(data_), size_);
+  }
+
+ private:
+  MappedFile(void* data, size_t size) : data_(data), size_(size) {}
+
+  static absl::Status ErrnoError(absl::string_view message,
+                                 absl::string_view path) {
+    return absl::NotFoundError(
+        absl::StrCat(message, " ", path, ": ", std::strerror(errno)));
+  }
+
+  void* const data_;
+  const size_t size_;
+};
+
+// Represents files of length-delimited binary protos as a value table with
+// one row per proto, in the order of the files. Each record is a varint with
+// the size of the serialized proto, followed by the proto itself (the format
+// written by google::protobuf::util::SerializeDelimitedToOstream).
+//
+// The files are memory-mapped and the proto Values reference the mapped bytes,
+// so a file is never read into memory as a whole and rows are only parsed as
+// far as the query reads their fields.
+class ProtoRecordsEvaluatorTableIterator
+    : public SimpleProtoEvaluatorTableIterator {
+ public:
+  ProtoRecordsEvaluatorTableIterator(
+      std::vector<std::shared_ptr<const MappedFile>> files,
+      const ProtoType* proto_type, absl::Span<const int> columns)
+      : SimpleProtoEvaluatorTableIterator(proto_type),
+        files_(std::move(files)) {
+    ZETASQL_CHECK_EQ(columns.size(), 1);
+    ZETASQL_CHECK_EQ(columns[0], 0);
+  }
+
+  bool NextRow() override {
+    if (!status_.ok()) {
+      return false;
+    }
+    while (remaining_.empty()) {
+      if (next_file_ >= files_.size()) {
+        return false;
+      }
+      file_ = files_[next_file_++];
+      remaining_ = file_->contents();
+    }
+    uint64_t size = 0;
+    int shift = 0;
+    while (true) {
+      if (remaining_.empty() || shift >= 64) {
+        status_ = absl::OutOfRangeError(
+            absl::StrCat("Invalid record size in proto record file at row ",
+                         row_count_));
+        return false;
+      }
+      const uint8_t byte = static_cast<uint8_t>(remaining_.front());
+      remaining_.remove_prefix(1);
+      size |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      shift += 7;
+      if ((byte & 0x80) == 0) break;
+    }
+    if (size > remaining_.size()) {
+      status_ = absl::OutOfRangeError(absl::StrCat(
+          "Truncated record in proto record file at row ", row_count_));
+      return false;
+    }
+    // The releaser holds a reference to the mapping, so the Value stays valid
+    // even if it outlives this iterator.
+    std::shared_ptr<const MappedFile> file = file_;
+    current_value_ = Value::Proto(
+        proto_type_,
+        absl::MakeCordFromExternal(remaining_.substr(0, size),
+                                   [file = std::move(file)] {}));
+    remaining_.remove_prefix(size);
+    ++row_count_;
+    return true;
+  }
+
+ private:
+  const std::vector<std::shared_ptr<const MappedFile>> files_;
+  // The index in 'files_' of the next file to read.
+  int next_file_ = 0;
+  // The file being read, and the part of it that has not been read yet.
+  std::shared_ptr<const MappedFile> file_;
+  absl::string_view remaining_;
+  int64_t row_count_ = 0;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromProtoRecordFile(
+    absl::string_view table_name, absl::string_view path,
+    const ProtoType* column_proto_type) {
+  return MakeTableFromProtoRecordFiles(table_name, {std::string(path)},
+                                       column_proto_type);
+}
+
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromProtoRecordFiles(
+    absl::string_view table_name, absl::Span<const std::string> paths,
+    const ProtoType* column_proto_type) {
+  std::vector<SimpleTable::NameAndType> columns = {
+      {SimpleProtoEvaluatorTableIterator::kValueColumnName, column_proto_type}};
+
+  // Map the files up front so that a missing file is reported when the table
+  // is created rather than when it is first queried. All the scans of the table
+  // share the mappings.
+  std::vector<std::shared_ptr<const MappedFile>> files;
+  files.reserve(paths.size());
+  for (const std::string& path : paths) {
+    ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<const MappedFile> file,
+                     MappedFile::Open(path));
+    files.push_back(std::move(file));
+  }
+
+  auto table = absl::make_unique<SimpleTable>(table_name, columns);
+  table->set_is_value_table(true);
+  table->SetEvaluatorTableIteratorFactory(
+      [files, column_proto_type](absl::Span<const int> columns)
+          -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
+        return absl::make_unique<ProtoRecordsEvaluatorTableIterator>(
+            files, column_proto_type, columns);
+      });
+  return table;
+}
+
+}  // namespace zetasql
@@ -29,6 +29,7 @@
 #include "zetasql/public/type.h"
 #include "zetasql/public/types/proto_type.h"
 #include "zetasql/public/value.h"
+#include "zetasql/tools/execute_query/execute_query_tool.h"
 #include "zetasql/tools/execute_query/simple_proto_evaluator_table_iterator.h"
 #include "zetasql/tools/execute_query/string_error_collector.h"
 #include "absl/memory/memory.h"
@@ -44,30 +45,31 @@
 namespace zetasql {
 namespace {
 
-// Represents a text proto file as a value table with 1 row.
+// Represents text proto files as a value table with 1 row per file. Each file
+// is only read when the scan reaches it.
 class TextProtoEvaluatorTableIterator
     : public SimpleProtoEvaluatorTableIterator {
  public:
-  TextProtoEvaluatorTableIterator(absl::string_view path,
+  TextProtoEvaluatorTableIterator(std::vector<std::string> paths,
                                   const ProtoType* proto_type,
                                   absl::Span<const int> columns)
-      : SimpleProtoEvaluatorTableIterator(proto_type), path_(path) {
+      : SimpleProtoEvaluatorTableIterator(proto_type),
+        paths_(std::move(paths)) {
     ZETASQL_CHECK_EQ(columns.size(), 1);
     ZETASQL_CHECK_EQ(columns[0], 0);
   }
 
   bool NextRow() override {
-    if (done_) {
+    if (!status_.ok() || next_path_ >= paths_.size()) {
       return false;
     }
-    done_ = true;
 
     google::protobuf::DynamicMessageFactory dynfac;
     std::unique_ptr<google::protobuf::Message> dynmsg(
         dynfac.GetPrototype(proto_type_->descriptor())->New());
 
     std::string buf;
-    status_ = internal::GetContents(path_, &buf);
+    status_ = internal::GetContents(paths_[next_path_++], &buf);
     if (!status_.ok()) return false;
 
     google::protobuf::TextFormat::Parser parser;
@@ -91,8 +93,8 @@ class TextProtoEvaluatorTableIterator
   }
 
  private:
-  const std::string path_;
-  bool done_ = false;
+  const std::vector<std::string> paths_;
+  int next_path_ = 0;
 };
 
 }  // namespace
@@ -100,19 +102,26 @@ class TextProtoEvaluatorTableIterator
 absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromTextProtoFile(
     absl::string_view table_name, absl::string_view path,
     const ProtoType* column_proto_type) {
+  return MakeTableFromTextProtoFiles(table_name, {std::string(path)},
+                                     column_proto_type);
+}
+
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromTextProtoFiles(
+    absl::string_view table_name, absl::Span<const std::string> paths,
+    const ProtoType* column_proto_type) {
   std::unique_ptr<SimpleTable> table;
   std::vector<SimpleTable::NameAndType> columns = {
       {SimpleProtoEvaluatorTableIterator::kValueColumnName, column_proto_type}};
 
   table = absl::make_unique<SimpleTable>(table_name, columns);
   table->set_is_value_table(true);
-  // Make a copy, because we cannot trust the lifetime of `path`.
-  std::string string_path = std::string(path);
+  // Make a copy, because we cannot trust the lifetime of `paths`.
+  std::vector<std::string> string_paths(paths.begin(), paths.end());
   table->SetEvaluatorTableIteratorFactory(
-      [string_path, column_proto_type](absl::Span<const int> columns)
+      [string_paths, column_proto_type](absl::Span<const int> columns)
           -> absl::StatusOr<std::unique_ptr<EvaluatorTableIterator>> {
         return absl::make_unique<TextProtoEvaluatorTableIterator>(
-            string_path, column_proto_type, columns);
+            string_paths, column_proto_type, columns);
       });
   return table;
 }
@@ -16,6 +16,8 @@
 
 #include "zetasql/tools/execute_query/execute_query_tool.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -25,6 +27,7 @@
 
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor_database.h"
+#include "zetasql/base/logging.h"
 #include "zetasql/public/analyzer.h"
 #include "zetasql/public/analyzer_output.h"
 #include "zetasql/public/catalog.h"
@@ -42,8 +45,12 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "zetasql/base/file_util.h"
+#include "zetasql/base/path.h"
 #include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
 
@@ -53,7 +60,10 @@ ABSL_FLAG(std::string, mode, "execute",
           "\n     'resolve' print the resolved AST"
           "\n     'explain' print the query plan"
           "\n     'execute' actually run the query and print the result. (not"
-          "                 all functionality is supported).");
+          "                 all functionality is supported)."
+          "\n     'profile' run the query, print the result and then the query"
+          "                 plan with the rows, time and memory of each "
+          "operator.");
 
 ABSL_FLAG(std::string, table_spec, "",
           "The table spec to use for building the ZetaSQL Catalog. This is a "
@@ -63,8 +73,19 @@ ABSL_FLAG(std::string, table_spec, "",
           "represented by a value table"
           "\n    textproto:<proto>:<path> - text proto file that is "
           "represented by a value table"
+          "\n    protorecords:<proto>:<path> - file of varint length-delimited "
+          "binary protos that is memory-mapped and represented by a value "
+          "table with one row per proto"
           "\n    csv:<path> - csv file that is represented by a table whose "
-          "string-typed column names are determined from the header row.");
+          "string-typed column names are determined from the header row."
+          "\nA <path> whose file name contains '*' wildcards matches several "
+          "files, which are combined into one table in file name order: csv "
+          "rows and protorecords records are concatenated, and binproto and "
+          "textproto files become one row each.");
+
+ABSL_FLAG(int32_t, table_load_threads, 8,
+          "The number of threads used to load the files of a --table_spec "
+          "path that matches several files.");
 
 ABSL_FLAG(
     std::string, descriptor_pool,
@@ -108,6 +129,9 @@ absl::Status SetToolModeFromFlags(ExecuteQueryConfig& config) {
   } else if (mode == "execute") {
     config.set_tool_mode(ToolMode::kExecute);
     return absl::OkStatus();
+  } else if (mode == "profile") {
+    config.set_tool_mode(ToolMode::kProfile);
+    return absl::OkStatus();
   } else {
     return zetasql_base::InvalidArgumentErrorBuilder()
            << "Invalid --mode: '" << mode << "'";
@@ -156,6 +180,33 @@ static absl::StatusOr<const ProtoType*> GetProtoType(
   return type->AsProto();
 }
 
+// Returns the files matched by `path` in file name order if its file name
+// contains wildcards, or `path` itself otherwise.
+static absl::StatusOr<std::vector<std::string>> ExpandTablePath(
+    absl::string_view path) {
+  if (!absl::StrContains(zetasql_base::Basename(path), '*')) {
+    return std::vector<std::string>{std::string(path)};
+  }
+  std::vector<std::string> paths;
+  // Match() cannot open an empty directory name, so a pattern without a
+  // directory (e.g. "events-*.csv") is matched in "." and the "./" that this
+  // adds is removed from the results.
+  const bool in_current_dir = zetasql_base::Dirname(path).empty();
+  ZETASQL_RETURN_IF_ERROR(internal::Match(
+      in_current_dir ? zetasql_base::JoinPath(".", path) : std::string(path),
+      &paths));
+  if (in_current_dir) {
+    for (std::string& matched_path : paths) {
+      matched_path = std::string(absl::StripPrefix(matched_path, "./"));
+    }
+  }
+  if (paths.empty()) {
+    return zetasql_base::NotFoundErrorBuilder() << "No files match " << path;
+  }
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
 static absl::StatusOr<std::unique_ptr<const Table>> MakeTableFromTableSpec(
     absl::string_view table_spec, ExecuteQueryConfig& config) {
   std::vector<absl::string_view> table_spec_parts =
@@ -179,8 +230,18 @@ static absl::StatusOr<std::unique_ptr<const Table>> MakeTableFromTableSpec(
              << "Invalid specification for csv table " << table_name << ": "
              << table_spec;
     }
-    absl::string_view path = spec_parts[1];
-    return MakeTableFromCsvFile(table_name, path);
+    ZETASQL_ASSIGN_OR_RETURN(std::vector<std::string> paths,
+                     ExpandTablePath(spec_parts[1]));
+    return MakeTableFromCsvFiles(
+        table_name, paths, absl::GetFlag(FLAGS_table_load_threads),
+        [table_name](absl::string_view path, int num_shards_loaded,
+                     int num_shards) {
+          if (num_shards > 1) {
+            ZETASQL_LOG(INFO) << "Loaded " << path << " (" << num_shards_loaded
+                      << "/" << num_shards << " files of table " << table_name
+                      << ")";
+          }
+        });
   } else if (format == "binproto") {
     if (spec_parts.size() != 3) {
       return zetasql_base::InvalidArgumentErrorBuilder()
@@ -192,7 +253,9 @@ static absl::StatusOr<std::unique_ptr<const Table>> MakeTableFromTableSpec(
 
     ZETASQL_ASSIGN_OR_RETURN(const ProtoType* record_type,
                      GetProtoType(config, proto_name));
-    return MakeTableFromBinaryProtoFile(table_name, path, record_type);
+    ZETASQL_ASSIGN_OR_RETURN(std::vector<std::string> paths,
+                     ExpandTablePath(path));
+    return MakeTableFromBinaryProtoFiles(table_name, paths, record_type);
   } else if (format == "textproto") {
     if (spec_parts.size() != 3) {
       return zetasql_base::InvalidArgumentErrorBuilder()
@@ -204,7 +267,23 @@ static absl::StatusOr<std::unique_ptr<const Table>> MakeTableFromTableSpec(
 
     ZETASQL_ASSIGN_OR_RETURN(const ProtoType* record_type,
                      GetProtoType(config, proto_name));
-    return MakeTableFromTextProtoFile(table_name, path, record_type);
+    ZETASQL_ASSIGN_OR_RETURN(std::vector<std::string> paths,
+                     ExpandTablePath(path));
+    return MakeTableFromTextProtoFiles(table_name, paths, record_type);
+  } else if (format == "protorecords") {
+    if (spec_parts.size() != 3) {
+      return zetasql_base::InvalidArgumentErrorBuilder()
+             << "Invalid specification for table " << table_name << ": "
+             << table_spec;
+    }
+    absl::string_view proto_name = spec_parts[1];
+    absl::string_view path = spec_parts[2];
+
+    ZETASQL_ASSIGN_OR_RETURN(const ProtoType* record_type,
+                     GetProtoType(config, proto_name));
+    ZETASQL_ASSIGN_OR_RETURN(std::vector<std::string> paths,
+                     ExpandTablePath(path));
+    return MakeTableFromProtoRecordFiles(table_name, paths, record_type);
   } else {
     return zetasql_base::InvalidArgumentErrorBuilder()
            << "Unknown format " << format << " for table " << table_name;
@@ -362,6 +441,17 @@ absl::Status ExecuteQuery(absl::string_view sql, ExecuteQueryConfig& config,
 
         return writer.executed(*resolved_node, std::move(iter));
       }
+      case ToolMode::kProfile: {
+        OperatorProfile profile;
+        PreparedQuery::QueryOptions options;
+        options.profile = &profile;
+        ZETASQL_ASSIGN_OR_RETURN(std::unique_ptr<EvaluatorTableIterator> iter,
+                         query.ExecuteAfterPrepare(options));
+
+        // 'executed' destroys the iterator, which populates 'profile'.
+        ZETASQL_RETURN_IF_ERROR(writer.executed(*resolved_node, std::move(iter)));
+        return writer.profiled(*resolved_node, profile.DebugString());
+      }
       default:
         return absl::InternalError(absl::StrCat(
             "unknown tool mode: ", static_cast<int>(config.tool_mode())));
@@ -387,6 +477,9 @@ absl::Status ExecuteQuery(absl::string_view sql, ExecuteQueryConfig& config,
 
         return writer.ExecutedExpression(*resolved_node, value);
       }
+      case ToolMode::kProfile:
+        return zetasql_base::InvalidArgumentErrorBuilder()
+               << "--mode=profile is only supported for queries";
       default:
         return absl::InternalError(absl::StrCat(
             "unknown tool mode: ", static_cast<int>(config.tool_mode())));
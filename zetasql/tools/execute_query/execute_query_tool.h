@@ -17,11 +17,13 @@
 #ifndef ZETASQL_TOOLS_EXECUTE_QUERY_EXECUTE_QUERY_TOOL_H_
 #define ZETASQL_TOOLS_EXECUTE_QUERY_EXECUTE_QUERY_TOOL_H_
 
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/descriptor_database.h"
 #include "zetasql/public/analyzer_options.h"
@@ -34,6 +36,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace zetasql {
 
@@ -57,7 +60,12 @@ class ExecuteQueryConfig {
     kExplain,
 
     // Execute the query and pretty print the result.
-    kExecute
+    kExecute,
+
+    // Execute the query, pretty print the result, and then print how many
+    // rows each operator of the query plan produced and the time and memory
+    // it used. Only supported for queries.
+    kProfile
   };
 
   enum class SqlMode {
@@ -128,14 +136,49 @@ absl::Status SetDescriptorPoolFromFlags(ExecuteQueryConfig& config);
 absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromCsvFile(
     absl::string_view table_name, absl::string_view path);
 
+// Called after each shard of a multi-file table is loaded, with the number of
+// shards loaded so far. Calls are serialized, but may come from any thread.
+using ShardLoadedCallback = std::function<void(
+    absl::string_view path, int num_shards_loaded, int num_shards)>;
+
+// Makes a single table from the CSV files in `paths`, which must all have the
+// same header row. The files are loaded on up to `num_threads` threads.
+// `shard_loaded_cb` may be null.
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromCsvFiles(
+    absl::string_view table_name, absl::Span<const std::string> paths,
+    int num_threads, const ShardLoadedCallback& shard_loaded_cb);
+
 absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromBinaryProtoFile(
     absl::string_view table_name, absl::string_view path,
     const ProtoType* column_proto_type);
 
+// Same as above, with one row per file in `paths`. Files are read lazily, as
+// the scan reaches them.
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromBinaryProtoFiles(
+    absl::string_view table_name, absl::Span<const std::string> paths,
+    const ProtoType* column_proto_type);
+
 absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromTextProtoFile(
     absl::string_view table_name, absl::string_view path,
     const ProtoType* column_proto_type);
 
+// Same as above, with one row per file in `paths`. Files are read lazily, as
+// the scan reaches them.
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromTextProtoFiles(
+    absl::string_view table_name, absl::Span<const std::string> paths,
+    const ProtoType* column_proto_type);
+
+// Makes a value table of `column_proto_type` from a file of varint
+// length-delimited binary protos. The file is memory-mapped rather than read.
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromProtoRecordFile(
+    absl::string_view table_name, absl::string_view path,
+    const ProtoType* column_proto_type);
+
+// Same as above, with the records of all the files in `paths`, in order.
+absl::StatusOr<std::unique_ptr<SimpleTable>> MakeTableFromProtoRecordFiles(
+    absl::string_view table_name, absl::Span<const std::string> paths,
+    const ProtoType* column_proto_type);
+
 absl::Status AddTablesFromFlags(ExecuteQueryConfig& config);
 
 absl::StatusOr<std::unique_ptr<ExecuteQueryWriter>> MakeWriterFromFlags(
@@ -153,6 +196,7 @@ absl::Status ExecuteQuery(absl::string_view sql, ExecuteQueryConfig& config,
 ABSL_DECLARE_FLAG(std::string, mode);
 ABSL_DECLARE_FLAG(std::string, sql_mode);
 ABSL_DECLARE_FLAG(std::string, table_spec);
+ABSL_DECLARE_FLAG(int32_t, table_load_threads);
 ABSL_DECLARE_FLAG(std::string, descriptor_pool);
 ABSL_DECLARE_FLAG(std::string, output_mode);
 
@@ -16,12 +16,18 @@
 
 #include "zetasql/tools/execute_query/execute_query_tool.h"
 
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
 #include <string>
 
 #include "zetasql/base/path.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/map_field.h"
 #include "google/protobuf/text_format.h"
+#include "google/protobuf/util/delimited_message_util.h"
 #include "zetasql/base/testing/status_matchers.h"
 #include "zetasql/public/catalog.h"
 #include "zetasql/public/types/type_factory.h"
@@ -42,8 +48,11 @@ namespace {
 
 using zetasql_test__::EmptyMessage;
 using zetasql_test__::KitchenSinkPB;
+using testing::AllOf;
+using testing::HasSubstr;
 using testing::IsEmpty;
 using testing::NotNull;
+using testing::StartsWith;
 using zetasql_base::testing::StatusIs;
 using ToolMode = ExecuteQueryConfig::ToolMode;
 using SqlMode = ExecuteQueryConfig::SqlMode;
@@ -65,6 +74,7 @@ TEST(SetToolModeFromFlags, ToolMode) {
   CheckFlag("resolve", ToolMode::kResolve);
   CheckFlag("explain", ToolMode::kExplain);
   CheckFlag("execute", ToolMode::kExecute);
+  CheckFlag("profile", ToolMode::kProfile);
 }
 
 TEST(SetToolModeFromFlags, BadToolMode) {
@@ -280,6 +290,12 @@ TEST(AddTablesFromFlags, BadFlags) {
   // TextProto
   ExpectTableSpecIsInvalid("BadTable=textproto:missing_proto");
   ExpectTableSpecIsInvalid("BadTable=textproto:::extra");
+
+  // ProtoRecords
+  ExpectTableSpecIsInvalid("BadTable=protorecords:missing_proto");
+  ExpectTableSpecIsInvalid("BadTable=protorecords:::extra");
+  ExpectTableSpecIsInvalid(
+      "BadTable=protorecords:zetasql_test__.KitchenSinkPB:/no/such/file");
 }
 
 TEST(AddTablesFromFlags, GoodFlags) {
@@ -334,6 +350,170 @@ TEST(ExecuteQuery, ReadCsvTableFileEndToEnd) {
 )");
 }
 
+// Writes `protos` to a new file of length-delimited protos and returns its
+// path.
+static std::string WriteProtoRecordFile(
+    absl::string_view name, const std::vector<KitchenSinkPB>& protos) {
+  const std::string path = zetasql_base::JoinPath(testing::TempDir(), name);
+  std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+  for (const KitchenSinkPB& proto : protos) {
+    EXPECT_TRUE(
+        google::protobuf::util::SerializeDelimitedToOstream(proto, &stream));
+  }
+  return path;
+}
+
+TEST(ExecuteQuery, ReadProtoRecordTableFileEndToEnd) {
+  std::vector<KitchenSinkPB> protos(3);
+  for (int i = 0; i < protos.size(); ++i) {
+    protos[i].set_int64_key_1(10 * (i + 1));
+    protos[i].set_int64_key_2(i);
+  }
+  const std::string path = WriteProtoRecordFile("records.binpb", protos);
+
+  ExecuteQueryConfig config;
+  config.mutable_catalog().SetDescriptorPool(
+      google::protobuf::DescriptorPool::generated_pool());
+  absl::SetFlag(&FLAGS_table_spec,
+                absl::StrCat("ProtoRecordsTable=protorecords:"
+                             "zetasql_test__.KitchenSinkPB:",
+                             path));
+  ZETASQL_EXPECT_OK(AddTablesFromFlags(config));
+  std::ostringstream output;
+  ZETASQL_EXPECT_OK(ExecuteQuery(
+      "SELECT int64_key_1 FROM ProtoRecordsTable WHERE int64_key_2 > 0 "
+      "ORDER BY int64_key_1",
+      config, output));
+  EXPECT_EQ(output.str(), R"(+-------------+
+| int64_key_1 |
++-------------+
+| 20          |
+| 30          |
++-------------+
+
+)");
+}
+
+TEST(ExecuteQuery, ReadTruncatedProtoRecordTableFile) {
+  KitchenSinkPB proto;
+  proto.set_int64_key_1(1);
+  proto.set_int64_key_2(2);
+  std::ostringstream record;
+  ASSERT_TRUE(
+      google::protobuf::util::SerializeDelimitedToOstream(proto, &record));
+  // Drop the last byte of the only record.
+  const std::string path =
+      zetasql_base::JoinPath(testing::TempDir(), "truncated.binpb");
+  std::ofstream(path, std::ios::binary | std::ios::trunc)
+      << record.str().substr(0, record.str().size() - 1);
+
+  ExecuteQueryConfig config;
+  config.mutable_catalog().SetDescriptorPool(
+      google::protobuf::DescriptorPool::generated_pool());
+  absl::SetFlag(&FLAGS_table_spec,
+                absl::StrCat("ProtoRecordsTable=protorecords:"
+                             "zetasql_test__.KitchenSinkPB:",
+                             path));
+  ZETASQL_EXPECT_OK(AddTablesFromFlags(config));
+  std::ostringstream output;
+  EXPECT_THAT(
+      ExecuteQuery("SELECT COUNT(*) FROM ProtoRecordsTable", config, output),
+      StatusIs(absl::StatusCode::kOutOfRange, HasSubstr("Truncated record")));
+}
+
+// Writes `contents` to a new file in a fresh directory `dir` under the test
+// temporary directory, and returns the path of the file.
+static std::string WriteTestFile(absl::string_view dir, absl::string_view name,
+                                 absl::string_view contents) {
+  const std::string dir_path = zetasql_base::JoinPath(testing::TempDir(), dir);
+  mkdir(dir_path.c_str(), 0755);
+  const std::string path = zetasql_base::JoinPath(dir_path, name);
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+  return path;
+}
+
+TEST(ExecuteQuery, ReadShardedCsvTableEndToEnd) {
+  absl::FlagSaver fs;
+  for (int i = 0; i < 5; ++i) {
+    WriteTestFile("csv_shards", absl::StrCat("shard-", i, ".csv"),
+                  absl::StrCat("key,value\n", i, ",a\n", i, ",b\n"));
+  }
+  // Does not match the pattern.
+  WriteTestFile("csv_shards", "other.csv", "key,value\n9,c\n");
+
+  ExecuteQueryConfig config;
+  absl::SetFlag(&FLAGS_table_load_threads, 3);
+  absl::SetFlag(&FLAGS_table_spec,
+                absl::StrCat("CsvTable=csv:",
+                             zetasql_base::JoinPath(testing::TempDir(),
+                                                    "csv_shards/shard-*.csv")));
+  ZETASQL_EXPECT_OK(AddTablesFromFlags(config));
+  std::ostringstream output;
+  ZETASQL_EXPECT_OK(ExecuteQuery(
+      "SELECT key, COUNT(*) AS n FROM CsvTable GROUP BY key ORDER BY key",
+      config, output));
+  EXPECT_EQ(output.str(), R"(+-----+---+
+| key | n |
++-----+---+
+| 0   | 2 |
+| 1   | 2 |
+| 2   | 2 |
+| 3   | 2 |
+| 4   | 2 |
++-----+---+
+
+)");
+}
+
+TEST(AddTablesFromFlags, ShardedCsvTableInCurrentDirectory) {
+  absl::FlagSaver fs;
+  WriteTestFile("cwd_csv_shards", "shard-0.csv", "key,value\n1,a\n");
+  WriteTestFile("cwd_csv_shards", "shard-1.csv", "key,value\n2,b\n");
+
+  char old_cwd[PATH_MAX];
+  ASSERT_NE(getcwd(old_cwd, sizeof(old_cwd)), nullptr);
+  const std::string dir =
+      zetasql_base::JoinPath(testing::TempDir(), "cwd_csv_shards");
+  ASSERT_EQ(chdir(dir.c_str()), 0);
+
+  // A pattern without a directory part is matched in the current directory.
+  ExecuteQueryConfig config;
+  absl::SetFlag(&FLAGS_table_spec, "CsvTable=csv:shard-*.csv");
+  const absl::Status add_status = AddTablesFromFlags(config);
+  std::ostringstream output;
+  const absl::Status query_status =
+      add_status.ok()
+          ? ExecuteQuery("SELECT COUNT(*) FROM CsvTable", config, output)
+          : absl::OkStatus();
+  ASSERT_EQ(chdir(old_cwd), 0);
+
+  ZETASQL_ASSERT_OK(add_status);
+  ZETASQL_ASSERT_OK(query_status);
+  EXPECT_THAT(output.str(), HasSubstr("| 2 "));
+}
+
+TEST(AddTablesFromFlags, ShardedCsvTableErrors) {
+  WriteTestFile("bad_csv_shards", "shard-0.csv", "key,value\n1,a\n");
+  WriteTestFile("bad_csv_shards", "shard-1.csv", "key,other\n1,a\n");
+
+  ExecuteQueryConfig config;
+  absl::SetFlag(&FLAGS_table_spec,
+                absl::StrCat("CsvTable=csv:",
+                             zetasql_base::JoinPath(testing::TempDir(),
+                                                    "bad_csv_shards/*")));
+  EXPECT_THAT(AddTablesFromFlags(config),
+              StatusIs(absl::StatusCode::kUnknown,
+                       HasSubstr("has a different header row")));
+
+  absl::SetFlag(&FLAGS_table_spec,
+                absl::StrCat("CsvTable=csv:",
+                             zetasql_base::JoinPath(testing::TempDir(),
+                                                    "bad_csv_shards/*.txt")));
+  EXPECT_THAT(AddTablesFromFlags(config),
+              StatusIs(absl::StatusCode::kNotFound,
+                       HasSubstr("No files match")));
+}
+
 TEST(ExecuteQuery, ParseQuery) {
   ExecuteQueryConfig config;
   config.set_tool_mode(ToolMode::kParse);
@@ -395,6 +575,36 @@ TEST(ExecuteQuery, ExecuteQuery) {
 )");
 }
 
+TEST(ExecuteQuery, ProfileQuery) {
+  ExecuteQueryConfig config;
+  config.set_tool_mode(ToolMode::kProfile);
+  std::ostringstream output;
+  ZETASQL_EXPECT_OK(ExecuteQuery("select 1", config, output));
+  // The times vary from run to run.
+  EXPECT_THAT(output.str(),
+              AllOf(StartsWith(R"(+---+
+|   |
++---+
+| 1 |
++---+
+
+RootOp: evaluations=1 next_calls=2 rows_in=1 rows_out=1 wall_time=)"),
+                    HasSubstr("\n+-ComputeOp: evaluations=1 next_calls=2 "
+                              "rows_in=1 rows_out=1 wall_time="),
+                    HasSubstr("\n  +-EnumerateOp: evaluations=1 next_calls=2 "
+                              "rows_in=0 rows_out=1 wall_time=")));
+}
+
+TEST(ExecuteQuery, ProfileExpression) {
+  ExecuteQueryConfig config;
+  config.set_tool_mode(ToolMode::kProfile);
+  config.set_sql_mode(SqlMode::kExpression);
+  std::ostringstream output;
+  EXPECT_THAT(ExecuteQuery("1", config, output),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("only supported for queries")));
+}
+
 TEST(ExecuteQuery, ParseExpression) {
   ExecuteQueryConfig config;
   config.set_tool_mode(ToolMode::kParse);
@@ -115,4 +115,10 @@ absl::Status ExecuteQueryStreamWriter::ExecutedExpression(
   return absl::OkStatus();
 }
 
+absl::Status ExecuteQueryStreamWriter::profiled(const ResolvedNode& ast,
+                                                absl::string_view profile) {
+  stream_ << profile << std::endl;
+  return absl::OkStatus();
+}
+
 }  // namespace zetasql
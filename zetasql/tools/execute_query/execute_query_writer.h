@@ -54,6 +54,11 @@ class ExecuteQueryWriter {
     return absl::UnimplementedError(
         "ExecuteQueryWriter::executed is not implemented");
   }
+  virtual absl::Status profiled(const ResolvedNode& ast,
+                                absl::string_view profile) {
+    return absl::UnimplementedError(
+        "ExecuteQueryWriter::profiled is not implemented");
+  }
 };
 
 // Writes a human-readable representation of the query result to an output
@@ -72,6 +77,8 @@ class ExecuteQueryStreamWriter : public ExecuteQueryWriter {
                         std::unique_ptr<EvaluatorTableIterator> iter) override;
   absl::Status ExecutedExpression(const ResolvedNode& ast,
                                   const Value& value) override;
+  absl::Status profiled(const ResolvedNode& ast,
+                        absl::string_view profile) override;
 
  private:
   std::ostream& stream_;